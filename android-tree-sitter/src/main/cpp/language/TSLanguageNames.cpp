@@ -0,0 +1,160 @@
+/*
+ *  This file is part of android-tree-sitter.
+ *
+ *  android-tree-sitter library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  android-tree-sitter library is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *  along with android-tree-sitter.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include "TSLanguageNames.h"
+
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+// the symbols of the ERROR nodes are not included in the symbol count
+#define SYM_ERROR ((TSSymbol) -1)
+#define SYM_ERROR_REPEAT ((TSSymbol) -2)
+
+struct NameTable {
+  std::vector<jstring> symbols;
+  std::vector<jstring> fields;
+  jstring error = nullptr;
+  jstring error_repeat = nullptr;
+};
+
+static std::shared_mutex tables_lock;
+static std::unordered_map<const TSLanguage *, NameTable *> tables;
+
+static jstring new_global_string(JNIEnv *env, const char *str) {
+  if (str == nullptr) {
+    return nullptr;
+  }
+
+  auto local = env->NewStringUTF(str);
+  if (local == nullptr) {
+    // OutOfMemoryError is pending
+    env->ExceptionClear();
+    return nullptr;
+  }
+
+  auto global = (jstring) env->NewGlobalRef(local);
+  env->DeleteLocalRef(local);
+  return global;
+}
+
+static void delete_table(JNIEnv *env, NameTable *table) {
+  for (auto name : table->symbols) {
+    if (name != nullptr) env->DeleteGlobalRef(name);
+  }
+  for (auto name : table->fields) {
+    if (name != nullptr) env->DeleteGlobalRef(name);
+  }
+  if (table->error != nullptr) env->DeleteGlobalRef(table->error);
+  if (table->error_repeat != nullptr) env->DeleteGlobalRef(table->error_repeat);
+  delete table;
+}
+
+static jstring local_ref(JNIEnv *env, jstring name) {
+  return name == nullptr ? nullptr : (jstring) env->NewLocalRef(name);
+}
+
+void TSLanguageNames::intern(JNIEnv *env, const TSLanguage *language) {
+  {
+    std::shared_lock<std::shared_mutex> guard(tables_lock);
+    if (tables.find(language) != tables.end()) {
+      return;
+    }
+  }
+
+  // create the strings without holding the lock so that the getters of other
+  // languages are not blocked
+  auto *table = new NameTable;
+  uint32_t symbol_count = ts_language_symbol_count(language);
+  table->symbols.reserve(symbol_count);
+  for (uint32_t i = 0; i < symbol_count; ++i) {
+    table->symbols.push_back(
+        new_global_string(env, ts_language_symbol_name(language, (TSSymbol) i)));
+  }
+
+  // field ids start at 1
+  uint32_t field_count = ts_language_field_count(language);
+  table->fields.reserve(field_count + 1);
+  table->fields.push_back(nullptr);
+  for (uint32_t i = 1; i <= field_count; ++i) {
+    table->fields.push_back(
+        new_global_string(env, ts_language_field_name_for_id(language, (TSFieldId) i)));
+  }
+
+  table->error = new_global_string(env, ts_language_symbol_name(language, SYM_ERROR));
+  table->error_repeat =
+      new_global_string(env, ts_language_symbol_name(language, SYM_ERROR_REPEAT));
+
+  std::unique_lock<std::shared_mutex> guard(tables_lock);
+  if (!tables.emplace(language, table).second) {
+    // another thread interned the same language in the meantime
+    delete_table(env, table);
+  }
+}
+
+void TSLanguageNames::release(JNIEnv *env, const TSLanguage *language) {
+  std::unique_lock<std::shared_mutex> guard(tables_lock);
+  auto it = tables.find(language);
+  if (it == tables.end()) {
+    return;
+  }
+
+  delete_table(env, it->second);
+  tables.erase(it);
+}
+
+jstring TSLanguageNames::symbol_name(JNIEnv *env,
+                                     const TSLanguage *language,
+                                     TSSymbol symbol) {
+  {
+    std::shared_lock<std::shared_mutex> guard(tables_lock);
+    auto it = tables.find(language);
+    if (it != tables.end()) {
+      const NameTable *table = it->second;
+      if (symbol < table->symbols.size()) {
+        return local_ref(env, table->symbols[symbol]);
+      }
+      if (symbol == SYM_ERROR) {
+        return local_ref(env, table->error);
+      }
+      if (symbol == SYM_ERROR_REPEAT) {
+        return local_ref(env, table->error_repeat);
+      }
+      return nullptr;
+    }
+  }
+
+  return env->NewStringUTF(ts_language_symbol_name(language, symbol));
+}
+
+jstring TSLanguageNames::field_name(JNIEnv *env,
+                                    const TSLanguage *language,
+                                    TSFieldId field) {
+  {
+    std::shared_lock<std::shared_mutex> guard(tables_lock);
+    auto it = tables.find(language);
+    if (it != tables.end()) {
+      const NameTable *table = it->second;
+      return field < table->fields.size() ? local_ref(env, table->fields[field])
+                                          : nullptr;
+    }
+  }
+
+  return env->NewStringUTF(ts_language_field_name_for_id(language, field));
+}
@@ -0,0 +1,62 @@
+/*
+ *  This file is part of android-tree-sitter.
+ *
+ *  android-tree-sitter library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  android-tree-sitter library is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *  along with android-tree-sitter.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef ANDROIDTREESITTER_TSLANGUAGENAMES_H
+#define ANDROIDTREESITTER_TSLANGUAGENAMES_H
+
+#include <jni.h>
+
+#include "tree_sitter/api.h"
+
+/**
+ * Process-wide tables of the symbol and field names of languages, as global references to Java
+ * strings. The names of a language never change, so the getters which return the name of a symbol
+ * or a field return the same string instance instead of creating a new one with
+ * <code>NewStringUTF</code> on each call.
+ *
+ * Languages which are not interned fall back to creating a new string. All the functions are
+ * thread-safe.
+ */
+class TSLanguageNames {
+
+ public:
+  /**
+   * Create the name tables for the given language, if they have not been created yet.
+   */
+  static void intern(JNIEnv *env, const TSLanguage *language);
+
+  /**
+   * Delete the name tables for the given language. This must be called before the language is
+   * unloaded, as the pointer of the language may be reused for another language.
+   */
+  static void release(JNIEnv *env, const TSLanguage *language);
+
+  /**
+   * @return A local reference to the name of the given symbol, or <code>nullptr</code> if the
+   *         symbol is invalid.
+   */
+  static jstring symbol_name(JNIEnv *env, const TSLanguage *language, TSSymbol symbol);
+
+  /**
+   * @return A local reference to the name of the given field, or <code>nullptr</code> if the field
+   *         id is invalid.
+   */
+  static jstring field_name(JNIEnv *env, const TSLanguage *language, TSFieldId field);
+};
+
+#endif //ANDROIDTREESITTER_TSLANGUAGENAMES_H
@@ -0,0 +1,209 @@
+/*
+ *  This file is part of android-tree-sitter.
+ *
+ *  android-tree-sitter library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  android-tree-sitter library is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *  along with android-tree-sitter.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include "TSLanguageRegistry.h"
+
+#include <dlfcn.h>
+#include <condition_variable>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include "TSLanguageNames.h"
+#include "ts__log.h"
+#include "../utils/ts_thread_pool.h"
+
+typedef const TSLanguage *(*TsLangFunc)();
+
+namespace {
+
+struct Library {
+  void *handle = nullptr;
+
+  // whether the library is being opened by another thread
+  bool loading = true;
+
+  // whether a reference is held for a preload
+  bool preloaded = false;
+  uint32_t ref_count = 0;
+  std::unordered_map<std::string, const TSLanguage *> languages;
+};
+
+std::mutex registry_lock;
+std::condition_variable library_loaded;
+std::unordered_map<std::string, std::unique_ptr<Library>> libraries;
+
+/**
+ * Close the library at the given path, which has no references. Must be called
+ * with the registry lock held.
+ */
+void unload(JNIEnv *env,
+            std::unordered_map<std::string, std::unique_ptr<Library>>::iterator it) {
+  auto *library = it->second.get();
+  if (env != nullptr) {
+    for (const auto &language : library->languages) {
+      TSLanguageNames::release(env, language.second);
+    }
+  }
+
+  dlclose(library->handle);
+  libraries.erase(it);
+}
+
+/**
+ * Find the library with the given handle. Must be called with the registry lock
+ * held.
+ */
+std::unordered_map<std::string, std::unique_ptr<Library>>::iterator
+find_by_handle(void *handle) {
+  auto it = libraries.begin();
+  while (it != libraries.end() && (it->second->loading || it->second->handle != handle)) {
+    ++it;
+  }
+  return it;
+}
+
+}  // namespace
+
+bool TSLanguageRegistry::load(const std::string &path,
+                              const std::string &function,
+                              TSLoadedLanguage *result) {
+  return acquire(path, function, result, false);
+}
+
+bool TSLanguageRegistry::acquire(const std::string &path,
+                                 const std::string &function,
+                                 TSLoadedLanguage *result,
+                                 bool preload) {
+  std::unique_lock<std::mutex> lock(registry_lock);
+
+  // the entry is looked up again after waiting, as the library may have failed
+  // to load and have been removed in the meantime
+  auto it = libraries.find(path);
+  while (it != libraries.end() && it->second->loading) {
+    library_loaded.wait(lock);
+    it = libraries.find(path);
+  }
+
+  if (it == libraries.end()) {
+    it = libraries.emplace(path, std::make_unique<Library>()).first;
+
+    // open the library without holding the lock, so that other libraries can
+    // be loaded in the meantime
+    lock.unlock();
+    void *handle = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+    std::string error = handle == nullptr ? dlerror() : "";
+    lock.lock();
+
+    it = libraries.find(path);
+    if (handle == nullptr) {
+      LOGE(LOG_TAG, "Failed to dlopen library '%s': %s", path.c_str(), error.c_str());
+      libraries.erase(it);
+      library_loaded.notify_all();
+      return false;
+    }
+
+    it->second->handle = handle;
+    it->second->loading = false;
+    library_loaded.notify_all();
+  }
+
+  auto *library = it->second.get();
+  auto cached = library->languages.find(function);
+  const TSLanguage *language = nullptr;
+  if (cached != library->languages.end()) {
+    language = cached->second;
+  } else {
+    auto lang_func = reinterpret_cast<TsLangFunc>(dlsym(library->handle, function.c_str()));
+    if (lang_func == nullptr) {
+      LOGE(LOG_TAG,
+           "Cannot find function '%s' to create language instance: %s",
+           function.c_str(),
+           dlerror());
+    } else if ((language = lang_func()) == nullptr) {
+      LOGE(LOG_TAG, "Function '%s' returned nullptr", function.c_str());
+    } else {
+      library->languages.emplace(function, language);
+    }
+  }
+
+  if (language == nullptr) {
+    if (library->ref_count == 0) {
+      unload(nullptr, it);
+    }
+    return false;
+  }
+
+  if (!preload || !library->preloaded) {
+    library->preloaded = library->preloaded || preload;
+    ++library->ref_count;
+  }
+
+  result->language = language;
+  result->handle = library->handle;
+  return true;
+}
+
+void TSLanguageRegistry::release(JNIEnv *env, void *handle) {
+  std::lock_guard<std::mutex> guard(registry_lock);
+  auto it = find_by_handle(handle);
+  if (it == libraries.end()) {
+    dlclose(handle);
+    return;
+  }
+
+  if (--it->second->ref_count == 0) {
+    unload(env, it);
+  }
+}
+
+void TSLanguageRegistry::preload(
+    std::vector<std::pair<std::string, std::string>> languages) {
+  auto *pool = TSThreadPool::shared();
+  for (auto &language : languages) {
+    pool->submit([language = std::move(language)] {
+      TSLoadedLanguage result{};
+      acquire(language.first, language.second, &result, true);
+    });
+  }
+}
+
+void TSLanguageRegistry::release_preloaded(JNIEnv *env) {
+  std::lock_guard<std::mutex> guard(registry_lock);
+  auto it = libraries.begin();
+  while (it != libraries.end()) {
+    auto *library = it->second.get();
+    if (!library->loading && library->preloaded) {
+      library->preloaded = false;
+      if (--library->ref_count == 0) {
+        auto next = std::next(it);
+        unload(env, it);
+        it = next;
+        continue;
+      }
+    }
+    ++it;
+  }
+}
+
+uint32_t TSLanguageRegistry::ref_count(void *handle) {
+  std::lock_guard<std::mutex> guard(registry_lock);
+  auto it = find_by_handle(handle);
+  return it == libraries.end() ? 0 : it->second->ref_count;
+}
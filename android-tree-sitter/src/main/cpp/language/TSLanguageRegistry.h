@@ -0,0 +1,99 @@
+/*
+ *  This file is part of android-tree-sitter.
+ *
+ *  android-tree-sitter library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  android-tree-sitter library is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *  along with android-tree-sitter.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef ANDROIDTREESITTER_TSLANGUAGEREGISTRY_H
+#define ANDROIDTREESITTER_TSLANGUAGEREGISTRY_H
+
+#include <jni.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "tree_sitter/api.h"
+
+/**
+ * A language loaded from a shared library, along with the handle of the
+ * library.
+ */
+struct TSLoadedLanguage {
+  const TSLanguage *language;
+  void *handle;
+};
+
+/**
+ * Process-wide registry of the grammar libraries loaded with
+ * <code>dlopen</code>. Each library is opened once per path and reference
+ * counted : every successful load acquires a reference which must be released
+ * with release(), and the library is closed when its last reference is
+ * released. The languages created by each library are cached by the name of
+ * their function.
+ *
+ * Libraries can be preloaded on the shared thread pool, in which case a
+ * reference is held by the registry until release_preloaded() is called.
+ * Loading a library which is being preloaded waits for the preload to complete
+ * instead of opening it again. All the functions are thread-safe.
+ */
+class TSLanguageRegistry {
+
+ public:
+  /**
+   * Load the language created by the given function of the library at the
+   * given path, and acquire a reference to the library.
+   *
+   * @return Whether the language was loaded. The errors are logged.
+   */
+  static bool load(const std::string &path,
+                   const std::string &function,
+                   TSLoadedLanguage *result);
+
+  /**
+   * Release a reference to the library with the given handle. The library is
+   * closed when its last reference is released, after the interned names of
+   * its languages are released. Handles which were not opened by the registry
+   * are closed directly.
+   */
+  static void release(JNIEnv *env, void *handle);
+
+  /**
+   * Load the given (path, function) pairs on the shared thread pool, and return
+   * immediately. The registry holds a reference to each library which was
+   * preloaded successfully.
+   */
+  static void preload(std::vector<std::pair<std::string, std::string>> languages);
+
+  /**
+   * Release the references held by the registry for the preloaded libraries.
+   */
+  static void release_preloaded(JNIEnv *env);
+
+  /**
+   * @return The number of references to the library with the given handle, or
+   *         0 if the library is not open.
+   */
+  static uint32_t ref_count(void *handle);
+
+ private:
+  TSLanguageRegistry() = delete;
+
+  static bool acquire(const std::string &path,
+                      const std::string &function,
+                      TSLoadedLanguage *result,
+                      bool preload);
+};
+
+#endif //ANDROIDTREESITTER_TSLANGUAGEREGISTRY_H
@@ -17,6 +17,7 @@
 
 #include <jni.h>
 
+#include "utils/ts_allocator.h"
 #include "utils/ts_obj_utils.h"
 #include "ts__log.h"
 
@@ -30,6 +31,9 @@ static jint JNI_VERSION = JNI_VERSION_10;
 
 JNIEXPORT jint JNI_OnLoad(JavaVM *vm, void *reserved) {
 
+  // before anything is allocated by tree-sitter
+  TSAllocator::install();
+
   JNIEnv *env;
   if (vm->GetEnv(reinterpret_cast<void **>(&env), JNI_VERSION) != JNI_OK) {
     LOGE(LOG_TAG, "Failed to get JNIEnv* from JavaVM: %p", vm);
@@ -0,0 +1,145 @@
+/*
+ *  This file is part of android-tree-sitter.
+ *
+ *  android-tree-sitter library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  android-tree-sitter library is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *  along with android-tree-sitter.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include "TSInputs.h"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "utf16str/UTF16String.h"
+#include "utils/ts_misc.h"
+
+/**
+ * `TSInput` read callback which reads directly from the storage of the
+ * `UTF16String` provided as the payload.
+ */
+static const char *
+utf16_string_read(void *payload,
+                  uint32_t byte_index,
+                  __TS_ATTR_UNUSED TSPoint position,
+                  uint32_t *bytes_read) {
+  auto *source = (UTF16String *) payload;
+  auto chunk = source->chunk_at(byte_index, bytes_read);
+  return chunk ? chunk : "";
+}
+
+TSInput ts_input_from_string(UTF16String *source) {
+  return {source, utf16_string_read, TSInputEncodingUTF16};
+}
+
+std::string ts_mapping_error(const char *path, int error) {
+  std::string message = "Unable to map file ";
+  message += path;
+  message += ": ";
+  message += strerror(error);
+  return message;
+}
+
+TSMappedFile::~TSMappedFile() {
+  unmap();
+}
+
+int TSMappedFile::map(const char *path) {
+  unmap();
+
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return errno;
+  }
+
+  struct stat st{};
+  if (fstat(fd, &st) != 0) {
+    int error = errno;
+    close(fd);
+    return error;
+  }
+
+  if (!S_ISREG(st.st_mode)) {
+    close(fd);
+    return EINVAL;
+  }
+
+  // tree-sitter uses 32-bit byte offsets
+  if ((uint64_t) st.st_size > UINT32_MAX) {
+    close(fd);
+    return EFBIG;
+  }
+
+  // mmap fails for empty files, these are parsed as empty sources
+  if (st.st_size == 0) {
+    close(fd);
+    return 0;
+  }
+
+  void *data = mmap(nullptr, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  int error = errno;
+
+  // the mapping stays valid after the file descriptor is closed
+  close(fd);
+  if (data == MAP_FAILED) {
+    return error;
+  }
+
+  // the lexer reads the source mostly front to back
+  madvise(data, (size_t) st.st_size, MADV_SEQUENTIAL);
+
+  _data = data;
+  _size = (size_t) st.st_size;
+  _length = (uint32_t) _size;
+  return 0;
+}
+
+void TSMappedFile::unmap() {
+  if (_data) {
+    munmap(_data, _size);
+  }
+
+  _data = nullptr;
+  _size = 0;
+  _length = 0;
+}
+
+TSInput TSMappedFile::as_input(TSInputEncoding encoding) {
+  _length = (uint32_t) _size;
+  if (encoding == TSInputEncodingUTF16) {
+    // a trailing odd byte is not a complete code unit
+    _length &= ~1u;
+  }
+
+  return {this, read, encoding};
+}
+
+const char *TSMappedFile::read(void *payload,
+                               uint32_t byte_index,
+                               __TS_ATTR_UNUSED TSPoint position,
+                               uint32_t *bytes_read) {
+  auto *file = (TSMappedFile *) payload;
+  if (byte_index >= file->_length) {
+    *bytes_read = 0;
+    return "";
+  }
+
+  *bytes_read = file->_length - byte_index;
+  return (const char *) file->_data + byte_index;
+}
@@ -0,0 +1,90 @@
+/*
+ *  This file is part of android-tree-sitter.
+ *
+ *  android-tree-sitter library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  android-tree-sitter library is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *  along with android-tree-sitter.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef ANDROIDTREESITTER_TSINPUTS_H
+#define ANDROIDTREESITTER_TSINPUTS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "tree_sitter/api.h"
+
+class UTF16String;
+
+/**
+ * A read-only memory mapping of a source file, which can be parsed without
+ * copying its content.
+ */
+class TSMappedFile {
+
+ public:
+  TSMappedFile() = default;
+
+  TSMappedFile(const TSMappedFile &) = delete;
+
+  TSMappedFile &operator=(const TSMappedFile &) = delete;
+
+  ~TSMappedFile();
+
+  /**
+   * Map the file at the given path, unmapping the previously mapped file, if
+   * any.
+   *
+   * @return 0 on success, or the <code>errno</code> value of the failure.
+   */
+  int map(const char *path);
+
+  /**
+   * Unmap the mapped file. Trees parsed from the file remain valid, as they do
+   * not reference the source.
+   */
+  void unmap();
+
+  /**
+   * Create a `TSInput` which reads the mapped file, decoding it with the given
+   * encoding. The file must remain mapped until the parse completes.
+   */
+  TSInput as_input(TSInputEncoding encoding);
+
+ private:
+  void *_data = nullptr;
+  size_t _size = 0;
+
+  // the number of bytes readable by the input
+  uint32_t _length = 0;
+
+  static const char *read(void *payload,
+                          uint32_t byte_index,
+                          TSPoint position,
+                          uint32_t *bytes_read);
+};
+
+/**
+ * Create a `TSInput` which reads directly from the storage of the given
+ * string. The string must not be modified until the parse completes.
+ */
+TSInput ts_input_from_string(UTF16String *source);
+
+/**
+ * Build the message for an `IOException` thrown when the file at the given
+ * path cannot be mapped.
+ */
+std::string ts_mapping_error(const char *path, int error);
+
+#endif //ANDROIDTREESITTER_TSINPUTS_H
@@ -0,0 +1,365 @@
+/*
+ *  This file is part of android-tree-sitter.
+ *
+ *  android-tree-sitter library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  android-tree-sitter library is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *  along with android-tree-sitter.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include "TSLayeredDocument.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "TSInputs.h"
+#include "TSParserInternal.h"
+#include "TSParserPool.h"
+#include "../query/TSQueryInternal.h"
+#include "../utf16str/UTF16String.h"
+#include "../utils/ts_preconditions.h"
+#include "../utils/ts_instrumentation.h"
+#include "../utils/ts_thread_pool.h"
+
+#define NO_CAPTURE UINT32_MAX
+
+static bool name_equals(const char *name, uint32_t length, const char *expected) {
+  return length == strlen(expected) && strncmp(name, expected, length) == 0;
+}
+
+/**
+ * Map a byte offset in the old text to the new text, the same way ts_tree_edit
+ * moves the positions of the nodes.
+ */
+static uint32_t shift(uint32_t offset, const TSInputEdit &edit) {
+  if (offset >= edit.old_end_byte) {
+    return offset - edit.old_end_byte + edit.new_end_byte;
+  }
+  if (offset > edit.start_byte) {
+    return std::min(offset, edit.new_end_byte);
+  }
+  return offset;
+}
+
+static bool same_bytes(const std::vector<TSRange> &a, const std::vector<TSRange> &b) {
+  return std::equal(a.begin(), a.end(), b.begin(), b.end(),
+                    [](const TSRange &lhs, const TSRange &rhs) {
+                      return lhs.start_byte == rhs.start_byte && lhs.end_byte == rhs.end_byte;
+                    });
+}
+
+/**
+ * Sort the ranges and merge the overlapping ranges, as required by
+ * ts_parser_set_included_ranges.
+ */
+static void normalize(std::vector<TSRange> &ranges) {
+  std::sort(ranges.begin(), ranges.end(), [](const TSRange &lhs, const TSRange &rhs) {
+    return lhs.start_byte < rhs.start_byte
+        || (lhs.start_byte == rhs.start_byte && lhs.end_byte < rhs.end_byte);
+  });
+
+  size_t count = 0;
+  for (const auto &range : ranges) {
+    if (count > 0 && range.start_byte < ranges[count - 1].end_byte) {
+      auto &last = ranges[count - 1];
+      if (range.end_byte > last.end_byte) {
+        last.end_byte = range.end_byte;
+        last.end_point = range.end_point;
+      }
+    } else {
+      ranges[count++] = range;
+    }
+  }
+  ranges.resize(count);
+}
+
+TSLayeredDocument::TSLayeredDocument(const TSLanguage *host, TSQueryInternal *injections)
+    : _host(new TSParserPool(host, 1)),
+      _injections(injections),
+      _cursor(ts_query_cursor_new()),
+      _tree(nullptr),
+      _content_capture(NO_CAPTURE),
+      _language_capture(NO_CAPTURE) {
+  _injections->retain();
+  compile_injections();
+}
+
+TSLayeredDocument::~TSLayeredDocument() {
+  for (auto *layer : _layers) {
+    if (layer->tree != nullptr) {
+      ts_tree_delete(layer->tree);
+    }
+    delete layer;
+  }
+
+  for (auto &entry : _languages) {
+    entry.second->destroy();
+  }
+
+  if (_tree != nullptr) {
+    ts_tree_delete(_tree);
+  }
+
+  _host->destroy();
+  ts_query_cursor_delete(_cursor);
+  _injections->release();
+}
+
+void TSLayeredDocument::compile_injections() {
+  const TSQuery *query = _injections->query();
+
+  uint32_t capture_count = ts_query_capture_count(query);
+  for (uint32_t i = 0; i < capture_count; ++i) {
+    uint32_t length = 0;
+    const char *name = ts_query_capture_name_for_id(query, i, &length);
+    if (name_equals(name, length, "injection.content") || name_equals(name, length, "content")) {
+      _content_capture = i;
+    } else if (name_equals(name, length, "injection.language")
+        || name_equals(name, length, "language")) {
+      _language_capture = i;
+    }
+  }
+
+  // (#set! injection.language "name")
+  uint32_t pattern_count = ts_query_pattern_count(query);
+  _pattern_languages.resize(pattern_count);
+  for (uint32_t pattern = 0; pattern < pattern_count; ++pattern) {
+    uint32_t step_count = 0;
+    const TSQueryPredicateStep *steps =
+        ts_query_predicates_for_pattern(query, pattern, &step_count);
+
+    for (uint32_t start = 0; start < step_count;) {
+      uint32_t end = start;
+      while (end < step_count && steps[end].type != TSQueryPredicateStepTypeDone) {
+        ++end;
+      }
+
+      const TSQueryPredicateStep *predicate = steps + start;
+      if (end - start == 3
+          && predicate[0].type == TSQueryPredicateStepTypeString
+          && predicate[1].type == TSQueryPredicateStepTypeString
+          && predicate[2].type == TSQueryPredicateStepTypeString) {
+        uint32_t length = 0;
+        const char *name = ts_query_string_value_for_id(query, predicate[0].value_id, &length);
+        const char *key = nullptr;
+        uint32_t key_length = 0;
+        if (name_equals(name, length, "set!")) {
+          key = ts_query_string_value_for_id(query, predicate[1].value_id, &key_length);
+        }
+        if (key != nullptr && (name_equals(key, key_length, "injection.language")
+            || name_equals(key, key_length, "language"))) {
+          const char *value = ts_query_string_value_for_id(query, predicate[2].value_id, &length);
+          _pattern_languages[pattern].assign(value, length);
+        }
+      }
+
+      start = end + 1;
+    }
+  }
+}
+
+void TSLayeredDocument::add_language(const std::string &name, const TSLanguage *language) {
+  auto it = _languages.find(name);
+  if (it != _languages.end()) {
+    remove_layer(name);
+    it->second->destroy();
+    _languages.erase(it);
+  }
+
+  _languages.emplace(name, new TSParserPool(language, 1));
+}
+
+void TSLayeredDocument::remove_layer(const std::string &name) {
+  for (auto it = _layers.begin(); it != _layers.end(); ++it) {
+    if ((*it)->name == name) {
+      if ((*it)->tree != nullptr) {
+        ts_tree_delete((*it)->tree);
+      }
+      delete *it;
+      _layers.erase(it);
+      return;
+    }
+  }
+}
+
+void TSLayeredDocument::edit(const TSInputEdit &edit) {
+  if (_tree == nullptr) {
+    return;
+  }
+
+  ts_tree_edit(_tree, &edit);
+
+  for (auto *layer : _layers) {
+    if (layer->tree != nullptr) {
+      ts_tree_edit(layer->tree, &edit);
+    }
+
+    for (auto &range : layer->ranges) {
+      if (edit.start_byte <= range.end_byte && edit.old_end_byte >= range.start_byte) {
+        layer->dirty = true;
+      }
+      range.start_byte = shift(range.start_byte, edit);
+      range.end_byte = shift(range.end_byte, edit);
+    }
+  }
+}
+
+void TSLayeredDocument::collect_injections(
+    const UTF16String *source,
+    std::unordered_map<std::string, std::vector<TSRange>> &dest) {
+  if (_content_capture == NO_CAPTURE) {
+    return;
+  }
+
+  ts_query_cursor_exec(_cursor, _injections->query(), ts_tree_root_node(_tree));
+
+  std::u16string text;
+  TSQueryMatch match;
+  while (ts_query_cursor_next_match(_cursor, &match)) {
+    if (!_injections->satisfies_text_predicates(match, source)) {
+      continue;
+    }
+
+    std::string language = match.pattern_index < _pattern_languages.size()
+                           ? _pattern_languages[match.pattern_index]
+                           : std::string();
+    const TSNode *content = nullptr;
+    for (uint16_t i = 0; i < match.capture_count; ++i) {
+      const TSQueryCapture &capture = match.captures[i];
+      if (capture.index == _content_capture) {
+        content = &capture.node;
+      } else if (capture.index == _language_capture && language.empty()) {
+        // language names are ASCII
+        source->read_chars(ts_node_start_byte(capture.node), ts_node_end_byte(capture.node), text);
+        for (char16_t c : text) {
+          if (c < 0x80) language.push_back((char) c);
+        }
+      }
+    }
+
+    if (content == nullptr || language.empty() || _languages.find(language) == _languages.end()) {
+      continue;
+    }
+
+    dest[language].push_back({ts_node_start_point(*content),
+                              ts_node_end_point(*content),
+                              ts_node_start_byte(*content),
+                              ts_node_end_byte(*content)});
+  }
+}
+
+bool TSLayeredDocument::parse(UTF16String *source) {
+  TSTraceSection section("TSLayeredDocument#parse");
+  auto *host = _host->acquire(-1);
+  if (host == nullptr) {
+    return false;
+  }
+
+  TSTree *tree = ts_parser_parse(host->raw_parser(), _tree, ts_input_from_string(source));
+  _host->release(host);
+  if (tree == nullptr) {
+    return false;
+  }
+
+  if (_tree != nullptr) {
+    ts_tree_delete(_tree);
+  }
+  _tree = tree;
+
+  std::unordered_map<std::string, std::vector<TSRange>> injections;
+  collect_injections(source, injections);
+
+  // remove the layers of the languages which are not injected anymore
+  for (auto it = _layers.begin(); it != _layers.end();) {
+    if (injections.find((*it)->name) == injections.end()) {
+      if ((*it)->tree != nullptr) {
+        ts_tree_delete((*it)->tree);
+      }
+      delete *it;
+      it = _layers.erase(it);
+    } else {
+      ++it;
+    }
+  }
+
+  std::vector<TSDocumentLayer *> jobs;
+  for (auto &entry : injections) {
+    auto &ranges = entry.second;
+    normalize(ranges);
+
+    auto it = std::find_if(_layers.begin(), _layers.end(), [&](const TSDocumentLayer *layer) {
+      return layer->name == entry.first;
+    });
+
+    TSDocumentLayer *layer;
+    if (it == _layers.end()) {
+      layer = new TSDocumentLayer;
+      layer->name = entry.first;
+      layer->pool = _languages[entry.first];
+      _layers.push_back(layer);
+    } else {
+      layer = *it;
+    }
+
+    layer->reparsed = layer->tree == nullptr || layer->dirty || !same_bytes(layer->ranges, ranges);
+    layer->ranges = std::move(ranges);
+    layer->dirty = false;
+    if (layer->reparsed) {
+      jobs.push_back(layer);
+    }
+  }
+
+  std::sort(_layers.begin(), _layers.end(),
+            [](const TSDocumentLayer *lhs, const TSDocumentLayer *rhs) {
+              return lhs->name < rhs->name;
+            });
+
+  // each layer has its own parser, so the layers can be parsed in parallel
+  auto count = (uint32_t) jobs.size();
+  ts_run_parallel(count, count, [&](uint32_t worker_index, const TSNextJob &next_job) {
+    for (auto i = next_job(); i < count; i = next_job()) {
+      TSDocumentLayer *layer = jobs[i];
+      auto *parser = layer->pool->acquire(-1);
+      if (parser == nullptr) {
+        continue;
+      }
+
+      TSParser *ts_parser = parser->raw_parser();
+      TSTree *layer_tree = nullptr;
+      if (ts_parser_set_included_ranges(ts_parser, layer->ranges.data(),
+                                        (uint32_t) layer->ranges.size())) {
+        layer_tree = ts_parser_parse(ts_parser, layer->tree, ts_input_from_string(source));
+      }
+      layer->pool->release(parser);
+
+      if (layer->tree != nullptr) {
+        ts_tree_delete(layer->tree);
+      }
+      layer->tree = layer_tree;
+    }
+  });
+
+  return true;
+}
+
+const TSTree *TSLayeredDocument::tree() const {
+  return _tree;
+}
+
+const std::vector<TSDocumentLayer *> &TSLayeredDocument::layers() const {
+  return _layers;
+}
+
+TSLayeredDocument *as_document(JNIEnv *env, jlong pointer) {
+  req_nnp(env, pointer, "TSLayeredDocument pointer");
+  return (TSLayeredDocument *) pointer;
+}
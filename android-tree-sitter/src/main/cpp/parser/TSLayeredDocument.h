@@ -0,0 +1,139 @@
+/*
+ *  This file is part of android-tree-sitter.
+ *
+ *  android-tree-sitter library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  android-tree-sitter library is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *  along with android-tree-sitter.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef ANDROIDTREESITTER_TSLAYEREDDOCUMENT_H
+#define ANDROIDTREESITTER_TSLAYEREDDOCUMENT_H
+
+#include <jni.h>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "tree_sitter/api.h"
+
+class TSParserPool;
+class TSQueryInternal;
+class UTF16String;
+
+/**
+ * A layer of a TSLayeredDocument : the ranges of the document which are written in an injected
+ * language, and the syntax tree of those ranges.
+ */
+struct TSDocumentLayer {
+  std::string name;
+  TSParserPool *pool;
+  std::vector<TSRange> ranges;
+  TSTree *tree = nullptr;
+
+  // whether an edit intersected the ranges since the last parse
+  bool dirty = false;
+
+  // whether the layer was parsed by the last parse
+  bool reparsed = false;
+};
+
+/**
+ * The native object backing a Java TSLayeredDocument. This holds the syntax tree of a document in
+ * its host language, and one layer for each language injected in the document.
+ *
+ * Each parse reparses the host tree incrementally, runs the injection query on it and groups the
+ * injected ranges by language. Only the layers whose ranges changed or were edited are parsed
+ * again, in parallel on the shared thread pool, each with the included ranges of its language.
+ * The parsers of each language are kept in a pool between the parses.
+ *
+ * The injection query follows the conventions of the tree-sitter injection queries : the
+ * <code>@injection.content</code> capture (or <code>@content</code>) is the injected node, and
+ * the language is either the text of the <code>@injection.language</code> capture (or
+ * <code>@language</code>), or set with <code>(#set! injection.language "name")</code>. All the
+ * ranges of a language are parsed as a single combined layer. Only the injections of the host
+ * tree are processed, injections nested in the layers are not.
+ *
+ * Instances are not thread-safe.
+ */
+class TSLayeredDocument {
+
+ public:
+  /**
+   * Create a new document. The document holds a reference to the injection query.
+   */
+  TSLayeredDocument(const TSLanguage *host, TSQueryInternal *injections);
+
+  TSLayeredDocument(const TSLayeredDocument &) = delete;
+
+  TSLayeredDocument &operator=(const TSLayeredDocument &) = delete;
+
+  ~TSLayeredDocument();
+
+  /**
+   * Register the language with the given name, as it is named by the injection query. The
+   * injections of the languages which are not registered are ignored. If a language was already
+   * registered with the same name, its layer is removed and parsed again on the next parse.
+   */
+  void add_language(const std::string &name, const TSLanguage *language);
+
+  /**
+   * Apply the given edit to the host tree and the trees of the layers. A layer is parsed again on
+   * the next parse if the edit intersects its ranges.
+   */
+  void edit(const TSInputEdit &edit);
+
+  /**
+   * Parse the given source, which must be the source of the previous parse with the edits applied.
+   *
+   * @return Whether the host tree was parsed. If a layer cannot be parsed, the layer is kept
+   *         without a tree.
+   */
+  bool parse(UTF16String *source);
+
+  /**
+   * @return The host tree, or <code>nullptr</code> if the document has not been parsed yet. The
+   *         tree is owned by the document.
+   */
+  const TSTree *tree() const;
+
+  /**
+   * @return The layers, sorted by their language name.
+   */
+  const std::vector<TSDocumentLayer *> &layers() const;
+
+ private:
+  TSParserPool *_host;
+  TSQueryInternal *_injections;
+  TSQueryCursor *_cursor;
+  TSTree *_tree;
+  std::unordered_map<std::string, TSParserPool *> _languages;
+  std::vector<TSDocumentLayer *> _layers;
+
+  uint32_t _content_capture;
+  uint32_t _language_capture;
+
+  // the languages set with #set! for each pattern, if any
+  std::vector<std::string> _pattern_languages;
+
+  void compile_injections();
+
+  void collect_injections(const UTF16String *source,
+                          std::unordered_map<std::string, std::vector<TSRange>> &dest);
+
+  void remove_layer(const std::string &name);
+};
+
+TSLayeredDocument *as_document(JNIEnv *env, jlong pointer);
+
+#endif //ANDROIDTREESITTER_TSLAYEREDDOCUMENT_H
@@ -0,0 +1,258 @@
+/*
+ *  This file is part of android-tree-sitter.
+ *
+ *  android-tree-sitter library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  android-tree-sitter library is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *  along with android-tree-sitter.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef ANDROIDTREESITTER_TSPARSERINTERNAL_H
+#define ANDROIDTREESITTER_TSPARSERINTERNAL_H
+
+#include <jni.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "tree_sitter/api.h"
+#include "../utils/ts_exceptions.h"
+#include "../utils/ts_misc.h"
+#include "../utils/ts_instrumentation.h"
+
+// tree-sitter reads the cancellation flag through a plain `size_t` pointer
+static_assert(sizeof(std::atomic<size_t>) == sizeof(size_t),
+              "std::atomic<size_t> must have the same layout as size_t");
+static_assert(std::atomic<size_t>::is_always_lock_free,
+              "std::atomic<size_t> must be lock-free");
+
+/**
+ * `TSParserInternal` stores the actual tree sitter parser instance along
+ * with the state of the current parse. The cancellation flag is embedded in
+ * this object and is installed in the parser once, so starting, cancelling and
+ * finishing a parse never allocate or take a lock.
+ */
+class TSParserInternal {
+ public:
+
+  /**
+   * No parse is in progress.
+   */
+  static constexpr int STATE_IDLE = 0;
+
+  /**
+   * A parse is in progress.
+   */
+  static constexpr int STATE_PARSING = 1;
+
+  /**
+   * A parse is in progress and the cancellation flag is being set.
+   */
+  static constexpr int STATE_CANCELLING = 2;
+
+  /**
+   * A parse is in progress and has been requested to be cancelled.
+   */
+  static constexpr int STATE_CANCELLED = 3;
+
+  TSParserInternal() {
+    parser = ts_parser_new();
+    ts_parser_set_cancellation_flag(parser, (const size_t *) &cancellation_flag);
+  }
+
+  ~TSParserInternal() {
+    ts_parser_delete(parser);
+    parser = nullptr;
+  }
+
+  TSParserInternal(const TSParserInternal &) = delete;
+
+  TSParserInternal &operator=(const TSParserInternal &) = delete;
+
+  TSParser *getParser(JNIEnv *env) {
+    if (check_destroyed(env)) {
+      return nullptr;
+    }
+
+    return this->parser;
+  }
+
+  /**
+   * Get the tree sitter parser without checking whether this instance has been
+   * destroyed. For native callers without a JNIEnv, which own this instance.
+   */
+  TSParser *raw_parser() const {
+    return this->parser;
+  }
+
+  bool begin_round(JNIEnv *env) {
+    if (check_destroyed(env)) {
+      return false;
+    }
+
+    int expected = STATE_IDLE;
+    if (!state.compare_exchange_strong(expected, STATE_PARSING,
+                                       std::memory_order_acq_rel)) {
+      throw_illegal_state(env,
+                          "Parser is already parsing another syntax tree! You must cancel the current parse first!");
+      return false;
+    }
+
+    // set the cancellation flag to '0' to indicate that the parser should continue parsing
+    cancellation_flag.store(0, std::memory_order_relaxed);
+    bytes_read.store(0, std::memory_order_relaxed);
+    round_start_ns = TSStats::enabled() ? TSStats::now() : 0;
+    return true;
+  }
+
+  /**
+   * End the current parse, which produced the given tree.
+   */
+  void end_round(__TS_ATTR_UNUSED JNIEnv *env, const TSTree *tree) {
+    if (round_start_ns != 0) {
+      // tree-sitter returns no tree if the parse was cancelled or timed out
+      bool cancelled = tree == nullptr
+          && state.load(std::memory_order_acquire) != STATE_PARSING;
+      bool timed_out = tree == nullptr && !cancelled
+          && ts_parser_timeout_micros(parser) != 0;
+      stats.record(TSStats::now() - round_start_ns, get_bytes_read(),
+                   cancelled, timed_out);
+    }
+
+    // a concurrent cancellation request may be writing the cancellation flag,
+    // which takes only a few instructions; wait for it so that the write does
+    // not cancel the next parse
+    int current = state.load(std::memory_order_acquire);
+    while (current == STATE_CANCELLING) {
+      current = state.load(std::memory_order_acquire);
+    }
+
+    // the pooled parses do not go through begin_round, do not leave the flag
+    // set for them
+    clear_cancellation();
+    state.store(STATE_IDLE, std::memory_order_release);
+  }
+
+  /**
+   * Clear the cancellation flag, so that a cancellation requested for an
+   * earlier parse does not cancel the next one. Must only be called while no
+   * parse is in progress.
+   */
+  void clear_cancellation() {
+    cancellation_flag.store(0, std::memory_order_relaxed);
+  }
+
+  /**
+   * Request the current parse to be cancelled.
+   *
+   * @return <code>true</code> if a parse was in progress and has been requested
+   *         to be cancelled, <code>false</code> otherwise.
+   */
+  bool request_cancellation() {
+    int expected = STATE_PARSING;
+    if (!state.compare_exchange_strong(expected, STATE_CANCELLING,
+                                       std::memory_order_acq_rel)) {
+      // already cancelled by another caller
+      return expected == STATE_CANCELLING || expected == STATE_CANCELLED;
+    }
+
+    // set the cancellation flag to a non-zero value to indicate that the parse
+    // operation has been cancelled
+    cancellation_flag.store(1, std::memory_order_relaxed);
+    state.store(STATE_CANCELLED, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * Get the state of the parser, one of the <code>STATE_*</code> constants.
+   */
+  int get_state() const {
+    return state.load(std::memory_order_acquire);
+  }
+
+  /**
+   * Get the number of bytes of the source read by the current parse, or by the
+   * last parse if no parse is in progress. This only counts the inputs wrapped
+   * by track_progress.
+   */
+  uint32_t get_bytes_read() const {
+    return bytes_read.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * Wrap the given input so that the bytes read by the parser are reported by
+   * get_bytes_read. The returned input is valid until the next call to this
+   * function.
+   */
+  TSInput track_progress(TSInput input) {
+    tracked_input = input;
+    return {this, read_tracked, input.encoding};
+  }
+
+  /**
+   * The stats of the parses started with begin_round, recorded only while the
+   * stats are enabled.
+   */
+  TSParserStats &get_stats() {
+    return stats;
+  }
+
+ private:
+  std::atomic<size_t> cancellation_flag{0};
+  std::atomic<int> state{STATE_IDLE};
+  std::atomic<uint32_t> bytes_read{0};
+  TSInput tracked_input{};
+  uint64_t round_start_ns = 0;
+  TSParserStats stats;
+
+  TSParser *parser;
+
+  /**
+   * The maximum number of bytes handed to the lexer at once by read_tracked.
+   * The inputs return everything up to the gap or the end of the source, so
+   * chunks are split to make the lexer come back for the next one after at
+   * most this many bytes.
+   */
+  static constexpr uint32_t PROGRESS_CHUNK_SIZE = 4096;
+
+  static const char *read_tracked(void *payload,
+                                  uint32_t byte_index,
+                                  TSPoint position,
+                                  uint32_t *bytes) {
+    auto *self = (TSParserInternal *) payload;
+    auto &input = self->tracked_input;
+    auto chunk = input.read(input.payload, byte_index, position, bytes);
+    if (*bytes > PROGRESS_CHUNK_SIZE) {
+      *bytes = PROGRESS_CHUNK_SIZE;
+    }
+
+    // the lexer may go back to an earlier position, only report the furthest
+    // position requested so far. The lexer reads at the end of the source to
+    // detect its end, so a complete parse reports the whole source.
+    if (byte_index > self->bytes_read.load(std::memory_order_relaxed)) {
+      self->bytes_read.store(byte_index, std::memory_order_relaxed);
+    }
+
+    return chunk;
+  }
+
+  bool check_destroyed(JNIEnv *env) {
+    if (parser == nullptr) {
+      throw_illegal_state(env, "TSParserInternal has already been destroyed");
+      return true;
+    }
+
+    return false;
+  }
+};
+
+#endif //ANDROIDTREESITTER_TSPARSERINTERNAL_H
@@ -0,0 +1,154 @@
+/*
+ *  This file is part of android-tree-sitter.
+ *
+ *  android-tree-sitter library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  android-tree-sitter library is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *  along with android-tree-sitter.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include "TSParserPool.h"
+
+#include <chrono>
+
+#include "TSParserInternal.h"
+
+TSParserPool::TSParserPool(const TSLanguage *language, uint32_t max_size)
+    : _language(language),
+      _max_size(max_size == 0 ? 1 : max_size),
+      _size(0),
+      _waiters(0),
+      _destroyed(false) {
+}
+
+TSParserPool::~TSParserPool() = default;
+
+bool TSParserPool::can_delete() const {
+  return _destroyed && _size == 0 && _waiters == 0;
+}
+
+TSParserInternal *TSParserPool::new_parser() const {
+  auto *parser = new TSParserInternal;
+  ts_parser_set_language(parser->raw_parser(), _language);
+  return parser;
+}
+
+TSParserInternal *TSParserPool::acquire(int64_t timeout_millis) {
+  std::unique_lock<std::mutex> lock(_lock);
+
+  auto can_acquire = [this] {
+    return _destroyed || !_idle.empty() || _size < _max_size;
+  };
+
+  bool acquired;
+  ++_waiters;
+  if (timeout_millis < 0) {
+    _available.wait(lock, can_acquire);
+    acquired = true;
+  } else {
+    acquired = _available.wait_for(lock,
+                                   std::chrono::milliseconds(timeout_millis),
+                                   can_acquire);
+  }
+  --_waiters;
+
+  if (_destroyed) {
+    // the last one out deletes the pool
+    bool delete_pool = can_delete();
+    lock.unlock();
+    if (delete_pool) {
+      delete this;
+    }
+    return nullptr;
+  }
+
+  if (!acquired) {
+    return nullptr;
+  }
+
+  if (!_idle.empty()) {
+    auto *parser = _idle.back();
+    _idle.pop_back();
+    return parser;
+  }
+
+  // reserve the slot and create the parser without holding the lock
+  ++_size;
+  lock.unlock();
+  return new_parser();
+}
+
+void TSParserPool::release(TSParserInternal *parser) {
+  TSParser *ts_parser = parser->raw_parser();
+  ts_parser_reset(ts_parser);
+  ts_parser_set_language(ts_parser, _language);
+  ts_parser_set_included_ranges(ts_parser, nullptr, 0);
+  ts_parser_set_timeout_micros(ts_parser, 0);
+  parser->clear_cancellation();
+
+  bool delete_pool = false;
+  {
+    std::lock_guard<std::mutex> guard(_lock);
+    if (!_destroyed) {
+      _idle.push_back(parser);
+      _available.notify_one();
+      return;
+    }
+
+    --_size;
+    delete_pool = can_delete();
+  }
+
+  delete parser;
+  if (delete_pool) {
+    delete this;
+  }
+}
+
+void TSParserPool::destroy() {
+  std::vector<TSParserInternal *> idle;
+  bool delete_pool;
+  {
+    std::lock_guard<std::mutex> guard(_lock);
+    _destroyed = true;
+    idle.swap(_idle);
+    _size -= (uint32_t) idle.size();
+    delete_pool = can_delete();
+    _available.notify_all();
+  }
+
+  for (auto *parser: idle) {
+    delete parser;
+  }
+
+  if (delete_pool) {
+    delete this;
+  }
+}
+
+const TSLanguage *TSParserPool::language() const {
+  return _language;
+}
+
+uint32_t TSParserPool::max_size() const {
+  return _max_size;
+}
+
+uint32_t TSParserPool::size() {
+  std::lock_guard<std::mutex> guard(_lock);
+  return _size;
+}
+
+uint32_t TSParserPool::idle_count() {
+  std::lock_guard<std::mutex> guard(_lock);
+  return (uint32_t) _idle.size();
+}
@@ -0,0 +1,112 @@
+/*
+ *  This file is part of android-tree-sitter.
+ *
+ *  android-tree-sitter library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  android-tree-sitter library is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *  along with android-tree-sitter.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef ANDROIDTREESITTER_TSPARSERPOOL_H
+#define ANDROIDTREESITTER_TSPARSERPOOL_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "tree_sitter/api.h"
+
+class TSParserInternal;
+
+/**
+ * A pool of parsers for a single language. Idle parsers are handed out to
+ * callers and returned to the pool when they are released, so that their parse
+ * stacks and lexer state are reused instead of being reallocated for every
+ * parse. New parsers are created on demand until the configured maximum size is
+ * reached, after which callers wait for a parser to be released.
+ *
+ * All the functions are thread-safe.
+ */
+class TSParserPool {
+
+ public:
+  TSParserPool(const TSLanguage *language, uint32_t max_size);
+
+  TSParserPool(const TSParserPool &) = delete;
+
+  TSParserPool &operator=(const TSParserPool &) = delete;
+
+  /**
+   * Acquire a parser from the pool.
+   *
+   * @param timeout_millis The maximum time to wait for a parser to be released
+   *                       if the pool has reached its maximum size. 0 to
+   *                       return immediately and a negative value to wait
+   *                       indefinitely.
+   * @return The parser, or <code>nullptr</code> if no parser was available
+   *         within the timeout or the pool has been destroyed.
+   */
+  TSParserInternal *acquire(int64_t timeout_millis);
+
+  /**
+   * Return the given parser to the pool. The parser is reset to parse a new
+   * document with the language of the pool, without any included ranges or
+   * timeout.
+   */
+  void release(TSParserInternal *parser);
+
+  /**
+   * Destroy this pool. The idle parsers are deleted immediately, the parsers
+   * which are currently acquired are deleted when they are released. The pool
+   * itself is deleted once all the parsers have been released, it must not be
+   * used by the caller after this call.
+   */
+  void destroy();
+
+  const TSLanguage *language() const;
+
+  uint32_t max_size() const;
+
+  /**
+   * @return The number of parsers created by this pool (idle and acquired).
+   */
+  uint32_t size();
+
+  /**
+   * @return The number of idle parsers.
+   */
+  uint32_t idle_count();
+
+ private:
+  const TSLanguage *_language;
+  const uint32_t _max_size;
+
+  std::mutex _lock;
+  std::condition_variable _available;
+  std::vector<TSParserInternal *> _idle;
+  uint32_t _size;
+  uint32_t _waiters;
+  bool _destroyed;
+
+  ~TSParserPool();
+
+  /**
+   * Whether the pool has been destroyed and is no longer referenced by any
+   * parser or waiting caller. Must be called with the lock held.
+   */
+  bool can_delete() const;
+
+  TSParserInternal *new_parser() const;
+};
+
+#endif //ANDROIDTREESITTER_TSPARSERPOOL_H
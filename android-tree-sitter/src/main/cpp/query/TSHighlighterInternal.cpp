@@ -0,0 +1,426 @@
+/*
+ *  This file is part of android-tree-sitter.
+ *
+ *  android-tree-sitter library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  android-tree-sitter library is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *  along with android-tree-sitter.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include "TSHighlighterInternal.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iterator>
+
+#include "TSQueryInternal.h"
+#include "../utils/ts_allocator.h"
+#include "../utils/ts_preconditions.h"
+#include "../utils/ts_instrumentation.h"
+
+typedef std::pair<uint32_t, uint32_t> ByteRange;
+
+bool HighlightSpan::operator<(const HighlightSpan &rhs) const {
+  if (start_byte != rhs.start_byte) return start_byte < rhs.start_byte;
+  if (end_byte != rhs.end_byte) return end_byte < rhs.end_byte;
+  if (capture_id != rhs.capture_id) return capture_id < rhs.capture_id;
+  return pattern_index < rhs.pattern_index;
+}
+
+bool HighlightSpan::operator==(const HighlightSpan &rhs) const {
+  return start_byte == rhs.start_byte && end_byte == rhs.end_byte
+      && capture_id == rhs.capture_id && pattern_index == rhs.pattern_index;
+}
+
+/**
+ * Whether the span [start, end) intersects the range. Empty spans intersect
+ * the range if they are within it.
+ */
+static bool intersects(uint32_t start, uint32_t end, const ByteRange &range) {
+  return start < range.second && (end > range.first || start >= range.first);
+}
+
+/**
+ * Map a byte offset in the old text to the new text, the same way ts_tree_edit
+ * moves the positions of the nodes.
+ */
+static uint32_t shift(uint32_t offset, const TSInputEdit &edit) {
+  if (offset >= edit.old_end_byte) {
+    return offset - edit.old_end_byte + edit.new_end_byte;
+  }
+  if (offset > edit.start_byte) {
+    return std::min(offset, edit.new_end_byte);
+  }
+  return offset;
+}
+
+static void pack_span(std::vector<jint> &dest, const HighlightSpan &span) {
+  dest.push_back((jint) span.start_byte);
+  dest.push_back((jint) span.end_byte);
+  dest.push_back((jint) span.capture_id);
+  dest.push_back((jint) span.pattern_index);
+}
+
+TSHighlighterInternal::TSHighlighterInternal(TSQueryInternal *query)
+    : _query(query),
+      _cursor(ts_query_cursor_new()),
+      _tree(nullptr),
+      _shift_index(0),
+      _shift(0) {
+  _query->retain();
+}
+
+TSHighlighterInternal::~TSHighlighterInternal() {
+  if (_tree != nullptr) {
+    ts_tree_delete(_tree);
+  }
+  ts_query_cursor_delete(_cursor);
+  _query->release();
+}
+
+static bool is_long(const HighlightSpan &span, uint32_t max_bytes) {
+  return span.end_byte - span.start_byte > max_bytes;
+}
+
+HighlightSpan TSHighlighterInternal::span_at(size_t index) const {
+  HighlightSpan span = _spans[index];
+  if (index >= _shift_index) {
+    span.start_byte += _shift;
+    span.end_byte += _shift;
+  }
+  return span;
+}
+
+size_t TSHighlighterInternal::lower_bound(uint32_t start_byte, size_t from) const {
+  size_t low = from;
+  size_t high = _spans.size();
+  while (low < high) {
+    size_t mid = low + (high - low) / 2;
+    uint32_t start = _spans[mid].start_byte + (mid >= _shift_index ? _shift : 0);
+    if (start < start_byte) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  return low;
+}
+
+void TSHighlighterInternal::move_shift(size_t index) {
+  if (_shift == 0) {
+    _shift_index = index;
+    return;
+  }
+
+  for (; _shift_index < index; ++_shift_index) {
+    _spans[_shift_index].start_byte += _shift;
+    _spans[_shift_index].end_byte += _shift;
+  }
+
+  for (; _shift_index > index; --_shift_index) {
+    _spans[_shift_index - 1].start_byte -= _shift;
+    _spans[_shift_index - 1].end_byte -= _shift;
+  }
+
+  if (_shift_index == _spans.size()) {
+    _shift = 0;
+  }
+}
+
+void TSHighlighterInternal::splice(size_t first,
+                                   size_t last,
+                                   const std::vector<HighlightSpan> &spans) {
+  size_t count = last - first;
+  size_t copied = std::min(count, spans.size());
+  std::copy(spans.begin(), spans.begin() + (std::ptrdiff_t) copied,
+            _spans.begin() + (std::ptrdiff_t) first);
+  if (copied < count) {
+    _spans.erase(_spans.begin() + (std::ptrdiff_t) (first + copied),
+                 _spans.begin() + (std::ptrdiff_t) last);
+    _shift_index -= count - copied;
+  } else if (copied < spans.size()) {
+    _spans.insert(_spans.begin() + (std::ptrdiff_t) last,
+                  spans.begin() + (std::ptrdiff_t) copied, spans.end());
+    _shift_index += spans.size() - copied;
+  }
+}
+
+void TSHighlighterInternal::edit(const TSInputEdit &edit) {
+  if (_tree == nullptr) {
+    return;
+  }
+
+  ts_tree_edit(_tree, &edit);
+
+  // the spans which start before the edited range and end before it are not
+  // affected, and the spans which start after it are moved as a whole by
+  // adding the difference to the pending shift, so that only the spans in
+  // between are shifted here
+  uint32_t first_start = edit.start_byte >= LONG_SPAN_BYTES
+      ? edit.start_byte - LONG_SPAN_BYTES + 1 : 0;
+  size_t first = lower_bound(first_start);
+  size_t last = lower_bound(edit.old_end_byte, first);
+  move_shift(last);
+  if (last < _spans.size()) {
+    _shift += edit.new_end_byte - edit.old_end_byte;
+  }
+
+  for (size_t i = first; i < last; ++i) {
+    _spans[i].start_byte = shift(_spans[i].start_byte, edit);
+    _spans[i].end_byte = shift(_spans[i].end_byte, edit);
+  }
+
+  // spans which started inside the edited range may now start at the same
+  // offset as the spans after it
+  size_t sorted = lower_bound(edit.new_end_byte + 1, last);
+  move_shift(sorted);
+  auto begin = _spans.begin() + (std::ptrdiff_t) first;
+  auto end = _spans.begin() + (std::ptrdiff_t) sorted;
+  std::sort(begin, end);
+
+  for (auto &span : _long_spans) {
+    span.start_byte = shift(span.start_byte, edit);
+    span.end_byte = shift(span.end_byte, edit);
+  }
+
+  // the spans which contain the edit may have grown too long
+  auto long_begin = std::stable_partition(begin, end, [](const HighlightSpan &span) {
+    return !is_long(span, LONG_SPAN_BYTES);
+  });
+  if (long_begin != end) {
+    _long_spans.insert(_long_spans.end(), long_begin, end);
+    _shift_index -= (size_t) (end - long_begin);
+    _spans.erase(long_begin, end);
+  }
+
+  if (!std::is_sorted(_long_spans.begin(), _long_spans.end())) {
+    std::sort(_long_spans.begin(), _long_spans.end());
+  }
+
+  for (auto &range : _edited) {
+    range.first = shift(range.first, edit);
+    range.second = shift(range.second, edit);
+  }
+  _edited.emplace_back(edit.start_byte, edit.new_end_byte);
+}
+
+void TSHighlighterInternal::collect_ranges(const TSTree *tree, std::vector<ByteRange> &ranges) {
+  uint32_t count = 0;
+  TSRange *changed = ts_tree_get_changed_ranges(_tree, tree, &count);
+  std::vector<ByteRange> raw(_edited);
+  for (uint32_t i = 0; i < count; ++i) {
+    raw.emplace_back(changed[i].start_byte, changed[i].end_byte);
+  }
+  TSAllocator::free(changed);
+
+  // expand each range to its enclosing node, and to the parent of that node so
+  // that the patterns which match the siblings of the node are found as well
+  TSNode root = ts_tree_root_node(tree);
+  for (auto &range : raw) {
+    TSNode node = ts_node_descendant_for_byte_range(root, range.first, range.second);
+    TSNode parent = ts_node_parent(node);
+    if (!ts_node_is_null(parent) && !ts_node_eq(parent, root)) {
+      node = parent;
+    }
+    range.first = std::min(range.first, ts_node_start_byte(node));
+    range.second = std::max(range.second, ts_node_end_byte(node));
+  }
+
+  std::sort(raw.begin(), raw.end());
+  ranges.clear();
+  for (const auto &range : raw) {
+    if (!ranges.empty() && range.first <= ranges.back().second) {
+      ranges.back().second = std::max(ranges.back().second, range.second);
+    } else {
+      ranges.push_back(range);
+    }
+  }
+}
+
+void TSHighlighterInternal::capture(TSNode root,
+                                    uint32_t start,
+                                    uint32_t end,
+                                    const UTF16String *source,
+                                    std::vector<HighlightSpan> &dest) {
+  ByteRange range(start, end);
+  ts_query_cursor_set_byte_range(_cursor, start, end);
+  ts_query_cursor_exec(_cursor, _query->query(), root);
+
+  TSQueryMatch match;
+  uint32_t capture_index;
+  while (_query->next_capture(_cursor, source, &match, &capture_index)) {
+    const TSQueryCapture &capture = match.captures[capture_index];
+    uint32_t start_byte = ts_node_start_byte(capture.node);
+    uint32_t end_byte = ts_node_end_byte(capture.node);
+
+    // the other captures of a match may be outside the range
+    if (intersects(start_byte, end_byte, range)) {
+      dest.push_back({start_byte, end_byte, capture.index, match.pattern_index});
+    }
+  }
+}
+
+void TSHighlighterInternal::update(const TSTree *tree,
+                                   const UTF16String *source,
+                                   std::vector<jint> &diff) {
+  TSTraceSection section("TSHighlighter#update");
+  std::vector<ByteRange> ranges;
+  if (_tree == nullptr) {
+    ranges.emplace_back(0, UINT32_MAX);
+  } else {
+    collect_ranges(tree, ranges);
+  }
+
+  TSNode root = ts_tree_root_node(tree);
+  std::vector<HighlightSpan> removed;
+  std::vector<HighlightSpan> added;
+  std::vector<HighlightSpan> added_long;
+  std::vector<HighlightSpan> captured;
+  std::vector<HighlightSpan> kept;
+  std::vector<HighlightSpan> window;
+
+  // the short spans which intersect a range start at most LONG_SPAN_BYTES
+  // before it, so each range only replaces a window of the spans. The ranges
+  // whose windows overlap are replaced together.
+  size_t next_group = 0;
+  while (next_group < ranges.size()) {
+    size_t group_end = next_group + 1;
+    while (group_end < ranges.size()
+        && ranges[group_end].first < (uint64_t) ranges[group_end - 1].second + LONG_SPAN_BYTES) {
+      ++group_end;
+    }
+
+    captured.clear();
+    for (size_t i = next_group; i < group_end; ++i) {
+      capture(root, ranges[i].first, ranges[i].second, source, captured);
+    }
+
+    // a span may intersect more than one range
+    std::sort(captured.begin(), captured.end());
+    captured.erase(std::unique(captured.begin(), captured.end()), captured.end());
+
+    uint32_t group_start = ranges[next_group].first;
+    size_t first = lower_bound(group_start >= LONG_SPAN_BYTES
+                                   ? group_start - LONG_SPAN_BYTES + 1 : 0);
+    size_t last = lower_bound(ranges[group_end - 1].second, first);
+    move_shift(last);
+
+    // the ranges are sorted and disjoint, and the spans are sorted by their
+    // start, so a range which ends before a span also ends before the next
+    // spans
+    kept.clear();
+    size_t next_range = next_group;
+    for (size_t i = first; i < last; ++i) {
+      const auto &span = _spans[i];
+      while (next_range < group_end && ranges[next_range].second <= span.start_byte) {
+        ++next_range;
+      }
+
+      if (next_range < group_end
+          && intersects(span.start_byte, span.end_byte, ranges[next_range])) {
+        removed.push_back(span);
+      } else {
+        kept.push_back(span);
+      }
+    }
+
+    window.clear();
+    auto short_end = captured.begin();
+    for (const auto &span : captured) {
+      if (is_long(span, LONG_SPAN_BYTES)) {
+        added_long.push_back(span);
+      } else {
+        *short_end++ = span;
+      }
+    }
+    std::merge(kept.begin(), kept.end(), captured.begin(), short_end,
+               std::back_inserter(window));
+    added.insert(added.end(), captured.begin(), short_end);
+    splice(first, last, window);
+
+    next_group = group_end;
+  }
+
+  // the long spans are few, check all of them
+  std::sort(added_long.begin(), added_long.end());
+  added_long.erase(std::unique(added_long.begin(), added_long.end()), added_long.end());
+  kept.clear();
+  for (const auto &span : _long_spans) {
+    bool hit = false;
+    for (const auto &range : ranges) {
+      if (intersects(span.start_byte, span.end_byte, range)) {
+        hit = true;
+        break;
+      }
+    }
+
+    if (hit) {
+      removed.push_back(span);
+    } else {
+      kept.push_back(span);
+    }
+  }
+  _long_spans.clear();
+  std::merge(kept.begin(), kept.end(), added_long.begin(), added_long.end(),
+             std::back_inserter(_long_spans));
+  added.insert(added.end(), added_long.begin(), added_long.end());
+
+  std::sort(removed.begin(), removed.end());
+  std::sort(added.begin(), added.end());
+
+  // only report the spans which actually changed
+  std::vector<HighlightSpan> removed_only;
+  std::vector<HighlightSpan> added_only;
+  std::set_difference(removed.begin(), removed.end(), added.begin(), added.end(),
+                      std::back_inserter(removed_only));
+  std::set_difference(added.begin(), added.end(), removed.begin(), removed.end(),
+                      std::back_inserter(added_only));
+
+  diff.clear();
+  diff.reserve(2 + (removed_only.size() + added_only.size()) * PACKED_SPAN_SIZE);
+  diff.push_back((jint) removed_only.size());
+  diff.push_back((jint) added_only.size());
+  for (const auto &span : removed_only) {
+    pack_span(diff, span);
+  }
+  for (const auto &span : added_only) {
+    pack_span(diff, span);
+  }
+
+  if (_tree != nullptr) {
+    ts_tree_delete(_tree);
+  }
+  _tree = ts_tree_copy(tree);
+  _edited.clear();
+}
+
+void TSHighlighterInternal::pack_spans(std::vector<jint> &dest) const {
+  dest.clear();
+  dest.reserve((_spans.size() + _long_spans.size()) * PACKED_SPAN_SIZE);
+  size_t next_long = 0;
+  for (size_t i = 0; i < _spans.size(); ++i) {
+    HighlightSpan span = span_at(i);
+    while (next_long < _long_spans.size() && _long_spans[next_long] < span) {
+      pack_span(dest, _long_spans[next_long++]);
+    }
+    pack_span(dest, span);
+  }
+
+  for (; next_long < _long_spans.size(); ++next_long) {
+    pack_span(dest, _long_spans[next_long]);
+  }
+}
+
+TSHighlighterInternal *as_highlighter(JNIEnv *env, jlong pointer) {
+  req_nnp(env, pointer, "TSHighlighter pointer");
+  return (TSHighlighterInternal *) pointer;
+}
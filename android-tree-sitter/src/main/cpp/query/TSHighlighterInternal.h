@@ -0,0 +1,164 @@
+/*
+ *  This file is part of android-tree-sitter.
+ *
+ *  android-tree-sitter library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  android-tree-sitter library is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *  along with android-tree-sitter.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef ANDROIDTREESITTER_TSHIGHLIGHTERINTERNAL_H
+#define ANDROIDTREESITTER_TSHIGHLIGHTERINTERNAL_H
+
+#include <jni.h>
+#include <cstdint>
+#include <vector>
+
+#include "tree_sitter/api.h"
+
+class TSQueryInternal;
+class UTF16String;
+
+// The number of jint values in a packed highlight span record :
+// start byte, end byte, capture id, pattern index
+// Must be kept in sync with TSHighlightSpans.RECORD_SIZE
+#define PACKED_SPAN_SIZE 4
+
+/**
+ * A highlighted span of the source, i.e. a capture of the highlight query.
+ */
+struct HighlightSpan {
+  uint32_t start_byte;
+  uint32_t end_byte;
+  uint32_t capture_id;
+  uint32_t pattern_index;
+
+  bool operator<(const HighlightSpan &rhs) const;
+
+  bool operator==(const HighlightSpan &rhs) const;
+};
+
+/**
+ * The native object backing a Java TSHighlighter. This holds a highlight query, the tree that was
+ * last highlighted and the spans of that tree, sorted by their start byte.
+ *
+ * After each reparse, the captures are only executed inside the ranges whose syntactic structure
+ * changed and the ranges which were edited, each expanded to its enclosing node. The spans which
+ * intersect those ranges are replaced, so the cost of an update is proportional to the size of the
+ * edit instead of the size of the file.
+ *
+ * Most spans are short, and are stored in a vector whose tail is shifted lazily : the spans after
+ * the shift index must still be moved by the pending shift, which is only applied when the shift
+ * index moves. An edit then only touches the spans between the previous edit and this one, and
+ * the spans near the edit are found by binary search, as a short span which ends after an offset
+ * starts at most LONG_SPAN_BYTES before it. The few long spans, like the block comments, are kept
+ * in a separate vector which is shifted eagerly.
+ *
+ * Instances are not thread-safe.
+ */
+class TSHighlighterInternal {
+
+ public:
+  /**
+   * Create a new highlighter for the given query. The highlighter holds a reference to the query.
+   */
+  explicit TSHighlighterInternal(TSQueryInternal *query);
+
+  TSHighlighterInternal(const TSHighlighterInternal &) = delete;
+
+  TSHighlighterInternal &operator=(const TSHighlighterInternal &) = delete;
+
+  ~TSHighlighterInternal();
+
+  /**
+   * Apply the given edit to the last highlighted tree and shift the spans accordingly. This must
+   * be called with the same edits that are applied to the tree which is reparsed.
+   */
+  void edit(const TSInputEdit &edit);
+
+  /**
+   * Update the spans for the given tree, which must have been reparsed from the last highlighted
+   * tree (or be the first tree to highlight).
+   *
+   * @param tree The new tree. The highlighter keeps a copy of the tree.
+   * @param source The source of the tree, used to evaluate the text predicates of the query. If
+   *               <code>nullptr</code>, the text predicates are not evaluated.
+   * @param diff The vector to write the diff to : the number of removed spans, the number of added
+   *             spans, followed by the removed and the added spans, each sorted and packed as
+   *             PACKED_SPAN_SIZE values.
+   */
+  void update(const TSTree *tree, const UTF16String *source, std::vector<jint> &diff);
+
+  /**
+   * Pack all the current spans into the given vector.
+   */
+  void pack_spans(std::vector<jint> &dest) const;
+
+ private:
+  /**
+   * The spans which are longer than this are stored in _long_spans.
+   */
+  static constexpr uint32_t LONG_SPAN_BYTES = 256;
+
+  TSQueryInternal *_query;
+  TSQueryCursor *_cursor;
+  TSTree *_tree;
+
+  // the spans of at most LONG_SPAN_BYTES, sorted. The spans at or after
+  // _shift_index are stored without _shift, which wraps around for negative
+  // shifts.
+  std::vector<HighlightSpan> _spans;
+  size_t _shift_index;
+  uint32_t _shift;
+
+  // the longer spans, sorted
+  std::vector<HighlightSpan> _long_spans;
+
+  // the ranges edited since the last update, as [start, end) pairs in the
+  // coordinates of the new tree
+  std::vector<std::pair<uint32_t, uint32_t>> _edited;
+
+  /**
+   * Get the span at the given index of _spans, with the pending shift applied.
+   */
+  HighlightSpan span_at(size_t index) const;
+
+  /**
+   * Get the index of the first span of _spans, at or after the given index,
+   * which starts at or after the given byte.
+   */
+  size_t lower_bound(uint32_t start_byte, size_t from = 0) const;
+
+  /**
+   * Move the shift index to the given index, applying the pending shift to the
+   * spans before it and removing it from the spans after it.
+   */
+  void move_shift(size_t index);
+
+  /**
+   * Replace the spans of _spans in [first, last) with the given spans. The
+   * shift index must not be before last.
+   */
+  void splice(size_t first, size_t last, const std::vector<HighlightSpan> &spans);
+
+  void collect_ranges(const TSTree *tree, std::vector<std::pair<uint32_t, uint32_t>> &ranges);
+
+  void capture(TSNode root,
+               uint32_t start,
+               uint32_t end,
+               const UTF16String *source,
+               std::vector<HighlightSpan> &dest);
+};
+
+TSHighlighterInternal *as_highlighter(JNIEnv *env, jlong pointer);
+
+#endif //ANDROIDTREESITTER_TSHIGHLIGHTERINTERNAL_H
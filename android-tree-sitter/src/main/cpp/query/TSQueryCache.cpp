@@ -0,0 +1,163 @@
+/*
+ *  This file is part of android-tree-sitter.
+ *
+ *  android-tree-sitter library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  android-tree-sitter library is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *  along with android-tree-sitter.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include "TSQueryCache.h"
+
+#include <functional>
+#include <list>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "TSQueryInternal.h"
+
+struct QueryKey {
+  const TSLanguage *language;
+
+  // points to the source owned by the entry, or to the source being looked up
+  std::string_view source;
+
+  bool operator==(const QueryKey &rhs) const {
+    return language == rhs.language && source == rhs.source;
+  }
+};
+
+struct QueryKeyHash {
+  size_t operator()(const QueryKey &key) const {
+    size_t hash = std::hash<std::string_view>()(key.source);
+    return hash ^ (std::hash<const void *>()(key.language) + 0x9e3779b9 +
+                   (hash << 6) + (hash >> 2));
+  }
+};
+
+struct CacheEntry {
+  const TSLanguage *language;
+  std::string source;
+  TSQueryInternal *query;
+};
+
+static std::mutex cache_lock;
+
+// the entries, the most recently used first
+static std::list<CacheEntry> entries;
+static std::unordered_map<QueryKey, std::list<CacheEntry>::iterator, QueryKeyHash>
+    cache;
+static size_t cache_limit = TSQueryCache::DEFAULT_LIMIT;
+
+static void erase_entry(std::list<CacheEntry>::iterator entry) {
+  cache.erase(QueryKey{entry->language, entry->source});
+  entry->query->release();
+  entries.erase(entry);
+}
+
+// evict the least recently used entries until the cache fits in its limit
+// the evicted queries which are still in use are deleted when they are released
+static void trim_to_limit() {
+  while (entries.size() > cache_limit) {
+    erase_entry(std::prev(entries.end()));
+  }
+}
+
+TSQueryInternal *TSQueryCache::acquire(const TSLanguage *language,
+                                       const char *source,
+                                       uint32_t length,
+                                       uint32_t *error_offset,
+                                       TSQueryError *error_type) {
+  *error_offset = 0;
+  *error_type = TSQueryErrorNone;
+
+  QueryKey key{language, std::string_view(source, length)};
+  {
+    std::lock_guard<std::mutex> guard(cache_lock);
+    auto it = cache.find(key);
+    if (it != cache.end()) {
+      entries.splice(entries.begin(), entries, it->second);
+      it->second->query->retain();
+      return it->second->query;
+    }
+  }
+
+  // compile without holding the lock so that unrelated queries can be compiled
+  // in parallel
+  TSQuery *query =
+      ts_query_new(language, source, length, error_offset, error_type);
+  if (query == nullptr) {
+    return nullptr;
+  }
+
+  auto *compiled = new TSQueryInternal(query);
+
+  std::lock_guard<std::mutex> guard(cache_lock);
+  auto it = cache.find(key);
+  if (it != cache.end()) {
+    // another thread compiled the same query in the meantime
+    compiled->release();
+    entries.splice(entries.begin(), entries, it->second);
+    it->second->query->retain();
+    return it->second->query;
+  }
+
+  if (cache_limit == 0) {
+    // the only reference is the caller's
+    return compiled;
+  }
+
+  entries.push_front(CacheEntry{language, std::string(source, length), compiled});
+  cache.emplace(QueryKey{language, entries.front().source}, entries.begin());
+  trim_to_limit();
+
+  // one reference for the cache, one for the caller
+  compiled->retain();
+  return compiled;
+}
+
+void TSQueryCache::evict(const TSLanguage *language) {
+  std::lock_guard<std::mutex> guard(cache_lock);
+  for (auto it = entries.begin(); it != entries.end();) {
+    auto entry = it++;
+    if (entry->language == language) {
+      erase_entry(entry);
+    }
+  }
+}
+
+void TSQueryCache::clear() {
+  std::lock_guard<std::mutex> guard(cache_lock);
+  for (auto &entry : entries) {
+    entry.query->release();
+  }
+  cache.clear();
+  entries.clear();
+}
+
+size_t TSQueryCache::size() {
+  std::lock_guard<std::mutex> guard(cache_lock);
+  return entries.size();
+}
+
+size_t TSQueryCache::limit() {
+  std::lock_guard<std::mutex> guard(cache_lock);
+  return cache_limit;
+}
+
+void TSQueryCache::set_limit(size_t limit) {
+  std::lock_guard<std::mutex> guard(cache_lock);
+  cache_limit = limit;
+  trim_to_limit();
+}
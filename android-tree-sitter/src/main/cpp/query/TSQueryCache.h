@@ -0,0 +1,93 @@
+/*
+ *  This file is part of android-tree-sitter.
+ *
+ *  android-tree-sitter library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  android-tree-sitter library is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *  along with android-tree-sitter.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef ANDROIDTREESITTER_TSQUERYCACHE_H
+#define ANDROIDTREESITTER_TSQUERYCACHE_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "tree_sitter/api.h"
+
+class TSQueryInternal;
+
+/**
+ * Process-wide cache of compiled queries, keyed by the language and the source of the query.
+ * Compiling large queries (e.g. highlights) can take tens of milliseconds, so queries created
+ * with the same language and source share the same compiled query.
+ *
+ * The cache holds a reference to each cached query. It keeps at most limit() queries, and evicts
+ * the least recently used query when it is full : the evicted queries which are still in use are
+ * deleted when they are released. All the functions are thread-safe.
+ */
+class TSQueryCache {
+
+ public:
+  /**
+   * The default maximum number of cached queries.
+   */
+  static constexpr size_t DEFAULT_LIMIT = 64;
+
+  /**
+   * Get the compiled query for the given language and source, compiling the query if it is not
+   * cached. Queries with errors are never cached.
+   *
+   * @param language The language of the query.
+   * @param source The UTF-8 source of the query.
+   * @param length The length of the source in bytes.
+   * @param error_offset Set to the byte offset of the error, if any.
+   * @param error_type Set to the type of the error, if any.
+   * @return The compiled query with its reference count incremented for the caller, or
+   *         <code>nullptr</code> if the query could not be compiled.
+   */
+  static TSQueryInternal *acquire(const TSLanguage *language,
+                                  const char *source,
+                                  uint32_t length,
+                                  uint32_t *error_offset,
+                                  TSQueryError *error_type);
+
+  /**
+   * Remove all the cached queries for the given language. This must be called before the language
+   * is unloaded, as the pointer of the language may be reused for another language.
+   */
+  static void evict(const TSLanguage *language);
+
+  /**
+   * Remove all the cached queries. The queries which are still in use are deleted when they are
+   * released.
+   */
+  static void clear();
+
+  /**
+   * @return The number of cached queries.
+   */
+  static size_t size();
+
+  /**
+   * @return The maximum number of cached queries.
+   */
+  static size_t limit();
+
+  /**
+   * Set the maximum number of cached queries, evicting the least recently used queries if there
+   * are more. 0 disables the cache.
+   */
+  static void set_limit(size_t limit);
+};
+
+#endif //ANDROIDTREESITTER_TSQUERYCACHE_H
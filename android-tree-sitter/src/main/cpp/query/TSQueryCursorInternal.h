@@ -0,0 +1,103 @@
+/*
+ *  This file is part of android-tree-sitter.
+ *
+ *  android-tree-sitter library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  android-tree-sitter library is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *  along with android-tree-sitter.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef ANDROIDTREESITTER_TSQUERYCURSORINTERNAL_H
+#define ANDROIDTREESITTER_TSQUERYCURSORINTERNAL_H
+
+#include <jni.h>
+#include <cstdint>
+
+#include "tree_sitter/api.h"
+#include "../utils/ts_preconditions.h"
+#include "../utils/ts_instrumentation.h"
+
+/**
+ * The native object backing a Java TSQueryCursor. This holds the tree-sitter
+ * query cursor along with its stats, which are recorded only while the stats
+ * are enabled.
+ */
+class TSQueryCursorInternal {
+ public:
+  TSQueryCursorInternal() : _cursor(ts_query_cursor_new()) {}
+
+  ~TSQueryCursorInternal() {
+    ts_query_cursor_delete(_cursor);
+  }
+
+  TSQueryCursorInternal(const TSQueryCursorInternal &) = delete;
+
+  TSQueryCursorInternal &operator=(const TSQueryCursorInternal &) = delete;
+
+  TSQueryCursor *cursor() const {
+    return _cursor;
+  }
+
+  void exec(const TSQuery *query, TSNode node) {
+    ts_query_cursor_exec(_cursor, query, node);
+    _limit_recorded = false;
+    if (TSStats::enabled()) {
+      TSStats::add(_stats.executions);
+    }
+  }
+
+  /**
+   * Start timing a next* call. Returns 0 if the stats are disabled.
+   */
+  static uint64_t begin_next() {
+    return TSStats::enabled() ? TSStats::now() : 0;
+  }
+
+  /**
+   * Record the results of a next* call started with begin_next.
+   */
+  void end_next(uint64_t start_ns,
+                uint32_t matches,
+                uint32_t captures,
+                uint32_t rejections) {
+    if (start_ns == 0) {
+      return;
+    }
+
+    TSStats::add(_stats.time_ns, TSStats::now() - start_ns);
+    TSStats::add(_stats.matches, matches);
+    TSStats::add(_stats.captures, captures);
+    TSStats::add(_stats.predicate_rejections, rejections);
+
+    // the flag stays set until the next execution, count it once
+    if (!_limit_recorded && ts_query_cursor_did_exceed_match_limit(_cursor)) {
+      _limit_recorded = true;
+      TSStats::add(_stats.match_limit_hits);
+    }
+  }
+
+  TSQueryCursorStats &stats() {
+    return _stats;
+  }
+
+ private:
+  TSQueryCursor *_cursor;
+  bool _limit_recorded = false;
+  TSQueryCursorStats _stats;
+};
+
+inline TSQueryCursorInternal *as_query_cursor(JNIEnv *env, jlong pointer) {
+  req_nnp(env, pointer, "TSQueryCursor pointer");
+  return (TSQueryCursorInternal *) pointer;
+}
+
+#endif //ANDROIDTREESITTER_TSQUERYCURSORINTERNAL_H
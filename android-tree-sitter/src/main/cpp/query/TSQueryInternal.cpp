@@ -0,0 +1,391 @@
+/*
+ *  This file is part of android-tree-sitter.
+ *
+ *  android-tree-sitter library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  android-tree-sitter library is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *  along with android-tree-sitter.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include "TSQueryInternal.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "ts__log.h"
+#include "../utf16str/UTF16String.h"
+#include "../utils/ts_preconditions.h"
+
+// std::regex backtracks recursively, so the time and the stack it needs grow
+// with the length of the text. Only the start of the longer texts is searched.
+#define MAX_MATCH_TEXT_LENGTH 4096
+
+/**
+ * Decode the given UTF-8 string to code points.
+ */
+static std::u32string decode_utf8(const char *str, uint32_t len) {
+  std::u32string result;
+  result.reserve(len);
+  for (uint32_t i = 0; i < len;) {
+    auto c = (uint8_t) str[i];
+    uint32_t cp;
+    uint32_t extra;
+    if (c < 0x80) {
+      cp = c;
+      extra = 0;
+    } else if ((c & 0xe0) == 0xc0) {
+      cp = c & 0x1f;
+      extra = 1;
+    } else if ((c & 0xf0) == 0xe0) {
+      cp = c & 0x0f;
+      extra = 2;
+    } else {
+      cp = c & 0x07;
+      extra = 3;
+    }
+
+    ++i;
+    for (uint32_t j = 0; j < extra && i < len; ++j, ++i) {
+      cp = (cp << 6) | ((uint8_t) str[i] & 0x3f);
+    }
+    result.push_back((char32_t) cp);
+  }
+  return result;
+}
+
+static std::u16string to_utf16(const std::u32string &str) {
+  std::u16string result;
+  result.reserve(str.size());
+  for (auto cp : str) {
+    if (cp >= 0x10000) {
+      cp -= 0x10000;
+      result.push_back((char16_t) (0xd800 + (cp >> 10)));
+      result.push_back((char16_t) (0xdc00 + (cp & 0x3ff)));
+    } else {
+      result.push_back((char16_t) cp);
+    }
+  }
+  return result;
+}
+
+/**
+ * Convert the first max_len characters of the given UTF-16 string to a wide
+ * string, combining surrogate pairs if wchar_t can hold all the code points.
+ */
+static void to_wstring(const std::u16string &str, std::wstring &dest,
+                       size_t max_len = std::u16string::npos) {
+  auto len = std::min(str.size(), max_len);
+  dest.clear();
+  dest.reserve(len);
+  for (size_t i = 0; i < len; ++i) {
+    uint32_t c = str[i];
+    if (sizeof(wchar_t) >= 4 && c >= 0xd800 && c < 0xdc00 &&
+        i + 1 < len && str[i + 1] >= 0xdc00 && str[i + 1] < 0xe000) {
+      c = 0x10000 + ((c - 0xd800) << 10) + (str[i + 1] - 0xdc00);
+      ++i;
+    }
+    dest.push_back((wchar_t) c);
+  }
+}
+
+static std::shared_ptr<std::wregex> compile_regex(const char *pattern,
+                                                  uint32_t len) {
+  auto flags = std::regex_constants::ECMAScript;
+
+  // tree-sitter queries are usually written for the Rust regex engine, which
+  // supports inline flags
+  // support the case-insensitive flag at the start of the pattern
+  if (len >= 4 && strncmp(pattern, "(?i)", 4) == 0) {
+    flags |= std::regex_constants::icase;
+    pattern += 4;
+    len -= 4;
+  }
+
+  std::wstring wpattern;
+  to_wstring(to_utf16(decode_utf8(pattern, len)), wpattern);
+
+  try {
+    return std::make_shared<std::wregex>(wpattern, flags);
+  } catch (const std::regex_error &err) {
+    LOGW(LOG_TAG, "Unsupported regex in query predicate '%s': %s", pattern,
+         err.what());
+    return nullptr;
+  }
+}
+
+TSQueryInternal::TSQueryInternal(TSQuery *query)
+    : _query(query), _ref_count(1) {
+  compile_predicates();
+}
+
+TSQueryInternal::~TSQueryInternal() {
+  ts_query_delete(_query);
+}
+
+TSQuery *TSQueryInternal::query() const {
+  return _query;
+}
+
+void TSQueryInternal::retain() {
+  _ref_count.fetch_add(1, std::memory_order_relaxed);
+}
+
+void TSQueryInternal::release() {
+  if (_ref_count.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    delete this;
+  }
+}
+
+void TSQueryInternal::compile_predicates() {
+  uint32_t pattern_count = ts_query_pattern_count(_query);
+  _predicates.resize(pattern_count);
+
+  for (uint32_t pattern = 0; pattern < pattern_count; ++pattern) {
+    uint32_t step_count;
+    const TSQueryPredicateStep *steps =
+        ts_query_predicates_for_pattern(_query, pattern, &step_count);
+
+    uint32_t start = 0;
+    while (start < step_count) {
+      uint32_t end = start;
+      while (end < step_count && steps[end].type != TSQueryPredicateStepTypeDone) {
+        ++end;
+      }
+
+      const TSQueryPredicateStep *predicate = steps + start;
+      const uint32_t arg_count = end - start;
+      start = end + 1;
+
+      if (arg_count < 3 || predicate[0].type != TSQueryPredicateStepTypeString ||
+          predicate[1].type != TSQueryPredicateStepTypeCapture) {
+        // not a text predicate
+        continue;
+      }
+
+      uint32_t len;
+      const char *name =
+          ts_query_string_value_for_id(_query, predicate[0].value_id, &len);
+      std::string op(name, len);
+
+      TextPredicate text_predicate{};
+      text_predicate.capture_id = predicate[1].value_id;
+      text_predicate.is_positive = op.find("not-") == std::string::npos;
+      text_predicate.match_all = op.rfind("any-", 0) != 0 || op == "any-of?" ||
+                                 op == "not-any-of?";
+
+      if (op == "eq?" || op == "not-eq?" || op == "any-eq?" ||
+          op == "any-not-eq?") {
+        if (arg_count != 3) {
+          continue;
+        }
+
+        if (predicate[2].type == TSQueryPredicateStepTypeCapture) {
+          text_predicate.type = TextPredicateType::EqCapture;
+          text_predicate.other_capture_id = predicate[2].value_id;
+        } else {
+          const char *value =
+              ts_query_string_value_for_id(_query, predicate[2].value_id, &len);
+          text_predicate.type = TextPredicateType::EqString;
+          text_predicate.values.push_back(to_utf16(decode_utf8(value, len)));
+        }
+      } else if (op == "match?" || op == "not-match?" || op == "any-match?" ||
+                 op == "any-not-match?") {
+        if (arg_count != 3 ||
+            predicate[2].type != TSQueryPredicateStepTypeString) {
+          continue;
+        }
+
+        const char *value =
+            ts_query_string_value_for_id(_query, predicate[2].value_id, &len);
+        text_predicate.type = TextPredicateType::Match;
+        // the predicate is kept even if the pattern cannot be compiled, in
+        // which case it rejects every match
+        text_predicate.regex = compile_regex(value, len);
+      } else if (op == "any-of?" || op == "not-any-of?") {
+        bool valid = true;
+        for (uint32_t i = 2; i < arg_count; ++i) {
+          if (predicate[i].type != TSQueryPredicateStepTypeString) {
+            valid = false;
+            break;
+          }
+
+          const char *value =
+              ts_query_string_value_for_id(_query, predicate[i].value_id, &len);
+          text_predicate.values.push_back(to_utf16(decode_utf8(value, len)));
+        }
+
+        if (!valid) {
+          continue;
+        }
+        text_predicate.type = TextPredicateType::AnyOf;
+      } else {
+        // not a standard predicate, handled in Java
+        continue;
+      }
+
+      _predicates[pattern].push_back(std::move(text_predicate));
+    }
+  }
+}
+
+/**
+ * Evaluate the given predicate on the text of a single node.
+ */
+static bool test_text(const TextPredicate &predicate,
+                      const std::u16string &text,
+                      std::wstring &wtext) {
+  switch (predicate.type) {
+    case TextPredicateType::EqString:
+      return text == predicate.values[0];
+    case TextPredicateType::Match:
+      to_wstring(text, wtext, MAX_MATCH_TEXT_LENGTH);
+      try {
+        return std::regex_search(wtext, *predicate.regex);
+      } catch (const std::regex_error &err) {
+        // the search was too complex, this must not terminate the process as
+        // this may run on a thread of the pool
+        LOGW(LOG_TAG, "Failed to evaluate regex in query predicate: %s",
+             err.what());
+        return false;
+      }
+    case TextPredicateType::AnyOf:
+      for (const auto &value : predicate.values) {
+        if (text == value) {
+          return true;
+        }
+      }
+      return false;
+    default:
+      return false;
+  }
+}
+
+bool TSQueryInternal::satisfies_text_predicates(
+    const TSQueryMatch &match, const UTF16String *source) const {
+  if (source == nullptr || match.pattern_index >= _predicates.size()) {
+    return true;
+  }
+
+  const auto &predicates = _predicates[match.pattern_index];
+  if (predicates.empty()) {
+    return true;
+  }
+
+  // reused across matches and predicates on the same thread
+  static thread_local std::u16string text;
+  static thread_local std::u16string other_text;
+  static thread_local std::wstring wtext;
+
+  for (const auto &predicate : predicates) {
+    if (predicate.type == TextPredicateType::Match && !predicate.regex) {
+      // the pattern is not supported, so it is not known which nodes match
+      return false;
+    }
+
+    if (predicate.type == TextPredicateType::EqCapture) {
+      // compare the nodes of both the captures pairwise
+      uint16_t i = 0;
+      uint16_t j = 0;
+      bool satisfied = true;
+      bool decided = false;
+      while (!decided) {
+        while (i < match.capture_count &&
+               match.captures[i].index != predicate.capture_id) {
+          ++i;
+        }
+        while (j < match.capture_count &&
+               match.captures[j].index != predicate.other_capture_id) {
+          ++j;
+        }
+
+        if (i >= match.capture_count || j >= match.capture_count) {
+          // all pairs have been compared
+          satisfied = i >= match.capture_count && j >= match.capture_count;
+          break;
+        }
+
+        const TSNode lhs = match.captures[i++].node;
+        const TSNode rhs = match.captures[j++].node;
+        source->read_chars(ts_node_start_byte(lhs), ts_node_end_byte(lhs),
+                           text);
+        source->read_chars(ts_node_start_byte(rhs), ts_node_end_byte(rhs),
+                           other_text);
+
+        bool equal = text == other_text;
+        if (equal != predicate.is_positive && predicate.match_all) {
+          satisfied = false;
+          decided = true;
+        } else if (equal == predicate.is_positive && !predicate.match_all) {
+          satisfied = true;
+          decided = true;
+        }
+      }
+
+      if (!satisfied) {
+        return false;
+      }
+
+      continue;
+    }
+
+    // with 'match_all', every node of the capture must pass the test
+    // otherwise, at least one node must pass the test
+    bool satisfied = predicate.match_all;
+    for (uint16_t i = 0; i < match.capture_count; ++i) {
+      const TSQueryCapture &capture = match.captures[i];
+      if (capture.index != predicate.capture_id) {
+        continue;
+      }
+
+      source->read_chars(ts_node_start_byte(capture.node),
+                         ts_node_end_byte(capture.node), text);
+      bool passed = test_text(predicate, text, wtext) == predicate.is_positive;
+      if (predicate.match_all && !passed) {
+        satisfied = false;
+        break;
+      }
+
+      if (!predicate.match_all && passed) {
+        satisfied = true;
+        break;
+      }
+    }
+
+    if (!satisfied) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool TSQueryInternal::next_capture(TSQueryCursor *cursor,
+                                   const UTF16String *source,
+                                   TSQueryMatch *match,
+                                   uint32_t *capture_index,
+                                   uint32_t *rejections) const {
+  while (ts_query_cursor_next_capture(cursor, match, capture_index)) {
+    if (satisfies_text_predicates(*match, source)) {
+      return true;
+    }
+    ts_query_cursor_remove_match(cursor, match->id);
+    if (rejections != nullptr) {
+      ++*rejections;
+    }
+  }
+  return false;
+}
+
+TSQueryInternal *as_query(JNIEnv *env, jlong pointer) {
+  req_nnp(env, pointer, "TSQuery pointer");
+  return (TSQueryInternal *) pointer;
+}
@@ -0,0 +1,145 @@
+/*
+ *  This file is part of android-tree-sitter.
+ *
+ *  android-tree-sitter library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  android-tree-sitter library is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *  along with android-tree-sitter.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef ANDROIDTREESITTER_TSQUERYINTERNAL_H
+#define ANDROIDTREESITTER_TSQUERYINTERNAL_H
+
+#include <jni.h>
+#include <atomic>
+#include <memory>
+#include <regex>
+#include <string>
+#include <vector>
+
+#include "tree_sitter/api.h"
+
+class UTF16String;
+
+/**
+ * The standard text predicates which are evaluated natively.
+ */
+enum class TextPredicateType {
+
+  // #eq? @capture "string"
+  EqString,
+
+  // #eq? @capture @other_capture
+  EqCapture,
+
+  // #match? @capture "regex"
+  Match,
+
+  // #any-of? @capture "string1" "string2" ...
+  AnyOf
+};
+
+/**
+ * A precompiled text predicate.
+ */
+struct TextPredicate {
+  TextPredicateType type;
+
+  // false for the #not-* variants
+  bool is_positive;
+
+  // false for the #any-* variants of #eq? and #match?
+  bool match_all;
+
+  uint32_t capture_id;
+  uint32_t other_capture_id;
+  std::vector<std::u16string> values;
+
+  // null if the pattern of a #match? predicate is not supported
+  std::shared_ptr<std::wregex> regex;
+};
+
+/**
+ * The native object backing a Java TSQuery. This holds the compiled tree-sitter query along with
+ * the standard text predicates of each pattern, which are compiled once when the query is
+ * created.
+ *
+ * Instances are reference counted, as the same compiled query is shared between all the Java
+ * TSQuery objects created with the same language and source (see TSQueryCache). The query is
+ * never modified after it is created, so it is safe to use from multiple threads.
+ */
+class TSQueryInternal {
+
+ public:
+  /**
+   * Create a new instance for the given query. The reference count is initially 1.
+   */
+  explicit TSQueryInternal(TSQuery *query);
+
+  TSQueryInternal(const TSQueryInternal &) = delete;
+
+  TSQueryInternal &operator=(const TSQueryInternal &) = delete;
+
+  /**
+   * @return The compiled tree-sitter query.
+   */
+  TSQuery *query() const;
+
+  /**
+   * Increment the reference count.
+   */
+  void retain();
+
+  /**
+   * Decrement the reference count. The instance is deleted when the reference count reaches 0.
+   */
+  void release();
+
+  /**
+   * Check whether the given match satisfies all the standard text predicates of its pattern.
+   *
+   * @param match The match to check.
+   * @param source The source text of the tree that the query was executed on. If this is
+   *               <code>nullptr</code>, the predicates are not evaluated and this returns
+   *               <code>true</code>.
+   * @return Whether the match satisfies the predicates.
+   */
+  bool satisfies_text_predicates(const TSQueryMatch &match,
+                                 const UTF16String *source) const;
+
+  /**
+   * Advance the given cursor to the next capture whose match satisfies the text predicates of
+   * this query. Matches which do not satisfy the predicates are removed from the cursor so that
+   * their remaining captures are skipped as well.
+   *
+   * @param rejections If not <code>nullptr</code>, incremented for each match which is removed.
+   * @return Whether a capture was found.
+   */
+  bool next_capture(TSQueryCursor *cursor,
+                    const UTF16String *source,
+                    TSQueryMatch *match,
+                    uint32_t *capture_index,
+                    uint32_t *rejections = nullptr) const;
+
+ private:
+  TSQuery *_query;
+  std::atomic<uint32_t> _ref_count;
+  std::vector<std::vector<TextPredicate>> _predicates;
+
+  ~TSQueryInternal();
+
+  void compile_predicates();
+};
+
+TSQueryInternal *as_query(JNIEnv *env, jlong pointer);
+
+#endif //ANDROIDTREESITTER_TSQUERYINTERNAL_H
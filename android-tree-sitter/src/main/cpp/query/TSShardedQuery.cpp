@@ -0,0 +1,136 @@
+/*
+ *  This file is part of android-tree-sitter.
+ *
+ *  android-tree-sitter library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  android-tree-sitter library is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *  along with android-tree-sitter.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include "TSShardedQuery.h"
+
+#include <algorithm>
+
+#include "TSQueryInternal.h"
+#include "../utils/ts_obj_utils.h"
+#include "../utils/ts_thread_pool.h"
+
+// Splitting smaller nodes is not worth the cost of the additional cursors
+#define MIN_SHARD_BYTES (16 * 1024)
+
+TSShardedQuery::TSShardedQuery(const TSQueryInternal *query,
+                               const UTF16String *source,
+                               uint32_t match_limit)
+    : _query(query), _source(source), _match_limit(match_limit) {}
+
+std::vector<TSShardedQuery::Shard> TSShardedQuery::split(TSNode node,
+                                                         uint32_t max_shards) const {
+  auto node_start = ts_node_start_byte(node);
+  auto node_end = ts_node_end_byte(node);
+  auto shard_count = std::min(max_shards, (node_end - node_start) / MIN_SHARD_BYTES);
+
+  // the shard boundaries, at the start of a child
+  std::vector<uint32_t> boundaries;
+  if (shard_count > 1) {
+    auto target = (node_end - node_start) / shard_count;
+    auto shard_start = node_start;
+    auto cursor = ts_tree_cursor_new(node);
+    if (ts_tree_cursor_goto_first_child(&cursor)) {
+      do {
+        auto child_start = ts_node_start_byte(ts_tree_cursor_current_node(&cursor));
+        if (child_start - shard_start >= target && boundaries.size() + 1 < shard_count) {
+          boundaries.push_back(child_start);
+          shard_start = child_start;
+        }
+      } while (ts_tree_cursor_goto_next_sibling(&cursor));
+    }
+    ts_tree_cursor_delete(&cursor);
+  }
+
+  std::vector<Shard> shards(boundaries.size() + 1);
+  for (size_t i = 0; i < shards.size(); ++i) {
+    auto &shard = shards[i];
+    shard.start = i == 0 ? 0 : boundaries[i - 1];
+    shard.end = i == boundaries.size() ? UINT32_MAX : boundaries[i];
+    shard.rejections = 0;
+
+    // start a byte early, so that the zero-width nodes at the boundary are not missed
+    shard.range_start = i == 0 ? 0 : shard.start - 1;
+  }
+  return shards;
+}
+
+void TSShardedQuery::run_shard(TSQueryCursor *cursor, TSNode node, Shard &shard) const {
+  ts_query_cursor_set_match_limit(cursor, _match_limit);
+  ts_query_cursor_set_byte_range(cursor, shard.range_start, UINT32_MAX);
+  ts_query_cursor_exec(cursor, _query->query(), node);
+
+  TSQueryMatch m;
+  uint32_t capture_index;
+  while (_query->next_capture(cursor, _source, &m, &capture_index, &shard.rejections)) {
+    const TSQueryCapture *capture = m.captures + capture_index;
+    auto start = ts_node_start_byte(capture->node);
+
+    // the captures are returned in document order, after the earlier
+    // captures of the matches which are still in progress
+    if (start >= shard.end) {
+      break;
+    }
+    if (start < shard.start) {
+      continue;
+    }
+
+    auto id = (uint64_t) capture->node.id;
+    shard.records.push_back((jint) capture->index);
+    shard.records.push_back((jint) m.pattern_index);
+    shard.records.push_back((jint) start);
+    shard.records.push_back((jint) ts_node_end_byte(capture->node));
+    shard.records.push_back((jint) (id & 0xffffffff));
+    shard.records.push_back((jint) (id >> 32));
+  }
+}
+
+uint32_t TSShardedQuery::run(TSNode node, uint32_t max_shards, std::vector<jint> &records) {
+  if (max_shards == 0) {
+    max_shards = TSThreadPool::shared()->thread_count() + 1;
+  }
+
+  auto shards = split(node, max_shards);
+  auto count = (uint32_t) shards.size();
+  ts_run_parallel(count, count, [&](uint32_t worker_index, const TSNextJob &next_job) {
+    TSQueryCursor *cursor = nullptr;
+    for (auto i = next_job(); i < count; i = next_job()) {
+      if (cursor == nullptr) {
+        cursor = ts_query_cursor_new();
+      }
+      run_shard(cursor, node, shards[i]);
+    }
+
+    if (cursor != nullptr) {
+      ts_query_cursor_delete(cursor);
+    }
+  });
+
+  uint32_t rejections = 0;
+  size_t size = 0;
+  for (const auto &shard: shards) {
+    size += shard.records.size();
+  }
+
+  records.clear();
+  records.reserve(size);
+  for (const auto &shard: shards) {
+    records.insert(records.end(), shard.records.begin(), shard.records.end());
+    rejections += shard.rejections;
+  }
+  return rejections;
+}
@@ -0,0 +1,89 @@
+/*
+ *  This file is part of android-tree-sitter.
+ *
+ *  android-tree-sitter library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  android-tree-sitter library is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *  along with android-tree-sitter.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef ANDROIDTREESITTER_TSSHARDEDQUERY_H
+#define ANDROIDTREESITTER_TSSHARDEDQUERY_H
+
+#include <jni.h>
+#include <cstdint>
+#include <vector>
+
+#include "tree_sitter/api.h"
+
+class TSQueryInternal;
+class UTF16String;
+
+/**
+ * Runs a query over a whole node in parallel, by splitting the node into byte-range shards which
+ * are aligned to the start of its children. Each shard is run with its own query cursor on the
+ * shared thread pool.
+ *
+ * Each shard keeps only the captures which start within the shard, and the captures of the
+ * matches spanning several shards are split between them. The cursor of a shard starts at the
+ * start of the shard : the query cursor still finds the matches which intersect its range but
+ * start before it, including the matches of the non-local patterns which start at any of the
+ * preceding siblings. The cursor has no end, as it would drop the matches which are still in
+ * progress at the end of its range, which may have captures in the shard. It is stopped at the
+ * first capture after the shard instead. The captures of each shard are returned in document
+ * order, so concatenating the shards gives the same captures as running the query with a single
+ * cursor.
+ */
+class TSShardedQuery {
+
+ public:
+  /**
+   * @param query The query to run.
+   * @param source The source text for the standard text predicates, or nullptr.
+   * @param match_limit The match limit of the cursor of each shard.
+   */
+  TSShardedQuery(const TSQueryInternal *query,
+                 const UTF16String *source,
+                 uint32_t match_limit);
+
+  /**
+   * Run the query on the given node, using at most max_shards shards (0 to use one shard per
+   * thread of the shared thread pool), and write the captures as packed capture records
+   * (PACKED_CAPTURE_SIZE values each) to records, in document order.
+   *
+   * @return The number of predicate rejections.
+   */
+  uint32_t run(TSNode node, uint32_t max_shards, std::vector<jint> &records);
+
+ private:
+  struct Shard {
+    // the captures which start in [start, end) belong to this shard
+    uint32_t start;
+    uint32_t end;
+
+    // the start of the byte range of the query cursor
+    uint32_t range_start;
+
+    std::vector<jint> records;
+    uint32_t rejections;
+  };
+
+  const TSQueryInternal *_query;
+  const UTF16String *_source;
+  uint32_t _match_limit;
+
+  std::vector<Shard> split(TSNode node, uint32_t max_shards) const;
+
+  void run_shard(TSQueryCursor *cursor, TSNode node, Shard &shard) const;
+};
+
+#endif //ANDROIDTREESITTER_TSSHARDEDQUERY_H
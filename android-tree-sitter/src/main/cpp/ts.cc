@@ -18,6 +18,8 @@
 #include <array>
 #include <tree_sitter/api.h>
 
+#include "utils/ts_allocator.h"
+#include "utils/ts_exceptions.h"
 #include "ts__log.h"
 #include "ts_meta.h"
 
@@ -29,9 +31,32 @@ static jint ats_min_compatible_language_version(JNIEnv *env, jclass self) {
   return (jint) TREE_SITTER_MIN_COMPATIBLE_LANGUAGE_VERSION;
 }
 
+static void ats_set_allocator(JNIEnv *env, jclass self, jint allocator) {
+  if (allocator != ALLOCATOR_SYSTEM && allocator != ALLOCATOR_POOLED) {
+    throw_illegal_args(env, "Unknown allocator");
+    return;
+  }
+
+  if (!TSAllocator::set((TSAllocatorType) allocator)) {
+    throw_illegal_state(env,
+                        "The allocator must be set before any tree-sitter object is created");
+  }
+}
+
+static jint ats_get_allocator(JNIEnv *env, jclass self) {
+  return (jint) TSAllocator::get();
+}
+
+static jlongArray ats_get_allocator_stats(JNIEnv *env, jclass self) {
+  return TSAllocator::pack_stats(env);
+}
+
 void TreeSitter_Native__SetJniMethods(JNINativeMethod *methods, int count) {
 
   SET_JNI_METHOD(methods, TreeSitter_Native_getLanguageVersion, ats_language_version);
   SET_JNI_METHOD(methods, TreeSitter_Native_getMinimumCompatibleLanguageVersion,
                  ats_min_compatible_language_version);
+  SET_JNI_METHOD(methods, TreeSitter_Native_setAllocator, ats_set_allocator);
+  SET_JNI_METHOD(methods, TreeSitter_Native_getAllocator, ats_get_allocator);
+  SET_JNI_METHOD(methods, TreeSitter_Native_getAllocatorStats, ats_get_allocator_stats);
 }
\ No newline at end of file
@@ -15,24 +15,113 @@
  *  along with android-tree-sitter.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <mutex>
+#include <vector>
+
+#include "language/TSLanguageNames.h"
 #include "utils/ts_obj_utils.h"
 #include "utils/ts_preconditions.h"
 
 #include "ts_tree_cursor.h"
 
+// The pooled cursor count and the pool hits.
+// Must be kept in sync with TSTreeCursor.getPooledCount() and TSTreeCursor.getPoolHits()
+#define PACKED_CURSOR_POOL_STATS_SIZE 2
+
+/**
+ * Keeps the cursors released by Java for reuse, so that creating a cursor does not allocate the
+ * cursor and its stack again. A pooled cursor keeps the capacity of its stack, and is re-initialized
+ * with ts_tree_cursor_reset. Pooling is disabled (capacity is 0) until enabled from Java.
+ */
+class TSTreeCursorPool {
+ public:
+
+  static TSTreeCursor *obtain() {
+    std::lock_guard<std::mutex> guard(lock);
+    if (cursors.empty()) {
+      return nullptr;
+    }
+
+    auto *cursor = cursors.back();
+    cursors.pop_back();
+    ++hits;
+    return cursor;
+  }
+
+  static void recycle(TSTreeCursor *cursor) {
+    {
+      std::lock_guard<std::mutex> guard(lock);
+      if (cursors.size() < capacity) {
+        cursors.push_back(cursor);
+        return;
+      }
+    }
+
+    ts_tree_cursor_delete(cursor);
+    delete cursor;
+  }
+
+  static void set_capacity(size_t new_capacity) {
+    std::vector<TSTreeCursor *> trimmed;
+    {
+      std::lock_guard<std::mutex> guard(lock);
+      capacity = new_capacity;
+      while (cursors.size() > capacity) {
+        trimmed.push_back(cursors.back());
+        cursors.pop_back();
+      }
+    }
+
+    for (auto *cursor: trimmed) {
+      ts_tree_cursor_delete(cursor);
+      delete cursor;
+    }
+  }
+
+  static size_t get_capacity() {
+    std::lock_guard<std::mutex> guard(lock);
+    return capacity;
+  }
+
+  static void pack_stats(jlong *stats) {
+    std::lock_guard<std::mutex> guard(lock);
+    stats[0] = (jlong) cursors.size();
+    stats[1] = (jlong) hits;
+  }
+
+ private:
+  static std::mutex lock;
+  static std::vector<TSTreeCursor *> cursors;
+  static size_t capacity;
+  static uint64_t hits;
+};
+
+std::mutex TSTreeCursorPool::lock;
+std::vector<TSTreeCursor *> TSTreeCursorPool::cursors;
+size_t TSTreeCursorPool::capacity = 0;
+uint64_t TSTreeCursorPool::hits = 0;
+
 static jlong TreeCursor_newCursor(JNIEnv *env, jclass self, jobject node) {
-  auto
-      *cursor = new TSTreeCursor(ts_tree_cursor_new(_unmarshalNode(env, node)));
+  auto ts_node = _unmarshalNode(env, node);
+  auto *cursor = TSTreeCursorPool::obtain();
+  if (cursor) {
+    ts_tree_cursor_reset(cursor, ts_node);
+  } else {
+    cursor = new TSTreeCursor(ts_tree_cursor_new(ts_node));
+  }
   return (jlong) cursor;
 }
 
 static jobject TreeCursor_currentTreeCursorNode(JNIEnv *env, jclass self, jlong cursor) {
   req_nnp(env, cursor);
   TSNode node = ts_tree_cursor_current_node((TSTreeCursor *) cursor);
+  const TSLanguage *language = ts_node_language(node);
+  TSFieldId field = ts_tree_cursor_current_field_id((TSTreeCursor *) cursor);
   return _marshalTreeCursorNode(env,
-                                (TreeCursorNode) {ts_node_type(node),
-                                                  ts_tree_cursor_current_field_name(
-                                                      (TSTreeCursor *) cursor),
+                                (TreeCursorNode) {TSLanguageNames::symbol_name(env,
+                                                                               language,
+                                                                               ts_node_symbol(node)),
+                                                  TSLanguageNames::field_name(env, language, field),
                                                   ts_node_start_byte(node) / 2,
                                                   ts_node_end_byte(node) / 2});
 }
@@ -40,9 +129,14 @@ static jobject TreeCursor_currentTreeCursorNode(JNIEnv *env, jclass self, jlong
 
 static jstring TreeCursor_currentFieldName(JNIEnv *env, jclass self, jlong cursor) {
   req_nnp(env, cursor);
-  const char *name = ts_tree_cursor_current_field_name((TSTreeCursor *) cursor);
-  jstring result = env->NewStringUTF(name);
-  return result;
+  auto *tree_cursor = (TSTreeCursor *) cursor;
+  TSFieldId field = ts_tree_cursor_current_field_id(tree_cursor);
+  if (field == 0) {
+    return nullptr;
+  }
+
+  TSNode node = ts_tree_cursor_current_node(tree_cursor);
+  return TSLanguageNames::field_name(env, ts_node_language(node), field);
 }
 
 static jobject TreeCursor_currentNode(JNIEnv *env, jclass self, jlong cursor) {
@@ -53,8 +147,7 @@ static jobject TreeCursor_currentNode(JNIEnv *env, jclass self, jlong cursor) {
 
 static void TreeCursor_delete(JNIEnv *env, jclass self, jlong cursor) {
   req_nnp(env, cursor);
-  ts_tree_cursor_delete((TSTreeCursor *) cursor);
-  delete (TSTreeCursor *) cursor;
+  TSTreeCursorPool::recycle((TSTreeCursor *) cursor);
 }
 
 static jboolean TreeCursor_gotoFirstChild(JNIEnv *env, jclass self, jlong cursor) {
@@ -149,11 +242,126 @@ static void TreeCursor_resetTo(JNIEnv *env, jclass clazz, jlong pointer, jlong a
 
 static jlong TreeCursor_copy(JNIEnv *env, jclass clazz, jlong pointer) {
   req_nnp(env, pointer);
-  auto
-      *copied = new TSTreeCursor(ts_tree_cursor_copy((TSTreeCursor *) pointer));
+  auto *copied = TSTreeCursorPool::obtain();
+  if (copied) {
+    ts_tree_cursor_reset_to(copied, (TSTreeCursor *) pointer);
+  } else {
+    copied = new TSTreeCursor(ts_tree_cursor_copy((TSTreeCursor *) pointer));
+  }
   return (jlong) copied;
 }
 
+static void TreeCursor_setPoolCapacity(JNIEnv *env, jclass clazz, jint capacity) {
+  TSTreeCursorPool::set_capacity((size_t) capacity);
+}
+
+static jint TreeCursor_getPoolCapacity(JNIEnv *env, jclass clazz) {
+  return (jint) TSTreeCursorPool::get_capacity();
+}
+
+static jlongArray TreeCursor_getPoolStats(JNIEnv *env, jclass clazz) {
+  jlong stats[PACKED_CURSOR_POOL_STATS_SIZE];
+  TSTreeCursorPool::pack_stats(stats);
+  auto result = env->NewLongArray(PACKED_CURSOR_POOL_STATS_SIZE);
+  env->SetLongArrayRegion(result, 0, PACKED_CURSOR_POOL_STATS_SIZE, stats);
+  return result;
+}
+
+/**
+ * Whether the given node intersects the byte range [start, end). Empty nodes
+ * are included if they are within the range.
+ */
+static bool intersects(TSNode node, uint32_t start, uint32_t end) {
+  uint32_t node_start = ts_node_start_byte(node);
+  uint32_t node_end = ts_node_end_byte(node);
+  return node_start < end && (node_end > start || node_start >= start);
+}
+
+static void pack_cursor_info(TSTreeCursor *cursor, jint *info) {
+  TSNode node = ts_tree_cursor_current_node(cursor);
+  TSPoint start = ts_node_start_point(node);
+  info[0] = (jint) ts_node_symbol(node);
+  info[1] = (jint) ts_tree_cursor_current_field_id(cursor);
+  info[2] = (jint) ts_node_start_byte(node);
+  info[3] = (jint) ts_node_end_byte(node);
+  info[4] = (jint) start.row;
+  info[5] = (jint) start.column;
+  info[6] = (jint) ts_tree_cursor_current_depth(cursor);
+  info[7] = _nodeFlags(node);
+}
+
+/**
+ * Move the cursor to the next node in pre-order which intersects the byte
+ * range [start, end), without descending below max_depth.
+ *
+ * @return Whether the cursor moved, false when the traversal is complete.
+ */
+static bool step_pre_order(TSTreeCursor *cursor,
+                           uint32_t max_depth,
+                           uint32_t start,
+                           uint32_t end) {
+  if (ts_tree_cursor_current_depth(cursor) < max_depth) {
+    // skip the children which end before the range without visiting them
+    bool moved = start == 0
+                 ? ts_tree_cursor_goto_first_child(cursor)
+                 : ts_tree_cursor_goto_first_child_for_byte(cursor, start) >= 0;
+    if (moved) {
+      if (intersects(ts_tree_cursor_current_node(cursor), start, end)) {
+        return true;
+      }
+    }
+  }
+
+  while (true) {
+    while (ts_tree_cursor_goto_next_sibling(cursor)) {
+      TSNode node = ts_tree_cursor_current_node(cursor);
+      if (ts_node_start_byte(node) >= end) {
+        // the next siblings start after the range too
+        break;
+      }
+
+      if (intersects(node, start, end)) {
+        return true;
+      }
+    }
+
+    // the cursor cannot go above the node it was created with
+    if (!ts_tree_cursor_goto_parent(cursor)) {
+      return false;
+    }
+  }
+}
+
+static jboolean TreeCursor_gotoNextPreOrder(JNIEnv *env,
+                                            jclass clazz,
+                                            jlong pointer,
+                                            jint max_depth,
+                                            jint start_byte,
+                                            jint end_byte,
+                                            jintArray info) {
+  req_nnp(env, pointer);
+  auto *cursor = (TSTreeCursor *) pointer;
+  if (!step_pre_order(cursor, (uint32_t) max_depth, (uint32_t) start_byte,
+                      (uint32_t) end_byte)) {
+    return false;
+  }
+
+  jint record[PACKED_CURSOR_INFO_SIZE];
+  pack_cursor_info(cursor, record);
+  env->SetIntArrayRegion(info, 0, PACKED_CURSOR_INFO_SIZE, record);
+  return true;
+}
+
+static void TreeCursor_currentNodeInfo(JNIEnv *env,
+                                       jclass clazz,
+                                       jlong pointer,
+                                       jintArray info) {
+  req_nnp(env, pointer);
+  jint record[PACKED_CURSOR_INFO_SIZE];
+  pack_cursor_info((TSTreeCursor *) pointer, record);
+  env->SetIntArrayRegion(info, 0, PACKED_CURSOR_INFO_SIZE, record);
+}
+
 void TSTreeCursor_Native__SetJniMethods(JNINativeMethod *methods, int count) {
   SET_JNI_METHOD(methods, TSTreeCursor_Native_copy, TreeCursor_copy);
   SET_JNI_METHOD(methods, TSTreeCursor_Native_currentDescendantIndex, TreeCursor_currentDescendantIndex);
@@ -174,4 +382,9 @@ void TSTreeCursor_Native__SetJniMethods(JNINativeMethod *methods, int count) {
   SET_JNI_METHOD(methods, TSTreeCursor_Native_newCursor, TreeCursor_newCursor);
   SET_JNI_METHOD(methods, TSTreeCursor_Native_reset, TreeCursor_reset);
   SET_JNI_METHOD(methods, TSTreeCursor_Native_resetTo, TreeCursor_resetTo);
+  SET_JNI_METHOD(methods, TSTreeCursor_Native_gotoNextPreOrder, TreeCursor_gotoNextPreOrder);
+  SET_JNI_METHOD(methods, TSTreeCursor_Native_currentNodeInfo, TreeCursor_currentNodeInfo);
+  SET_JNI_METHOD(methods, TSTreeCursor_Native_setPoolCapacity, TreeCursor_setPoolCapacity);
+  SET_JNI_METHOD(methods, TSTreeCursor_Native_getPoolCapacity, TreeCursor_getPoolCapacity);
+  SET_JNI_METHOD(methods, TSTreeCursor_Native_getPoolStats, TreeCursor_getPoolStats);
 }
\ No newline at end of file
@@ -0,0 +1,89 @@
+/*
+ *  This file is part of android-tree-sitter.
+ *
+ *  android-tree-sitter library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  android-tree-sitter library is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *  along with android-tree-sitter.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include "ts_highlighter.h"
+
+#include <vector>
+
+#include "query/TSHighlighterInternal.h"
+#include "query/TSQueryInternal.h"
+#include "utf16str/UTF16String.h"
+#include "utils/ts_misc.h"
+#include "utils/ts_obj_utils.h"
+#include "utils/ts_preconditions.h"
+
+static jlong TSHighlighter_newHighlighter(JNIEnv *env,
+                                          __TS_ATTR_UNUSED jclass self,
+                                          jlong query) {
+  return (jlong) new TSHighlighterInternal(as_query(env, query));
+}
+
+static void TSHighlighter_delete(JNIEnv *env,
+                                 __TS_ATTR_UNUSED jclass self,
+                                 jlong highlighter) {
+  delete as_highlighter(env, highlighter);
+}
+
+static void TSHighlighter_edit(JNIEnv *env,
+                               __TS_ATTR_UNUSED jclass self,
+                               jlong highlighter,
+                               jintArray edits) {
+  auto *internal = as_highlighter(env, highlighter);
+  req_nnp(env, edits, "edits");
+
+  thread_local std::vector<TSInputEdit> unpacked;
+  if (!_unpackEdits(env, edits, unpacked)) {
+    return;
+  }
+
+  for (const auto &edit : unpacked) {
+    internal->edit(edit);
+  }
+}
+
+static jintArray TSHighlighter_update(JNIEnv *env,
+                                      __TS_ATTR_UNUSED jclass self,
+                                      jlong highlighter,
+                                      jlong tree,
+                                      jlong source) {
+  auto *internal = as_highlighter(env, highlighter);
+  req_nnp(env, tree, "tree");
+
+  // reused across calls to avoid allocating on every update
+  thread_local std::vector<jint> diff;
+  internal->update((TSTree *) tree,
+                   source == 0 ? nullptr : (const UTF16String *) source,
+                   diff);
+  return _newIntArray(env, diff);
+}
+
+static jintArray TSHighlighter_getSpans(JNIEnv *env,
+                                        __TS_ATTR_UNUSED jclass self,
+                                        jlong highlighter) {
+  thread_local std::vector<jint> spans;
+  as_highlighter(env, highlighter)->pack_spans(spans);
+  return _newIntArray(env, spans);
+}
+
+void TSHighlighter_Native__SetJniMethods(JNINativeMethod *methods, int count) {
+  SET_JNI_METHOD(methods, TSHighlighter_Native_newHighlighter, TSHighlighter_newHighlighter);
+  SET_JNI_METHOD(methods, TSHighlighter_Native_delete, TSHighlighter_delete);
+  SET_JNI_METHOD(methods, TSHighlighter_Native_edit, TSHighlighter_edit);
+  SET_JNI_METHOD(methods, TSHighlighter_Native_update, TSHighlighter_update);
+  SET_JNI_METHOD(methods, TSHighlighter_Native_getSpans, TSHighlighter_getSpans);
+}
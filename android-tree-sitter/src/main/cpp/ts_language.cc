@@ -15,17 +15,20 @@
  *  along with android-tree-sitter.  If not, see <https://www.gnu.org/licenses/>.
  */
 
-#include <dlfcn.h>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include "tree_sitter/api.h"
+#include "language/TSLanguageNames.h"
+#include "language/TSLanguageRegistry.h"
+#include "utils/ts_exceptions.h"
 #include "utils/ts_obj_utils.h"
 #include "ts__log.h"
 #include "utils/ts_preconditions.h"
 
 #include "ts_language.h"
 
-typedef const TSLanguage *(*TsLangFunc)();
-
 static jint TSLanguage_symCount(JNIEnv *env, jclass self, jlong ptr) {
   req_nnp(env, ptr);
   return (jint) ts_language_symbol_count((TSLanguage *) ptr);
@@ -57,15 +60,14 @@ static jint TSLanguage_symForName(JNIEnv *env,
 static jstring
 TSLanguage_symName(JNIEnv *env, jclass self, jlong lngPtr, jint sym) {
   req_nnp(env, lngPtr);
-  return env->NewStringUTF(ts_language_symbol_name((TSLanguage *) lngPtr, sym));
+  return TSLanguageNames::symbol_name(env, (TSLanguage *) lngPtr, (TSSymbol) sym);
 }
 
 
 static jstring
 TSLanguage_fldNameForId(JNIEnv *env, jclass self, jlong ptr, jint id) {
   req_nnp(env, ptr);
-  return env->NewStringUTF(ts_language_field_name_for_id((TSLanguage *) ptr,
-                                                         id));
+  return TSLanguageNames::field_name(env, (TSLanguage *) ptr, (TSFieldId) id);
 }
 
 
@@ -95,52 +97,35 @@ static jint TSLanguage_langVer(JNIEnv *env, jclass self, jlong ptr) {
   return (jint) ts_language_version((TSLanguage *) ptr);
 }
 
+/**
+ * Copy the given Java string, which must not be null.
+ */
+static std::string copy_string(JNIEnv *env, jstring str) {
+  auto chars = env->GetStringUTFChars(str, nullptr);
+  std::string result(chars);
+  env->ReleaseStringUTFChars(str, chars);
+  return result;
+}
+
 static jlongArray TSLanguage_loadLanguage(JNIEnv *env,
                                           jclass clazz,
                                           jstring libpath,
                                           jstring func) {
-  auto lib_path = env->GetStringUTFChars(libpath, nullptr);
-  auto func_name = env->GetStringUTFChars(func, nullptr);
-
-  auto handle = dlopen(lib_path, RTLD_LAZY);
-  if (handle == nullptr) {
-    LOGE(LOG_TAG, "Failed to dlopen library '%s': %s", lib_path, dlerror());
-    env->ReleaseStringUTFChars(libpath, lib_path);
-    env->ReleaseStringUTFChars(func, func_name);
-    return nullptr;
-  }
-
-  void *func_addr = dlsym(handle, func_name);
-  if (func_addr == nullptr) {
-    LOGE(LOG_TAG,
-         "Cannot find function '%s' to create language instance: %s",
-         func_name,
-         dlerror());
-    env->ReleaseStringUTFChars(libpath, lib_path);
-    env->ReleaseStringUTFChars(func, func_name);
-    return nullptr;
-  }
-
-  auto lang_func = reinterpret_cast<TsLangFunc>(func_addr);
-  if (lang_func == nullptr) {
-    LOGE(LOG_TAG, "Cannot reinterpreset_cast to TsLangFunc");
-    env->ReleaseStringUTFChars(libpath, lib_path);
-    env->ReleaseStringUTFChars(func, func_name);
+  req_nnp(env, libpath, "libraryPath");
+  req_nnp(env, func, "function");
+  if (env->ExceptionCheck()) {
     return nullptr;
   }
 
-  auto language = lang_func();
-  if (language == nullptr) {
-    LOGE(LOG_TAG, "Function '%s' returned nullptr", func_name);
+  auto func_name = copy_string(env, func);
+  TSLoadedLanguage loaded{};
+  if (!TSLanguageRegistry::load(copy_string(env, libpath), func_name, &loaded)) {
     return nullptr;
   }
 
-  LOGD(LOG_TAG, "Loaded tree sitter language with function '%s'", func_name);
+  LOGD(LOG_TAG, "Loaded tree sitter language with function '%s'", func_name.c_str());
 
-  env->ReleaseStringUTFChars(libpath, lib_path);
-  env->ReleaseStringUTFChars(func, func_name);
-
-  jlong ptrs[2] = {(jlong) language, (jlong) handle};
+  jlong ptrs[2] = {(jlong) loaded.language, (jlong) loaded.handle};
 
   auto result = env->NewLongArray(2);
   env->SetLongArrayRegion(result, 0, 2, ptrs);
@@ -149,7 +134,49 @@ static jlongArray TSLanguage_loadLanguage(JNIEnv *env,
 
 static void TSLanguage_dlclose(JNIEnv *env, jclass clazz, jlong libhandle) {
   if (libhandle == 0) return;
-  dlclose((void *) libhandle);
+  TSLanguageRegistry::release(env, (void *) libhandle);
+}
+
+static void TSLanguage_preload(JNIEnv *env,
+                               jclass clazz,
+                               jobjectArray libpaths,
+                               jobjectArray funcs) {
+  req_nnp(env, libpaths, "libraryPaths");
+  req_nnp(env, funcs, "functions");
+  if (env->ExceptionCheck()) {
+    return;
+  }
+
+  auto count = env->GetArrayLength(libpaths);
+  if (env->GetArrayLength(funcs) != count) {
+    throw_illegal_args(env, "The number of library paths and functions must be the same");
+    return;
+  }
+
+  std::vector<std::pair<std::string, std::string>> languages;
+  languages.reserve(count);
+  for (jsize i = 0; i < count; ++i) {
+    auto path = (jstring) env->GetObjectArrayElement(libpaths, i);
+    auto func = (jstring) env->GetObjectArrayElement(funcs, i);
+    if (path == nullptr || func == nullptr) {
+      throw_npe(env, "The library paths and functions must not be null");
+      return;
+    }
+
+    languages.emplace_back(copy_string(env, path), copy_string(env, func));
+    env->DeleteLocalRef(path);
+    env->DeleteLocalRef(func);
+  }
+
+  TSLanguageRegistry::preload(std::move(languages));
+}
+
+static void TSLanguage_releasePreloaded(JNIEnv *env, jclass clazz) {
+  TSLanguageRegistry::release_preloaded(env);
+}
+
+static jint TSLanguage_libRefCount(JNIEnv *env, jclass clazz, jlong libhandle) {
+  return (jint) TSLanguageRegistry::ref_count((void *) libhandle);
 }
 
 static jint TSLanguage_stateCount(JNIEnv *env, jclass clazz, jlong pointer) {
@@ -168,6 +195,11 @@ static jshort TSLanguage_nextState(JNIEnv *env,
                                          symbol);
 }
 
+static void TSLanguage_internNames(JNIEnv *env, jclass clazz, jlong pointer) {
+  req_nnp(env, pointer);
+  TSLanguageNames::intern(env, (TSLanguage *) pointer);
+}
+
 void TSLanguage_Native__SetJniMethods(JNINativeMethod *methods, int count) {
   SET_JNI_METHOD(methods, TSLanguage_Native_symCount, TSLanguage_symCount);
   SET_JNI_METHOD(methods, TSLanguage_Native_fldCount, TSLanguage_fldCount);
@@ -181,4 +213,8 @@ void TSLanguage_Native__SetJniMethods(JNINativeMethod *methods, int count) {
   SET_JNI_METHOD(methods, TSLanguage_Native_dlclose, TSLanguage_dlclose);
   SET_JNI_METHOD(methods, TSLanguage_Native_stateCount, TSLanguage_stateCount);
   SET_JNI_METHOD(methods, TSLanguage_Native_nextState, TSLanguage_nextState);
+  SET_JNI_METHOD(methods, TSLanguage_Native_internNames, TSLanguage_internNames);
+  SET_JNI_METHOD(methods, TSLanguage_Native_preload, TSLanguage_preload);
+  SET_JNI_METHOD(methods, TSLanguage_Native_releasePreloaded, TSLanguage_releasePreloaded);
+  SET_JNI_METHOD(methods, TSLanguage_Native_libRefCount, TSLanguage_libRefCount);
 }
\ No newline at end of file
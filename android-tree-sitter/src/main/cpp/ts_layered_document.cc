@@ -0,0 +1,151 @@
+/*
+ *  This file is part of android-tree-sitter.
+ *
+ *  android-tree-sitter library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  android-tree-sitter library is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *  along with android-tree-sitter.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include "ts_layered_document.h"
+
+#include <vector>
+
+#include "parser/TSLayeredDocument.h"
+#include "query/TSQueryInternal.h"
+#include "utf16str/UTF16String.h"
+#include "utils/ts_exceptions.h"
+#include "utils/ts_misc.h"
+#include "utils/ts_obj_utils.h"
+#include "utils/ts_preconditions.h"
+
+static TSDocumentLayer *layer_at(JNIEnv *env, jlong document, jint index) {
+  const auto &layers = as_document(env, document)->layers();
+  if (index < 0 || (size_t) index >= layers.size()) {
+    throw_illegal_args(env, "Invalid layer index");
+    return nullptr;
+  }
+  return layers[index];
+}
+
+static jlong TSLayeredDocument_newDocument(JNIEnv *env,
+                                           __TS_ATTR_UNUSED jclass self,
+                                           jlong language,
+                                           jlong injections) {
+  req_nnp(env, language, "language");
+  return (jlong) new TSLayeredDocument((TSLanguage *) language, as_query(env, injections));
+}
+
+static void TSLayeredDocument_delete(JNIEnv *env,
+                                     __TS_ATTR_UNUSED jclass self,
+                                     jlong document) {
+  delete as_document(env, document);
+}
+
+static void TSLayeredDocument_addLanguage(JNIEnv *env,
+                                          __TS_ATTR_UNUSED jclass self,
+                                          jlong document,
+                                          jstring name,
+                                          jlong language) {
+  auto *layered = as_document(env, document);
+  req_nnp(env, language, "language");
+
+  auto c_name = env->GetStringUTFChars(name, nullptr);
+  layered->add_language(c_name, (TSLanguage *) language);
+  env->ReleaseStringUTFChars(name, c_name);
+}
+
+static void TSLayeredDocument_edit(JNIEnv *env,
+                                   __TS_ATTR_UNUSED jclass self,
+                                   jlong document,
+                                   jintArray edits) {
+  auto *layered = as_document(env, document);
+
+  thread_local std::vector<TSInputEdit> unpacked;
+  if (!_unpackEdits(env, edits, unpacked)) {
+    return;
+  }
+
+  for (const auto &edit : unpacked) {
+    layered->edit(edit);
+  }
+}
+
+static jboolean TSLayeredDocument_parse(JNIEnv *env,
+                                        __TS_ATTR_UNUSED jclass self,
+                                        jlong document,
+                                        jlong source) {
+  auto *layered = as_document(env, document);
+  return (jboolean) layered->parse(as_str(env, source));
+}
+
+static jlong TSLayeredDocument_getTree(JNIEnv *env,
+                                       __TS_ATTR_UNUSED jclass self,
+                                       jlong document) {
+  const TSTree *tree = as_document(env, document)->tree();
+  return tree == nullptr ? 0 : (jlong) ts_tree_copy(tree);
+}
+
+static jint TSLayeredDocument_getLayerCount(JNIEnv *env,
+                                            __TS_ATTR_UNUSED jclass self,
+                                            jlong document) {
+  return (jint) as_document(env, document)->layers().size();
+}
+
+static jstring TSLayeredDocument_getLayerName(JNIEnv *env,
+                                              __TS_ATTR_UNUSED jclass self,
+                                              jlong document,
+                                              jint index) {
+  auto *layer = layer_at(env, document, index);
+  return layer == nullptr ? nullptr : env->NewStringUTF(layer->name.c_str());
+}
+
+static jlong TSLayeredDocument_getLayerTree(JNIEnv *env,
+                                            __TS_ATTR_UNUSED jclass self,
+                                            jlong document,
+                                            jint index) {
+  auto *layer = layer_at(env, document, index);
+  return layer == nullptr || layer->tree == nullptr ? 0 : (jlong) ts_tree_copy(layer->tree);
+}
+
+static jintArray TSLayeredDocument_getLayerRanges(JNIEnv *env,
+                                                  __TS_ATTR_UNUSED jclass self,
+                                                  jlong document,
+                                                  jint index) {
+  auto *layer = layer_at(env, document, index);
+  if (layer == nullptr) {
+    return nullptr;
+  }
+  return _packRanges(env, layer->ranges.data(), (uint32_t) layer->ranges.size());
+}
+
+static jboolean TSLayeredDocument_isLayerReparsed(JNIEnv *env,
+                                                  __TS_ATTR_UNUSED jclass self,
+                                                  jlong document,
+                                                  jint index) {
+  auto *layer = layer_at(env, document, index);
+  return (jboolean) (layer != nullptr && layer->reparsed);
+}
+
+void TSLayeredDocument_Native__SetJniMethods(JNINativeMethod *methods, int count) {
+  SET_JNI_METHOD(methods, TSLayeredDocument_Native_newDocument, TSLayeredDocument_newDocument);
+  SET_JNI_METHOD(methods, TSLayeredDocument_Native_delete, TSLayeredDocument_delete);
+  SET_JNI_METHOD(methods, TSLayeredDocument_Native_addLanguage, TSLayeredDocument_addLanguage);
+  SET_JNI_METHOD(methods, TSLayeredDocument_Native_edit, TSLayeredDocument_edit);
+  SET_JNI_METHOD(methods, TSLayeredDocument_Native_parse, TSLayeredDocument_parse);
+  SET_JNI_METHOD(methods, TSLayeredDocument_Native_getTree, TSLayeredDocument_getTree);
+  SET_JNI_METHOD(methods, TSLayeredDocument_Native_getLayerCount, TSLayeredDocument_getLayerCount);
+  SET_JNI_METHOD(methods, TSLayeredDocument_Native_getLayerName, TSLayeredDocument_getLayerName);
+  SET_JNI_METHOD(methods, TSLayeredDocument_Native_getLayerTree, TSLayeredDocument_getLayerTree);
+  SET_JNI_METHOD(methods, TSLayeredDocument_Native_getLayerRanges, TSLayeredDocument_getLayerRanges);
+  SET_JNI_METHOD(methods, TSLayeredDocument_Native_isLayerReparsed, TSLayeredDocument_isLayerReparsed);
+}
@@ -17,8 +17,10 @@
 
 #include <cstring>
 #include <jni.h>
+#include <vector>
 
 #include "tree_sitter/api.h"
+#include "language/TSLanguageNames.h"
 #include "utils/jni_string.h"
 #include "utils/ts_preconditions.h"
 
@@ -55,9 +57,10 @@ static jstring TSLookaheadIterator_currentSymbolName(JNIEnv *env,
                                                      jclass clazz,
                                                      jlong pointer) {
   req_nnp(env, pointer);
-  const char *name =
-      ts_lookahead_iterator_current_symbol_name((TSLookaheadIterator *) pointer);
-  return env->NewStringUTF(name);
+  auto *iterator = (TSLookaheadIterator *) pointer;
+  return TSLanguageNames::symbol_name(env,
+                                      ts_lookahead_iterator_language(iterator),
+                                      ts_lookahead_iterator_current_symbol(iterator));
 }
 
 static jboolean TSLookaheadIterator_resetState(JNIEnv *env,
@@ -87,6 +90,134 @@ TSLookaheadIterator_language(JNIEnv *env, jclass clazz, jlong pointer) {
   return (jlong) ts_lookahead_iterator_language((TSLookaheadIterator *) pointer);
 }
 
+/**
+ * The initial parse state of every language.
+ */
+#define TS_INITIAL_PARSE_STATE 1
+
+/**
+ * Moves the cursor to the last leaf of its current node which is not an extra, if any.
+ */
+static void goto_last_leaf(TSTreeCursor *cursor) {
+  while (ts_tree_cursor_goto_last_child(cursor)) {
+    while (ts_node_is_extra(ts_tree_cursor_current_node(cursor))) {
+      if (!ts_tree_cursor_goto_previous_sibling(cursor)) {
+        ts_tree_cursor_goto_parent(cursor);
+        return;
+      }
+    }
+  }
+}
+
+/**
+ * Find the parse state in which a token starting at the given byte offset would be lexed. This is
+ * the state after the last token which ends at or before the offset, ignoring extras. If the
+ * offset is inside a token, this is the state before that token.
+ */
+static TSStateId parse_state_at(TSTree *tree, uint32_t offset) {
+  auto root = ts_tree_root_node(tree);
+  auto cursor = ts_tree_cursor_new(root);
+
+  // the deepest node which ends at or before the offset, and is not an extra
+  TSNode before = {{0, 0, 0, 0}, nullptr, nullptr};
+  TSNode node = root;
+  while (ts_tree_cursor_goto_first_child(&cursor)) {
+    auto found = false;
+    do {
+      auto child = ts_tree_cursor_current_node(&cursor);
+      if (ts_node_end_byte(child) <= offset) {
+        if (!ts_node_is_extra(child)) {
+          before = child;
+        }
+        continue;
+      }
+
+      if (ts_node_start_byte(child) < offset) {
+        node = child;
+        found = true;
+      }
+      break;
+    } while (ts_tree_cursor_goto_next_sibling(&cursor));
+
+    if (!found) {
+      break;
+    }
+  }
+
+  TSStateId state;
+  if (ts_node_child_count(node) == 0 && ts_node_start_byte(node) < offset
+      && !ts_node_eq(node, root)) {
+    state = ts_node_parse_state(node);
+  } else if (ts_node_is_null(before)) {
+    state = TS_INITIAL_PARSE_STATE;
+  } else {
+    ts_tree_cursor_reset(&cursor, before);
+    goto_last_leaf(&cursor);
+    state = ts_node_next_parse_state(ts_tree_cursor_current_node(&cursor));
+  }
+
+  ts_tree_cursor_delete(&cursor);
+  return state;
+}
+
+static bool is_valid_state(const TSLanguage *language, TSStateId state) {
+  return state != 0 && state < ts_language_state_count(language);
+}
+
+static jshort TSLookaheadIterator_parseStateAt(JNIEnv *env,
+                                               jclass clazz,
+                                               jlong tree,
+                                               jint byte_offset) {
+  req_nnp(env, tree, "tree");
+  return (jshort) parse_state_at((TSTree *) tree, (uint32_t) byte_offset);
+}
+
+static jshortArray TSLookaheadIterator_symbolsAt(JNIEnv *env,
+                                                 jclass clazz,
+                                                 jlong tree,
+                                                 jint byte_offset) {
+  req_nnp(env, tree, "tree");
+
+  auto *ts_tree = (TSTree *) tree;
+  auto *language = ts_tree_language(ts_tree);
+  auto state = parse_state_at(ts_tree, (uint32_t) byte_offset);
+  if (!is_valid_state(language, state)) {
+    return env->NewShortArray(0);
+  }
+
+  // reuse the iterator and the buffer across the completion requests on this thread
+  struct ThreadIterator {
+    TSLookaheadIterator *iterator = nullptr;
+
+    ~ThreadIterator() {
+      if (iterator) {
+        ts_lookahead_iterator_delete(iterator);
+      }
+    }
+  };
+
+  thread_local ThreadIterator thread_iterator;
+  thread_local std::vector<jshort> symbols;
+
+  auto *&iterator = thread_iterator.iterator;
+  if (!iterator) {
+    iterator = ts_lookahead_iterator_new(language, state);
+  } else if (ts_lookahead_iterator_language(iterator) == language) {
+    ts_lookahead_iterator_reset_state(iterator, state);
+  } else {
+    ts_lookahead_iterator_reset(iterator, language, state);
+  }
+
+  symbols.clear();
+  while (iterator && ts_lookahead_iterator_next(iterator)) {
+    symbols.push_back((jshort) ts_lookahead_iterator_current_symbol(iterator));
+  }
+
+  auto result = env->NewShortArray((jsize) symbols.size());
+  env->SetShortArrayRegion(result, 0, (jsize) symbols.size(), symbols.data());
+  return result;
+}
+
 void TSLookaheadIterator_Native__SetJniMethods(JNINativeMethod *methods, int count) {
   SET_JNI_METHOD(methods, TSLookaheadIterator_Native_newIterator,
                  TSLookaheadIterator_newIterator);
@@ -101,4 +232,8 @@ void TSLookaheadIterator_Native__SetJniMethods(JNINativeMethod *methods, int cou
   SET_JNI_METHOD(methods, TSLookaheadIterator_Native_reset, TSLookaheadIterator_reset);
   SET_JNI_METHOD(methods, TSLookaheadIterator_Native_language,
                  TSLookaheadIterator_language);
+  SET_JNI_METHOD(methods, TSLookaheadIterator_Native_parseStateAt,
+                 TSLookaheadIterator_parseStateAt);
+  SET_JNI_METHOD(methods, TSLookaheadIterator_Native_symbolsAt,
+                 TSLookaheadIterator_symbolsAt);
 }
\ No newline at end of file
@@ -15,6 +15,8 @@
  *  along with android-tree-sitter.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include "language/TSLanguageNames.h"
+#include "utils/ts_allocator.h"
 #include "utils/ts_obj_utils.h"
 #include "utils/ts_preconditions.h"
 #include "ts__log.h"
@@ -201,7 +203,7 @@ TSNode_isEqualTo(JNIEnv *env, jclass clazz, jobject self, jobject other) {
 static jstring TSNode_getNodeString(JNIEnv *env, jclass clazz, jobject self) {
   char *nodeString = ts_node_string(_unmarshalNode(env, self));
   jstring result = env->NewStringUTF(nodeString);
-  free(nodeString);
+  TSAllocator::free(nodeString);
   return result;
 }
 
@@ -222,9 +224,8 @@ static jobject TSNode_getEndPoint(JNIEnv *env, jclass clazz, jobject self) {
 }
 
 static jstring TSNode_getType(JNIEnv *env, jclass clazz, jobject self) {
-  const char *type = ts_node_type(_unmarshalNode(env, self));
-  jstring result = env->NewStringUTF(type);
-  return result;
+  TSNode node = _unmarshalNode(env, self);
+  return TSLanguageNames::symbol_name(env, ts_node_language(node), ts_node_symbol(node));
 }
 
 static jshort TSNode_getSymbol(JNIEnv *env, jclass clazz, jobject self) {
@@ -287,11 +288,82 @@ static jint TSNode_getDescendantCount(JNIEnv *env, jclass clazz, jobject self) {
 }
 
 
+static jintArray
+TSNode_getChildren(JNIEnv *env, jclass clazz, jobject self, jboolean named) {
+  TSNode node = _unmarshalNode(env, self);
+  std::vector<jint> records;
+  records.reserve(ts_node_child_count(node) * PACKED_NODE_SIZE);
+
+  // walking the children with a cursor is linear in the number of children
+  // while ts_node_child(node, i) has to skip the first i children every time
+  TSTreeCursor cursor = ts_tree_cursor_new(node);
+  if (ts_tree_cursor_goto_first_child(&cursor)) {
+    do {
+      TSNode child = ts_tree_cursor_current_node(&cursor);
+      if (!named || ts_node_is_named(child)) {
+        _packNode(records, child);
+      }
+    } while (ts_tree_cursor_goto_next_sibling(&cursor));
+  }
+  ts_tree_cursor_delete(&cursor);
+
+  return _newIntArray(env, records);
+}
+
+static jintArray TSNode_getDescendantsInByteRange(JNIEnv *env,
+                                                  jclass clazz,
+                                                  jobject self,
+                                                  jint start,
+                                                  jint end,
+                                                  jboolean named) {
+  TSNode node = _unmarshalNode(env, self);
+  std::vector<jint> records;
+
+  // pre-order traversal, only descending into the nodes which intersect with
+  // the given byte range i.e. start_byte < end && end_byte > start
+  TSTreeCursor cursor = ts_tree_cursor_new(node);
+  uint32_t depth = 0;
+  bool visit_children = true;
+  while (true) {
+    if (visit_children && ts_tree_cursor_goto_first_child(&cursor)) {
+      ++depth;
+    } else {
+      while (depth > 0 && !ts_tree_cursor_goto_next_sibling(&cursor)) {
+        ts_tree_cursor_goto_parent(&cursor);
+        --depth;
+      }
+
+      if (depth == 0) {
+        break;
+      }
+    }
+
+    TSNode current = ts_tree_cursor_current_node(&cursor);
+    auto node_start = ts_node_start_byte(current);
+    auto node_end = ts_node_end_byte(current);
+    if (node_start >= (uint32_t) end) {
+      // the remaining siblings start after the end of the range
+      // move to the last sibling so that the traversal continues with the parent
+      while (ts_tree_cursor_goto_next_sibling(&cursor));
+      visit_children = false;
+      continue;
+    }
+
+    visit_children = node_end > (uint32_t) start;
+    if (visit_children && (!named || ts_node_is_named(current))) {
+      _packNode(records, current);
+    }
+  }
+  ts_tree_cursor_delete(&cursor);
+
+  return _newIntArray(env, records);
+}
+
 static jstring TSNode_getGrammarType(JNIEnv *env, jclass clazz, jobject self) {
   TSNode node = _unmarshalNode(env, self);
-  const char *grammar_type = ts_node_grammar_type(node);
-  jstring result = env->NewStringUTF(grammar_type);
-  return result;
+  return TSLanguageNames::symbol_name(env,
+                                     ts_node_language(node),
+                                     ts_node_grammar_symbol(node));
 }
 
 static jlong TSNode_getLanguage(JNIEnv *env, jclass clazz, jobject self) {
@@ -349,4 +421,7 @@ void TSNode_Native__SetJniMethods(JNINativeMethod *methods, int count) {
   SET_JNI_METHOD(methods, TSNode_Native_getDescendantCount, TSNode_getDescendantCount);
   SET_JNI_METHOD(methods, TSNode_Native_getGrammarType, TSNode_getGrammarType);
   SET_JNI_METHOD(methods, TSNode_Native_getLanguage, TSNode_getLanguage);
+  SET_JNI_METHOD(methods, TSNode_Native_getChildren, TSNode_getChildren);
+  SET_JNI_METHOD(methods, TSNode_Native_getDescendantsInByteRange,
+                 TSNode_getDescendantsInByteRange);
 }
\ No newline at end of file
@@ -18,110 +18,95 @@
 #include <atomic>
 #include <mutex>
 #include <iostream>
+#include <algorithm>
+#include <vector>
 
+#include "parser/TSInputs.h"
+#include "parser/TSParserInternal.h"
 #include "utf16str/UTF16String.h"
 #include "utils/ts_obj_utils.h"
 #include "utils/ts_exceptions.h"
 #include "utils/ts_preconditions.h"
+#include "utils/ts_misc.h"
+#include "utils/ts_instrumentation.h"
 #include "ts__log.h"
 
 #include "ts_parser.h"
 
 /**
- * `TSParserInternal` stores the actual tree sitter parser instance along
- * with the cancellation flag and the cancellation flag mutex.
+ * Payload for the `TSInput` which reads the source code from a Java
+ * `TSInputReader`, one chunk at a time.
  */
-class TSParserInternal {
- public:
+struct JavaInputPayload {
+  JNIEnv *env;
+  jobject reader;
+  jcharArray buffer;
+  jint buffer_size;
+  std::vector<jchar> chunk;
+  bool failed;
+};
 
-  TSParserInternal() {
-    cancellation_flag_mutex = new std::mutex();
-    cancellation_flag = new std::atomic<size_t *>(nullptr);
-    parser = ts_parser_new();
+static const char *
+java_input_read(void *payload,
+                uint32_t byte_index,
+                __TS_ATTR_UNUSED TSPoint position,
+                uint32_t *bytes_read) {
+  auto *input = (JavaInputPayload *) payload;
+  *bytes_read = 0;
+
+  // a previous read threw an exception, do not call into Java code
+  // until the exception has been thrown to the caller
+  if (input->failed) {
+    return "";
   }
 
-  ~TSParserInternal() {
-    delete cancellation_flag_mutex;
-    delete cancellation_flag;
-    ts_parser_delete(parser);
-
-    cancellation_flag_mutex = nullptr;
-    cancellation_flag = nullptr;
-    parser = nullptr;
+  auto env = input->env;
+  auto count = _readInput(env, input->reader, (jint) (byte_index >> 1), input->buffer);
+  if (env->ExceptionCheck()) {
+    input->failed = true;
+    return "";
   }
 
-  TSParser *getParser(JNIEnv *env) {
-    if (check_destroyed(env)) {
-      return nullptr;
-    }
-
-    return this->parser;
-  }
-
-  bool begin_round(JNIEnv *env) {
-    auto flag = get_cancellation_flag(env);
-
-    if (flag) {
-      throw_illegal_state(env,
-                          "Parser is already parsing another syntax tree! You must cancel the current parse first!");
-      return false;
-    }
-
-    // allocate a new cancellation flag
-    flag = (size_t *) malloc(sizeof(int));
-    set_cancellation_flag(env, flag);
-
-    // set the cancellation flag to '0' to indicate that the parser should continue parsing
-    *flag = 0;
-    ts_parser_set_cancellation_flag(getParser(env), flag);
-
-    return true;
+  if (count <= 0) {
+    return "";
   }
 
-  void end_round(JNIEnv *env) {
-
-    size_t *flag = get_cancellation_flag(env);
-
-    // release the cancellation flag
-    free((size_t *) flag);
-    set_cancellation_flag(env, nullptr);
-    ts_parser_set_cancellation_flag(getParser(env), nullptr);
-  }
-
-  size_t *get_cancellation_flag(JNIEnv *env) {
-    if (check_destroyed(env)) {
-      return nullptr;
-    }
+  count = std::min(count, input->buffer_size);
+  env->GetCharArrayRegion(input->buffer, 0, count, input->chunk.data());
+  *bytes_read = (uint32_t) count << 1;
+  return (const char *) input->chunk.data();
+}
 
-    std::lock_guard<std::mutex> get_lock(*cancellation_flag_mutex);
-    return cancellation_flag->load();
-  }
+/**
+ * Payload for the `TSInput` which reads the source code from a list of
+ * `UTF16String` chunks.
+ */
+struct ChunkedInputPayload {
+  std::vector<UTF16String *> chunks;
 
-  void set_cancellation_flag(JNIEnv *env, size_t *flag) {
-    if (check_destroyed(env)) {
-      return;
-    }
+  // the byte offset at which each chunk starts
+  std::vector<uint32_t> offsets;
+};
 
-    std::lock_guard<std::mutex> set_lock(*cancellation_flag_mutex);
-    cancellation_flag->store(flag);
+static const char *
+chunked_input_read(void *payload,
+                   uint32_t byte_index,
+                   __TS_ATTR_UNUSED TSPoint position,
+                   uint32_t *bytes_read) {
+  auto *input = (ChunkedInputPayload *) payload;
+  *bytes_read = 0;
+
+  // find the last chunk which starts at or before byte_index
+  // empty chunks share their offset with the next chunk and are skipped
+  auto it = std::upper_bound(input->offsets.begin(), input->offsets.end(), byte_index);
+  if (it == input->offsets.begin()) {
+    return "";
   }
 
- private:
-  std::mutex *cancellation_flag_mutex;
-  std::atomic<size_t *> *cancellation_flag;
-
-  TSParser *parser;
-
-  bool check_destroyed(JNIEnv *env) {
-    if (cancellation_flag_mutex == nullptr || cancellation_flag == nullptr
-        || parser == nullptr) {
-      throw_illegal_state(env, "TSParserInternal has already been destroyed");
-      return true;
-    }
-
-    return false;
-  }
-};
+  auto idx = std::distance(input->offsets.begin(), it) - 1;
+  auto chunk = input->chunks[idx]->chunk_at(byte_index - input->offsets[idx], bytes_read);
+  return chunk ? chunk : "";
+}
 
 static jlong
 TSParser_newParser(JNIEnv *env,
@@ -197,17 +182,47 @@ TSParser_setIncludedRanges(
     jobjectArray ranges) {
   req_nnp(env, parser);
   int count = env->GetArrayLength(ranges);
-  TSRange tsRanges[count];
+
+  // allocated on the heap, the number of ranges is not bounded
+  std::vector<TSRange> tsRanges;
+  tsRanges.reserve(count);
   for (int i = 0; i < count; i++) {
     jobject range = env->GetObjectArrayElement(ranges, i);
     std::string msg = std::string("ranges[") + std::to_string(i) + "]";
     req_nnp(env, range, msg);
-    tsRanges[i] = _unmarshalRange(env, range);
+    if (env->ExceptionCheck()) {
+      return false;
+    }
+    tsRanges.push_back(_unmarshalRange(env, range));
+    env->DeleteLocalRef(range);
+  }
+
+  return (jboolean) ts_parser_set_included_ranges(((TSParserInternal *) parser)->getParser(
+      env), tsRanges.data(), count);
+}
+
+static jboolean TSParser_setIncludedRangesPacked(JNIEnv *env,
+                                                 jclass self,
+                                                 jlong parser,
+                                                 jintArray ranges) {
+  req_nnp(env, parser);
+  thread_local std::vector<TSRange> unpacked;
+  if (!_unpackRanges(env, ranges, unpacked)) {
+    return false;
   }
 
-  const TSRange *r = tsRanges;
   return (jboolean) ts_parser_set_included_ranges(((TSParserInternal *) parser)->getParser(
-      env), r, count);
+      env), unpacked.data(), (uint32_t) unpacked.size());
+}
+
+static jintArray TSParser_getIncludedRangesPacked(JNIEnv *env,
+                                                  jclass self,
+                                                  jlong parser) {
+  req_nnp(env, parser);
+  uint32_t count = 0;
+  const TSRange *ranges =
+      ts_parser_included_ranges(((TSParserInternal *) parser)->getParser(env), &count);
+  return _packRanges(env, ranges, count);
 }
 
 static jobjectArray
@@ -230,6 +245,32 @@ TSParser_getIncludedRanges(
   return result;
 }
 
+static TSTree *parse_input(JNIEnv *env,
+                           jlong parser,
+                           jlong tree_pointer,
+                           TSInput input) {
+  auto *ts_parser_internal = (TSParserInternal *) parser;
+  TSParser *ts_parser = ts_parser_internal->getParser(env);
+  TSTree *old_tree = tree_pointer == 0 ? nullptr : (TSTree *) tree_pointer;
+
+  if (!ts_parser_internal->begin_round(env)) {
+    return nullptr;
+  }
+
+  // start parsing
+  // if the user cancels the parse while this method is being executed
+  // then this will return nullptr
+  TSTree *tree;
+  {
+    TSTraceSection section("TSParser#parse");
+    tree = ts_parser_parse(ts_parser, old_tree,
+                           ts_parser_internal->track_progress(input));
+  }
+
+  ts_parser_internal->end_round(env, tree);
+  return tree;
+}
+
 static jlong TSParser_parse(JNIEnv *env,
                             jclass clazz,
                             jlong parser,
@@ -237,31 +278,149 @@ static jlong TSParser_parse(JNIEnv *env,
                             jlong str_pointer) {
   req_nnp(env, parser);
   req_nnp(env, str_pointer, "string");
-  auto *ts_parser_internal = (TSParserInternal *) parser;
-  TSParser *ts_parser = ts_parser_internal->getParser(env);
-  TSTree *old_tree = tree_pointer == 0 ? nullptr : (TSTree *) tree_pointer;
   auto *source = as_str(env, str_pointer);
 
-  if (!ts_parser_internal->begin_round(env)) {
+  // tree-sitter reads the source directly from the string's storage
+  // the string must not be modified until the parse completes
+  auto tree = parse_input(env, parser, tree_pointer,
+                          ts_input_from_string(source));
+
+  return (jlong) tree;
+}
+
+static jintArray TSParser_reparse(JNIEnv *env,
+                                  jclass clazz,
+                                  jlong parser,
+                                  jlong tree_pointer,
+                                  jintArray edits,
+                                  jlong str_pointer,
+                                  jlongArray new_tree) {
+  req_nnp(env, parser);
+  req_nnp(env, tree_pointer, "oldTree");
+  req_nnp(env, str_pointer, "string");
+  auto *old_tree = (TSTree *) tree_pointer;
+  auto *source = as_str(env, str_pointer);
+  if (env->ExceptionCheck() || !_applyPackedEdits(env, old_tree, edits)) {
+    return nullptr;
+  }
+
+  auto tree = parse_input(env, parser, tree_pointer,
+                          ts_input_from_string(source));
+  if (!tree) {
+    return nullptr;
+  }
+
+  auto tree_ptr = (jlong) tree;
+  env->SetLongArrayRegion(new_tree, 0, 1, &tree_ptr);
+  return _packChangedRanges(env, old_tree, tree);
+}
+
+static jlong TSParser_parseInput(JNIEnv *env,
+                                 jclass clazz,
+                                 jlong parser,
+                                 jlong tree_pointer,
+                                 jobject reader,
+                                 jcharArray buffer) {
+  req_nnp(env, parser);
+  req_nnp(env, reader, "reader");
+  req_nnp(env, buffer, "buffer");
+
+  JavaInputPayload payload;
+  payload.env = env;
+  payload.reader = reader;
+  payload.buffer = buffer;
+  payload.buffer_size = env->GetArrayLength(buffer);
+  payload.chunk.resize(payload.buffer_size);
+  payload.failed = false;
+
+  TSInput input = {&payload, java_input_read, TSInputEncodingUTF16};
+  auto tree = parse_input(env, parser, tree_pointer, input);
+
+  // the reader threw an exception, the tree (if any) is incomplete
+  // the pending exception is thrown to the Java caller when we return
+  if (payload.failed) {
+    ts_tree_delete(tree);
     return 0;
   }
 
-  auto src_cstring = source->to_cstring();
+  return (jlong) tree;
+}
 
-  // start parsing
-  // if the user cancels the parse while this method is being executed
-  // then this will return nullptr
-  auto tree = ts_parser_parse_string_encoding(ts_parser,
-                                              old_tree,
-                                              src_cstring,
-                                              source->byte_length(),
-                                              TSInputEncodingUTF16);
+static jlong TSParser_parseChunks(JNIEnv *env,
+                                  jclass clazz,
+                                  jlong parser,
+                                  jlong tree_pointer,
+                                  jlongArray str_pointers) {
+  req_nnp(env, parser);
+  req_nnp(env, str_pointers, "chunks");
 
-  ts_parser_internal->end_round(env);
-  delete[] src_cstring;
+  auto count = env->GetArrayLength(str_pointers);
+  std::vector<jlong> pointers(count);
+  env->GetLongArrayRegion(str_pointers, 0, count, pointers.data());
 
+  ChunkedInputPayload payload;
+  payload.chunks.reserve(count);
+  payload.offsets.reserve(count);
 
-  return (jlong) tree;
+  uint32_t offset = 0;
+  for (auto pointer: pointers) {
+    auto *chunk = as_str(env, pointer);
+    if (env->ExceptionCheck()) {
+      return 0;
+    }
+
+    payload.chunks.push_back(chunk);
+    payload.offsets.push_back(offset);
+    offset += chunk->byte_length();
+  }
+
+  TSInput input = {&payload, chunked_input_read, TSInputEncodingUTF16};
+  return (jlong) parse_input(env, parser, tree_pointer, input);
+}
+
+static jlong TSParser_parseFile(JNIEnv *env,
+                                jclass clazz,
+                                jlong parser,
+                                jlong tree_pointer,
+                                jstring path,
+                                jint encoding) {
+  req_nnp(env, parser);
+
+  auto c_path = env->GetStringUTFChars(path, nullptr);
+  TSMappedFile file;
+  int error = file.map(c_path);
+  if (error != 0) {
+    throw_io_exception(env, ts_mapping_error(c_path, error).c_str());
+    env->ReleaseStringUTFChars(path, c_path);
+    return 0;
+  }
+  env->ReleaseStringUTFChars(path, c_path);
+
+  // the file is unmapped when this function returns, the tree does not
+  // reference the source after the parse
+  auto input = file.as_input((TSInputEncoding) encoding);
+  return (jlong) parse_input(env, parser, tree_pointer, input);
+}
+
+static jlong TSParser_getParseProgress(JNIEnv *env,
+                                       jclass clazz,
+                                       jlong parser) {
+  req_nnp(env, parser);
+  return (jlong) ((TSParserInternal *) parser)->get_bytes_read();
+}
+
+static jlongArray TSParser_getStats(JNIEnv *env,
+                                    jclass clazz,
+                                    jlong parser) {
+  req_nnp(env, parser);
+  return ((TSParserInternal *) parser)->get_stats().pack(env);
+}
+
+static void TSParser_resetStats(JNIEnv *env,
+                                jclass clazz,
+                                jlong parser) {
+  req_nnp(env, parser);
+  ((TSParserInternal *) parser)->get_stats().reset();
 }
 
 static jboolean
@@ -270,19 +429,13 @@ TSParser_requestCancellation(
     jclass clazz,
     jlong parser) {
 
+  req_nnp(env, parser);
   auto *parserInternal = (TSParserInternal *) parser;
-  auto flag = parserInternal->get_cancellation_flag(env);
-
-  // no parse is in progress
-  if (flag == nullptr) {
-    LOGD("TSParser",
-         "Cannot cancel parsing, no parse is in progress (cancellation flag is nullptr).");
+  if (!parserInternal->request_cancellation()) {
+    LOGD("TSParser", "Cannot cancel parsing, no parse is in progress.");
     return false;
   }
 
-  // set the cancellation flag to a non-zero value to indicate that the parse
-  // operation has been cancelled
-  *flag = 1;
   LOGD("TSParser", "Cancellation flag has been set");
   return true;
 }
@@ -297,7 +450,17 @@ void TSParser_Native__SetJniMethods(JNINativeMethod *methods, int count) {
   SET_JNI_METHOD(methods, TSParser_Native_getTimeout, TSParser_getTimeout);
   SET_JNI_METHOD(methods, TSParser_Native_setIncludedRanges, TSParser_setIncludedRanges);
   SET_JNI_METHOD(methods, TSParser_Native_getIncludedRanges, TSParser_getIncludedRanges);
+  SET_JNI_METHOD(methods, TSParser_Native_setIncludedRangesPacked, TSParser_setIncludedRangesPacked);
+  SET_JNI_METHOD(methods, TSParser_Native_getIncludedRangesPacked, TSParser_getIncludedRangesPacked);
   SET_JNI_METHOD(methods, TSParser_Native_parse, TSParser_parse);
   SET_JNI_METHOD(methods, TSParser_Native_requestCancellation,
                  TSParser_requestCancellation);
+  SET_JNI_METHOD(methods, TSParser_Native_parseInput, TSParser_parseInput);
+  SET_JNI_METHOD(methods, TSParser_Native_parseChunks, TSParser_parseChunks);
+  SET_JNI_METHOD(methods, TSParser_Native_parseFile, TSParser_parseFile);
+  SET_JNI_METHOD(methods, TSParser_Native_getParseProgress,
+                 TSParser_getParseProgress);
+  SET_JNI_METHOD(methods, TSParser_Native_getStats, TSParser_getStats);
+  SET_JNI_METHOD(methods, TSParser_Native_resetStats, TSParser_resetStats);
+  SET_JNI_METHOD(methods, TSParser_Native_reparse, TSParser_reparse);
 }
\ No newline at end of file
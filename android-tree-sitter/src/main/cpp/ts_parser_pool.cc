@@ -0,0 +1,223 @@
+/*
+ *  This file is part of android-tree-sitter.
+ *
+ *  android-tree-sitter library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  android-tree-sitter library is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *  along with android-tree-sitter.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include "ts_parser_pool.h"
+
+#include <string>
+#include <vector>
+
+#include "parser/TSInputs.h"
+#include "parser/TSParserInternal.h"
+#include "parser/TSParserPool.h"
+#include "utf16str/UTF16String.h"
+#include "utils/ts_misc.h"
+#include "utils/ts_preconditions.h"
+#include "utils/ts_thread_pool.h"
+
+static jlong TSParserPool_newPool(JNIEnv *env,
+                                  __TS_ATTR_UNUSED jclass self,
+                                  jlong language,
+                                  jint max_size) {
+  req_nnp(env, language, "language");
+  return (jlong) new TSParserPool((TSLanguage *) language, (uint32_t) max_size);
+}
+
+static void TSParserPool_destroy(JNIEnv *env,
+                                 __TS_ATTR_UNUSED jclass self,
+                                 jlong pool) {
+  req_nnp(env, pool);
+  ((TSParserPool *) pool)->destroy();
+}
+
+static jlong TSParserPool_acquire(JNIEnv *env,
+                                  __TS_ATTR_UNUSED jclass self,
+                                  jlong pool,
+                                  jlong timeout_millis) {
+  req_nnp(env, pool);
+  return (jlong) ((TSParserPool *) pool)->acquire(timeout_millis);
+}
+
+static void TSParserPool_release(JNIEnv *env,
+                                 __TS_ATTR_UNUSED jclass self,
+                                 jlong pool,
+                                 jlong parser) {
+  req_nnp(env, pool);
+  req_nnp(env, parser, "parser");
+  ((TSParserPool *) pool)->release((TSParserInternal *) parser);
+}
+
+static jint TSParserPool_size(JNIEnv *env,
+                              __TS_ATTR_UNUSED jclass self,
+                              jlong pool) {
+  req_nnp(env, pool);
+  return (jint) ((TSParserPool *) pool)->size();
+}
+
+static jint TSParserPool_idleCount(JNIEnv *env,
+                                   __TS_ATTR_UNUSED jclass self,
+                                   jlong pool) {
+  req_nnp(env, pool);
+  return (jint) ((TSParserPool *) pool)->idle_count();
+}
+
+static jlongArray TSParserPool_parseBatch(JNIEnv *env,
+                                          __TS_ATTR_UNUSED jclass self,
+                                          jlong pool,
+                                          jlongArray str_pointers,
+                                          jlong timeout_micros) {
+  req_nnp(env, pool);
+  req_nnp(env, str_pointers, "sources");
+
+  auto count = (uint32_t) env->GetArrayLength(str_pointers);
+  std::vector<jlong> pointers(count);
+  env->GetLongArrayRegion(str_pointers, 0, (jsize) count, pointers.data());
+
+  std::vector<UTF16String *> sources(count);
+  for (uint32_t i = 0; i < count; ++i) {
+    sources[i] = as_str(env, pointers[i]);
+    if (env->ExceptionCheck()) {
+      return nullptr;
+    }
+  }
+
+  auto *parser_pool = (TSParserPool *) pool;
+  std::vector<jlong> trees(count, 0);
+
+  // each worker parses with its own parser from the pool and picks the next
+  // source as soon as it is done with the previous one, so that a few large
+  // sources do not keep the other workers idle
+  ts_run_parallel(count, parser_pool->max_size(),
+                  [&](uint32_t worker_index, const TSNextJob &next_job) {
+    // only the calling thread waits for a parser to be released, the other
+    // workers give up if the pool is exhausted and leave the sources to the
+    // workers which got a parser
+    auto *parser = parser_pool->acquire(worker_index == 0 ? -1 : 0);
+    if (!parser) {
+      return;
+    }
+
+    TSParser *ts_parser = parser->raw_parser();
+    ts_parser_set_timeout_micros(ts_parser, (uint64_t) timeout_micros);
+
+    for (auto i = next_job(); i < count; i = next_job()) {
+      TSTree *tree = ts_parser_parse(ts_parser, nullptr,
+                                     ts_input_from_string(sources[i]));
+      if (!tree) {
+        // the parse timed out, discard its state before parsing the next source
+        ts_parser_reset(ts_parser);
+      }
+      trees[i] = (jlong) tree;
+    }
+
+    parser_pool->release(parser);
+  });
+
+  auto result = env->NewLongArray((jsize) count);
+  env->SetLongArrayRegion(result, 0, (jsize) count, trees.data());
+  return result;
+}
+
+static jlongArray TSParserPool_parseFileBatch(JNIEnv *env,
+                                              __TS_ATTR_UNUSED jclass self,
+                                              jlong pool,
+                                              jobjectArray paths,
+                                              jint encoding,
+                                              jlong timeout_micros,
+                                              jobjectArray errors) {
+  req_nnp(env, pool);
+  req_nnp(env, paths, "paths");
+  req_nnp(env, errors, "errors");
+
+  auto count = (uint32_t) env->GetArrayLength(paths);
+  std::vector<std::string> file_paths(count);
+  for (uint32_t i = 0; i < count; ++i) {
+    auto path = (jstring) env->GetObjectArrayElement(paths, (jsize) i);
+    auto c_path = env->GetStringUTFChars(path, nullptr);
+    file_paths[i] = c_path;
+    env->ReleaseStringUTFChars(path, c_path);
+    env->DeleteLocalRef(path);
+  }
+
+  auto *parser_pool = (TSParserPool *) pool;
+  std::vector<jlong> trees(count, 0);
+
+  // the errno of each file which could not be mapped, each worker only writes
+  // the elements of its own jobs
+  std::vector<int> map_errors(count, 0);
+
+  ts_run_parallel(count, parser_pool->max_size(),
+                  [&](uint32_t worker_index, const TSNextJob &next_job) {
+    auto *parser = parser_pool->acquire(worker_index == 0 ? -1 : 0);
+    if (!parser) {
+      return;
+    }
+
+    TSParser *ts_parser = parser->raw_parser();
+    ts_parser_set_timeout_micros(ts_parser, (uint64_t) timeout_micros);
+
+    // each file is mapped only while it is parsed, so that a large batch
+    // does not keep all the files mapped at once
+    TSMappedFile file;
+    for (auto i = next_job(); i < count; i = next_job()) {
+      int error = file.map(file_paths[i].c_str());
+      if (error != 0) {
+        // the other files are still parsed
+        map_errors[i] = error;
+        continue;
+      }
+
+      TSTree *tree = ts_parser_parse(ts_parser, nullptr,
+                                     file.as_input((TSInputEncoding) encoding));
+      if (!tree) {
+        ts_parser_reset(ts_parser);
+      }
+      trees[i] = (jlong) tree;
+      file.unmap();
+    }
+
+    parser_pool->release(parser);
+  });
+
+  for (uint32_t i = 0; i < count; ++i) {
+    if (map_errors[i] == 0) {
+      continue;
+    }
+
+    auto message = ts_mapping_error(file_paths[i].c_str(), map_errors[i]);
+    auto error = env->NewStringUTF(message.c_str());
+    env->SetObjectArrayElement(errors, (jsize) i, error);
+    env->DeleteLocalRef(error);
+  }
+
+  auto result = env->NewLongArray((jsize) count);
+  env->SetLongArrayRegion(result, 0, (jsize) count, trees.data());
+  return result;
+}
+
+void TSParserPool_Native__SetJniMethods(JNINativeMethod *methods,
+                                        __TS_ATTR_UNUSED int count) {
+  SET_JNI_METHOD(methods, TSParserPool_Native_newPool, TSParserPool_newPool)
+  SET_JNI_METHOD(methods, TSParserPool_Native_destroy, TSParserPool_destroy)
+  SET_JNI_METHOD(methods, TSParserPool_Native_acquire, TSParserPool_acquire)
+  SET_JNI_METHOD(methods, TSParserPool_Native_release, TSParserPool_release)
+  SET_JNI_METHOD(methods, TSParserPool_Native_size, TSParserPool_size)
+  SET_JNI_METHOD(methods, TSParserPool_Native_idleCount, TSParserPool_idleCount)
+  SET_JNI_METHOD(methods, TSParserPool_Native_parseBatch, TSParserPool_parseBatch)
+  SET_JNI_METHOD(methods, TSParserPool_Native_parseFileBatch,
+                 TSParserPool_parseFileBatch)
+}
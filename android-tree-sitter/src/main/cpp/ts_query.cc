@@ -15,6 +15,8 @@
  *  along with android-tree-sitter.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include "query/TSQueryCache.h"
+#include "query/TSQueryInternal.h"
 #include "utils/ts_exceptions.h"
 #include "utils/ts_obj_utils.h"
 #include "utils/ts_preconditions.h"
@@ -31,58 +33,106 @@ static jlong TSQuery_newQuery(JNIEnv *env,
                               jlong language,
                               jstring source) {
   req_nnp(env, language);
-  const char *c_source;
-  uint32_t source_length = env->GetStringLength(source);
-  c_source = env->GetStringUTFChars(source, nullptr);
-  auto error_offset = new uint32_t;
-  auto error_type = new TSQueryError;
-  TSQuery *query = ts_query_new((TSLanguage *) language,
-                                c_source,
-                                source_length,
-                                error_offset,
-                                error_type);
-  fillQuery(env, queryObject, *error_offset, *error_type);
+  req_nnp(env, source);
+
+  // ts_query_new expects the length of the UTF-8 source, in bytes
+  uint32_t source_length = env->GetStringUTFLength(source);
+  const char *c_source = env->GetStringUTFChars(source, nullptr);
+  uint32_t error_offset = 0;
+  TSQueryError error_type = TSQueryErrorNone;
+  TSQueryInternal *query = TSQueryCache::acquire((TSLanguage *) language,
+                                                 c_source,
+                                                 source_length,
+                                                 &error_offset,
+                                                 &error_type);
+  fillQuery(env, queryObject, error_offset, error_type);
   env->ReleaseStringUTFChars(source, c_source);
   return (jlong) query;
 }
 
 static void TSQuery_delete(JNIEnv *env, jclass self, jlong query) {
-  req_nnp(env, query);
-  ts_query_delete((TSQuery *) query);
+  as_query(env, query)->release();
+}
+
+static jboolean TSQuery_preload(JNIEnv *env,
+                                jclass self,
+                                jlong language,
+                                jstring source) {
+  req_nnp(env, language);
+  req_nnp(env, source);
+
+  uint32_t source_length = env->GetStringUTFLength(source);
+  const char *c_source = env->GetStringUTFChars(source, nullptr);
+  uint32_t error_offset;
+  TSQueryError error_type;
+  TSQueryInternal *query = TSQueryCache::acquire((TSLanguage *) language,
+                                                 c_source,
+                                                 source_length,
+                                                 &error_offset,
+                                                 &error_type);
+  env->ReleaseStringUTFChars(source, c_source);
+  if (query == nullptr) {
+    return JNI_FALSE;
+  }
+
+  // the cache keeps its own reference
+  query->release();
+  return JNI_TRUE;
+}
+
+static void TSQuery_evictCached(JNIEnv *env, jclass self, jlong language) {
+  req_nnp(env, language);
+  TSQueryCache::evict((TSLanguage *) language);
+}
+
+static void TSQuery_clearCache(JNIEnv *env, jclass self) {
+  TSQueryCache::clear();
+}
+
+static jint TSQuery_cacheSize(JNIEnv *env, jclass self) {
+  return (jint) TSQueryCache::size();
+}
+
+static jint TSQuery_cacheLimit(JNIEnv *env, jclass self) {
+  return (jint) TSQueryCache::limit();
+}
+
+static void TSQuery_setCacheLimit(JNIEnv *env, jclass self, jint limit) {
+  TSQueryCache::set_limit((size_t) limit);
 }
 
 static jint TSQuery_captureCount(JNIEnv *env, jclass self, jlong query) {
-  req_nnp(env, query);
-  return (jint) ts_query_capture_count((TSQuery *) query);
+  TSQuery *ts_query = as_query(env, query)->query();
+  return (jint) ts_query_capture_count(ts_query);
 }
 
 static jint TSQuery_patternCount(JNIEnv *env, jclass self, jlong query) {
-  req_nnp(env, query);
-  return (jint) ts_query_pattern_count((TSQuery *) query);
+  TSQuery *ts_query = as_query(env, query)->query();
+  return (jint) ts_query_pattern_count(ts_query);
 }
 
 static jint TSQuery_stringCount(JNIEnv *env, jclass self, jlong query) {
-  req_nnp(env, query);
-  return (jint) ts_query_string_count((TSQuery *) query);
+  TSQuery *ts_query = as_query(env, query)->query();
+  return (jint) ts_query_string_count(ts_query);
 }
 
 static jint TSQuery_startByteForPattern(JNIEnv *env,
                                         jclass self,
                                         jlong query,
                                         jint pattern) {
-  req_nnp(env, query);
-  return (jint) ts_query_start_byte_for_pattern((TSQuery *) query, pattern);
+  TSQuery *ts_query = as_query(env, query)->query();
+  return (jint) ts_query_start_byte_for_pattern(ts_query, pattern);
 }
 
 static jobjectArray TSQuery_predicatesForPattern(JNIEnv *env,
                                                  jclass self,
                                                  jlong query,
                                                  jint pattern) {
-  req_nnp(env, query);
+  TSQuery *ts_query = as_query(env, query)->query();
 
   uint32_t count;
   const TSQueryPredicateStep *predicates =
-      ts_query_predicates_for_pattern((TSQuery *) query, pattern, &count);
+      ts_query_predicates_for_pattern(ts_query, pattern, &count);
   jobjectArray result = createQueryPredicateStepArr(env, (jint) count);
   req_nnp(env, result, "TSQueryPredicateStep[] from factory");
 
@@ -97,42 +147,39 @@ static jobjectArray TSQuery_predicatesForPattern(JNIEnv *env,
 
 static jboolean
 TSQuery_patternRooted(JNIEnv *env, jclass self, jlong query, jint pattern) {
-  req_nnp(env, query);
-  return (jboolean) ts_query_is_pattern_rooted((TSQuery *) query, pattern);
+  TSQuery *ts_query = as_query(env, query)->query();
+  return (jboolean) ts_query_is_pattern_rooted(ts_query, pattern);
 }
 
 static jboolean TSQuery_patternNonLocal(JNIEnv *env,
                                         jclass self,
                                         jlong query,
                                         jint pattern_index) {
-  req_nnp(env, query);
-  return (jboolean) ts_query_is_pattern_non_local((TSQuery *) query,
-                                                  pattern_index);
+  TSQuery *ts_query = as_query(env, query)->query();
+  return (jboolean) ts_query_is_pattern_non_local(ts_query, pattern_index);
 }
 
 static jboolean TSQuery_patternGuaranteedAtStep(JNIEnv *env,
                                                 jclass self,
                                                 jlong query,
                                                 jint offset) {
-  req_nnp(env, query);
-  return (jboolean) ts_query_is_pattern_guaranteed_at_step((TSQuery *) query,
-                                                           offset);
+  TSQuery *ts_query = as_query(env, query)->query();
+  return (jboolean) ts_query_is_pattern_guaranteed_at_step(ts_query, offset);
 }
 
 static jstring
 TSQuery_captureNameForId(JNIEnv *env, jclass self, jlong query, jint id) {
-  req_nnp(env, query);
+  TSQuery *ts_query = as_query(env, query)->query();
   uint32_t count;
-  const char
-      *name = ts_query_capture_name_for_id((TSQuery *) query, id, &count);
+  const char *name = ts_query_capture_name_for_id(ts_query, id, &count);
   return (jstring) env->NewStringUTF(name);
 }
 
 static jstring
 TSQuery_stringValueForId(JNIEnv *env, jclass self, jlong query, jint id) {
-  req_nnp(env, query);
+  TSQuery *ts_query = as_query(env, query)->query();
   uint32_t count;
-  const char *str = ts_query_string_value_for_id((TSQuery *) query, id, &count);
+  const char *str = ts_query_string_value_for_id(ts_query, id, &count);
   return env->NewStringUTF(str);
 }
 
@@ -172,8 +219,7 @@ static jint TSQuery_captureQuantifierForId(JNIEnv *env,
                                            jlong query,
                                            jint pattern,
                                            jint capture) {
-  req_nnp(env, query);
-  auto ts_query = (TSQuery *) query;
+  auto ts_query = as_query(env, query)->query();
   auto quantifier =
       ts_query_capture_quantifier_for_id(ts_query, pattern, capture);
   return query_quantifier_id(env, quantifier);
@@ -200,6 +246,12 @@ int query_quantifier_id(JNIEnv *env, TSQuantifier quantifier) {
 void TSQuery_Native__SetJniMethods(JNINativeMethod *methods, int count) {
   SET_JNI_METHOD(methods, TSQuery_Native_newQuery, TSQuery_newQuery);
   SET_JNI_METHOD(methods, TSQuery_Native_delete, TSQuery_delete);
+  SET_JNI_METHOD(methods, TSQuery_Native_preload, TSQuery_preload);
+  SET_JNI_METHOD(methods, TSQuery_Native_evictCached, TSQuery_evictCached);
+  SET_JNI_METHOD(methods, TSQuery_Native_clearCache, TSQuery_clearCache);
+  SET_JNI_METHOD(methods, TSQuery_Native_cacheSize, TSQuery_cacheSize);
+  SET_JNI_METHOD(methods, TSQuery_Native_cacheLimit, TSQuery_cacheLimit);
+  SET_JNI_METHOD(methods, TSQuery_Native_setCacheLimit, TSQuery_setCacheLimit);
   SET_JNI_METHOD(methods, TSQuery_Native_captureCount, TSQuery_captureCount);
   SET_JNI_METHOD(methods, TSQuery_Native_patternCount, TSQuery_patternCount);
   SET_JNI_METHOD(methods, TSQuery_Native_stringCount, TSQuery_stringCount);
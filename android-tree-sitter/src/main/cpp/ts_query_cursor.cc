@@ -15,20 +15,25 @@
  *  along with android-tree-sitter.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
 #include <iostream>
+#include <vector>
 
+#include "query/TSQueryCursorInternal.h"
+#include "query/TSQueryInternal.h"
+#include "query/TSShardedQuery.h"
+#include "utf16str/UTF16String.h"
 #include "utils/ts_obj_utils.h"
 #include "utils/ts_preconditions.h"
 
 #include "ts_query_cursor.h"
 
 static jlong TSQueryCursor_newCursor(JNIEnv *env, jclass self) {
-  return (jlong) ts_query_cursor_new();
+  return (jlong) new TSQueryCursorInternal;
 }
 
 static void TSQueryCursor_delete(JNIEnv *env, jclass self, jlong cursor) {
-  req_nnp(env, cursor);
-  ts_query_cursor_delete((TSQueryCursor *) cursor);
+  delete as_query_cursor(env, cursor);
 }
 
 static void TSQueryCursor_exec(JNIEnv *env,
@@ -36,30 +41,26 @@ static void TSQueryCursor_exec(JNIEnv *env,
                                jlong cursor,
                                jlong query,
                                jobject node) {
-  req_nnp(env, cursor);
-  ts_query_cursor_exec((TSQueryCursor *) cursor,
-                       (TSQuery *) query,
-                       _unmarshalNode(env, node));
+  as_query_cursor(env, cursor)->exec(as_query(env, query)->query(),
+                                     _unmarshalNode(env, node));
 }
 
 static jboolean
 TSQueryCursor_exceededMatchLimit(JNIEnv *env, jclass self, jlong cursor) {
-  req_nnp(env, cursor);
-  return (jboolean) ts_query_cursor_did_exceed_match_limit((TSQueryCursor *) cursor);
+  return (jboolean) ts_query_cursor_did_exceed_match_limit(
+      as_query_cursor(env, cursor)->cursor());
 }
 
 static void TSQueryCursor_setMatchLimit(JNIEnv *env,
                                         jclass self,
                                         jlong cursor,
                                         jint newLimit) {
-  req_nnp(env, cursor);
-  ts_query_cursor_set_match_limit((TSQueryCursor *) cursor, newLimit);
+  ts_query_cursor_set_match_limit(as_query_cursor(env, cursor)->cursor(), newLimit);
 }
 
 static jint
 TSQueryCursor_getMatchLimit(JNIEnv *env, jclass self, jlong cursor) {
-  req_nnp(env, cursor);
-  return (jint) ts_query_cursor_match_limit((TSQueryCursor *) cursor);
+  return (jint) ts_query_cursor_match_limit(as_query_cursor(env, cursor)->cursor());
 }
 
 static void TSQueryCursor_setByteRange(JNIEnv *env,
@@ -67,8 +68,7 @@ static void TSQueryCursor_setByteRange(JNIEnv *env,
                                        jlong cursor,
                                        jint start,
                                        jint end) {
-  req_nnp(env, cursor);
-  ts_query_cursor_set_byte_range((TSQueryCursor *) cursor, start, end);
+  ts_query_cursor_set_byte_range(as_query_cursor(env, cursor)->cursor(), start, end);
 }
 
 static void TSQueryCursor_setPointRange(JNIEnv *env,
@@ -76,26 +76,258 @@ static void TSQueryCursor_setPointRange(JNIEnv *env,
                                         jlong cursor,
                                         jobject start,
                                         jobject end) {
-  req_nnp(env, cursor);
-  ts_query_cursor_set_point_range((TSQueryCursor *) cursor,
+  ts_query_cursor_set_point_range(as_query_cursor(env, cursor)->cursor(),
                                   _unmarshalPoint(env, start),
                                   _unmarshalPoint(env, end));
 }
 
-static jobject TSQueryCursor_nextMatch(JNIEnv *env, jclass self, jlong cursor) {
-  req_nnp(env, cursor);
+/**
+ * Get the source text that the standard text predicates of the query must be
+ * evaluated against, or nullptr if the predicates must not be evaluated.
+ */
+static const UTF16String *predicate_source(jlong source) {
+  return source == 0 ? nullptr : (const UTF16String *) source;
+}
+
+static jobject TSQueryCursor_nextMatch(JNIEnv *env,
+                                       jclass self,
+                                       jlong cursor,
+                                       jlong query,
+                                       jlong source) {
+  auto *cursor_internal = as_query_cursor(env, cursor);
+  auto *internal = as_query(env, query);
+  auto *text = predicate_source(source);
+  auto start_ns = TSQueryCursorInternal::begin_next();
+  uint32_t rejections = 0;
+  TSQueryMatch m;
+  while (ts_query_cursor_next_match(cursor_internal->cursor(), &m)) {
+    if (internal->satisfies_text_predicates(m, text)) {
+      cursor_internal->end_next(start_ns, 1, m.capture_count, rejections);
+      return _marshalMatch(env, m);
+    }
+    ++rejections;
+  }
+  cursor_internal->end_next(start_ns, 0, 0, rejections);
+  return nullptr;
+}
+
+static jobject TSQueryCursor_nextCapture(JNIEnv *env,
+                                         jclass self,
+                                         jlong cursor,
+                                         jlong query,
+                                         jlong source) {
+  auto *cursor_internal = as_query_cursor(env, cursor);
+  auto start_ns = TSQueryCursorInternal::begin_next();
+  uint32_t rejections = 0;
   TSQueryMatch m;
-  bool b = ts_query_cursor_next_match((TSQueryCursor *) cursor, &m);
+  uint32_t capture_index;
+  bool b = as_query(env, query)->next_capture(cursor_internal->cursor(),
+                                              predicate_source(source),
+                                              &m,
+                                              &capture_index,
+                                              &rejections);
+  cursor_internal->end_next(start_ns, 0, b ? 1 : 0, rejections);
   if (!b) {
     return nullptr;
   }
-  return _marshalMatch(env, m);
+  return _marshalCaptureMatch(env, m, capture_index);
+}
+
+static jint TSQueryCursor_nextCaptures(JNIEnv *env,
+                                       jclass self,
+                                       jlong cursor,
+                                       jlong query,
+                                       jlong source,
+                                       jintArray buffer) {
+  auto *cursor_internal = as_query_cursor(env, cursor);
+  req_nnp(env, buffer);
+  auto *internal = as_query(env, query);
+  auto *text = predicate_source(source);
+
+  jint max = env->GetArrayLength(buffer) / PACKED_CAPTURE_SIZE;
+  if (max <= 0) {
+    return 0;
+  }
+
+  // reused across calls on the same thread to avoid allocating on every batch
+  static thread_local std::vector<jint> records;
+  records.clear();
+
+  auto start_ns = TSQueryCursorInternal::begin_next();
+  uint32_t rejections = 0;
+  TSQueryMatch m;
+  uint32_t capture_index;
+  jint count = 0;
+  while (count < max
+      && internal->next_capture(cursor_internal->cursor(),
+                                text,
+                                &m,
+                                &capture_index,
+                                &rejections)) {
+    const TSQueryCapture *capture = m.captures + capture_index;
+    auto id = (uint64_t) capture->node.id;
+    records.push_back((jint) capture->index);
+    records.push_back((jint) m.pattern_index);
+    records.push_back((jint) ts_node_start_byte(capture->node));
+    records.push_back((jint) ts_node_end_byte(capture->node));
+    records.push_back((jint) (id & 0xffffffff));
+    records.push_back((jint) (id >> 32));
+    ++count;
+  }
+  cursor_internal->end_next(start_ns, 0, (uint32_t) count, rejections);
+
+  if (count > 0) {
+    env->SetIntArrayRegion(buffer, 0, (jsize) records.size(), records.data());
+  }
+
+  return count;
+}
+
+// Must be kept in sync with TSQueryCursor.CAPTURE_RANGES_*
+#define CAPTURE_RANGES_DEDUPLICATE 1
+#define CAPTURE_RANGES_MERGE_NESTED 2
+
+typedef std::pair<uint32_t, uint32_t> ByteRange;
+
+/**
+ * Sort the ranges by their start, outermost first, then drop the duplicates
+ * and/or the ranges nested in a preceding range as requested by the flags.
+ */
+static void normalize_ranges(std::vector<ByteRange> &ranges, jint flags) {
+  std::sort(ranges.begin(), ranges.end(), [](const ByteRange &a, const ByteRange &b) {
+    return a.first != b.first ? a.first < b.first : a.second > b.second;
+  });
+
+  if ((flags & (CAPTURE_RANGES_DEDUPLICATE | CAPTURE_RANGES_MERGE_NESTED)) == 0) {
+    return;
+  }
+
+  size_t kept = 0;
+  uint32_t outer_end = 0;
+  for (size_t i = 0; i < ranges.size(); ++i) {
+    const auto &range = ranges[i];
+    if (kept > 0) {
+      if ((flags & CAPTURE_RANGES_MERGE_NESTED) && range.second <= outer_end) {
+        continue;
+      }
+      if ((flags & CAPTURE_RANGES_DEDUPLICATE) && range == ranges[kept - 1]) {
+        continue;
+      }
+    }
+
+    ranges[kept++] = range;
+    outer_end = std::max(outer_end, range.second);
+  }
+  ranges.resize(kept);
+}
+
+/**
+ * Run the query and group the ranges of the captured nodes by capture index.
+ * The result is packed as capture_count + 1 indices of the first range of each
+ * capture (the last one being the end of the ranges), followed by the start and
+ * end bytes of the ranges.
+ */
+static jintArray TSQueryCursor_captureRanges(JNIEnv *env,
+                                             jclass self,
+                                             jlong cursor,
+                                             jlong query,
+                                             jobject node,
+                                             jlong source,
+                                             jint flags) {
+  auto *cursor_internal = as_query_cursor(env, cursor);
+  auto *internal = as_query(env, query);
+  auto *text = predicate_source(source);
+  auto capture_count = ts_query_capture_count(internal->query());
+
+  // reused across calls on the same thread, only the ranges are cleared
+  static thread_local std::vector<std::vector<ByteRange>> ranges;
+  static thread_local std::vector<jint> packed;
+  if (ranges.size() < capture_count) {
+    ranges.resize(capture_count);
+  }
+  for (uint32_t i = 0; i < capture_count; ++i) {
+    ranges[i].clear();
+  }
+
+  cursor_internal->exec(internal->query(), _unmarshalNode(env, node));
+
+  auto start_ns = TSQueryCursorInternal::begin_next();
+  uint32_t matches = 0;
+  uint32_t captures = 0;
+  uint32_t rejections = 0;
+  TSQueryMatch m;
+  while (ts_query_cursor_next_match(cursor_internal->cursor(), &m)) {
+    if (!internal->satisfies_text_predicates(m, text)) {
+      ++rejections;
+      continue;
+    }
+
+    ++matches;
+    captures += m.capture_count;
+    for (uint16_t i = 0; i < m.capture_count; ++i) {
+      const auto &capture = m.captures[i];
+      ranges[capture.index].emplace_back(ts_node_start_byte(capture.node),
+                                         ts_node_end_byte(capture.node));
+    }
+  }
+  cursor_internal->end_next(start_ns, matches, captures, rejections);
+
+  packed.assign(capture_count + 1, 0);
+  for (uint32_t i = 0; i < capture_count; ++i) {
+    normalize_ranges(ranges[i], flags);
+    packed[i] = (jint) packed.size();
+    for (const auto &range: ranges[i]) {
+      packed.push_back((jint) range.first);
+      packed.push_back((jint) range.second);
+    }
+  }
+  packed[capture_count] = (jint) packed.size();
+
+  auto result = env->NewIntArray((jsize) packed.size());
+  env->SetIntArrayRegion(result, 0, (jsize) packed.size(), packed.data());
+  return result;
+}
+
+static jintArray TSQueryCursor_execParallel(JNIEnv *env,
+                                           jclass self,
+                                           jlong cursor,
+                                           jlong query,
+                                           jobject node,
+                                           jlong source,
+                                           jint max_shards) {
+  auto *cursor_internal = as_query_cursor(env, cursor);
+  auto *internal = as_query(env, query);
+  auto ts_node = _unmarshalNode(env, node);
+
+  TSShardedQuery sharded(internal,
+                         predicate_source(source),
+                         ts_query_cursor_match_limit(cursor_internal->cursor()));
+
+  static thread_local std::vector<jint> records;
+  auto start_ns = TSQueryCursorInternal::begin_next();
+  auto rejections = sharded.run(ts_node, (uint32_t) max_shards, records);
+  cursor_internal->end_next(start_ns,
+                            0,
+                            (uint32_t) (records.size() / PACKED_CAPTURE_SIZE),
+                            rejections);
+
+  auto result = env->NewIntArray((jsize) records.size());
+  env->SetIntArrayRegion(result, 0, (jsize) records.size(), records.data());
+  return result;
+}
+
+static jlongArray
+TSQueryCursor_getStats(JNIEnv *env, jclass self, jlong cursor) {
+  return as_query_cursor(env, cursor)->stats().pack(env);
+}
+
+static void TSQueryCursor_resetStats(JNIEnv *env, jclass self, jlong cursor) {
+  as_query_cursor(env, cursor)->stats().reset();
 }
 
 static void
 TSQueryCursor_removeMatch(JNIEnv *env, jclass self, jlong cursor, jint id) {
-  req_nnp(env, cursor);
-  ts_query_cursor_remove_match((TSQueryCursor *) cursor, id);
+  ts_query_cursor_remove_match(as_query_cursor(env, cursor)->cursor(), id);
 }
 
 void TSQueryCursor_Native__SetJniMethods(JNINativeMethod *methods, int count) {
@@ -112,5 +344,14 @@ void TSQueryCursor_Native__SetJniMethods(JNINativeMethod *methods, int count) {
   SET_JNI_METHOD(methods, TSQueryCursor_Native_setPointRange,
                  TSQueryCursor_setPointRange);
   SET_JNI_METHOD(methods, TSQueryCursor_Native_nextMatch, TSQueryCursor_nextMatch);
+  SET_JNI_METHOD(methods, TSQueryCursor_Native_nextCapture, TSQueryCursor_nextCapture);
+  SET_JNI_METHOD(methods, TSQueryCursor_Native_nextCaptures,
+                 TSQueryCursor_nextCaptures);
   SET_JNI_METHOD(methods, TSQueryCursor_Native_removeMatch, TSQueryCursor_removeMatch);
+  SET_JNI_METHOD(methods, TSQueryCursor_Native_captureRanges,
+                 TSQueryCursor_captureRanges);
+  SET_JNI_METHOD(methods, TSQueryCursor_Native_execParallel,
+                 TSQueryCursor_execParallel);
+  SET_JNI_METHOD(methods, TSQueryCursor_Native_getStats, TSQueryCursor_getStats);
+  SET_JNI_METHOD(methods, TSQueryCursor_Native_resetStats, TSQueryCursor_resetStats);
 }
\ No newline at end of file
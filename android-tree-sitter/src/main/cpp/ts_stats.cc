@@ -0,0 +1,67 @@
+/*
+ *  This file is part of android-tree-sitter.
+ *
+ *  android-tree-sitter library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  android-tree-sitter library is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *  along with android-tree-sitter.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include "utils/ts_misc.h"
+#include "utils/ts_instrumentation.h"
+
+#include "ts_stats.h"
+
+static void TSStats_setEnabled(__TS_ATTR_UNUSED JNIEnv *env,
+                               __TS_ATTR_UNUSED jclass self,
+                               jboolean enabled) {
+  TSStats::set_enabled(enabled);
+}
+
+static jboolean TSStats_isEnabled(__TS_ATTR_UNUSED JNIEnv *env,
+                                  __TS_ATTR_UNUSED jclass self) {
+  return (jboolean) TSStats::enabled();
+}
+
+static jlongArray TSStats_getMarshallingStats(JNIEnv *env,
+                                              __TS_ATTR_UNUSED jclass self) {
+  return TSStats::pack_marshalled(env);
+}
+
+static void TSStats_resetMarshallingStats(__TS_ATTR_UNUSED JNIEnv *env,
+                                          __TS_ATTR_UNUSED jclass self) {
+  TSStats::reset_marshalled();
+}
+
+static jboolean TSStats_setTracingEnabled(__TS_ATTR_UNUSED JNIEnv *env,
+                                          __TS_ATTR_UNUSED jclass self,
+                                          jboolean enabled) {
+  return (jboolean) TSTrace::set_enabled(enabled);
+}
+
+static jboolean TSStats_isTracingEnabled(__TS_ATTR_UNUSED JNIEnv *env,
+                                         __TS_ATTR_UNUSED jclass self) {
+  return (jboolean) TSTrace::enabled();
+}
+
+void TSStats_Native__SetJniMethods(JNINativeMethod *methods, int count) {
+  SET_JNI_METHOD(methods, TSStats_Native_setEnabled, TSStats_setEnabled);
+  SET_JNI_METHOD(methods, TSStats_Native_isEnabled, TSStats_isEnabled);
+  SET_JNI_METHOD(methods, TSStats_Native_getMarshallingStats,
+                 TSStats_getMarshallingStats);
+  SET_JNI_METHOD(methods, TSStats_Native_resetMarshallingStats,
+                 TSStats_resetMarshallingStats);
+  SET_JNI_METHOD(methods, TSStats_Native_setTracingEnabled,
+                 TSStats_setTracingEnabled);
+  SET_JNI_METHOD(methods, TSStats_Native_isTracingEnabled,
+                 TSStats_isTracingEnabled);
+}
@@ -18,6 +18,12 @@
 
 #include "ts_tree.h"
 
+#include <utility>
+#include <vector>
+
+#include "subtree.h"
+#include "tree.h"
+#include "utils/ts_allocator.h"
 #include "utils/ts_misc.h"
 #include "utils/ts_obj_utils.h"
 #include "utils/ts_preconditions.h"
@@ -30,6 +36,13 @@ static void TSTree_edit(JNIEnv *env, __TS_ATTR_UNUSED jclass self, jlong tree,
   ts_tree_edit((TSTree *)tree, &edit);
 }
 
+static void TSTree_editPacked(JNIEnv *env, __TS_ATTR_UNUSED jclass self,
+                              jlong tree, jintArray edits) {
+  req_nnp(env, tree);
+  req_nnp(env, edits, "edits");
+  _applyPackedEdits(env, (TSTree *)tree, edits);
+}
+
 static void TSTree_delete(JNIEnv *env, __TS_ATTR_UNUSED jclass self, jlong tree) {
   req_nnp(env, tree);
   ts_tree_delete((TSTree *)tree);
@@ -65,7 +78,7 @@ static jobjectArray TSTree_changedRanges(JNIEnv *env,
       ts_tree_get_changed_ranges((TSTree *)oldTree, (TSTree *)tree, &count);
   if (count == 0) {
     if (ranges != nullptr) {
-      free(ranges);
+      TSAllocator::free(ranges);
     }
     return nullptr;
   }
@@ -78,11 +91,19 @@ static jobjectArray TSTree_changedRanges(JNIEnv *env,
     env->SetObjectArrayElement(arr, (jint)i, _marshalRange(env, *r));
   }
 
-  free(ranges);
+  TSAllocator::free(ranges);
 
   return arr;
 }
 
+static jintArray TSTree_changedRangesPacked(JNIEnv *env,
+                                            __TS_ATTR_UNUSED jclass self,
+                                            jlong tree, jlong oldTree) {
+  req_nnp(env, tree, "thisTree");
+  req_nnp(env, oldTree, "oldTree");
+  return _packChangedRanges(env, (TSTree *)oldTree, (TSTree *)tree);
+}
+
 static jobjectArray TSTree_includedRanges(JNIEnv *env,
                                           __TS_ATTR_UNUSED jclass self,
                                           jlong tree) {
@@ -92,7 +113,7 @@ static jobjectArray TSTree_includedRanges(JNIEnv *env,
   TSRange *ranges = ts_tree_included_ranges((TSTree *)tree, &count);
   if (count == 0) {
     if (ranges != nullptr) {
-      free(ranges);
+      TSAllocator::free(ranges);
     }
 
     return nullptr;
@@ -106,7 +127,7 @@ static jobjectArray TSTree_includedRanges(JNIEnv *env,
     env->SetObjectArrayElement(arr, (jint)i, _marshalRange(env, *r));
   }
 
-  free(ranges);
+  TSAllocator::free(ranges);
 
   return arr;
 }
@@ -117,6 +138,73 @@ static jlong TSTree_getLanguage(JNIEnv *env, __TS_ATTR_UNUSED jclass self,
   return (jlong)ts_tree_language((TSTree *)tree);
 }
 
+static jlongArray TSTree_getFootprint(JNIEnv *env,
+                                      __TS_ATTR_UNUSED jclass self,
+                                      jlong tree) {
+  req_nnp(env, tree);
+  auto *ts_tree = (const TSTree *)tree;
+
+  // the tree itself and its included ranges are never shared
+  uint64_t unique_bytes =
+      sizeof(TSTree) + ts_tree->included_range_count * sizeof(TSRange);
+  uint64_t shared_bytes = 0;
+  uint64_t node_count = 0;
+  uint64_t subtree_count = 0;
+  uint64_t shared_subtree_count = 0;
+
+  // subtrees are shared between trees by reference counting : a subtree whose
+  // reference count is greater than 1 is also retained by another tree (a
+  // copy, or the old tree of an incremental parse), and so is everything below
+  // it. Inline subtrees are stored in their parent and take no memory of their
+  // own.
+  static thread_local std::vector<std::pair<Subtree, bool>> stack;
+  stack.clear();
+  stack.emplace_back(ts_tree->root, false);
+  while (!stack.empty()) {
+    auto entry = stack.back();
+    stack.pop_back();
+    ++node_count;
+
+    Subtree subtree = entry.first;
+    if (subtree.data.is_inline) {
+      continue;
+    }
+
+    bool shared = entry.second || subtree.ptr->ref_count > 1;
+    uint32_t child_count = subtree.ptr->child_count;
+    uint64_t bytes = ts_subtree_alloc_size(child_count);
+    if (child_count == 0 && subtree.ptr->has_external_tokens &&
+        subtree.ptr->external_scanner_state.length >
+            sizeof(subtree.ptr->external_scanner_state.short_data)) {
+      bytes += subtree.ptr->external_scanner_state.length;
+    }
+
+    ++subtree_count;
+    if (shared) {
+      ++shared_subtree_count;
+      shared_bytes += bytes;
+    } else {
+      unique_bytes += bytes;
+    }
+
+    const Subtree *children = ts_subtree_children(subtree);
+    for (uint32_t i = 0; i < child_count; ++i) {
+      stack.emplace_back(children[i], shared);
+    }
+  }
+
+  jlong values[PACKED_TREE_FOOTPRINT_SIZE] = {
+      (jlong)(unique_bytes + shared_bytes), (jlong)unique_bytes,
+      (jlong)shared_bytes,                  (jlong)node_count,
+      (jlong)subtree_count,                 (jlong)shared_subtree_count};
+
+  auto result = env->NewLongArray(PACKED_TREE_FOOTPRINT_SIZE);
+  if (result != nullptr) {
+    env->SetLongArrayRegion(result, 0, PACKED_TREE_FOOTPRINT_SIZE, values);
+  }
+  return result;
+}
+
 void TSTree_Native__SetJniMethods(JNINativeMethod *methods,
                                   __TS_ATTR_UNUSED int count) {
   SET_JNI_METHOD(methods, TSTree_Native_edit, TSTree_edit)
@@ -126,6 +214,10 @@ void TSTree_Native__SetJniMethods(JNINativeMethod *methods,
   SET_JNI_METHOD(methods, TSTree_Native_rootNodeWithOffset,
                  TSTree_rootNodeWithOffset)
   SET_JNI_METHOD(methods, TSTree_Native_changedRanges, TSTree_changedRanges)
+  SET_JNI_METHOD(methods, TSTree_Native_changedRangesPacked,
+                 TSTree_changedRangesPacked)
+  SET_JNI_METHOD(methods, TSTree_Native_editPacked, TSTree_editPacked)
   SET_JNI_METHOD(methods, TSTree_Native_includedRanges, TSTree_includedRanges)
   SET_JNI_METHOD(methods, TSTree_Native_getLanguage, TSTree_getLanguage)
+  SET_JNI_METHOD(methods, TSTree_Native_getFootprint, TSTree_getFootprint)
 }
\ No newline at end of file
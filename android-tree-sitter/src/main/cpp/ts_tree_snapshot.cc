@@ -0,0 +1,153 @@
+/*
+ *  This file is part of android-tree-sitter.
+ *
+ *  android-tree-sitter library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  android-tree-sitter library is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *  along with android-tree-sitter.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include "ts_tree_snapshot.h"
+
+#include <cstdlib>
+#include <vector>
+
+#include "utils/ts_misc.h"
+#include "utils/ts_obj_utils.h"
+#include "utils/ts_preconditions.h"
+
+// the columns of the snapshot
+// 32-bit columns are written first, followed by the 16-bit and 8-bit columns
+// so that every column is naturally aligned
+// the order must be kept in sync with TSTreeSnapshot
+#define INT_COLUMNS 7
+#define SHORT_COLUMNS 2
+#define BYTE_COLUMNS 1
+
+/**
+ * A flattened, struct-of-arrays snapshot of all the nodes in a syntax tree.
+ * The nodes are stored in pre-order and all the columns are stored in a single
+ * block of memory which is exposed to Java as a direct ByteBuffer.
+ */
+struct TreeSnapshot {
+  uint32_t node_count;
+  size_t size;
+  uint8_t *data;
+};
+
+static size_t snapshot_size(uint32_t node_count) {
+  return (size_t)node_count *
+         (INT_COLUMNS * sizeof(int32_t) + SHORT_COLUMNS * sizeof(int16_t) +
+          BYTE_COLUMNS * sizeof(int8_t));
+}
+
+static jlong TSTreeSnapshot_create(JNIEnv *env,
+                                   __TS_ATTR_UNUSED jclass self,
+                                   jlong tree) {
+  req_nnp(env, tree);
+
+  TSNode root = ts_tree_root_node((TSTree *)tree);
+
+  // the descendant count includes the root node itself
+  uint32_t count = ts_node_descendant_count(root);
+
+  auto *snapshot = new TreeSnapshot;
+  snapshot->node_count = count;
+  snapshot->size = snapshot_size(count);
+  snapshot->data = (uint8_t *)calloc(snapshot->size, 1);
+
+  auto *start_bytes = (int32_t *)snapshot->data;
+  auto *end_bytes = start_bytes + count;
+  auto *start_rows = end_bytes + count;
+  auto *start_columns = start_rows + count;
+  auto *end_rows = start_columns + count;
+  auto *end_columns = end_rows + count;
+  auto *parents = end_columns + count;
+  auto *symbols = (int16_t *)(parents + count);
+  auto *field_ids = symbols + count;
+  auto *flags = (int8_t *)(field_ids + count);
+
+  // the indices of the ancestors of the current node
+  std::vector<int32_t> ancestors;
+
+  TSTreeCursor cursor = ts_tree_cursor_new(root);
+  uint32_t index = 0;
+  bool done = false;
+  while (!done && index < count) {
+    TSNode node = ts_tree_cursor_current_node(&cursor);
+    TSPoint start = ts_node_start_point(node);
+    TSPoint end = ts_node_end_point(node);
+
+    start_bytes[index] = (int32_t)ts_node_start_byte(node);
+    end_bytes[index] = (int32_t)ts_node_end_byte(node);
+    start_rows[index] = (int32_t)start.row;
+    start_columns[index] = (int32_t)start.column;
+    end_rows[index] = (int32_t)end.row;
+    end_columns[index] = (int32_t)end.column;
+    parents[index] = ancestors.empty() ? -1 : ancestors.back();
+    symbols[index] = (int16_t)ts_node_symbol(node);
+    field_ids[index] = (int16_t)ts_tree_cursor_current_field_id(&cursor);
+    flags[index] = (int8_t)_nodeFlags(node);
+
+    if (ts_tree_cursor_goto_first_child(&cursor)) {
+      ancestors.push_back((int32_t)index);
+    } else {
+      while (!ts_tree_cursor_goto_next_sibling(&cursor)) {
+        if (!ts_tree_cursor_goto_parent(&cursor)) {
+          // back at the root node
+          done = true;
+          break;
+        }
+        ancestors.pop_back();
+      }
+    }
+
+    ++index;
+  }
+  ts_tree_cursor_delete(&cursor);
+
+  return (jlong)snapshot;
+}
+
+static void TSTreeSnapshot_delete(JNIEnv *env,
+                                  __TS_ATTR_UNUSED jclass self,
+                                  jlong pointer) {
+  req_nnp(env, pointer);
+  auto *snapshot = (TreeSnapshot *)pointer;
+  free(snapshot->data);
+  delete snapshot;
+}
+
+static jint TSTreeSnapshot_getNodeCount(JNIEnv *env,
+                                        __TS_ATTR_UNUSED jclass self,
+                                        jlong pointer) {
+  req_nnp(env, pointer);
+  return (jint)((TreeSnapshot *)pointer)->node_count;
+}
+
+static jobject TSTreeSnapshot_getBuffer(JNIEnv *env,
+                                        __TS_ATTR_UNUSED jclass self,
+                                        jlong pointer) {
+  req_nnp(env, pointer);
+  auto *snapshot = (TreeSnapshot *)pointer;
+  return env->NewDirectByteBuffer(snapshot->data, (jlong)snapshot->size);
+}
+
+void TSTreeSnapshot_Native__SetJniMethods(JNINativeMethod *methods,
+                                          __TS_ATTR_UNUSED int count) {
+  SET_JNI_METHOD(methods, TSTreeSnapshot_Native_create, TSTreeSnapshot_create)
+  SET_JNI_METHOD(methods, TSTreeSnapshot_Native_delete, TSTreeSnapshot_delete)
+  SET_JNI_METHOD(methods, TSTreeSnapshot_Native_getNodeCount,
+                 TSTreeSnapshot_getNodeCount)
+  SET_JNI_METHOD(methods, TSTreeSnapshot_Native_getBuffer,
+                 TSTreeSnapshot_getBuffer)
+}
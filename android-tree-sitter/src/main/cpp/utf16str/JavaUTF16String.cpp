@@ -21,6 +21,7 @@
 #include <iostream>
 
 #include "UTF16String.h"
+#include "../utils/ts_obj_utils.h"
 #include "../utils/ts_preconditions.h"
 
 #include "ts_utf16string.h"
@@ -156,6 +157,75 @@ static jstring UTF16String_toString(JNIEnv *env, jclass clazz, jlong pointer) {
   return as_str(env, pointer)->to_jstring(env);
 }
 
+static jint UTF16String_lineCount(JNIEnv *env, jclass clazz, jlong pointer) {
+  return (jint) as_str(env, pointer)->line_count();
+}
+
+static jint
+UTF16String_lineStart(JNIEnv *env, jclass clazz, jlong pointer, jint line) {
+  return (jint) as_str(env, pointer)->line_start((uint32_t) line);
+}
+
+static jint
+UTF16String_lineOfChar(JNIEnv *env, jclass clazz, jlong pointer, jint index) {
+  return (jint) as_str(env, pointer)->line_of_char((uint32_t) index);
+}
+
+static jlong
+UTF16String_pointOfChar(JNIEnv *env, jclass clazz, jlong pointer, jint index) {
+  uint32_t row, column;
+  as_str(env, pointer)->point_of_char((uint32_t) index, &row, &column);
+
+  // the row in the high bits, the column in the low bits
+  return (jlong) (((uint64_t) row << 32) | column);
+}
+
+static jint UTF16String_charOfPoint(JNIEnv *env,
+                                    jclass clazz,
+                                    jlong pointer,
+                                    jint row,
+                                    jint column) {
+  return (jint) as_str(env, pointer)->char_of_point((uint32_t) row,
+                                                    (uint32_t) column);
+}
+
+static void UTF16String_editChars(JNIEnv *env,
+                                  jclass clazz,
+                                  jlong pointer,
+                                  jint start,
+                                  jint end,
+                                  jstring str,
+                                  jintArray edit) {
+  auto *self = as_str(env, pointer);
+  auto len = env->GetStringLength(str);
+
+  jint record[PACKED_EDIT_SIZE];
+  record[0] = start * 2;
+  record[1] = end * 2;
+  record[2] = (start + len) * 2;
+
+  uint32_t row, column;
+  self->point_of_char((uint32_t) start, &row, &column);
+  record[3] = (jint) row;
+  record[4] = (jint) column;
+  self->point_of_char((uint32_t) end, &row, &column);
+  record[5] = (jint) row;
+  record[6] = (jint) column;
+
+  if (len == 0) {
+    self->delete_chars(start, end);
+  } else {
+    self->replace_chars(env, start, end, str);
+  }
+
+  // the new end point is computed from the edited string
+  self->point_of_char((uint32_t) (start + len), &row, &column);
+  record[7] = (jint) row;
+  record[8] = (jint) column;
+
+  env->SetIntArrayRegion(edit, 0, PACKED_EDIT_SIZE, record);
+}
+
 void UTF16String_Native__SetJniMethods(JNINativeMethod *methods, int count) {
   SET_JNI_METHOD(methods, UTF16String_Native_byteAt, UTF16String_byteAt);
   SET_JNI_METHOD(methods, UTF16String_Native_setByteAt, UTF16String_setByteAt);
@@ -180,4 +250,10 @@ void UTF16String_Native__SetJniMethods(JNINativeMethod *methods, int count) {
   SET_JNI_METHOD(methods, UTF16String_Native_length, UTF16String_length);
   SET_JNI_METHOD(methods, UTF16String_Native_byteLength, UTF16String_byteLength);
   SET_JNI_METHOD(methods, UTF16String_Native_erase, UTF16String_erase);
+  SET_JNI_METHOD(methods, UTF16String_Native_lineCount, UTF16String_lineCount);
+  SET_JNI_METHOD(methods, UTF16String_Native_lineStart, UTF16String_lineStart);
+  SET_JNI_METHOD(methods, UTF16String_Native_lineOfChar, UTF16String_lineOfChar);
+  SET_JNI_METHOD(methods, UTF16String_Native_pointOfChar, UTF16String_pointOfChar);
+  SET_JNI_METHOD(methods, UTF16String_Native_charOfPoint, UTF16String_charOfPoint);
+  SET_JNI_METHOD(methods, UTF16String_Native_editChars, UTF16String_editChars);
 }
\ No newline at end of file
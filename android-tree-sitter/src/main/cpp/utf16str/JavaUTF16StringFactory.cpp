@@ -39,15 +39,9 @@ UTF16StringFactory_newStringBytes(
     jbyteArray bytes,
     jint off,
     jint len) {
-  auto ba = env->GetByteArrayElements(bytes, nullptr);
-  auto vec = std::vector<jbyte>();
-  for (int i = off; i < off + len; ++i) {
-    vec.emplace_back(*(ba + off));
-  }
-
-  auto *ustr = new UTF16String(vec);
-  env->ReleaseByteArrayElements(bytes, ba, JNI_ABORT);
-  return (jlong) ustr;
+  auto vec = std::vector<jbyte>(len);
+  env->GetByteArrayRegion(bytes, off, len, vec.data());
+  return (jlong) new UTF16String(std::move(vec));
 }
 
 void UTF16StringFactory_Native__SetJniMethods(JNINativeMethod *methods, int count) {
@@ -20,6 +20,7 @@
 #include <cstring>
 #include <utility>
 #include <iostream>
+#include <algorithm>
 
 #include "UTF16String.h"
 #include "../utils/jni_string.h"
@@ -30,90 +31,155 @@
 #define LO_BYTE_SHIFT 8
 #define CODER 1
 
+// the minimum number of bytes the gap grows by when it is full
+#define MIN_GAP_SIZE 256
+
+// UTF-16LE is the native byte order of jchar on little-endian hosts
+// in which case, chars can be copied to and from the string with memcpy
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define NATIVE_BYTE_ORDER_UTF16LE
+#endif
+
 using namespace std;
 
-const jbyte *to_bytes(const jchar *chars, jint len);
+static void write_chars(jbyte *dest, const jchar *chars, jint len);
+
+static void copy_jstring(JNIEnv *env, jstring src, jint from, jint len, jbyte *dest);
+
+UTF16String::UTF16String()
+    : _buffer(), _gap_start(0), _gap_end(0), _line_starts(), _lines_valid(false) {
+}
+
+UTF16String::UTF16String(vector<jbyte> bytes)
+    : _buffer(std::move(bytes)), _line_starts(), _lines_valid(false) {
+    _gap_start = _gap_end = _buffer.size();
+}
 
-UTF16String::UTF16String() {
-    _string = vector<jbyte>();
+size_t UTF16String::gap_length() const {
+    return _gap_end - _gap_start;
 }
 
-UTF16String::UTF16String(vector<jbyte> bytes) {
-    _string = std::move(bytes);
+size_t UTF16String::physical_index(size_t index) const {
+    return index < _gap_start ? index : index + gap_length();
+}
+
+void UTF16String::move_gap(size_t index) {
+    auto *data = _buffer.data();
+    if (index < _gap_start) {
+        auto count = _gap_start - index;
+        memmove(data + _gap_end - count, data + index, count);
+        _gap_start -= count;
+        _gap_end -= count;
+    } else if (index > _gap_start) {
+        auto count = index - _gap_start;
+        memmove(data + _gap_start, data + _gap_end, count);
+        _gap_start += count;
+        _gap_end += count;
+    }
+}
+
+jbyte *UTF16String::make_room(size_t index, size_t len) {
+    move_gap(index);
+    if (gap_length() < len) {
+        auto size = _buffer.size() - gap_length();
+        auto tail = _buffer.size() - _gap_end;
+
+        // keep the capacity even so that the bytes after the gap stay aligned to jchar
+        auto capacity = size + len + (std::max((size_t) MIN_GAP_SIZE, size >> 1) & ~(size_t) 1);
+        _buffer.resize(capacity);
+
+        auto *data = _buffer.data();
+        memmove(data + capacity - tail, data + _gap_end, tail);
+        _gap_end = capacity - tail;
+    }
+
+    auto *dest = _buffer.data() + _gap_start;
+    _gap_start += len;
+    return dest;
+}
+
+void UTF16String::copy_bytes(size_t start, size_t end, jbyte *dest) const {
+    if (start >= end) {
+        return;
+    }
+
+    auto *data = _buffer.data();
+    if (start < _gap_start) {
+        auto count = std::min(end, _gap_start) - start;
+        memcpy(dest, data + start, count);
+        dest += count;
+        start += count;
+    }
+
+    if (start < end) {
+        memcpy(dest, data + start + gap_length(), end - start);
+    }
 }
 
 void UTF16String::append(jchar c) {
-    _string.emplace_back((jbyte) (c >> HI_BYTE_SHIFT));
-    _string.emplace_back((jbyte) (c >> LO_BYTE_SHIFT));
+    auto *dest = make_room(byte_length(), 2);
+    *dest++ = (jbyte) (c >> HI_BYTE_SHIFT);
+    *dest = (jbyte) (c >> LO_BYTE_SHIFT);
+
+    if (_lines_valid && c == '\n') {
+        _line_starts.push_back((uint32_t) length());
+    }
 }
 
 jbyte UTF16String::byte_at(jint index) {
-    return _string.at(index);
+    return _buffer[physical_index(index)];
 }
 
 UTF16String *UTF16String::set_byte_at(jint index, jbyte byte) {
-    _string[index] = byte;
+    _buffer[physical_index(index)] = byte;
+    _lines_valid = false;
     return this;
 }
 
 jchar UTF16String::char_at(jint index) {
     auto idx = index << CODER;
-    jint hi = (_string[idx++] & 0xff) << HI_BYTE_SHIFT;
-    jint lo = (_string[idx] & 0xff) << LO_BYTE_SHIFT;
+    jint hi = (_buffer[physical_index(idx)] & 0xff) << HI_BYTE_SHIFT;
+    jint lo = (_buffer[physical_index(idx + 1)] & 0xff) << LO_BYTE_SHIFT;
     return (jchar) (hi | lo);
 }
 
 UTF16String *UTF16String::set_char_at(jint index, jchar c) {
     jint idx = index << CODER;
-    _string[idx++] = (jbyte) (c >> HI_BYTE_SHIFT);
-    _string[idx] = (jbyte) (c >> LO_BYTE_SHIFT);
+    _buffer[physical_index(idx)] = (jbyte) (c >> HI_BYTE_SHIFT);
+    _buffer[physical_index(idx + 1)] = (jbyte) (c >> LO_BYTE_SHIFT);
+    update_lines(index, index + 1, 1);
     return this;
 }
 
 UTF16String *UTF16String::append(JNIEnv *env, jstring src) {
-    jint len;
-    const jchar *chars = FNI_GetStringChars(env, src, &len);
-    _string.reserve(vsize(_string) + len);
-    for (jint i = 0; i < len; ++i) {
-        auto c = *(chars + i);
-        append(c);
-    }
-    FNI_ReleaseStringChars(chars);
-    return this;
+    return append(env, src, 0, env->GetStringLength(src));
 }
 
 UTF16String *UTF16String::append(JNIEnv *env, jstring src, jint from, jint len) {
-    const jchar *chars = FNI_GetStringChars(env, src, nullptr);
-    for (jint i = from; i < from + len; ++i) {
-        auto c = *(chars + i);
-        append(c);
-    }
-    FNI_ReleaseStringChars(chars);
+    auto index = length();
+    copy_jstring(env, src, from, len, make_room(byte_length(), len << CODER));
+    update_lines(index, index, len);
     return this;
 }
 
 UTF16String *UTF16String::insert(jint index, jbyte byte) {
-    _string.insert(_string.begin() + index, byte);
+    *make_room(index, 1) = byte;
+    _lines_valid = false;
     return this;
 }
 
 UTF16String *UTF16String::insert(jint index, jchar c) {
-    insert(index << CODER, (jbyte) (c >> HI_BYTE_SHIFT));
-    insert((index << CODER) + 1, (jbyte) (c >> LO_BYTE_SHIFT));
+    auto *dest = make_room(index << CODER, 2);
+    *dest++ = (jbyte) (c >> HI_BYTE_SHIFT);
+    *dest = (jbyte) (c >> LO_BYTE_SHIFT);
+    update_lines(index, index, 1);
     return this;
 }
 
 UTF16String *UTF16String::insert(JNIEnv *env, jstring src, jint index) {
-    jint len;
-    const jchar *chars = FNI_GetStringChars(env, src, &len);
-    _string.reserve(byte_length() + len);
-    for (jint i = 0; i < len; ++i) {
-        auto c = *(chars + i);
-        insert(index + i, c);
-    }
-
-    FNI_ReleaseStringChars(chars);
-
+    auto len = env->GetStringLength(src);
+    copy_jstring(env, src, 0, len, make_room(index << CODER, len << CODER));
+    update_lines(index, index, len);
     return this;
 }
 
@@ -122,8 +188,10 @@ UTF16String *UTF16String::delete_chars(jint start, jint end) {
 }
 
 UTF16String *UTF16String::delete_bytes(jint start, jint end) {
-    const auto &iter = _string.begin();
-    _string.erase(iter + start, iter + end);
+    // the deleted bytes simply become a part of the gap
+    move_gap(start);
+    _gap_end += end - start;
+    update_lines_for_bytes(start, end, 0);
     return this;
 }
 
@@ -132,30 +200,10 @@ UTF16String *UTF16String::replace_chars(JNIEnv *env, jint start, jint end, jstri
 }
 
 UTF16String *UTF16String::replace_bytes(JNIEnv *env, jint start, jint end, jstring str) {
-    jint len;
-    const jchar *chars = FNI_GetStringChars(env, str, &len);
-    jint blen = len << CODER;
-    jint last = blen < end ? blen : end;
-    const jbyte *bytes = to_bytes(chars, len);
-
-    jint i = start;
-    while (i < last) {
-        set_byte_at(i, *(bytes + i));
-        ++i;
-    }
-
-    if (blen > end) {
-        while (i < blen) {
-            insert(i, *(bytes + i));
-            ++i;
-        }
-    } else if (blen < end) {
-        delete_bytes(i, end);
-    }
-
-    FNI_ReleaseStringChars(chars);
-    delete [] bytes;
-
+    auto len = env->GetStringLength(str);
+    delete_bytes(start, end);
+    copy_jstring(env, str, 0, len, make_room(start, len << CODER));
+    update_lines_for_bytes(start, start, len << CODER);
     return this;
 }
 
@@ -164,46 +212,171 @@ UTF16String *UTF16String::substring_chars(jint start, jint end) {
 }
 
 UTF16String *UTF16String::substring_bytes(jint start, jint end) {
-    auto copy = vector<jbyte>();
-    for (int i = start; i < end; ++i) {
-        copy.emplace_back(_string[i]);
+    auto copy = vector<jbyte>(end - start);
+    copy_bytes(start, end, copy.data());
+    return new UTF16String(std::move(copy));
+}
+
+jstring UTF16String::subjstring_chars(JNIEnv *env, jint start, jint end) const {
+    return subjstring_bytes(env, start << CODER, end << CODER);
+}
+
+jstring UTF16String::subjstring_bytes(JNIEnv *env, jint start, jint end) const {
+    // the buffer may be read by a parse on another thread, so the gap is not
+    // moved. The bytes are read in place if the range is on one side of the
+    // gap, and are copied across the gap otherwise.
+    if ((size_t) start >= _gap_start || (size_t) end <= _gap_start) {
+        return FNI_NewString(env, _buffer.data() + physical_index(start), end - start);
     }
 
-    auto *result = new UTF16String(copy);
-    return result;
+    auto copy = vector<jbyte>(end - start);
+    copy_bytes(start, end, copy.data());
+    return FNI_NewString(env, copy.data(), end - start);
 }
 
-jstring UTF16String::subjstring_chars(JNIEnv *env, jint start, jint end) {
-    UTF16String *substr = substring_chars(start, end);
-    jstring jstr = substr->to_jstring(env);
-    delete substr;
-    return jstr;
+jint UTF16String::byte_length() const {
+    return static_cast<jint>(_buffer.size() - gap_length());
 }
 
-jstring UTF16String::subjstring_bytes(JNIEnv *env, jint start, jint end) {
-    UTF16String *substr = substring_bytes(start, end);
-    jstring jstr = substr->to_jstring(env);
-    delete substr;
-    return jstr;
+jint UTF16String::length() const {
+    return byte_length() >> CODER;
 }
 
-jint UTF16String::byte_length() {
-    return vsize(_string);
+jstring UTF16String::to_jstring(JNIEnv *env) const {
+    return subjstring_bytes(env, 0, byte_length());
 }
 
-jint UTF16String::length() {
-    return byte_length() >> CODER;
+const char *UTF16String::chunk_at(uint32_t index, uint32_t *length) {
+    if (index >= (uint32_t) byte_length()) {
+        *length = 0;
+        return nullptr;
+    }
+
+    // the bytes before the gap, or the bytes after the gap
+    auto end = index < _gap_start ? _gap_start : _buffer.size();
+    auto physical = physical_index(index);
+    *length = end - physical;
+    return reinterpret_cast<const char *>(_buffer.data() + physical);
 }
 
-jstring UTF16String::to_jstring(JNIEnv *env) {
-    return FNI_NewString(env, _string.data(), byte_length());
+void UTF16String::read_chars(uint32_t start, uint32_t end, u16string &dest) const {
+    dest.clear();
+    auto size = (uint32_t) byte_length();
+    end = std::min(end, size) & ~1u;
+    start &= ~1u;
+    if (start >= end) {
+        return;
+    }
+
+    dest.resize((end - start) >> CODER);
+#ifdef NATIVE_BYTE_ORDER_UTF16LE
+    copy_bytes(start, end, (jbyte *) &dest[0]);
+#else
+    for (size_t i = 0; i < dest.size(); ++i) {
+        auto idx = start + (i << CODER);
+        jint hi = (_buffer[physical_index(idx)] & 0xff) << HI_BYTE_SHIFT;
+        jint lo = (_buffer[physical_index(idx + 1)] & 0xff) << LO_BYTE_SHIFT;
+        dest[i] = (char16_t) (hi | lo);
+    }
+#endif
+}
+
+void UTF16String::ensure_lines() {
+    if (_lines_valid) {
+        return;
+    }
+
+    _line_starts.clear();
+    _line_starts.push_back(0);
+
+    auto len = (uint32_t) length();
+    for (uint32_t i = 0; i < len; ++i) {
+        if (char_at((jint) i) == '\n') {
+            _line_starts.push_back(i + 1);
+        }
+    }
+
+    _lines_valid = true;
+}
+
+void UTF16String::update_lines(size_t start, size_t old_end, size_t new_len) {
+    // the index is built lazily, from the current content, when it is used
+    if (!_lines_valid) {
+        return;
+    }
+
+    // the lines which start in (start, old_end] started after a line break
+    // which has been removed
+    auto first = std::upper_bound(_line_starts.begin() + 1, _line_starts.end(), (uint32_t) start);
+    auto last = std::upper_bound(first, _line_starts.end(), (uint32_t) old_end);
+
+    auto delta = (int64_t) new_len - (int64_t) (old_end - start);
+    for (auto it = last; it != _line_starts.end(); ++it) {
+        *it = (uint32_t) (*it + delta);
+    }
+
+    // the lines which start after the line breaks in the new chars
+    thread_local vector<uint32_t> added;
+    added.clear();
+    for (size_t i = 0; i < new_len; ++i) {
+        if (char_at((jint) (start + i)) == '\n') {
+            added.push_back((uint32_t) (start + i + 1));
+        }
+    }
+
+    auto pos = _line_starts.erase(first, last);
+    _line_starts.insert(pos, added.begin(), added.end());
+}
+
+void UTF16String::update_lines_for_bytes(size_t start, size_t old_end, size_t new_len) {
+    if (((start | old_end | new_len) & 1) != 0) {
+        _lines_valid = false;
+        return;
+    }
+
+    update_lines(start >> CODER, old_end >> CODER, new_len >> CODER);
+}
+
+uint32_t UTF16String::line_count() {
+    ensure_lines();
+    return (uint32_t) _line_starts.size();
+}
+
+uint32_t UTF16String::line_start(uint32_t line) {
+    ensure_lines();
+    return _line_starts[std::min(line, (uint32_t) _line_starts.size() - 1)];
+}
+
+uint32_t UTF16String::line_of_char(uint32_t index) {
+    ensure_lines();
+    index = std::min(index, (uint32_t) length());
+    auto it = std::upper_bound(_line_starts.begin(), _line_starts.end(), index);
+    return (uint32_t) (it - _line_starts.begin() - 1);
+}
+
+void UTF16String::point_of_char(uint32_t index, uint32_t *row, uint32_t *column) {
+    index = std::min(index, (uint32_t) length());
+    auto line = line_of_char(index);
+    *row = line;
+    *column = (index - _line_starts[line]) << CODER;
+}
+
+uint32_t UTF16String::char_of_point(uint32_t row, uint32_t column) {
+    ensure_lines();
+    if (row >= _line_starts.size()) {
+        return (uint32_t) length();
+    }
+
+    auto start = _line_starts[row];
+
+    // the end of the line, excluding the line break
+    auto end = row + 1 < _line_starts.size() ? _line_starts[row + 1] - 1 : (uint32_t) length();
+    return std::min(start + (column >> CODER), end);
 }
 
 const char *UTF16String::to_cstring() {
     char *chars = new char[byte_length()];
-    for (jint i = 0; i < byte_length(); ++i) {
-        *(chars + i) = _string.at(i);
-    }
+    copy_bytes(0, byte_length(), reinterpret_cast<jbyte *>(chars));
     return chars;
 }
 
@@ -213,22 +386,56 @@ UTF16String *as_str(JNIEnv *env, jlong pointer) {
 }
 
 bool UTF16String::operator==(const UTF16String &rhs) const {
-    return _string == rhs._string;
+    auto len = byte_length();
+    if (len != rhs.byte_length()) {
+        return false;
+    }
+
+    for (jint i = 0; i < len; ++i) {
+        if (_buffer[physical_index(i)] != rhs._buffer[rhs.physical_index(i)]) {
+            return false;
+        }
+    }
+
+    return true;
 }
 
 bool UTF16String::operator!=(const UTF16String &rhs) const {
     return !(rhs == *this);
 }
 
-const jbyte *to_bytes(const jchar *chars, jint len) {
-    auto *bytes = new jbyte[len << CODER];
+static void write_chars(jbyte *dest, const jchar *chars, jint len) {
+#ifdef NATIVE_BYTE_ORDER_UTF16LE
+    memcpy(dest, chars, (size_t) len << CODER);
+#else
     for (int i = 0; i < len; ++i) {
-        jint idx = i << CODER;
         jchar c = *(chars + i);
-        *(bytes + idx++) = (jbyte) (c >> HI_BYTE_SHIFT);
-        *(bytes + idx) = (jbyte) (c >> LO_BYTE_SHIFT);
+        *dest++ = (jbyte) (c >> HI_BYTE_SHIFT);
+        *dest++ = (jbyte) (c >> LO_BYTE_SHIFT);
+    }
+#endif
+}
+
+/**
+ * Copy <code>len</code> characters of the given Java string, starting at <code>from</code>, to
+ * <code>dest</code> as UTF-16LE bytes.
+ */
+static void copy_jstring(JNIEnv *env, jstring src, jint from, jint len, jbyte *dest) {
+    if (len <= 0) {
+        return;
     }
-    return bytes;
+
+#ifdef NATIVE_BYTE_ORDER_UTF16LE
+    // the chars can be copied directly to the destination if it is aligned to jchar
+    if (((uintptr_t) dest & (alignof(jchar) - 1)) == 0) {
+        env->GetStringRegion(src, from, len, reinterpret_cast<jchar *>(dest));
+        return;
+    }
+#endif
+
+    auto chars = vector<jchar>(len);
+    env->GetStringRegion(src, from, len, chars.data());
+    write_chars(dest, chars.data(), len);
 }
 
 jint vsize(const vector<jbyte> &vc) {
@@ -19,17 +19,75 @@
 #define ANDROIDTREESITTER_UTF16STRING_H
 
 #include <jni.h>
+#include <cstdint>
+#include <string>
 #include <vector>
 
 using namespace std;
 
 /**
  * Provides access to <code>std::string</code> to Java classes.
+ *
+ * The bytes of the string are stored in a gap buffer. The bytes between <code>_gap_start</code>
+ * and <code>_gap_end</code> are not part of the string. Edits move the gap to the position of the
+ * edit, so inserting, deleting or replacing text costs as much as the size of the edit plus the
+ * distance from the previous edit, instead of the size of the whole string.
+ *
+ * The string also maintains an index of the start of each line, so that char indices can be
+ * translated to tree-sitter points and back without scanning the text. The index is built the
+ * first time it is used and is then updated by the char-based edits.
  */
 class UTF16String {
 
 private:
-    vector<jbyte> _string;
+    vector<jbyte> _buffer;
+    size_t _gap_start;
+    size_t _gap_end;
+
+    size_t gap_length() const;
+
+    /**
+     * Get the index in the buffer of the byte at the given index in the string.
+     */
+    size_t physical_index(size_t index) const;
+
+    /**
+     * Move the gap so that it starts at the given byte index.
+     */
+    void move_gap(size_t index);
+
+    /**
+     * Make room for <code>len</code> bytes at the given byte index and return the pointer
+     * to the location where the bytes must be written.
+     */
+    jbyte *make_room(size_t index, size_t len);
+
+    /**
+     * Copy the bytes between the given byte indices to <code>dest</code>.
+     */
+    void copy_bytes(size_t start, size_t end, jbyte *dest) const;
+
+    // the char indices of the start of each line, valid only if _lines_valid is true
+    vector<uint32_t> _line_starts;
+    bool _lines_valid;
+
+    /**
+     * Build the line index, if it is not valid.
+     */
+    void ensure_lines();
+
+    /**
+     * Update the line index after the chars between <code>start</code> and
+     * <code>old_end</code> have been replaced with <code>new_len</code> chars.
+     */
+    void update_lines(size_t start, size_t old_end, size_t new_len);
+
+    /**
+     * Update the line index after the bytes between <code>start</code> and
+     * <code>old_end</code> have been replaced with <code>new_len</code> bytes.
+     * The index is invalidated if the edit is not aligned to chars.
+     */
+    void update_lines_for_bytes(size_t start, size_t old_end, size_t new_len);
 
 public:
     UTF16String();
@@ -179,7 +237,7 @@ public:
      * @param end The end index.
      * @return The substring.
      */
-    jstring subjstring_chars(JNIEnv *env, jint start, jint end);
+    jstring subjstring_chars(JNIEnv *env, jint start, jint end) const;
 
     /**
      * Creates a sub-string of this string containing the characters between the given indices.
@@ -190,17 +248,67 @@ public:
      * @param end The end index.
      * @return The substring.
      */
-    jstring subjstring_bytes(JNIEnv *env, jint start, jint end);
+    jstring subjstring_bytes(JNIEnv *env, jint start, jint end) const;
 
     /**
      * @return The length (char-based) of this string.
      */
-    jint length();
+    jint length() const;
 
     /**
      * @return The byte-based length of this string.
      */
-    jint byte_length();
+    jint byte_length() const;
+
+    /**
+     * Get a pointer to the contiguous run of bytes stored in this string, starting at the given
+     * byte index. No copy is made, so the returned pointer is only valid until this string is
+     * modified.
+     *
+     * @param index The byte index.
+     * @param length Set to the number of bytes which can be read from the returned pointer.
+     * @return The pointer to the bytes, or <code>nullptr</code> if the index is out of bounds.
+     */
+    const char *chunk_at(uint32_t index, uint32_t *length);
+
+    /**
+     * Copy the characters between the given byte indices to <code>dest</code>. The indices are
+     * clamped to the bounds of this string.
+     *
+     * @param start The start byte index.
+     * @param end The end byte index.
+     * @param dest The destination string. This is cleared before copying.
+     */
+    void read_chars(uint32_t start, uint32_t end, u16string &dest) const;
+
+    /**
+     * @return The number of lines in this string. An empty string has one line.
+     */
+    uint32_t line_count();
+
+    /**
+     * Get the char index of the start of the given line. The line is clamped to the lines of
+     * this string.
+     */
+    uint32_t line_start(uint32_t line);
+
+    /**
+     * Get the line which contains the char at the given index. The index is clamped to the
+     * length of this string.
+     */
+    uint32_t line_of_char(uint32_t index);
+
+    /**
+     * Get the tree-sitter point of the char at the given index, i.e. the line of the char and its
+     * byte-based column. The index is clamped to the length of this string.
+     */
+    void point_of_char(uint32_t index, uint32_t *row, uint32_t *column);
+
+    /**
+     * Get the char index of the given tree-sitter point. The column is byte-based, and both the
+     * row and the column are clamped to the bounds of this string and its lines.
+     */
+    uint32_t char_of_point(uint32_t row, uint32_t column);
 
     /**
      * Returns this string as a C-style string.
@@ -213,7 +321,7 @@ public:
     /**
      * @return This string as jstring.
      */
-    jstring to_jstring(JNIEnv *env);
+    jstring to_jstring(JNIEnv *env) const;
 
     bool operator==(const UTF16String &rhs) const;
 
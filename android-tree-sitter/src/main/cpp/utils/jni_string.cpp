@@ -16,58 +16,84 @@
  */
 
 #include "jni_string.h"
+#include "ts_obj_utils.h"
 
+#ifdef __ANDROID__
 jstring FNI_NewAndroidString(JNIEnv *pEnv, const jbyte *bytes, int len);
+#else
 jstring FNI_NewJVMString(JNIEnv *env, const jbyte *bytes, jsize len);
+#endif
 
+#ifdef __ANDROID__
+// StringDecoder
+static jclass stringDecoderClass;
+static jmethodID stringDecoderFromBytesMethod;
+#else
 static const char *charset_name = "UTF_16LE";
 
+// String
+static jclass stringClass;
+static jmethodID stringInitMethod;
+static jstring charsetName;
+#endif
+
+void FNI_onLoad(JNIEnv *env) {
+#ifdef __ANDROID__
+    _loadClass(stringDecoderClass, "com/itsaky/androidide/treesitter/string/StringDecoder")
+    _loadStaticMethod(stringDecoderFromBytesMethod, stringDecoderClass, "fromBytes",
+                      "([B)Ljava/lang/String;")
+#else
+    _loadClass(stringClass, "java/lang/String")
+    _loadMethod(stringInitMethod, stringClass, "<init>", "([BLjava/lang/String;)V")
+
+    jstring charset = env->NewStringUTF(charset_name);
+    charsetName = (jstring) env->NewGlobalRef(charset);
+    env->DeleteLocalRef(charset);
+#endif
+}
+
+void FNI_onUnload(JNIEnv *env) {
+#ifdef __ANDROID__
+    env->DeleteGlobalRef(stringDecoderClass);
+#else
+    env->DeleteGlobalRef(stringClass);
+    env->DeleteGlobalRef(charsetName);
+#endif
+}
+
+#ifndef __ANDROID__
 /** Constructs a new java.lang.String object from an array of Unicode
  * characters.
  *
  * Returns a Java string object, or NULL if the string cannot be constructed.
  */
 jstring FNI_NewJVMString(JNIEnv *env, const jbyte *bytes, jsize len) {
-    jstring result;
-    jstring charset = env->NewStringUTF(charset_name);
-    jclass strcls = env->FindClass("java/lang/String");
-    jmethodID cid = env->GetMethodID(strcls, "<init>", "([BLjava/lang/String;)V");
     jbyteArray ba = env->NewByteArray(len);
     env->SetByteArrayRegion(ba, 0, len, bytes);
-    result = (jstring) env->NewObject(strcls, cid, ba, charset);
+    auto result = (jstring) env->NewObject(stringClass, stringInitMethod, ba, charsetName);
     env->DeleteLocalRef(ba);
-    env->DeleteLocalRef(strcls);
-    env->DeleteLocalRef(charset);
     return result;
 }
+#endif
 
 /** Returns the length (the count of Unicode characters) of a Java string.
  */
 jsize FNI_GetStringLength(JNIEnv *env, jstring string) {
-    jclass strcls = env->FindClass("java/lang/String");
-    jmethodID mid = env->GetMethodID(strcls, "length", "()I");
-    env->DeleteLocalRef(strcls);
-    return env->CallIntMethod(string, mid);
+    return env->GetStringLength(string);
 }
 
 /** Returns a pointer to the array of Unicode characters of the string.
  * This pointer is valid until ReleaseStringchars() is called.
  *
- * If isCopy is not NULL, then *isCopy is set to JNI_TRUE if a copy is made;
- * or it is set to JNI_FALSE if no copy is made.
+ * If length is not NULL, then *length is set to the length of the string.
  *
  * Returns a pointer to a Unicode string, or NULL if the operation fails.
  */
 const jchar *FNI_GetStringChars(JNIEnv *env, jstring string, jint *length) {
-    jclass strcls = env->FindClass("java/lang/String");
-    jmethodID mid = env->GetMethodID(strcls, "toCharArray", "()[C");
-    auto ca = (jcharArray) env->CallObjectMethod(string, mid);
-    jsize len = env->GetArrayLength(ca);
+    jsize len = env->GetStringLength(string);
     if (length != nullptr) *length = len;
     auto *result = new jchar [len];
-    env->GetCharArrayRegion(ca, 0, len, result);
-    env->DeleteLocalRef(strcls);
-    env->DeleteLocalRef(ca);
+    env->GetStringRegion(string, 0, len, result);
     return result;
 }
 
@@ -86,14 +112,13 @@ jstring FNI_NewString(JNIEnv *env, const jbyte *bytes, int len) {
 #endif
 }
 
+#ifdef __ANDROID__
 jstring FNI_NewAndroidString(JNIEnv *env, const jbyte *bytes, int len) {
-    jstring result;
-    jclass strcls = env->FindClass("com/itsaky/androidide/treesitter/string/StringDecoder");
-    jmethodID newStr = env->GetStaticMethodID(strcls, "fromBytes", "([B)Ljava/lang/String;");
     jbyteArray ba = env->NewByteArray(len);
     env->SetByteArrayRegion(ba, 0, len, bytes);
-    result = (jstring) env->CallStaticObjectMethod(strcls, newStr, ba);
+    auto result = (jstring) env->CallStaticObjectMethod(stringDecoderClass,
+                                                        stringDecoderFromBytesMethod, ba);
     env->DeleteLocalRef(ba);
-    env->DeleteLocalRef(strcls);
     return result;
 }
+#endif
@@ -24,6 +24,17 @@
 #include <string>
 #include <cstring>
 
+/**
+ * Resolves and caches the classes and methods used by the FNI_* functions.
+ * Called from <code>onLoad</code>.
+ */
+void FNI_onLoad(JNIEnv *env);
+
+/**
+ * Releases the references cached by <code>FNI_onLoad</code>.
+ */
+void FNI_onUnload(JNIEnv *env);
+
 jsize FNI_GetStringLength(JNIEnv *env, jstring string);
 
 const jchar *FNI_GetStringChars(JNIEnv *env, jstring string, int32_t *length);
@@ -0,0 +1,349 @@
+/*
+ *  This file is part of android-tree-sitter.
+ *
+ *  android-tree-sitter library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  android-tree-sitter library is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *  along with android-tree-sitter.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include "ts_allocator.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+
+#include "tree_sitter/api.h"
+#include "ts_instrumentation.h"
+
+namespace {
+
+// the capacity of each size class, excluding the header
+constexpr uint32_t SIZE_CLASSES[] = {16, 32, 48, 64, 80, 96, 112, 128, 192,
+                                     256, 384, 512, 768, 1024};
+constexpr uint32_t CLASS_COUNT = sizeof(SIZE_CLASSES) / sizeof(SIZE_CLASSES[0]);
+
+// the size class of the allocations served by the system allocator
+constexpr uint32_t LARGE_CLASS = CLASS_COUNT;
+
+constexpr size_t SLAB_SIZE = 64 * 1024;
+
+// the maximum number of free blocks cached per class by each thread, half of
+// them are moved to the global free list when the cache is full
+constexpr uint32_t CACHE_LIMIT = 256;
+constexpr uint32_t BATCH_SIZE = CACHE_LIMIT / 2;
+
+/**
+ * Precedes every block allocated by the pooled allocator. The header is 16
+ * bytes long so that the blocks are aligned like the blocks of malloc.
+ */
+struct alignas(16) BlockHeader {
+  uint32_t size_class;
+
+  // the capacity of the large allocations
+  size_t size;
+};
+
+static_assert(sizeof(BlockHeader) == 16, "BlockHeader must be 16 bytes long");
+
+struct FreeBlock {
+  FreeBlock *next;
+};
+
+struct FreeList {
+  FreeBlock *head = nullptr;
+  uint32_t count = 0;
+
+  void push(FreeBlock *block) {
+    block->next = head;
+    head = block;
+    ++count;
+  }
+
+  FreeBlock *pop() {
+    auto *block = head;
+    head = block->next;
+    --count;
+    return block;
+  }
+
+  /**
+   * Move up to the given number of blocks from this list to the given list.
+   */
+  void move_to(FreeList &other, uint32_t max) {
+    while (head != nullptr && max-- > 0) {
+      other.push(pop());
+    }
+  }
+};
+
+struct GlobalClass {
+  std::mutex lock;
+  FreeList blocks;
+};
+
+GlobalClass global_classes[CLASS_COUNT];
+
+std::atomic<bool> allocated{false};
+std::atomic<int> current_type{ALLOCATOR_SYSTEM};
+
+std::atomic<uint64_t> allocation_count{0};
+std::atomic<uint64_t> free_count{0};
+std::atomic<uint64_t> large_allocation_count{0};
+std::atomic<int64_t> allocated_bytes{0};
+std::atomic<uint64_t> reserved_bytes{0};
+
+struct ThreadCache {
+  FreeList classes[CLASS_COUNT];
+
+  ~ThreadCache() {
+    // give the cached blocks back when the thread exits
+    for (uint32_t i = 0; i < CLASS_COUNT; ++i) {
+      if (classes[i].head != nullptr) {
+        std::lock_guard<std::mutex> guard(global_classes[i].lock);
+        classes[i].move_to(global_classes[i].blocks, classes[i].count);
+      }
+    }
+  }
+};
+
+thread_local ThreadCache thread_cache;
+
+uint32_t size_class_for(size_t size) {
+  if (size > SIZE_CLASSES[CLASS_COUNT - 1]) {
+    return LARGE_CLASS;
+  }
+
+  uint32_t size_class = 0;
+  while (SIZE_CLASSES[size_class] < size) {
+    ++size_class;
+  }
+  return size_class;
+}
+
+BlockHeader *header_of(void *ptr) {
+  return (BlockHeader *) ptr - 1;
+}
+
+size_t capacity_of(const BlockHeader *header) {
+  return header->size_class == LARGE_CLASS ? header->size
+                                           : SIZE_CLASSES[header->size_class];
+}
+
+/**
+ * Fill the thread cache of the given class from the global free list, or from
+ * a new slab if the global list is empty.
+ */
+bool refill(uint32_t size_class, FreeList &cache) {
+  auto &global = global_classes[size_class];
+  {
+    std::lock_guard<std::mutex> guard(global.lock);
+    global.blocks.move_to(cache, BATCH_SIZE);
+  }
+  if (cache.head != nullptr) {
+    return true;
+  }
+
+  auto *slab = (char *) malloc(SLAB_SIZE);
+  if (slab == nullptr) {
+    return false;
+  }
+
+  reserved_bytes.fetch_add(SLAB_SIZE, std::memory_order_relaxed);
+  auto block_size = sizeof(BlockHeader) + SIZE_CLASSES[size_class];
+  for (size_t offset = 0; offset + block_size <= SLAB_SIZE; offset += block_size) {
+    auto *header = (BlockHeader *) (slab + offset);
+    header->size_class = size_class;
+    cache.push((FreeBlock *) (header + 1));
+  }
+  return true;
+}
+
+void record_allocation(size_t capacity, bool large) {
+  if (TSStats::enabled()) {
+    TSStats::add(allocation_count);
+    if (large) {
+      TSStats::add(large_allocation_count);
+    }
+    allocated_bytes.fetch_add((int64_t) capacity, std::memory_order_relaxed);
+  }
+}
+
+void *pool_malloc(size_t size) {
+  auto size_class = size_class_for(size);
+  if (size_class == LARGE_CLASS) {
+    auto *header = (BlockHeader *) malloc(sizeof(BlockHeader) + size);
+    if (header == nullptr) {
+      return nullptr;
+    }
+    header->size_class = LARGE_CLASS;
+    header->size = size;
+    record_allocation(size, true);
+    return header + 1;
+  }
+
+  auto &cache = thread_cache.classes[size_class];
+  if (cache.head == nullptr && !refill(size_class, cache)) {
+    return nullptr;
+  }
+
+  record_allocation(SIZE_CLASSES[size_class], false);
+  return cache.pop();
+}
+
+void pool_free(void *ptr) {
+  if (ptr == nullptr) {
+    return;
+  }
+
+  auto *header = header_of(ptr);
+  if (TSStats::enabled()) {
+    TSStats::add(free_count);
+    allocated_bytes.fetch_sub((int64_t) capacity_of(header), std::memory_order_relaxed);
+  }
+
+  if (header->size_class == LARGE_CLASS) {
+    free(header);
+    return;
+  }
+
+  auto &cache = thread_cache.classes[header->size_class];
+  cache.push((FreeBlock *) ptr);
+  if (cache.count > CACHE_LIMIT) {
+    auto &global = global_classes[header->size_class];
+    std::lock_guard<std::mutex> guard(global.lock);
+    cache.move_to(global.blocks, BATCH_SIZE);
+  }
+}
+
+void *pool_calloc(size_t count, size_t size) {
+  if (size != 0 && count > SIZE_MAX / size) {
+    return nullptr;
+  }
+
+  auto *ptr = pool_malloc(count * size);
+  if (ptr != nullptr) {
+    memset(ptr, 0, count * size);
+  }
+  return ptr;
+}
+
+void *pool_realloc(void *ptr, size_t size) {
+  if (ptr == nullptr) {
+    return pool_malloc(size);
+  }
+
+  auto *header = header_of(ptr);
+  auto capacity = capacity_of(header);
+  if (header->size_class == LARGE_CLASS && size > SIZE_CLASSES[CLASS_COUNT - 1]) {
+    auto *resized = (BlockHeader *) realloc(header, sizeof(BlockHeader) + size);
+    if (resized == nullptr) {
+      return nullptr;
+    }
+    resized->size = size;
+    if (TSStats::enabled()) {
+      allocated_bytes.fetch_add((int64_t) size - (int64_t) capacity,
+                                std::memory_order_relaxed);
+    }
+    return resized + 1;
+  }
+
+  if (header->size_class != LARGE_CLASS && size <= capacity) {
+    return ptr;
+  }
+
+  auto *resized = pool_malloc(size);
+  if (resized == nullptr) {
+    return nullptr;
+  }
+  memcpy(resized, ptr, capacity < size ? capacity : size);
+  pool_free(ptr);
+  return resized;
+}
+
+// the system allocator, which records whether tree-sitter has allocated
+// anything so that the allocator is not changed afterwards
+
+void *tracked_malloc(size_t size) {
+  if (!allocated.load(std::memory_order_relaxed)) {
+    allocated.store(true, std::memory_order_relaxed);
+  }
+  return malloc(size);
+}
+
+void *tracked_calloc(size_t count, size_t size) {
+  if (!allocated.load(std::memory_order_relaxed)) {
+    allocated.store(true, std::memory_order_relaxed);
+  }
+  return calloc(count, size);
+}
+
+void *tracked_realloc(void *ptr, size_t size) {
+  if (!allocated.load(std::memory_order_relaxed)) {
+    allocated.store(true, std::memory_order_relaxed);
+  }
+  return realloc(ptr, size);
+}
+
+}  // namespace
+
+void TSAllocator::install() {
+  ts_set_allocator(tracked_malloc, tracked_calloc, tracked_realloc, ::free);
+}
+
+bool TSAllocator::set(TSAllocatorType type) {
+  static std::mutex lock;
+  std::lock_guard<std::mutex> guard(lock);
+  if (type == current_type.load(std::memory_order_relaxed)) {
+    return true;
+  }
+
+  // the pooled allocator does not track its allocations, it is never replaced
+  if (type != ALLOCATOR_POOLED || allocated.load(std::memory_order_relaxed)) {
+    return false;
+  }
+
+  ts_set_allocator(pool_malloc, pool_calloc, pool_realloc, pool_free);
+  current_type.store(type, std::memory_order_relaxed);
+  return true;
+}
+
+TSAllocatorType TSAllocator::get() {
+  return (TSAllocatorType) current_type.load(std::memory_order_relaxed);
+}
+
+void TSAllocator::free(void *ptr) {
+  // the allocator is only changed before the first allocation, so the memory
+  // was allocated by the current allocator
+  if (get() == ALLOCATOR_POOLED) {
+    pool_free(ptr);
+  } else {
+    ::free(ptr);
+  }
+}
+
+jlongArray TSAllocator::pack_stats(JNIEnv *env) {
+  jlong values[PACKED_ALLOCATOR_STATS_SIZE] = {
+      (jlong) allocation_count.load(std::memory_order_relaxed),
+      (jlong) free_count.load(std::memory_order_relaxed),
+      (jlong) large_allocation_count.load(std::memory_order_relaxed),
+      (jlong) allocated_bytes.load(std::memory_order_relaxed),
+      (jlong) reserved_bytes.load(std::memory_order_relaxed),
+  };
+
+  auto result = env->NewLongArray(PACKED_ALLOCATOR_STATS_SIZE);
+  if (result != nullptr) {
+    env->SetLongArrayRegion(result, 0, PACKED_ALLOCATOR_STATS_SIZE, values);
+  }
+  return result;
+}
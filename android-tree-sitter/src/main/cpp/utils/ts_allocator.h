@@ -0,0 +1,95 @@
+/*
+ *  This file is part of android-tree-sitter.
+ *
+ *  android-tree-sitter library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  android-tree-sitter library is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *  along with android-tree-sitter.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef ATS_TS_ALLOCATOR_H
+#define ATS_TS_ALLOCATOR_H
+
+#include <jni.h>
+#include <cstdint>
+
+// The number of jlong values in a packed allocator stats record :
+// allocations, frees, large allocations, allocated bytes, reserved bytes
+// Must be kept in sync with TSAllocatorStats.RECORD_SIZE
+#define PACKED_ALLOCATOR_STATS_SIZE 5
+
+/**
+ * The allocators that tree-sitter can use, must be kept in sync with the
+ * <code>ALLOCATOR_*</code> constants in TreeSitter.
+ */
+enum TSAllocatorType {
+
+  // the system allocator
+  ALLOCATOR_SYSTEM = 0,
+
+  // a size-class pool with per-thread caches, see TSAllocator
+  ALLOCATOR_POOLED = 1
+};
+
+/**
+ * Selects the allocator used by tree-sitter.
+ *
+ * The pooled allocator serves the small allocations (up to 1 KiB, which covers
+ * the subtrees, parse stack nodes and most of the arrays) from size classes
+ * carved out of 64 KiB slabs. Each thread caches the freed blocks of each class,
+ * so allocating and freeing on the parsing thread does not take a lock, and the
+ * caches are exchanged with the global free lists in batches. The slabs are
+ * never returned to the system : the memory of freed trees is reused by the
+ * next trees instead. The larger allocations go to the system allocator.
+ *
+ * The memory allocated by one allocator cannot be freed by the other, so the
+ * allocator can only be changed before tree-sitter has allocated anything.
+ */
+class TSAllocator {
+ public:
+  TSAllocator() = delete;
+
+  /**
+   * Install the system allocator, tracking whether tree-sitter has allocated
+   * anything. Called when the library is loaded, before any tree-sitter
+   * object is created.
+   */
+  static void install();
+
+  /**
+   * Use the given allocator.
+   *
+   * @return Whether the allocator is used, which is false if tree-sitter has
+   *         already allocated memory with another allocator. Once the pooled
+   *         allocator is used, it cannot be replaced.
+   */
+  static bool set(TSAllocatorType type);
+
+  static TSAllocatorType get();
+
+  /**
+   * Free memory which was allocated by tree-sitter, e.g. the arrays returned
+   * by ts_tree_get_changed_ranges or the string returned by ts_node_string.
+   * Such memory must never be released with the system free(), as it may have
+   * been allocated by the pooled allocator.
+   */
+  static void free(void *ptr);
+
+  /**
+   * Pack the stats of the pooled allocator into a new long[]. The counters
+   * are only updated while the stats are enabled (see TSStats), except for
+   * the reserved bytes.
+   */
+  static jlongArray pack_stats(JNIEnv *env);
+};
+
+#endif  // ATS_TS_ALLOCATOR_H
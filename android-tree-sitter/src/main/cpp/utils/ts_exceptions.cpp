@@ -41,3 +41,7 @@ int throw_illegal_state(JNIEnv *env, const char *message) {
 int throw_npe(JNIEnv *env, const char *message) {
   return throw_exception(env, "java/lang/NullPointerException", message);
 }
+
+int throw_io_exception(JNIEnv *env, const char *message) {
+  return throw_exception(env, "java/io/IOException", message);
+}
@@ -49,4 +49,11 @@ int throw_illegal_state(JNIEnv *env, const char *message);
  */
 int throw_npe(JNIEnv *env, const char *message);
 
+/**
+ * Throws an `IOException` in the JVM with the given message.
+ * @param env The JNI environment.
+ * @param message The message for the exception.
+ */
+int throw_io_exception(JNIEnv *env, const char *message);
+
 #endif //ATS_TS_EXCEPTIONS_H
@@ -0,0 +1,176 @@
+/*
+ *  This file is part of android-tree-sitter.
+ *
+ *  android-tree-sitter library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  android-tree-sitter library is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *  along with android-tree-sitter.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include "ts_instrumentation.h"
+#include "ts_misc.h"
+
+#ifdef __ANDROID__
+#include <dlfcn.h>
+#include <mutex>
+#endif
+
+std::atomic<bool> TSStats::_enabled{false};
+TSStats::PaddedCounter TSStats::_marshalled[MARSHALLED_TYPE_COUNT];
+std::atomic<bool> TSTrace::_enabled{false};
+
+static jlongArray pack_counters(JNIEnv *env, const jlong *values, jsize count) {
+  auto result = env->NewLongArray(count);
+  if (result != nullptr) {
+    env->SetLongArrayRegion(result, 0, count, values);
+  }
+  return result;
+}
+
+jlongArray TSStats::pack_marshalled(JNIEnv *env) {
+  jlong values[PACKED_MARSHALLING_STATS_SIZE];
+  for (int i = 0; i < MARSHALLED_TYPE_COUNT; ++i) {
+    values[i] = (jlong) _marshalled[i].value.load(std::memory_order_relaxed);
+  }
+  return pack_counters(env, values, PACKED_MARSHALLING_STATS_SIZE);
+}
+
+void TSStats::reset_marshalled() {
+  for (auto &counter : _marshalled) {
+    counter.value.store(0, std::memory_order_relaxed);
+  }
+}
+
+static uint32_t parse_time_bucket(uint64_t time_ns) {
+  auto micros = time_ns / 1000;
+  uint32_t bucket = 0;
+  while (micros > 1 && bucket < PARSE_TIME_BUCKETS - 1) {
+    micros >>= 1;
+    ++bucket;
+  }
+  return bucket;
+}
+
+void TSParserStats::record(uint64_t time_ns,
+                           uint32_t bytes,
+                           bool cancelled,
+                           bool timed_out) {
+  TSStats::add(parse_count);
+  TSStats::add(bytes_parsed, bytes);
+  TSStats::add(parse_time_ns, time_ns);
+  TSStats::add(parse_time_histogram[parse_time_bucket(time_ns)]);
+  if (cancelled) {
+    TSStats::add(cancellations);
+  }
+  if (timed_out) {
+    TSStats::add(timeouts);
+  }
+}
+
+jlongArray TSParserStats::pack(JNIEnv *env) const {
+  jlong values[PACKED_PARSER_STATS_SIZE];
+  values[0] = (jlong) parse_count.load(std::memory_order_relaxed);
+  values[1] = (jlong) bytes_parsed.load(std::memory_order_relaxed);
+  values[2] = (jlong) parse_time_ns.load(std::memory_order_relaxed);
+  values[3] = (jlong) cancellations.load(std::memory_order_relaxed);
+  values[4] = (jlong) timeouts.load(std::memory_order_relaxed);
+  for (int i = 0; i < PARSE_TIME_BUCKETS; ++i) {
+    values[5 + i] =
+        (jlong) parse_time_histogram[i].load(std::memory_order_relaxed);
+  }
+  return pack_counters(env, values, PACKED_PARSER_STATS_SIZE);
+}
+
+void TSParserStats::reset() {
+  parse_count.store(0, std::memory_order_relaxed);
+  bytes_parsed.store(0, std::memory_order_relaxed);
+  parse_time_ns.store(0, std::memory_order_relaxed);
+  cancellations.store(0, std::memory_order_relaxed);
+  timeouts.store(0, std::memory_order_relaxed);
+  for (auto &bucket : parse_time_histogram) {
+    bucket.store(0, std::memory_order_relaxed);
+  }
+}
+
+jlongArray TSQueryCursorStats::pack(JNIEnv *env) const {
+  jlong values[PACKED_QUERY_CURSOR_STATS_SIZE] = {
+      (jlong) executions.load(std::memory_order_relaxed),
+      (jlong) matches.load(std::memory_order_relaxed),
+      (jlong) captures.load(std::memory_order_relaxed),
+      (jlong) time_ns.load(std::memory_order_relaxed),
+      (jlong) match_limit_hits.load(std::memory_order_relaxed),
+      (jlong) predicate_rejections.load(std::memory_order_relaxed),
+  };
+  return pack_counters(env, values, PACKED_QUERY_CURSOR_STATS_SIZE);
+}
+
+void TSQueryCursorStats::reset() {
+  executions.store(0, std::memory_order_relaxed);
+  matches.store(0, std::memory_order_relaxed);
+  captures.store(0, std::memory_order_relaxed);
+  time_ns.store(0, std::memory_order_relaxed);
+  match_limit_hits.store(0, std::memory_order_relaxed);
+  predicate_rejections.store(0, std::memory_order_relaxed);
+}
+
+#ifdef __ANDROID__
+
+typedef void (*ATraceBeginSectionFn)(const char *);
+typedef void (*ATraceEndSectionFn)();
+
+static ATraceBeginSectionFn atrace_begin_section = nullptr;
+static ATraceEndSectionFn atrace_end_section = nullptr;
+
+static bool load_atrace() {
+  static std::once_flag once;
+  std::call_once(once, [] {
+    // libandroid is always loaded in app processes, the handle is never closed
+    void *lib = dlopen("libandroid.so", RTLD_NOW | RTLD_LOCAL);
+    if (lib == nullptr) {
+      return;
+    }
+
+    auto begin_section = (ATraceBeginSectionFn) dlsym(lib, "ATrace_beginSection");
+    auto end_section = (ATraceEndSectionFn) dlsym(lib, "ATrace_endSection");
+    if (begin_section && end_section) {
+      atrace_begin_section = begin_section;
+      atrace_end_section = end_section;
+    }
+  });
+  return atrace_begin_section != nullptr;
+}
+
+bool TSTrace::set_enabled(bool enabled) {
+  enabled = enabled && load_atrace();
+  _enabled.store(enabled, std::memory_order_relaxed);
+  return enabled;
+}
+
+void TSTrace::begin_section(const char *name) {
+  atrace_begin_section(name);
+}
+
+void TSTrace::end_section() {
+  atrace_end_section();
+}
+
+#else
+
+bool TSTrace::set_enabled(__TS_ATTR_UNUSED bool enabled) {
+  return false;
+}
+
+void TSTrace::begin_section(__TS_ATTR_UNUSED const char *name) {}
+
+void TSTrace::end_section() {}
+
+#endif
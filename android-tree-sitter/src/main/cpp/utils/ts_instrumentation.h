@@ -0,0 +1,217 @@
+/*
+ *  This file is part of android-tree-sitter.
+ *
+ *  android-tree-sitter library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  android-tree-sitter library is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *  along with android-tree-sitter.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef ATS_TS_INSTRUMENTATION_H
+#define ATS_TS_INSTRUMENTATION_H
+
+#include <jni.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+// The number of buckets of the parse time histogram. Bucket i counts the
+// parses which took [2^i, 2^(i+1)) microseconds, the first bucket also counts
+// the parses which took less than a microsecond and the last bucket counts all
+// the parses which took longer.
+#define PARSE_TIME_BUCKETS 24
+
+// The number of jlong values in a packed parser stats record :
+// parse count, bytes parsed, parse time (ns), cancellations, timeouts, followed
+// by the PARSE_TIME_BUCKETS buckets of the parse time histogram
+// Must be kept in sync with TSParserStats.RECORD_SIZE
+#define PACKED_PARSER_STATS_SIZE (5 + PARSE_TIME_BUCKETS)
+
+// The number of jlong values in a packed query cursor stats record :
+// executions, matches, captures, time spent in the next* calls (ns), match
+// limit hits, predicate rejections
+// Must be kept in sync with TSQueryCursorStats.RECORD_SIZE
+#define PACKED_QUERY_CURSOR_STATS_SIZE 6
+
+// The objects created through the NativeObjectFactory which are counted by the
+// marshalling stats, in the order of the packed marshalling stats record.
+// Must be kept in sync with TSMarshallingStats
+enum TSMarshalledType {
+  MARSHALLED_NODE = 0,
+  MARSHALLED_POINT,
+  MARSHALLED_RANGE,
+  MARSHALLED_MATCH,
+  MARSHALLED_CAPTURE,
+  MARSHALLED_TREE_CURSOR_NODE,
+  MARSHALLED_TYPE_COUNT
+};
+
+// The number of jlong values in a packed marshalling stats record
+// Must be kept in sync with TSMarshallingStats.RECORD_SIZE
+#define PACKED_MARSHALLING_STATS_SIZE MARSHALLED_TYPE_COUNT
+
+/**
+ * The counters are only updated while the stats are enabled. All the counters
+ * are relaxed atomics : they may be read from any thread while being updated,
+ * and a snapshot is not guaranteed to be consistent across counters.
+ */
+class TSStats {
+ public:
+  TSStats() = delete;
+
+  /**
+   * Whether the stats are being collected. This is a single relaxed load, and
+   * is the only cost of the instrumentation while the stats are disabled.
+   */
+  static bool enabled() {
+    return _enabled.load(std::memory_order_relaxed);
+  }
+
+  static void set_enabled(bool enabled) {
+    _enabled.store(enabled, std::memory_order_relaxed);
+  }
+
+  /**
+   * Get the current time of the monotonic clock, in nanoseconds.
+   */
+  static uint64_t now() {
+    return (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+  static void add(std::atomic<uint64_t> &counter, uint64_t value = 1) {
+    counter.fetch_add(value, std::memory_order_relaxed);
+  }
+
+  /**
+   * Count an object of the given type created through the NativeObjectFactory,
+   * if the stats are enabled.
+   */
+  static void count_marshalled(TSMarshalledType type) {
+    if (enabled()) {
+      add(_marshalled[type].value);
+    }
+  }
+
+  /**
+   * Pack the marshalling stats into a new long[].
+   */
+  static jlongArray pack_marshalled(JNIEnv *env);
+
+  static void reset_marshalled();
+
+ private:
+  // each counter is on its own cache line, as the objects are marshalled from
+  // multiple threads
+  struct alignas(64) PaddedCounter {
+    std::atomic<uint64_t> value{0};
+  };
+
+  static std::atomic<bool> _enabled;
+  static PaddedCounter _marshalled[MARSHALLED_TYPE_COUNT];
+};
+
+/**
+ * The stats of a single parser. Updated only by the thread parsing with the
+ * parser.
+ */
+struct TSParserStats {
+  std::atomic<uint64_t> parse_count{0};
+  std::atomic<uint64_t> bytes_parsed{0};
+  std::atomic<uint64_t> parse_time_ns{0};
+  std::atomic<uint64_t> cancellations{0};
+  std::atomic<uint64_t> timeouts{0};
+  std::atomic<uint64_t> parse_time_histogram[PARSE_TIME_BUCKETS]{};
+
+  /**
+   * Record a parse which took the given time.
+   */
+  void record(uint64_t time_ns, uint32_t bytes, bool cancelled, bool timed_out);
+
+  jlongArray pack(JNIEnv *env) const;
+
+  void reset();
+};
+
+/**
+ * The stats of a single query cursor. Updated only by the thread using the
+ * cursor.
+ */
+struct TSQueryCursorStats {
+  std::atomic<uint64_t> executions{0};
+  std::atomic<uint64_t> matches{0};
+  std::atomic<uint64_t> captures{0};
+  std::atomic<uint64_t> time_ns{0};
+  std::atomic<uint64_t> match_limit_hits{0};
+  std::atomic<uint64_t> predicate_rejections{0};
+
+  jlongArray pack(JNIEnv *env) const;
+
+  void reset();
+};
+
+/**
+ * Optional tracing of the long running native operations as atrace sections,
+ * which show up in Perfetto and systrace captures. The atrace functions are
+ * looked up at runtime as they are only available on API 23+, tracing is not
+ * supported on other platforms.
+ */
+class TSTrace {
+ public:
+  TSTrace() = delete;
+
+  /**
+   * Enable or disable the tracing.
+   *
+   * @return Whether the tracing is enabled, which is false if atrace is not
+   *         available.
+   */
+  static bool set_enabled(bool enabled);
+
+  static bool enabled() {
+    return _enabled.load(std::memory_order_relaxed);
+  }
+
+  static void begin_section(const char *name);
+
+  static void end_section();
+
+ private:
+  static std::atomic<bool> _enabled;
+};
+
+/**
+ * Trace the enclosing scope as an atrace section, if the tracing is enabled.
+ */
+class TSTraceSection {
+ public:
+  explicit TSTraceSection(const char *name) : _traced(TSTrace::enabled()) {
+    if (_traced) {
+      TSTrace::begin_section(name);
+    }
+  }
+
+  ~TSTraceSection() {
+    if (_traced) {
+      TSTrace::end_section();
+    }
+  }
+
+  TSTraceSection(const TSTraceSection &) = delete;
+
+  TSTraceSection &operator=(const TSTraceSection &) = delete;
+
+ private:
+  bool _traced;
+};
+
+#endif  // ATS_TS_INSTRUMENTATION_H
@@ -19,6 +19,10 @@
 #define TS_UTILS
 
 #include "ts_obj_utils.h"
+#include "jni_string.h"
+#include "ts_allocator.h"
+#include "ts_exceptions.h"
+#include "ts_instrumentation.h"
 
 jint getPredicateTypeId(TSQueryPredicateStepType type);
 
@@ -64,6 +68,7 @@ static jclass matchClass;
 static jfieldID matchClassIdField;
 static jfieldID matchClassPatternIndexField;
 static jfieldID matchClassCapturesField;
+static jfieldID matchClassCaptureIndexField;
 
 // TSQueryCapture
 static jclass captureClass;
@@ -75,6 +80,10 @@ static jclass queryPredicateStepClass;
 static jfieldID queryPredicateStepTypeField;
 static jfieldID queryPredicateStepValueIdField;
 
+// TSInputReader
+static jclass inputReaderClass;
+static jmethodID inputReaderReadMethod;
+
 static jclass objectFactoryClass;
 static jmethodID factory_createNode;
 static jmethodID factory_createTreeCursorNode;
@@ -89,6 +98,8 @@ static jmethodID factory_createQueryPredicateStepArr;
 
 void onLoad(JNIEnv *env) {
 
+  FNI_onLoad(env);
+
   _loadClass(objectFactoryClass,
              "com/itsaky/androidide/treesitter/internal/NativeObjectFactory")
 
@@ -194,6 +205,7 @@ void onLoad(JNIEnv *env) {
   _loadField(matchClassPatternIndexField, matchClass, "patternIndex", "I")
   _loadField(matchClassCapturesField, matchClass, "captures",
              "[Lcom/itsaky/androidide/treesitter/TSQueryCapture;")
+  _loadField(matchClassCaptureIndexField, matchClass, "captureIndex", "I")
 
   // TSQueryCapture
   _loadClass(captureClass, "com/itsaky/androidide/treesitter/TSQueryCapture")
@@ -208,9 +220,14 @@ void onLoad(JNIEnv *env) {
              "I")
   _loadField(queryPredicateStepValueIdField, queryPredicateStepClass,
              "valueId", "I")
+
+  // TSInputReader
+  _loadClass(inputReaderClass, "com/itsaky/androidide/treesitter/TSInputReader")
+  _loadMethod(inputReaderReadMethod, inputReaderClass, "read", "(I[C)I")
 }
 
 void onUnload(JNIEnv *env) {
+  FNI_onUnload(env);
   env->DeleteGlobalRef(nodeClass);
   env->DeleteGlobalRef(treeCursorNodeClass);
   env->DeleteGlobalRef(pointClass);
@@ -219,11 +236,13 @@ void onUnload(JNIEnv *env) {
   env->DeleteGlobalRef(matchClass);
   env->DeleteGlobalRef(captureClass);
   env->DeleteGlobalRef(queryPredicateStepClass);
+  env->DeleteGlobalRef(inputReaderClass);
   env->DeleteGlobalRef(objectFactoryClass);
 }
 
 // Node
 jobject _marshalNode(JNIEnv *env, TSNode node) {
+  TSStats::count_marshalled(MARSHALLED_NODE);
   return env->CallStaticObjectMethod(objectFactoryClass,
                                      factory_createNode,
                                      (jint) node.context[0],
@@ -246,18 +265,146 @@ TSNode _unmarshalNode(JNIEnv *env, jobject javaObject) {
       (const TSTree *) env->GetLongField(javaObject, nodeTreeField)};
 }
 
+void _packNode(std::vector<jint> &dest, TSNode node) {
+  auto id = (uint64_t) node.id;
+  dest.push_back((jint) node.context[0]);
+  dest.push_back((jint) node.context[1]);
+  dest.push_back((jint) node.context[2]);
+  dest.push_back((jint) node.context[3]);
+  dest.push_back((jint) (id & 0xffffffff));
+  dest.push_back((jint) (id >> 32));
+}
+
+jint _nodeFlags(TSNode node) {
+  return (ts_node_is_named(node) ? FLAG_NAMED : 0) |
+         (ts_node_is_extra(node) ? FLAG_EXTRA : 0) |
+         (ts_node_is_missing(node) ? FLAG_MISSING : 0) |
+         (ts_node_is_error(node) ? FLAG_ERROR : 0) |
+         (ts_node_has_error(node) ? FLAG_HAS_ERROR : 0);
+}
+
+jintArray _newIntArray(JNIEnv *env, const std::vector<jint> &values) {
+  auto size = (jsize) values.size();
+  auto result = env->NewIntArray(size);
+  if (result != nullptr && size > 0) {
+    env->SetIntArrayRegion(result, 0, size, values.data());
+  }
+  return result;
+}
+
+void _packRange(std::vector<jint> &dest, TSRange range) {
+  dest.push_back((jint) range.start_byte);
+  dest.push_back((jint) range.end_byte);
+  dest.push_back((jint) range.start_point.row);
+  dest.push_back((jint) range.start_point.column);
+  dest.push_back((jint) range.end_point.row);
+  dest.push_back((jint) range.end_point.column);
+}
+
+bool _unpackRanges(JNIEnv *env, jintArray ranges, std::vector<TSRange> &dest) {
+  auto length = env->GetArrayLength(ranges);
+  if (length % PACKED_RANGE_SIZE != 0) {
+    throw_illegal_args(env, "Malformed packed ranges");
+    return false;
+  }
+
+  thread_local std::vector<jint> records;
+  records.resize(length);
+  env->GetIntArrayRegion(ranges, 0, length, records.data());
+
+  dest.clear();
+  dest.reserve(length / PACKED_RANGE_SIZE);
+  for (jsize i = 0; i < length; i += PACKED_RANGE_SIZE) {
+    const jint *record = records.data() + i;
+    TSRange range;
+    range.start_byte = (uint32_t) record[0];
+    range.end_byte = (uint32_t) record[1];
+    range.start_point = {(uint32_t) record[2], (uint32_t) record[3]};
+    range.end_point = {(uint32_t) record[4], (uint32_t) record[5]};
+    dest.push_back(range);
+  }
+
+  return true;
+}
+
+jintArray _packRanges(JNIEnv *env, const TSRange *ranges, uint32_t count) {
+  thread_local std::vector<jint> records;
+  records.clear();
+  records.reserve(count * PACKED_RANGE_SIZE);
+  for (uint32_t i = 0; i < count; ++i) {
+    _packRange(records, ranges[i]);
+  }
+  return _newIntArray(env, records);
+}
+
+bool _unpackEdits(JNIEnv *env, jintArray edits, std::vector<TSInputEdit> &dest) {
+  auto length = env->GetArrayLength(edits);
+  if (length % PACKED_EDIT_SIZE != 0) {
+    throw_illegal_args(env, "Malformed packed edits");
+    return false;
+  }
+
+  // reused across calls to avoid allocating a buffer for every batch of edits
+  thread_local std::vector<jint> records;
+  records.resize(length);
+  env->GetIntArrayRegion(edits, 0, length, records.data());
+
+  dest.clear();
+  dest.reserve(length / PACKED_EDIT_SIZE);
+  for (jsize i = 0; i < length; i += PACKED_EDIT_SIZE) {
+    const jint *record = records.data() + i;
+    TSInputEdit edit;
+    edit.start_byte = (uint32_t) record[0];
+    edit.old_end_byte = (uint32_t) record[1];
+    edit.new_end_byte = (uint32_t) record[2];
+    edit.start_point = {(uint32_t) record[3], (uint32_t) record[4]};
+    edit.old_end_point = {(uint32_t) record[5], (uint32_t) record[6]};
+    edit.new_end_point = {(uint32_t) record[7], (uint32_t) record[8]};
+    dest.push_back(edit);
+  }
+
+  return true;
+}
+
+bool _applyPackedEdits(JNIEnv *env, TSTree *tree, jintArray edits) {
+  thread_local std::vector<TSInputEdit> unpacked;
+  if (!_unpackEdits(env, edits, unpacked)) {
+    return false;
+  }
+
+  for (const auto &edit : unpacked) {
+    ts_tree_edit(tree, &edit);
+  }
+
+  return true;
+}
+
+jintArray _packChangedRanges(JNIEnv *env, const TSTree *old_tree,
+                             const TSTree *new_tree) {
+  uint32_t count = 0;
+  TSRange *ranges = ts_tree_get_changed_ranges(old_tree, new_tree, &count);
+  jintArray result = _packRanges(env, ranges, count);
+  TSAllocator::free(ranges);
+  return result;
+}
+
 // TreeCursorNode
 jobject _marshalTreeCursorNode(JNIEnv *env, TreeCursorNode node) {
-  return env->CallStaticObjectMethod(objectFactoryClass,
-                                     factory_createTreeCursorNode,
-                                     env->NewStringUTF(node.type),
-                                     env->NewStringUTF(node.name),
-                                     (jint) node.startByte,
-                                     (jint) node.endByte);
+  TSStats::count_marshalled(MARSHALLED_TREE_CURSOR_NODE);
+  jobject result = env->CallStaticObjectMethod(objectFactoryClass,
+                                               factory_createTreeCursorNode,
+                                               node.type,
+                                               node.name,
+                                               (jint) node.startByte,
+                                               (jint) node.endByte);
+  if (node.type != nullptr) env->DeleteLocalRef(node.type);
+  if (node.name != nullptr) env->DeleteLocalRef(node.name);
+  return result;
 }
 
 // TSPoint
 jobject _marshalPoint(JNIEnv *env, TSPoint point) {
+  TSStats::count_marshalled(MARSHALLED_POINT);
   return env->CallStaticObjectMethod(objectFactoryClass,
                                      factory_createPoint,
                                      point.row,
@@ -287,6 +434,7 @@ TSInputEdit _unmarshalInputEdit(JNIEnv *env, jobject inputEdit) {
 }
 
 jobject _marshalMatch(JNIEnv *env, TSQueryMatch match) {
+  TSStats::count_marshalled(MARSHALLED_MATCH);
   jobjectArray captures =
       env->NewObjectArray(match.capture_count, captureClass, nullptr);
   for (int i = 0; i < match.capture_count; i++) {
@@ -301,7 +449,17 @@ jobject _marshalMatch(JNIEnv *env, TSQueryMatch match) {
                                      captures);
 }
 
+jobject _marshalCaptureMatch(JNIEnv *env, TSQueryMatch match,
+                             uint32_t capture_index) {
+  jobject result = _marshalMatch(env, match);
+  if (result != nullptr) {
+    env->SetIntField(result, matchClassCaptureIndexField, (jint) capture_index);
+  }
+  return result;
+}
+
 jobject _marshalCapture(JNIEnv *env, TSQueryCapture capture) {
+  TSStats::count_marshalled(MARSHALLED_CAPTURE);
   auto node = capture.node;
   return env->CallStaticObjectMethod(objectFactoryClass,
                                      factory_createQueryCapture,
@@ -315,6 +473,7 @@ jobject _marshalCapture(JNIEnv *env, TSQueryCapture capture) {
 }
 
 jobject _marshalRange(JNIEnv *env, TSRange range) {
+  TSStats::count_marshalled(MARSHALLED_RANGE);
   return env->CallStaticObjectMethod(objectFactoryClass, factory_createRange,
                                      (jint) range.start_byte,
                                      (jint) range.end_byte,
@@ -341,6 +500,10 @@ jobjectArray createRangeArr(JNIEnv *env, jint size) {
       size);
 }
 
+jint _readInput(JNIEnv *env, jobject reader, jint charOffset, jcharArray buffer) {
+  return env->CallIntMethod(reader, inputReaderReadMethod, charOffset, buffer);
+}
+
 jobject _marshalQueryPredicateStep(JNIEnv *env,
                                    const TSQueryPredicateStep *predicate) {
   return env->CallStaticObjectMethod(objectFactoryClass,
@@ -16,11 +16,53 @@
  */
 
 #include <jni.h>
+#include <vector>
 #include "tree_sitter/api.h"
 
+// The number of jint values in a packed TSNode record :
+// context[0], context[1], context[2], context[3], low bits of id, high bits of id
+// Must be kept in sync with TSNodeList.RECORD_SIZE
+#define PACKED_NODE_SIZE 6
+
+// The number of jint values in a packed capture record :
+// capture id, pattern index, start byte, end byte, low bits of node id, high
+// bits of node id
+// Must be kept in sync with TSQueryCursor.CAPTURE_RECORD_SIZE
+#define PACKED_CAPTURE_SIZE 6
+
+// The number of jint values in a packed TSInputEdit record :
+// start byte, old end byte, new end byte, start point, old end point, new end
+// point (row and column for each point)
+// Must be kept in sync with TSInputEdit.RECORD_SIZE
+#define PACKED_EDIT_SIZE 9
+
+// The number of jint values in a packed TSRange record :
+// start byte, end byte, start row, start column, end row, end column
+// Must be kept in sync with TSRangeList.RECORD_SIZE
+#define PACKED_RANGE_SIZE 6
+
+// The number of jint values in a packed tree cursor node info record :
+// symbol, field id, start byte, end byte, start row, start column, depth,
+// flags
+// Must be kept in sync with TSTreeCursor.INFO_SIZE
+#define PACKED_CURSOR_INFO_SIZE 8
+
+// The number of jlong values in a packed tree footprint record :
+// retained bytes, unique bytes, shared bytes, node count, heap subtree count,
+// shared heap subtree count
+// Must be kept in sync with TSTreeFootprint.RECORD_SIZE
+#define PACKED_TREE_FOOTPRINT_SIZE 6
+
+// node flags, must be kept in sync with TSTreeSnapshot and TSTreeCursor
+#define FLAG_NAMED 1
+#define FLAG_EXTRA 2
+#define FLAG_MISSING 4
+#define FLAG_ERROR 8
+#define FLAG_HAS_ERROR 16
+
 struct TreeCursorNode {
-  const char *type;
-  const char *name;
+  jstring type;
+  jstring name;
   uint32_t startByte;
   uint32_t endByte;
 };
@@ -37,6 +79,9 @@ struct TreeCursorNode {
   { VARIABLE = env->GetFieldID(CLASS, NAME, TYPE); }
 
 
+#define _loadMethod(VARIABLE, CLASS, NAME, SIGNATURE) \
+  { VARIABLE = env->GetMethodID(CLASS, NAME, SIGNATURE); }
+
 #define _loadStaticMethod(VARIABLE, CLASS, NAME, SIGNATURE) \
   {                                                   \
     VARIABLE = env->GetStaticMethodID(CLASS, NAME, SIGNATURE);                                                  \
@@ -48,20 +93,63 @@ void onUnload(JNIEnv *env);
 jobject _marshalNode(JNIEnv *env, TSNode node);
 TSNode _unmarshalNode(JNIEnv *env, jobject javaObject);
 
+void _packNode(std::vector<jint> &dest, TSNode node);
+
+/**
+ * Get the <code>FLAG_*</code> flags of the given node.
+ */
+jint _nodeFlags(TSNode node);
+jintArray _newIntArray(JNIEnv *env, const std::vector<jint> &values);
+
 jobject _marshalPoint(JNIEnv *env, TSPoint point);
 TSPoint _unmarshalPoint(JNIEnv *env, jobject javaObject);
 
 jobject _marshalRange(JNIEnv *env, TSRange range);
 TSRange _unmarshalRange(JNIEnv *env, jobject javaObject);
 jobjectArray createRangeArr(JNIEnv *env, jint size);
+void _packRange(std::vector<jint> &dest, TSRange range);
+
+/**
+ * Unpack the packed TSRange records in the given array into dest. Throws an
+ * IllegalArgumentException and returns false if the array is malformed.
+ */
+bool _unpackRanges(JNIEnv *env, jintArray ranges, std::vector<TSRange> &dest);
+
+/**
+ * Pack the given ranges into a new int[].
+ */
+jintArray _packRanges(JNIEnv *env, const TSRange *ranges, uint32_t count);
+
+/**
+ * Unpack the packed TSInputEdit records in the given array into dest. Throws an
+ * IllegalArgumentException and returns false if the array is malformed.
+ */
+bool _unpackEdits(JNIEnv *env, jintArray edits, std::vector<TSInputEdit> &dest);
+
+/**
+ * Apply the packed TSInputEdit records in the given array to the tree. Throws
+ * an IllegalArgumentException and returns false if the array is malformed.
+ */
+bool _applyPackedEdits(JNIEnv *env, TSTree *tree, jintArray edits);
+
+/**
+ * Compute the changed ranges between the edited old tree and the new tree, as
+ * packed TSRange records.
+ */
+jintArray _packChangedRanges(JNIEnv *env, const TSTree *old_tree,
+                             const TSTree *new_tree);
 
 jobject _marshalMatch(JNIEnv *env, TSQueryMatch match);
+jobject _marshalCaptureMatch(JNIEnv *env, TSQueryMatch match,
+                             uint32_t capture_index);
 jobject _marshalCapture(JNIEnv *env, TSQueryCapture capture);
 
 jobject _marshalTreeCursorNode(JNIEnv *env, TreeCursorNode node);
 
 TSInputEdit _unmarshalInputEdit(JNIEnv *env, jobject inputEdit);
 
+jint _readInput(JNIEnv *env, jobject reader, jint charOffset, jcharArray buffer);
+
 jobject
 _marshalQueryPredicateStep(JNIEnv *env, const TSQueryPredicateStep *predicate);
 jobjectArray createQueryPredicateStepArr(JNIEnv *env, jint size);
\ No newline at end of file
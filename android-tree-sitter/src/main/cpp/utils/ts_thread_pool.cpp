@@ -0,0 +1,155 @@
+/*
+ *  This file is part of android-tree-sitter.
+ *
+ *  android-tree-sitter library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  android-tree-sitter library is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *  along with android-tree-sitter.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include "ts_thread_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+TSThreadPool::TSThreadPool(uint32_t thread_count) : _stopped(false) {
+  thread_count = std::max(thread_count, 1u);
+  _threads.reserve(thread_count);
+  for (uint32_t i = 0; i < thread_count; ++i) {
+    _threads.emplace_back(&TSThreadPool::run, this);
+  }
+}
+
+TSThreadPool::~TSThreadPool() {
+  {
+    std::lock_guard<std::mutex> guard(_lock);
+    _stopped = true;
+  }
+  _available.notify_all();
+
+  for (auto &thread: _threads) {
+    thread.join();
+  }
+}
+
+TSThreadPool *TSThreadPool::shared() {
+  // intentionally leaked, the worker threads live as long as the process
+  static auto *pool = new TSThreadPool(std::thread::hardware_concurrency());
+  return pool;
+}
+
+void TSThreadPool::submit(std::function<void()> task) {
+  {
+    std::lock_guard<std::mutex> guard(_lock);
+    _tasks.push_back(std::move(task));
+  }
+  _available.notify_one();
+}
+
+uint32_t TSThreadPool::thread_count() const {
+  return (uint32_t) _threads.size();
+}
+
+void TSThreadPool::run() {
+  while (true) {
+    std::function<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(_lock);
+      _available.wait(lock, [this] { return _stopped || !_tasks.empty(); });
+      if (_stopped && _tasks.empty()) {
+        return;
+      }
+
+      task = std::move(_tasks.front());
+      _tasks.pop_front();
+    }
+
+    task();
+  }
+}
+
+/**
+ * State shared between the workers of a single ts_run_parallel call. The
+ * submitted workers keep it alive, as they may only be scheduled after the call
+ * has returned.
+ */
+struct ParallelRun {
+  std::atomic<uint32_t> next_job{0};
+  uint32_t count = 0;
+
+  std::mutex lock;
+  std::condition_variable done;
+
+  // the submitted workers which have not started yet, and the ones running
+  uint32_t unstarted_workers = 0;
+  uint32_t running_workers = 0;
+
+  // set when the call returns, the workers which start after this do nothing
+  bool closed = false;
+};
+
+void ts_run_parallel(uint32_t count,
+                     uint32_t max_workers,
+                     const TSParallelWorker &worker) {
+  if (count == 0) {
+    return;
+  }
+
+  auto *pool = TSThreadPool::shared();
+  uint32_t workers = std::min({count, std::max(max_workers, 1u),
+                               pool->thread_count() + 1});
+
+  auto run = std::make_shared<ParallelRun>();
+  run->count = count;
+  run->unstarted_workers = workers - 1;
+
+  ParallelRun *state = run.get();
+  TSNextJob next_job = [state] {
+    auto job = state->next_job.fetch_add(1, std::memory_order_relaxed);
+    return std::min(job, state->count);
+  };
+
+  for (uint32_t i = 1; i < workers; ++i) {
+    pool->submit([run, &worker, &next_job, i] {
+      {
+        std::lock_guard<std::mutex> guard(run->lock);
+        --run->unstarted_workers;
+        if (run->closed) {
+          // the worker and next_job no longer exist
+          return;
+        }
+        ++run->running_workers;
+      }
+
+      worker(i, next_job);
+
+      std::lock_guard<std::mutex> guard(run->lock);
+      --run->running_workers;
+      run->done.notify_all();
+    });
+  }
+
+  // the calling thread is one of the workers
+  worker(0, next_job);
+
+  // once all the jobs have been picked, only wait for the workers which are
+  // running them. Waiting for the workers which have not started would
+  // deadlock if this is called from the pool while all its threads are busy.
+  std::unique_lock<std::mutex> lock(run->lock);
+  run->done.wait(lock, [state, count] {
+    return state->running_workers == 0
+        && (state->unstarted_workers == 0
+            || state->next_job.load(std::memory_order_relaxed) >= count);
+  });
+  run->closed = true;
+}
@@ -0,0 +1,99 @@
+/*
+ *  This file is part of android-tree-sitter.
+ *
+ *  android-tree-sitter library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  android-tree-sitter library is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *  along with android-tree-sitter.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef ATS_TS_THREAD_POOL_H
+#define ATS_TS_THREAD_POOL_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * A fixed-size pool of native worker threads. The worker threads are not
+ * attached to the JVM, so the tasks must not call into JNI.
+ */
+class TSThreadPool {
+
+ public:
+  explicit TSThreadPool(uint32_t thread_count);
+
+  ~TSThreadPool();
+
+  TSThreadPool(const TSThreadPool &) = delete;
+
+  TSThreadPool &operator=(const TSThreadPool &) = delete;
+
+  /**
+   * Get the process-wide thread pool, which is sized to the number of
+   * available cores. The pool is created when this is called for the first
+   * time.
+   */
+  static TSThreadPool *shared();
+
+  /**
+   * Queue the given task to be run on one of the worker threads.
+   */
+  void submit(std::function<void()> task);
+
+  uint32_t thread_count() const;
+
+ private:
+  std::mutex _lock;
+  std::condition_variable _available;
+  std::deque<std::function<void()>> _tasks;
+  std::vector<std::thread> _threads;
+  bool _stopped;
+
+  void run();
+};
+
+/**
+ * Picks the next job of a ts_run_parallel call. Returns the index of the next
+ * job to run, or the number of jobs when all the jobs have been picked.
+ */
+typedef std::function<uint32_t()> TSNextJob;
+
+/**
+ * A worker of a ts_run_parallel call. The worker index is 0 for the worker
+ * which runs on the calling thread.
+ */
+typedef std::function<void(uint32_t worker_index, const TSNextJob &next_job)>
+    TSParallelWorker;
+
+/**
+ * Run <code>count</code> jobs on the shared thread pool, using at most
+ * <code>max_workers</code> workers, and wait for all the workers to complete.
+ * The calling thread runs one of the workers itself, so that the jobs make
+ * progress even if all the threads in the pool are busy.
+ *
+ * The workers pick the jobs with <code>next_job</code> until there are no jobs
+ * left, so that the jobs are balanced between the workers dynamically. Once
+ * all the jobs have been picked, this only waits for the workers which are
+ * running, the workers which have not started yet do not run. This can hence
+ * be called from a task of the shared pool, provided that the worker on the
+ * calling thread only returns when there are no jobs left.
+ */
+void ts_run_parallel(uint32_t count,
+                     uint32_t max_workers,
+                     const TSParallelWorker &worker);
+
+#endif //ATS_TS_THREAD_POOL_H
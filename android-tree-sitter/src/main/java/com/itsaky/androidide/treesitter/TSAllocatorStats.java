@@ -0,0 +1,91 @@
+/*
+ *  This file is part of android-tree-sitter.
+ *
+ *  android-tree-sitter library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  android-tree-sitter library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *  along with android-tree-sitter.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+package com.itsaky.androidide.treesitter;
+
+/**
+ * A snapshot of the stats of the pooled allocator, see {@link TreeSitter#getAllocatorStats()}.
+ *
+ * @author Akash Yadav
+ */
+public class TSAllocatorStats {
+
+  /**
+   * The number of values in a packed allocator stats record.
+   */
+  public static final int RECORD_SIZE = 5;
+
+  private static final int ALLOCATIONS = 0;
+  private static final int FREES = 1;
+  private static final int LARGE_ALLOCATIONS = 2;
+  private static final int ALLOCATED_BYTES = 3;
+  private static final int RESERVED_BYTES = 4;
+
+  private final long[] values;
+
+  protected TSAllocatorStats(long[] values) {
+    this.values = values;
+  }
+
+  /**
+   * The number of allocations, including the reallocations which moved the memory.
+   */
+  public long getAllocationCount() {
+    return values[ALLOCATIONS];
+  }
+
+  /**
+   * The number of blocks freed.
+   */
+  public long getFreeCount() {
+    return values[FREES];
+  }
+
+  /**
+   * The number of allocations which were too large for the pool and were served by the system
+   * allocator.
+   */
+  public long getLargeAllocationCount() {
+    return values[LARGE_ALLOCATIONS];
+  }
+
+  /**
+   * The number of bytes currently allocated, rounded up to the size classes. This is only accurate
+   * if the stats were enabled during the whole lifetime of the allocated objects.
+   */
+  public long getAllocatedBytes() {
+    return values[ALLOCATED_BYTES];
+  }
+
+  /**
+   * The number of bytes reserved from the system for the pool. The pool never shrinks.
+   */
+  public long getReservedBytes() {
+    return values[RESERVED_BYTES];
+  }
+
+  @Override
+  public String toString() {
+    return "TSAllocatorStats{" +
+      "allocations=" + getAllocationCount() +
+      ", frees=" + getFreeCount() +
+      ", largeAllocations=" + getLargeAllocationCount() +
+      ", allocatedBytes=" + getAllocatedBytes() +
+      ", reservedBytes=" + getReservedBytes() +
+      '}';
+  }
+}
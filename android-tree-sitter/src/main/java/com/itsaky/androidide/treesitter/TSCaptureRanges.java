@@ -0,0 +1,145 @@
+/*
+ *  This file is part of android-tree-sitter.
+ *
+ *  android-tree-sitter library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  android-tree-sitter library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *  along with android-tree-sitter.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+package com.itsaky.androidide.treesitter;
+
+import com.itsaky.androidide.treesitter.string.UTF16String;
+import java.util.Arrays;
+
+/**
+ * The byte ranges of the nodes captured by a query, grouped by capture, as returned by
+ * {@link TSQueryCursor#captureRanges(TSQuery, TSNode, UTF16String, int)}. The ranges are stored in
+ * a single flat <code>int[]</code>, and can be read without creating any objects.
+ *
+ * @author Akash Yadav
+ */
+public class TSCaptureRanges {
+
+  private final TSQuery query;
+
+  /**
+   * The index of the first range of each capture, followed by the end of the ranges, followed by
+   * the start and end bytes of the ranges.
+   */
+  private final int[] values;
+
+  protected TSCaptureRanges(TSQuery query, int[] values) {
+    this.query = query;
+    this.values = values;
+  }
+
+  /**
+   * Get the number of captures of the query. The capture indices are the same as
+   * {@link TSQuery#getCaptureNameForId(int)}.
+   */
+  public int getCaptureCount() {
+    return values[0] - 1;
+  }
+
+  /**
+   * Get the index of the capture with the given name.
+   *
+   * @param name The name of the capture, without the <code>@</code>.
+   * @return The index of the capture, or <code>-1</code> if the query has no such capture.
+   */
+  public int getCaptureIndex(String name) {
+    final var names = query.getCaptureNames();
+    for (int i = 0; i < names.length; i++) {
+      if (names[i].equals(name)) {
+        return i;
+      }
+    }
+    return -1;
+  }
+
+  /**
+   * Get the number of ranges of the given capture.
+   */
+  public int getRangeCount(int capture) {
+    checkCapture(capture);
+    return (values[capture + 1] - values[capture]) / 2;
+  }
+
+  /**
+   * Get the start byte of a range of the given capture.
+   *
+   * @param capture The index of the capture.
+   * @param index   The index of the range.
+   */
+  public int getStartByte(int capture, int index) {
+    return values[offsetOf(capture, index)];
+  }
+
+  /**
+   * Get the end byte of a range of the given capture.
+   *
+   * @param capture The index of the capture.
+   * @param index   The index of the range.
+   */
+  public int getEndByte(int capture, int index) {
+    return values[offsetOf(capture, index) + 1];
+  }
+
+  /**
+   * Get the ranges of the given capture, packed as the start and end bytes of each range.
+   *
+   * @param capture The index of the capture.
+   * @return A new array with the packed ranges.
+   */
+  public int[] getRanges(int capture) {
+    checkCapture(capture);
+    return Arrays.copyOfRange(values, values[capture], values[capture + 1]);
+  }
+
+  /**
+   * Get the ranges of the capture with the given name, see {@link #getRanges(int)}.
+   *
+   * @param name The name of the capture, without the <code>@</code>.
+   * @return A new array with the packed ranges, empty if the query has no such capture.
+   */
+  public int[] getRanges(String name) {
+    final var capture = getCaptureIndex(name);
+    return capture == -1 ? new int[0] : getRanges(capture);
+  }
+
+  private void checkCapture(int capture) {
+    if (capture < 0 || capture >= getCaptureCount()) {
+      throw new IndexOutOfBoundsException(
+        "capture: " + capture + ", capture count: " + getCaptureCount());
+    }
+  }
+
+  private int offsetOf(int capture, int index) {
+    if (index < 0 || index >= getRangeCount(capture)) {
+      throw new IndexOutOfBoundsException(
+        "index: " + index + ", range count: " + getRangeCount(capture));
+    }
+    return values[capture] + index * 2;
+  }
+
+  @Override
+  public String toString() {
+    final var sb = new StringBuilder("TSCaptureRanges{");
+    for (int i = 0; i < getCaptureCount(); i++) {
+      if (i > 0) {
+        sb.append(", ");
+      }
+      sb.append(query.getCaptureNames()[i]).append('=').append(getRangeCount(i));
+    }
+    return sb.append('}').toString();
+  }
+}
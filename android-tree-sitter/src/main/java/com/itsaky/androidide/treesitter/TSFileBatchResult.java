@@ -0,0 +1,73 @@
+/*
+ *  This file is part of android-tree-sitter.
+ *
+ *  android-tree-sitter library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  android-tree-sitter library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *  along with android-tree-sitter.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+package com.itsaky.androidide.treesitter;
+
+import java.io.File;
+import java.io.IOException;
+
+/**
+ * The result of {@link TSParserPool#parseFileBatch(File[], TSInputEncoding, long)} : the syntax
+ * tree of each file, and the error of each file which could not be read.
+ *
+ * @author Akash Yadav
+ */
+public class TSFileBatchResult {
+
+  protected final TSTree[] trees;
+  protected final IOException[] errors;
+  protected final int errorCount;
+
+  protected TSFileBatchResult(TSTree[] trees, IOException[] errors) {
+    this.trees = trees;
+    this.errors = errors;
+
+    int errorCount = 0;
+    for (final var error : errors) {
+      if (error != null) {
+        ++errorCount;
+      }
+    }
+    this.errorCount = errorCount;
+  }
+
+  /**
+   * Get the trees, in the same order as the files. An element is <code>null</code> if the
+   * corresponding file could not be read, see {@link #getError(int)}, or if its parse timed out.
+   * The caller owns the trees and must close them.
+   */
+  public TSTree[] getTrees() {
+    return trees;
+  }
+
+  /**
+   * Get the error of the file at the given index.
+   *
+   * @param index The index of the file.
+   * @return The error, or <code>null</code> if the file was read.
+   */
+  public IOException getError(int index) {
+    return errors[index];
+  }
+
+  /**
+   * Get the number of files which could not be read.
+   */
+  public int getErrorCount() {
+    return errorCount;
+  }
+}
@@ -0,0 +1,72 @@
+/*
+ *  This file is part of android-tree-sitter.
+ *
+ *  android-tree-sitter library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  android-tree-sitter library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *  along with android-tree-sitter.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+package com.itsaky.androidide.treesitter;
+
+import com.itsaky.androidide.treesitter.string.UTF16String;
+
+/**
+ * The result of {@link TSHighlighter#update(TSTree, UTF16String)} : the spans which were removed and the spans which were added since the previous update. Both
+ * are backed by the same flat <code>int[]</code>, filled by a single native call.
+ *
+ * @author Akash Yadav
+ */
+public class TSHighlightDiff {
+
+  protected final TSHighlightSpans removed;
+  protected final TSHighlightSpans added;
+
+  protected TSHighlightDiff(TSHighlightSpans removed, TSHighlightSpans added) {
+    this.removed = removed;
+    this.added = added;
+  }
+
+  /**
+   * Create a new {@link TSHighlightDiff} from the given packed diff : the number of removed spans,
+   * the number of added spans, followed by the removed and the added span records.
+   *
+   * @param records The packed diff.
+   * @return The diff.
+   */
+  public static TSHighlightDiff create(int[] records) {
+    final var removedCount = records[0];
+    final var addedCount = records[1];
+    return new TSHighlightDiff(new TSHighlightSpans(records, 2, removedCount),
+      new TSHighlightSpans(records, 2 + removedCount * TSHighlightSpans.RECORD_SIZE, addedCount));
+  }
+
+  /**
+   * Get the spans which were removed, in the coordinates of the new tree.
+   */
+  public TSHighlightSpans getRemoved() {
+    return removed;
+  }
+
+  /**
+   * Get the spans which were added.
+   */
+  public TSHighlightSpans getAdded() {
+    return added;
+  }
+
+  /**
+   * Whether the highlights did not change.
+   */
+  public boolean isEmpty() {
+    return removed.isEmpty() && added.isEmpty();
+  }
+}
@@ -0,0 +1,110 @@
+/*
+ *  This file is part of android-tree-sitter.
+ *
+ *  android-tree-sitter library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  android-tree-sitter library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *  along with android-tree-sitter.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+package com.itsaky.androidide.treesitter;
+
+/**
+ * A sorted list of highlighted spans, backed by a flat <code>int[]</code> filled by a single
+ * native call. Each span is a capture of the highlight query of a {@link TSHighlighter}, stored
+ * as a record of {@link #RECORD_SIZE} values : the start byte, the end byte, the capture id and
+ * the pattern index. The spans are sorted by their start byte, then by their end byte.
+ *
+ * @author Akash Yadav
+ */
+public class TSHighlightSpans {
+
+  /**
+   * The number of <code>int</code> values in a single span record.
+   */
+  public static final int RECORD_SIZE = 4;
+
+  private static final int OFFSET_START_BYTE = 0;
+  private static final int OFFSET_END_BYTE = 1;
+  private static final int OFFSET_CAPTURE_ID = 2;
+  private static final int OFFSET_PATTERN_INDEX = 3;
+
+  private final int[] records;
+  private final int offset;
+  private final int size;
+
+  protected TSHighlightSpans(int[] records, int offset, int size) {
+    this.records = records;
+    this.offset = offset;
+    this.size = size;
+  }
+
+  /**
+   * Create a new {@link TSHighlightSpans} from the given packed records.
+   *
+   * @param records The packed span records.
+   * @return The spans.
+   */
+  public static TSHighlightSpans create(int[] records) {
+    final var arr = records == null ? new int[0] : records;
+    return new TSHighlightSpans(arr, 0, arr.length / RECORD_SIZE);
+  }
+
+  /**
+   * Get the number of spans.
+   */
+  public int size() {
+    return size;
+  }
+
+  /**
+   * Whether there are no spans.
+   */
+  public boolean isEmpty() {
+    return size == 0;
+  }
+
+  /**
+   * Get the start byte of the span at the given index.
+   */
+  public int getStartByte(int index) {
+    return records[offsetOf(index) + OFFSET_START_BYTE];
+  }
+
+  /**
+   * Get the end byte of the span at the given index.
+   */
+  public int getEndByte(int index) {
+    return records[offsetOf(index) + OFFSET_END_BYTE];
+  }
+
+  /**
+   * Get the capture id of the span at the given index. The name of the capture can be retrieved
+   * with {@link TSQuery#getCaptureNameForId(int)}.
+   */
+  public int getCaptureId(int index) {
+    return records[offsetOf(index) + OFFSET_CAPTURE_ID];
+  }
+
+  /**
+   * Get the index of the pattern which captured the span at the given index.
+   */
+  public int getPatternIndex(int index) {
+    return records[offsetOf(index) + OFFSET_PATTERN_INDEX];
+  }
+
+  private int offsetOf(int index) {
+    if (index < 0 || index >= size) {
+      throw new IndexOutOfBoundsException("size=" + size + ", index=" + index);
+    }
+    return offset + index * RECORD_SIZE;
+  }
+}
@@ -0,0 +1,170 @@
+/*
+ *  This file is part of android-tree-sitter.
+ *
+ *  android-tree-sitter library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  android-tree-sitter library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *  along with android-tree-sitter.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+package com.itsaky.androidide.treesitter;
+
+import com.itsaky.androidide.treesitter.annotations.GenerateNativeHeaders;
+import com.itsaky.androidide.treesitter.string.UTF16String;
+import dalvik.annotation.optimization.FastNative;
+import java.util.Objects;
+
+/**
+ * An incremental highlighter, which keeps the highlighted spans of a syntax tree up to date as the
+ * tree is edited and reparsed. A span is a capture of the highlight query.
+ * <p>
+ * The highlighter holds the tree that was last highlighted. After each reparse, the captures are
+ * only executed natively inside the ranges whose syntactic structure changed and the ranges which
+ * were edited, each expanded to its enclosing node. The returned {@link TSHighlightDiff} contains
+ * the spans which were removed and added, so the cost of an update is proportional to the size of
+ * the edit instead of the size of the file :
+ * <pre>
+ *   // for each edit
+ *   tree.edit(edit);
+ *   highlighter.edit(edit);
+ *   try (final var newTree = parser.parseString(tree, source)) {
+ *     final var diff = highlighter.update(newTree, source);
+ *     // ...
+ *   }
+ * </pre>
+ * The standard text predicates of the query (<code>#eq?</code>, <code>#match?</code>,
+ * <code>#any-of?</code> and their variants) are evaluated natively. Custom predicates which are
+ * handled by {@link TSPredicateHandler} implementations are not evaluated by the highlighter.
+ * <p>
+ * Instances are not thread-safe.
+ *
+ * @author Akash Yadav
+ */
+public class TSHighlighter extends TSNativeObject {
+
+  protected final TSQuery query;
+
+  protected TSHighlighter(long pointer, TSQuery query) {
+    super(pointer);
+    this.query = query;
+  }
+
+  /**
+   * Create a new highlighter for the given query. The highlighter keeps a reference to the native
+   * query, so the query can be closed before the highlighter.
+   *
+   * @param query The highlight query.
+   * @return The highlighter.
+   */
+  public static TSHighlighter create(TSQuery query) {
+    Objects.requireNonNull(query, "query cannot be null");
+    if (!query.isValid()) {
+      throw new IllegalArgumentException("Cannot create a highlighter with an invalid query");
+    }
+
+    return new TSHighlighter(Native.newHighlighter(query.getNativeObject()), query);
+  }
+
+  /**
+   * Get the highlight query.
+   */
+  public TSQuery getQuery() {
+    return query;
+  }
+
+  /**
+   * Apply the given edit to the tree that was last highlighted, and shift the spans accordingly.
+   * This must be called with the same edits that are applied to the tree which is reparsed.
+   *
+   * @param edit The edit.
+   */
+  public void edit(TSInputEdit edit) {
+    Objects.requireNonNull(edit, "edit cannot be null");
+    final var records = new int[TSInputEdit.RECORD_SIZE];
+    edit.packInto(records, 0);
+    edit(records);
+  }
+
+  /**
+   * Same as {@link #edit(TSInputEdit)}, for the edits packed with {@link TSInputEdit#pack}.
+   *
+   * @param edits The packed edits.
+   */
+  public void edit(int[] edits) {
+    Objects.requireNonNull(edits, "edits cannot be null");
+    checkAccess();
+    Native.edit(getNativeObject(), edits);
+  }
+
+  /**
+   * Update the spans for the given tree. The tree must have been reparsed from the tree that was
+   * last highlighted, after applying the same edits with {@link #edit(TSInputEdit)}. On the first
+   * update, the whole tree is highlighted.
+   *
+   * @param tree   The new tree. The highlighter keeps a copy of the tree, so the tree can be closed
+   *               after this call.
+   * @param source The source of the tree, used to evaluate the text predicates of the query. If
+   *               <code>null</code>, the text predicates are not evaluated.
+   * @return The spans which were removed and added.
+   */
+  public TSHighlightDiff update(TSTree tree, UTF16String source) {
+    Objects.requireNonNull(tree, "tree cannot be null");
+    checkAccess();
+    tree.checkAccess();
+    if (source != null && !source.canAccess()) {
+      throw new IllegalArgumentException("Cannot highlight with an invalid source string");
+    }
+
+    try {
+      return TSHighlightDiff.create(Native.update(getNativeObject(), tree.getNativeObject(),
+        source == null ? 0 : source.getNativeObject()));
+    } finally {
+      tree.reachabilityFence();
+      if (source != null) {
+        source.reachabilityFence();
+      }
+    }
+  }
+
+  /**
+   * Get all the spans of the tree that was last highlighted.
+   *
+   * @return The spans, sorted by their start byte.
+   */
+  public TSHighlightSpans getSpans() {
+    checkAccess();
+    return TSHighlightSpans.create(Native.getSpans(getNativeObject()));
+  }
+
+  @Override
+  protected void closeNativeObj() {
+    Native.delete(getNativeObject());
+  }
+
+  @GenerateNativeHeaders(fileName = "highlighter")
+  private static class Native {
+
+    @FastNative
+    static native long newHighlighter(long query);
+
+    @FastNative
+    static native void delete(long highlighter);
+
+    @FastNative
+    static native void edit(long highlighter, int[] edits);
+
+    // not a @FastNative method as it executes the query, which may take a while
+    static native int[] update(long highlighter, long tree, long source);
+
+    @FastNative
+    static native int[] getSpans(long highlighter);
+  }
+}
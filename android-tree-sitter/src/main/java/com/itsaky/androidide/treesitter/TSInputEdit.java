@@ -18,6 +18,7 @@
 package com.itsaky.androidide.treesitter;
 
 import com.itsaky.androidide.treesitter.util.TSObjectFactoryProvider;
+import java.util.List;
 import java.util.Objects;
 
 /**
@@ -27,6 +28,13 @@ import java.util.Objects;
  */
 public class TSInputEdit {
 
+  /**
+   * The number of <code>int</code> values in a packed edit record : the start byte, the old end
+   * byte, the new end byte, followed by the row and column of the start point, the old end point
+   * and the new end point. See {@link #pack(List)}.
+   */
+  public static final int RECORD_SIZE = 9;
+
   protected int startByte;
   protected int oldEndByte;
   protected int newEndByte;
@@ -79,6 +87,53 @@ public class TSInputEdit {
       .createInputEdit(startByte, oldEndByte, newEndByte, startPoint, oldEndPoint, newEndPoint);
   }
 
+  /**
+   * Pack the given edits into a flat array of {@link #RECORD_SIZE} values per edit, which can be
+   * applied with a single native call using {@link TSTree#edit(int[])}.
+   *
+   * @param edits The edits to pack.
+   * @return The packed edits.
+   */
+  public static int[] pack(List<TSInputEdit> edits) {
+    final var records = new int[edits.size() * RECORD_SIZE];
+    for (int i = 0; i < edits.size(); i++) {
+      edits.get(i).packInto(records, i * RECORD_SIZE);
+    }
+    return records;
+  }
+
+  /**
+   * Create an edit from the packed record at the given offset in the given array.
+   *
+   * @param records The packed edit records.
+   * @param offset  The offset of the record in the array.
+   * @return The edit.
+   */
+  public static TSInputEdit unpack(int[] records, int offset) {
+    return create(records[offset], records[offset + 1], records[offset + 2],
+      TSPoint.create(records[offset + 3], records[offset + 4]),
+      TSPoint.create(records[offset + 5], records[offset + 6]),
+      TSPoint.create(records[offset + 7], records[offset + 8]));
+  }
+
+  /**
+   * Write this edit as a packed record to the given array.
+   *
+   * @param dest   The array to write the record to.
+   * @param offset The offset of the record in the array.
+   */
+  public void packInto(int[] dest, int offset) {
+    dest[offset] = startByte;
+    dest[offset + 1] = oldEndByte;
+    dest[offset + 2] = newEndByte;
+    dest[offset + 3] = startPoint.getRow();
+    dest[offset + 4] = startPoint.getColumn();
+    dest[offset + 5] = oldEndPoint.getRow();
+    dest[offset + 6] = oldEndPoint.getColumn();
+    dest[offset + 7] = newEndPoint.getRow();
+    dest[offset + 8] = newEndPoint.getColumn();
+  }
+
   @Override
   public boolean equals(Object o) {
     if (this == o) {
@@ -0,0 +1,50 @@
+/*
+ *  This file is part of android-tree-sitter.
+ *
+ *  android-tree-sitter library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  android-tree-sitter library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *  along with android-tree-sitter.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+package com.itsaky.androidide.treesitter;
+
+/**
+ * Provides the source code to a {@link TSParser} in chunks. This can be used to parse
+ * documents which are not stored as a single contiguous string (for example, ropes or piece
+ * tables) without flattening them first.
+ * <p>
+ * The parser calls {@link #read(int, char[])} repeatedly, requesting the text at the given
+ * offset. The offsets are not always sequential : the parser may jump back and forth when reusing
+ * the nodes of an old syntax tree.
+ *
+ * @author Akash Yadav
+ * @see TSParser#parseInput(TSTree, TSInputReader)
+ */
+public interface TSInputReader {
+
+  /**
+   * The default number of characters read by the parser in a single {@link #read(int, char[])}
+   * call.
+   */
+  int DEFAULT_CHUNK_SIZE = 16 * 1024;
+
+  /**
+   * Read the UTF-16 characters of the source code starting at the given character offset into the
+   * given buffer.
+   *
+   * @param charOffset The (char-based) offset to start reading from.
+   * @param buffer     The buffer to write the characters to. The buffer is reused between calls.
+   * @return The number of characters written to the buffer. Must be <code>0</code> if the offset is
+   * at or beyond the end of the source.
+   */
+  int read(int charOffset, char[] buffer);
+}
@@ -23,6 +23,7 @@ import com.itsaky.androidide.treesitter.util.TSObjectFactoryProvider;
 import dalvik.annotation.optimization.CriticalNative;
 import dalvik.annotation.optimization.FastNative;
 import java.nio.charset.StandardCharsets;
+import java.util.Objects;
 import java.util.concurrent.atomic.AtomicLong;
 import java.util.regex.Pattern;
 
@@ -43,6 +44,10 @@ public class TSLanguage extends TSNativeObject {
    */
   private final AtomicLong libHandle = new AtomicLong(0);
 
+  // the names of the symbols and fields, created on first use
+  private volatile String[] symbolNames;
+  private volatile String[] fieldNames;
+
   /**
    * Create a new {@link TSLanguage} instance with the given name and pointer.
    *
@@ -115,6 +120,45 @@ public class TSLanguage extends TSNativeObject {
     return Native.symName(getNativeObject(), symbol);
   }
 
+  /**
+   * Get the names of all the symbols in this language, indexed by symbol. The names are created
+   * once per language, so that the type of a node can be looked up from its symbol without creating
+   * a new string, for example when walking a tree with
+   * {@link TSTreeCursor#gotoNextPreOrder(int[])}.
+   *
+   * @return The names of the symbols. The returned array must not be modified.
+   */
+  public String[] getSymbolNames() {
+    var names = symbolNames;
+    if (names == null) {
+      names = new String[getSymbolCount()];
+      for (int i = 0; i < names.length; i++) {
+        names[i] = getSymbolName(i);
+      }
+      symbolNames = names;
+    }
+    return names;
+  }
+
+  /**
+   * Get the names of all the fields in this language, indexed by field id. The element at index
+   * <code>0</code> is <code>null</code>, as field ids start at <code>1</code>.
+   *
+   * @return The names of the fields. The returned array must not be modified.
+   * @see #getSymbolNames()
+   */
+  public String[] getFieldNames() {
+    var names = fieldNames;
+    if (names == null) {
+      names = new String[getFieldCount() + 1];
+      for (int i = 1; i < names.length; i++) {
+        names[i] = getFieldNameForId(i);
+      }
+      fieldNames = names;
+    }
+    return names;
+  }
+
   public int getSymbolForTypeString(String name, boolean isNamed) {
     checkAccess();
     final var bytes = name.getBytes(StandardCharsets.UTF_8);
@@ -172,6 +216,10 @@ public class TSLanguage extends TSNativeObject {
   @Override
   public void close() {
     if (isExternal()) {
+      // the language pointer may be reused once the library is closed
+      TSQuery.evictCachedQueries(this);
+
+      // the interned names are released when the last reference to the library is released
       Native.dlclose(getLibHandle());
       setLibHandle(0);
 
@@ -182,6 +230,18 @@ public class TSLanguage extends TSNativeObject {
     super.close();
   }
 
+  /**
+   * Create the native tables of the symbol and field names of this language. Once created, the
+   * native getters which return the name of a symbol or a field (e.g. {@link TSNode#getType()})
+   * return the same {@link String} instance on every call instead of creating a new one. This is
+   * done when the language is added to {@link TSLanguageCache}.
+   */
+  void internNames() {
+    if (canAccess()) {
+      Native.internNames(getNativeObject());
+    }
+  }
+
   @Override
   protected void closeNativeObj() {
     // no-op
@@ -219,6 +279,11 @@ public class TSLanguage extends TSNativeObject {
    * The native library is opened using <code>dlopen</code>. The {@link TSLanguage} instances
    * created with this method must be closed with {@link TSLanguage#close()}. This makes sure that
    * the underlying native library handle is closed as well.
+   * <p>
+   * Each library is opened only once per path, and is reference counted : each language loaded
+   * from it holds a reference, and the library is closed when the last one is closed. If the
+   * library is being preloaded (see {@link #preload(String[], String[])}), this waits for the
+   * preload to complete.
    *
    * @param libraryPath The absolute path to the shared library.
    * @param lang        The name of the language, without {@code tree-sitter-} prefix (e.g. 'java',
@@ -245,6 +310,77 @@ public class TSLanguage extends TSNativeObject {
     return language;
   }
 
+  /**
+   * Start loading the given languages on a background thread, so that the first call to
+   * {@link #loadLanguage(Context, String)} for each of them does not wait for the grammar's shared
+   * library to be loaded. This returns immediately. A language which is being preloaded when it is
+   * loaded waits for the preload to complete instead of loading the library again.
+   * <p>
+   * The preloaded libraries stay open until {@link #releasePreloaded()} is called.
+   *
+   * @param context The context used to retrive the
+   *                {@link android.content.pm.ApplicationInfo#nativeLibraryDir nativeLibraryDir}.
+   * @param langs   The names of the languages, without <code>tree-sitter-</code> prefix.
+   * @see #preload(String[], String[])
+   */
+  public static void preload(Context context, String... langs) {
+    final var libraryPaths = new String[langs.length];
+    for (int i = 0; i < langs.length; i++) {
+      libraryPaths[i] =
+        context.getApplicationInfo().nativeLibraryDir + "/libtree-sitter-" + langs[i] + ".so";
+    }
+    preload(libraryPaths, langs);
+  }
+
+  /**
+   * Start loading the given languages on a background thread. See
+   * {@link #preload(Context, String...)} for more details.
+   *
+   * @param libraryPaths The absolute paths to the shared libraries.
+   * @param langs        The names of the languages, without {@code tree-sitter-} prefix. The
+   *                     language at index <code>i</code> is loaded from the library at index
+   *                     <code>i</code>.
+   * @throws IllegalArgumentException If a language name is invalid, or if the arrays are not of
+   *                                  the same length.
+   */
+  public static void preload(String[] libraryPaths, String[] langs) {
+    Objects.requireNonNull(libraryPaths, "libraryPaths cannot be null");
+    Objects.requireNonNull(langs, "langs cannot be null");
+    if (libraryPaths.length != langs.length) {
+      throw new IllegalArgumentException("There must be exactly one library path per language");
+    }
+
+    final var funcs = new String[langs.length];
+    for (int i = 0; i < langs.length; i++) {
+      validateLangName(langs[i]);
+      funcs[i] = "tree_sitter_" + langs[i];
+    }
+
+    Native.preload(libraryPaths, funcs);
+  }
+
+  /**
+   * Release the references held to the libraries preloaded with {@link #preload(String[],
+   * String[])}. The libraries whose languages are still open stay loaded until the languages are
+   * closed.
+   */
+  public static void releasePreloaded() {
+    Native.releasePreloaded();
+  }
+
+  /**
+   * Get the number of references to the shared library of this language. Each language loaded
+   * with {@link #loadLanguage(String, String)} holds a reference, and so does a preload. The
+   * library is closed when the last reference is released.
+   *
+   * @return The number of references, or <code>0</code> if this language is not external or has
+   * been closed.
+   */
+  public int getLibRefCount() {
+    final var handle = getLibHandle();
+    return handle == 0 ? 0 : Native.libRefCount(handle);
+  }
+
   private static void validateLangName(String lang) {
     final var matcher = LANG_NAME.matcher(lang);
     if (!matcher.matches()) {
@@ -279,10 +415,10 @@ public class TSLanguage extends TSNativeObject {
     @FastNative
     static native int langVer(long ptr);
 
-    @FastNative
+    // not a @FastNative method as it opens the library, or waits for it to be preloaded
     static native long[] loadLanguage(String sharedLib, String func);
 
-    @FastNative
+    // not a @FastNative method as it may close the library
     static native void dlclose(long libhandle);
 
     @FastNative
@@ -290,5 +426,17 @@ public class TSLanguage extends TSNativeObject {
 
     @FastNative
     public static native short nextState(long pointer, short stateId, short symbol);
+
+    // not a @FastNative method as it creates a string for each symbol and field
+    static native void internNames(long pointer);
+
+    @FastNative
+    static native void preload(String[] sharedLibs, String[] funcs);
+
+    // not a @FastNative method as it may close libraries
+    static native void releasePreloaded();
+
+    @FastNative
+    static native int libRefCount(long libhandle);
   }
 }
@@ -36,7 +36,8 @@ public final class TSLanguageCache {
   }
 
   /**
-   * Caches the given {@link TSLanguage}.
+   * Caches the given {@link TSLanguage}. The names of the symbols and fields of the language are
+   * interned so that the getters for node types and field names do not create new strings.
    *
    * @param name     The name of the language. This can be later used to retrieve the language
    *                 instance using {@link TSLanguageCache#get(String)}.
@@ -45,6 +46,7 @@ public final class TSLanguageCache {
   public static void cache(String name, TSLanguage language) {
     languagesByName.computeIfAbsent(name, key -> language);
     languagesByPtr.put(language.getNativeObject(), language);
+    language.internNames();
   }
 
   /**
@@ -79,6 +81,8 @@ public final class TSLanguageCache {
    * Calls {@link TSLanguage#close()} on each cached language that is externally loaded. This makes
    * sure that any language that may have been opened with
    * {@link TSLanguage#loadLanguage(String, String)} closes the associated native library handle.
+   * The references held to the preloaded libraries (see
+   * {@link TSLanguage#preload(String[], String[])}) are released as well.
    */
   public static void closeExternal() {
     final var toRemove = new HashSet<Pair<String, Long>>();
@@ -95,6 +99,8 @@ public final class TSLanguageCache {
       //noinspection resource
       languagesByPtr.remove(lang.second);
     }
+
+    TSLanguage.releasePreloaded();
   }
 
   /**
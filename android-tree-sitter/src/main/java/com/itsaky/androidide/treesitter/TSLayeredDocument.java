@@ -0,0 +1,280 @@
+/*
+ *  This file is part of android-tree-sitter.
+ *
+ *  android-tree-sitter library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  android-tree-sitter library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *  along with android-tree-sitter.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+package com.itsaky.androidide.treesitter;
+
+import com.itsaky.androidide.treesitter.annotations.GenerateNativeHeaders;
+import com.itsaky.androidide.treesitter.string.UTF16String;
+import dalvik.annotation.optimization.FastNative;
+import java.util.HashMap;
+import java.util.Map;
+import java.util.Objects;
+
+/**
+ * A document written in a host language, with other languages injected in it (for example, the
+ * code in the string templates of a Kotlin file, or the scripts embedded in an XML file). The
+ * document holds the syntax tree of the host language and one layer for each injected language,
+ * all parsed natively :
+ * <pre>
+ *   final var document = TSLayeredDocument.create(TSLanguageXml.getInstance(), injections);
+ *   document.addLanguage("java", TSLanguageJava.getInstance());
+ *   document.parse(source);
+ *
+ *   // after each edit of the source
+ *   document.edit(edit);
+ *   document.parse(source);
+ *   for (int i = 0; i < document.getLayerCount(); i++) {
+ *     if (document.isLayerReparsed(i)) {
+ *       try (final var tree = document.getLayerTree(i)) {
+ *         // ...
+ *       }
+ *     }
+ *   }
+ * </pre>
+ * Each parse reparses the host tree incrementally, runs the injection query on it and groups the
+ * injected ranges by language. Only the layers whose ranges changed or were edited are parsed
+ * again, in parallel, each with the ranges of its language set as the included ranges of the
+ * parser. The parsers of each language are reused between the parses.
+ * <p>
+ * The injection query follows the conventions of the tree-sitter injection queries : the
+ * <code>@injection.content</code> capture (or <code>@content</code>) is the injected node, and
+ * the language is either the text of the <code>@injection.language</code> capture (or
+ * <code>@language</code>), or set with <code>(#set! injection.language "name")</code>. All the
+ * injected ranges of a language are parsed as a single layer. The standard text predicates of the
+ * query are evaluated natively, custom predicates are not. Injections nested in the layers are not
+ * processed.
+ * <p>
+ * Instances are not thread-safe.
+ *
+ * @author Akash Yadav
+ */
+public class TSLayeredDocument extends TSNativeObject {
+
+  protected final TSLanguage language;
+  protected final TSQuery injections;
+  protected final Map<String, TSLanguage> languages = new HashMap<>();
+
+  protected TSLayeredDocument(long pointer, TSLanguage language, TSQuery injections) {
+    super(pointer);
+    this.language = language;
+    this.injections = injections;
+  }
+
+  /**
+   * Create a new layered document.
+   *
+   * @param language   The host language of the document.
+   * @param injections The injection query, in the host language. The document keeps a reference
+   *                   to the native query, so the query can be closed before the document.
+   * @return The document.
+   */
+  public static TSLayeredDocument create(TSLanguage language, TSQuery injections) {
+    Objects.requireNonNull(language, "language cannot be null");
+    Objects.requireNonNull(injections, "injections cannot be null");
+    if (!injections.isValid()) {
+      throw new IllegalArgumentException("Invalid injection query");
+    }
+
+    language.checkAccess();
+    return new TSLayeredDocument(
+      Native.newDocument(language.getNativeObject(), injections.getNativeObject()), language,
+      injections);
+  }
+
+  /**
+   * Get the host language of this document.
+   */
+  public TSLanguage getLanguage() {
+    return language;
+  }
+
+  /**
+   * Get the injection query.
+   */
+  public TSQuery getInjections() {
+    return injections;
+  }
+
+  /**
+   * Register a language which can be injected in this document. The injections of the languages
+   * which are not registered are ignored. Registering a language with the same name as a
+   * registered language replaces it, and its layer is parsed again on the next parse.
+   *
+   * @param name     The name of the language, as it is named by the injection query.
+   * @param language The language.
+   */
+  public void addLanguage(String name, TSLanguage language) {
+    Objects.requireNonNull(name, "name cannot be null");
+    Objects.requireNonNull(language, "language cannot be null");
+    checkAccess();
+    language.checkAccess();
+    Native.addLanguage(getNativeObject(), name, language.getNativeObject());
+    languages.put(name, language);
+  }
+
+  /**
+   * Apply the given edit to the syntax trees of this document. This must be called for each edit
+   * of the source, before the next call to {@link #parse(UTF16String)}.
+   *
+   * @param edit The edit.
+   */
+  public void edit(TSInputEdit edit) {
+    Objects.requireNonNull(edit, "edit cannot be null");
+    final var records = new int[TSInputEdit.RECORD_SIZE];
+    edit.packInto(records, 0);
+    edit(records);
+  }
+
+  /**
+   * Same as {@link #edit(TSInputEdit)}, for the edits packed with {@link TSInputEdit#pack}.
+   *
+   * @param edits The packed edits.
+   */
+  public void edit(int[] edits) {
+    Objects.requireNonNull(edits, "edits cannot be null");
+    checkAccess();
+    Native.edit(getNativeObject(), edits);
+  }
+
+  /**
+   * Parse the given source, which must be the source of the previous parse with the edits applied.
+   *
+   * @param source The source of the document.
+   * @return Whether the host tree was parsed. The layers which cannot be parsed do not have a
+   * tree.
+   */
+  public boolean parse(UTF16String source) {
+    Objects.requireNonNull(source, "source cannot be null");
+    checkAccess();
+    if (!source.canAccess()) {
+      throw new IllegalArgumentException("Cannot parse an invalid source string");
+    }
+
+    try {
+      return Native.parse(getNativeObject(), source.getNativeObject());
+    } finally {
+      source.reachabilityFence();
+    }
+  }
+
+  /**
+   * Get the syntax tree of the host language.
+   *
+   * @return A copy of the tree, which must be closed by the caller, or <code>null</code> if the
+   * document has not been parsed.
+   */
+  public TSTree getTree() {
+    checkAccess();
+    final var pointer = Native.getTree(getNativeObject());
+    return pointer == 0 ? null : TSTree.create(pointer);
+  }
+
+  /**
+   * Get the number of layers, i.e. the number of languages injected in this document. The layers
+   * are sorted by the name of their language.
+   */
+  public int getLayerCount() {
+    checkAccess();
+    return Native.getLayerCount(getNativeObject());
+  }
+
+  /**
+   * Get the name of the language of the layer at the given index.
+   */
+  public String getLayerLanguageName(int index) {
+    checkAccess();
+    return Native.getLayerName(getNativeObject(), index);
+  }
+
+  /**
+   * Get the language of the layer at the given index.
+   */
+  public TSLanguage getLayerLanguage(int index) {
+    return languages.get(getLayerLanguageName(index));
+  }
+
+  /**
+   * Get the syntax tree of the layer at the given index.
+   *
+   * @return A copy of the tree, which must be closed by the caller, or <code>null</code> if the
+   * layer could not be parsed.
+   */
+  public TSTree getLayerTree(int index) {
+    checkAccess();
+    final var pointer = Native.getLayerTree(getNativeObject(), index);
+    return pointer == 0 ? null : TSTree.create(pointer);
+  }
+
+  /**
+   * Get the ranges of the layer at the given index, sorted and without overlaps.
+   */
+  public TSRangeList getLayerRanges(int index) {
+    checkAccess();
+    return TSRangeList.create(Native.getLayerRanges(getNativeObject(), index));
+  }
+
+  /**
+   * Whether the layer at the given index was parsed by the last call to
+   * {@link #parse(UTF16String)}.
+   */
+  public boolean isLayerReparsed(int index) {
+    checkAccess();
+    return Native.isLayerReparsed(getNativeObject(), index);
+  }
+
+  @Override
+  protected void closeNativeObj() {
+    Native.delete(getNativeObject());
+  }
+
+  @GenerateNativeHeaders(fileName = "layered_document")
+  private static class Native {
+
+    @FastNative
+    static native long newDocument(long language, long injections);
+
+    @FastNative
+    static native void delete(long document);
+
+    @FastNative
+    static native void addLanguage(long document, String name, long language);
+
+    @FastNative
+    static native void edit(long document, int[] edits);
+
+    // not a @FastNative method as it parses the document
+    static native boolean parse(long document, long source);
+
+    @FastNative
+    static native long getTree(long document);
+
+    @FastNative
+    static native int getLayerCount(long document);
+
+    @FastNative
+    static native String getLayerName(long document, int index);
+
+    @FastNative
+    static native long getLayerTree(long document, int index);
+
+    @FastNative
+    static native int[] getLayerRanges(long document, int index);
+
+    @FastNative
+    static native boolean isLayerReparsed(long document, int index);
+  }
+}
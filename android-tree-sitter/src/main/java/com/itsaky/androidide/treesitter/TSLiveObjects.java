@@ -0,0 +1,125 @@
+/*
+ *  This file is part of android-tree-sitter.
+ *
+ *  android-tree-sitter library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  android-tree-sitter library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *  along with android-tree-sitter.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+package com.itsaky.androidide.treesitter;
+
+import java.util.HashMap;
+import java.util.Map;
+import java.util.concurrent.ConcurrentHashMap;
+import java.util.concurrent.atomic.LongAdder;
+
+/**
+ * Process-wide counts of the live native objects (trees, parsers, cursors, queries, strings,
+ * etc.), by class. An object is live from the moment its native object is set until it is closed.
+ * Nodes are not counted as they do not own any native memory. This can be used to cap the
+ * native memory under load, along with {@link TSTree#getFootprint()}. The objects released by
+ * {@link TSResourceCleaner} without being closed are counted as leaked.
+ *
+ * @author Akash Yadav
+ */
+public final class TSLiveObjects {
+
+  private static final Map<Class<?>, LongAdder> counts = new ConcurrentHashMap<>();
+  private static final Map<Class<?>, LongAdder> leaks = new ConcurrentHashMap<>();
+
+  private TSLiveObjects() {
+    throw new UnsupportedOperationException();
+  }
+
+  static void update(Class<?> type, int delta) {
+    add(counts, type, delta);
+  }
+
+  static void leaked(Class<?> type, boolean tracked) {
+    if (tracked) {
+      add(counts, type, -1);
+    }
+    add(leaks, type, 1);
+  }
+
+  private static void add(Map<Class<?>, LongAdder> map, Class<?> type, int delta) {
+    var count = map.get(type);
+    if (count == null) {
+      count = map.computeIfAbsent(type, key -> new LongAdder());
+    }
+    count.add(delta);
+  }
+
+  /**
+   * Get the number of live objects of the given type, including its subclasses.
+   *
+   * @param type The type of the objects to count, e.g. {@link TSTree}.
+   * @return The number of live objects.
+   */
+  public static long getLiveCount(Class<? extends TSNativeObject> type) {
+    return sum(counts, type);
+  }
+
+  /**
+   * Get a snapshot of the number of live objects of each class. The classes which have no live
+   * objects are omitted.
+   *
+   * @return The counts, by the exact class of the objects.
+   */
+  public static Map<Class<? extends TSNativeObject>, Long> getLiveCounts() {
+    return snapshot(counts);
+  }
+
+  /**
+   * Get the number of objects of the given type, including its subclasses, which were released by
+   * {@link TSResourceCleaner} after becoming unreachable without being closed.
+   *
+   * @param type The type of the objects to count, e.g. {@link TSTreeCursor}.
+   * @return The number of leaked objects.
+   */
+  public static long getLeakedCount(Class<? extends TSNativeObject> type) {
+    return sum(leaks, type);
+  }
+
+  /**
+   * Get a snapshot of the number of leaked objects of each class, see
+   * {@link #getLeakedCount(Class)}. The classes which have no leaked objects are omitted.
+   *
+   * @return The counts, by the exact class of the objects.
+   */
+  public static Map<Class<? extends TSNativeObject>, Long> getLeakedCounts() {
+    return snapshot(leaks);
+  }
+
+  private static long sum(Map<Class<?>, LongAdder> map, Class<? extends TSNativeObject> type) {
+    long total = 0;
+    for (final var entry : map.entrySet()) {
+      if (type.isAssignableFrom(entry.getKey())) {
+        total += entry.getValue().sum();
+      }
+    }
+    return total;
+  }
+
+  @SuppressWarnings("unchecked")
+  private static Map<Class<? extends TSNativeObject>, Long> snapshot(
+    Map<Class<?>, LongAdder> map) {
+    final var result = new HashMap<Class<? extends TSNativeObject>, Long>();
+    map.forEach((type, count) -> {
+      final var sum = count.sum();
+      if (sum != 0) {
+        result.put((Class<? extends TSNativeObject>) type, sum);
+      }
+    });
+    return result;
+  }
+}
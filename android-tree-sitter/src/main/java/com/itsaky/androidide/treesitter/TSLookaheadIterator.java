@@ -59,6 +59,55 @@ public class TSLookaheadIterator extends TSNativeObject {
     return iterator;
   }
 
+  /**
+   * Get the parse state in which a token starting at the given byte offset would be lexed. This is
+   * the state after the last token which ends at or before the offset, ignoring the extras (e.g.
+   * comments). If the offset is inside a token, this is the state before that token.
+   *
+   * @param tree       The tree.
+   * @param byteOffset The byte offset in the source of the tree.
+   * @return The parse state, to be used with {@link #create(TSLanguage, short)}.
+   */
+  public static short getParseStateAt(TSTree tree, int byteOffset) {
+    tree.checkAccess();
+    checkByteOffset(byteOffset);
+    try {
+      return Native.parseStateAt(tree.getNativeObject(), byteOffset);
+    } finally {
+      tree.reachabilityFence();
+    }
+  }
+
+  /**
+   * Get all the symbols which are valid for a token starting at the given byte offset, in the parse
+   * state returned by {@link #getParseStateAt(TSTree, int)}. This is the same as iterating over a
+   * lookahead iterator created for that state, in a single native call. To complete a partially
+   * typed word, pass the offset of the start of the word.
+   * <p>
+   * The names of the symbols can be resolved with {@link TSLanguage#getSymbolNames()}. The
+   * returned symbols include the hidden and auxiliary symbols, which are usually filtered out with
+   * {@link TSLanguage#getSymbolType(int)}.
+   *
+   * @param tree       The tree.
+   * @param byteOffset The byte offset in the source of the tree.
+   * @return The valid symbols, empty if there is no valid parse state at the offset.
+   */
+  public static short[] getValidSymbolsAt(TSTree tree, int byteOffset) {
+    tree.checkAccess();
+    checkByteOffset(byteOffset);
+    try {
+      return Native.symbolsAt(tree.getNativeObject(), byteOffset);
+    } finally {
+      tree.reachabilityFence();
+    }
+  }
+
+  private static void checkByteOffset(int byteOffset) {
+    if (byteOffset < 0) {
+      throw new IllegalArgumentException("byteOffset must not be negative: " + byteOffset);
+    }
+  }
+
   /**
    * Creates a new {@link TSLookaheadIterator} instance with the given pointer.
    *
@@ -77,7 +126,11 @@ public class TSLookaheadIterator extends TSNativeObject {
    */
   public boolean next() {
     checkAccess();
-    return Native.next(getNativeObject());
+    try {
+      return Native.next(getNativeObject());
+    } finally {
+      reachabilityFence();
+    }
   }
 
   /**
@@ -85,7 +138,11 @@ public class TSLookaheadIterator extends TSNativeObject {
    */
   public short getCurrentSymbol() {
     checkAccess();
-    return Native.currentSymbol(getNativeObject());
+    try {
+      return Native.currentSymbol(getNativeObject());
+    } finally {
+      reachabilityFence();
+    }
   }
 
   /**
@@ -93,7 +150,11 @@ public class TSLookaheadIterator extends TSNativeObject {
    */
   public String getCurrentSymbolName() {
     checkAccess();
-    return Native.currentSymbolName(getNativeObject());
+    try {
+      return Native.currentSymbolName(getNativeObject());
+    } finally {
+      reachabilityFence();
+    }
   }
 
   /**
@@ -103,7 +164,11 @@ public class TSLookaheadIterator extends TSNativeObject {
    */
   public boolean resetState(short stateId) {
     checkAccess();
-    return Native.resetState(getNativeObject(), stateId);
+    try {
+      return Native.resetState(getNativeObject(), stateId);
+    } finally {
+      reachabilityFence();
+    }
   }
 
   /**
@@ -114,7 +179,13 @@ public class TSLookaheadIterator extends TSNativeObject {
   public boolean reset(TSLanguage language, short stateId) {
     checkAccess();
     language.checkAccess();
-    final var reset = Native.reset(getNativeObject(), language.getNativeObject(), stateId);
+    final boolean reset;
+    try {
+      reset = Native.reset(getNativeObject(), language.getNativeObject(), stateId);
+    } finally {
+      reachabilityFence();
+    }
+
     if (reset) {
       langName = language.getName();
     }
@@ -134,6 +205,11 @@ public class TSLookaheadIterator extends TSNativeObject {
     Native.delete(getNativeObject());
   }
 
+  @Override
+  protected NativeDeleter getNativeDeleter() {
+    return Native::delete;
+  }
+
   @GenerateNativeHeaders(fileName = "lookahead_iterator")
   private static final class Native {
 
@@ -160,5 +236,11 @@ public class TSLookaheadIterator extends TSNativeObject {
 
     @FastNative
     static native long language(long pointer);
+
+    @FastNative
+    static native short parseStateAt(long tree, int byteOffset);
+
+    @FastNative
+    static native short[] symbolsAt(long tree, int byteOffset);
   }
 }
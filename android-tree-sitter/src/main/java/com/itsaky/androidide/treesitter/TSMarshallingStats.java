@@ -0,0 +1,99 @@
+/*
+ *  This file is part of android-tree-sitter.
+ *
+ *  android-tree-sitter library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  android-tree-sitter library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *  along with android-tree-sitter.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+package com.itsaky.androidide.treesitter;
+
+/**
+ * A snapshot of the objects created through the native object factory, see
+ * {@link TSStats#getMarshallingStats()}.
+ *
+ * @author Akash Yadav
+ */
+public class TSMarshallingStats {
+
+  /**
+   * The number of values in a packed marshalling stats record.
+   */
+  public static final int RECORD_SIZE = 6;
+
+  private static final int NODES = 0;
+  private static final int POINTS = 1;
+  private static final int RANGES = 2;
+  private static final int MATCHES = 3;
+  private static final int CAPTURES = 4;
+  private static final int TREE_CURSOR_NODES = 5;
+
+  private final long[] values;
+
+  protected TSMarshallingStats(long[] values) {
+    this.values = values;
+  }
+
+  /**
+   * The number of {@link TSNode} objects created.
+   */
+  public long getNodeCount() {
+    return values[NODES];
+  }
+
+  /**
+   * The number of {@link TSPoint} objects created.
+   */
+  public long getPointCount() {
+    return values[POINTS];
+  }
+
+  /**
+   * The number of {@link TSRange} objects created.
+   */
+  public long getRangeCount() {
+    return values[RANGES];
+  }
+
+  /**
+   * The number of {@link TSQueryMatch} objects created.
+   */
+  public long getMatchCount() {
+    return values[MATCHES];
+  }
+
+  /**
+   * The number of {@link TSQueryCapture} objects created.
+   */
+  public long getCaptureCount() {
+    return values[CAPTURES];
+  }
+
+  /**
+   * The number of {@link TSTreeCursorNode} objects created.
+   */
+  public long getTreeCursorNodeCount() {
+    return values[TREE_CURSOR_NODES];
+  }
+
+  @Override
+  public String toString() {
+    return "TSMarshallingStats{" +
+      "nodes=" + getNodeCount() +
+      ", points=" + getPointCount() +
+      ", ranges=" + getRangeCount() +
+      ", matches=" + getMatchCount() +
+      ", captures=" + getCaptureCount() +
+      ", treeCursorNodes=" + getTreeCursorNodeCount() +
+      '}';
+  }
+}
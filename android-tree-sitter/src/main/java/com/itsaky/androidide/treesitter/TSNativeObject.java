@@ -28,6 +28,10 @@ import java.util.function.Supplier;
 public abstract class TSNativeObject implements TSClosable {
 
   protected final AtomicLong pointer = new AtomicLong(0);
+  private TSResourceCleaner.Cleanable cleanable;
+  private boolean borrowed;
+  private TSNativeObject owner;
+  private volatile boolean reachable;
 
   /**
    * Creates a new {@link TSNativeObject} instance with the given pointer.
@@ -49,7 +53,87 @@ public abstract class TSNativeObject implements TSClosable {
   }
 
   protected void setNativeObject(long pointer) {
-    this.pointer.set(pointer);
+    final var old = this.pointer.getAndSet(pointer);
+    if ((old == 0) == (pointer == 0)) {
+      return;
+    }
+
+    if (isTracked() && !borrowed) {
+      TSLiveObjects.update(getClass(), pointer != 0 ? 1 : -1);
+    }
+
+    if (pointer != 0) {
+      final var deleter = TSResourceCleaner.isEnabled() && !borrowed ? getNativeDeleter() : null;
+      if (deleter != null) {
+        cleanable = TSResourceCleaner.register(this, pointer, deleter);
+      }
+    } else if (cleanable != null) {
+      TSResourceCleaner.unregister(cleanable);
+      cleanable = null;
+    }
+  }
+
+  /**
+   * Get the function which releases the native object of this object without accessing this
+   * object, used by {@link TSResourceCleaner} once this object is unreachable. This is only used
+   * for the objects which own their native object, see {@link #markBorrowed(TSNativeObject)}.
+   *
+   * @return The deleter, <code>null</code> by default.
+   */
+  protected NativeDeleter getNativeDeleter() {
+    return null;
+  }
+
+  /**
+   * Mark this object as a view of a native object which is owned by another Java object. A view is
+   * not counted by {@link TSLiveObjects}, and its native object is not released when the view
+   * becomes unreachable. Closing the view closes its owner, if it is known, and only detaches the
+   * view otherwise. This must be called as soon as the view is created.
+   *
+   * @param owner The owner of the native object, kept reachable by this view. This may be
+   *              <code>null</code> if the owner is not known, in which case the owner must be kept
+   *              reachable while the view is used.
+   */
+  protected final void markBorrowed(TSNativeObject owner) {
+    if (borrowed) {
+      return;
+    }
+
+    this.borrowed = true;
+    this.owner = owner;
+    if (getNativeObject() != 0 && isTracked()) {
+      TSLiveObjects.update(getClass(), -1);
+    }
+
+    if (cleanable != null) {
+      TSResourceCleaner.unregister(cleanable);
+      cleanable = null;
+    }
+  }
+
+  /**
+   * Keep this object strongly reachable until this method is called, like
+   * <code>Reference.reachabilityFence(this)</code> which is not available before API 28.
+   * <p>
+   * The native methods only receive the pointer of this object, so this object may become
+   * unreachable while a native method is still using the pointer. If this object has a
+   * {@link #getNativeDeleter() deleter}, {@link TSResourceCleaner} would then release the native
+   * object during the call. Such subclasses must call this after each native call which uses the
+   * pointer, in a <code>finally</code> block.
+   */
+  protected final void reachabilityFence() {
+    // a volatile write to this object cannot be elided, nor moved before the native call
+    reachable = true;
+  }
+
+  /**
+   * Whether this object is counted by {@link TSLiveObjects} while its native object is set. This
+   * must return the same value for all the instances of a class.
+   *
+   * @return <code>true</code> by default.
+   */
+  protected boolean isTracked() {
+    return true;
   }
 
   /**
@@ -85,6 +169,15 @@ public abstract class TSNativeObject implements TSClosable {
 
   @Override
   public void close() {
+    if (borrowed) {
+      // the native object is released by its owner
+      if (owner != null) {
+        owner.close();
+      }
+      setNativeObject(0);
+      return;
+    }
+
     if (getNativeObject() != 0) {
       closeNativeObj();
     }
@@ -96,4 +189,12 @@ public abstract class TSNativeObject implements TSClosable {
    * Closes/deletes the native object.
    */
   protected abstract void closeNativeObj();
+
+  /**
+   * Releases a native object, given its pointer.
+   */
+  public interface NativeDeleter {
+
+    void delete(long pointer);
+  }
 }
@@ -78,7 +78,9 @@ public class TSNode extends TSNativeObject {
   }
 
   /**
-   * Get the syntax tree that this node is associated with.
+   * Get the syntax tree that this node is associated with. The returned object is a view of the
+   * tree which this node was obtained from. It does not keep that tree reachable, and closing it
+   * does not release the tree.
    *
    * @return The syntax tree.
    */
@@ -86,6 +88,7 @@ public class TSNode extends TSNativeObject {
     checkAccess();
     if (mTree == null) {
       mTree = TSTree.create(this.tree);
+      mTree.markBorrowed(null);
     }
     return mTree;
   }
@@ -170,6 +173,52 @@ public class TSNode extends TSNativeObject {
     return getChildByFieldName(bytes, bytes.length);
   }
 
+  /**
+   * Get all the children of this node with a single native call.
+   *
+   * @return The children of this node.
+   */
+  public TSNodeList getChildren() {
+    checkAccess();
+    return TSNodeList.create(Native.getChildren(this, false), tree);
+  }
+
+  /**
+   * Get all the named children of this node with a single native call.
+   *
+   * @return The named children of this node.
+   */
+  public TSNodeList getNamedChildren() {
+    checkAccess();
+    return TSNodeList.create(Native.getChildren(this, true), tree);
+  }
+
+  /**
+   * Get all the descendants of this node (in pre-order) which intersect with the given byte range,
+   * with a single native call.
+   *
+   * @param start The start byte of the range.
+   * @param end   The end byte of the range (exclusive).
+   * @return The descendants of this node.
+   */
+  public TSNodeList getDescendantsInByteRange(int start, int end) {
+    checkAccess();
+    return TSNodeList.create(Native.getDescendantsInByteRange(this, start, end, false), tree);
+  }
+
+  /**
+   * Get all the named descendants of this node (in pre-order) which intersect with the given byte
+   * range, with a single native call.
+   *
+   * @param start The start byte of the range.
+   * @param end   The end byte of the range (exclusive).
+   * @return The named descendants of this node.
+   */
+  public TSNodeList getNamedDescendantsInByteRange(int start, int end) {
+    checkAccess();
+    return TSNodeList.create(Native.getDescendantsInByteRange(this, start, end, true), tree);
+  }
+
   public TSTreeCursor walk() {
     checkAccess();
     return TSTreeCursor.create(this);
@@ -636,6 +685,12 @@ public class TSNode extends TSNativeObject {
     // no need to do anything
   }
 
+  @Override
+  protected boolean isTracked() {
+    // nodes do not own any native memory, and are never closed
+    return false;
+  }
+
   @GenerateNativeHeaders(fileName = "node")
   private static final class Native {
 
@@ -761,5 +816,12 @@ public class TSNode extends TSNativeObject {
 
     @FastNative
     public static native long getLanguage(TSNode self);
+
+    @FastNative
+    static native int[] getChildren(TSNode self, boolean named);
+
+    @FastNative
+    static native int[] getDescendantsInByteRange(TSNode self, int start, int end,
+                                                  boolean named);
   }
 }
@@ -0,0 +1,122 @@
+/*
+ *  This file is part of android-tree-sitter.
+ *
+ *  android-tree-sitter library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  android-tree-sitter library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *  along with android-tree-sitter.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+package com.itsaky.androidide.treesitter;
+
+import java.util.AbstractList;
+import java.util.RandomAccess;
+
+/**
+ * A list of {@link TSNode} objects, all of which belong to the same syntax tree, backed by a flat
+ * <code>int[]</code> filled by a single native call. Each node is stored as a record of
+ * {@link #RECORD_SIZE} values : <code>context[0..3]</code> followed by the low and high bits of
+ * the node's id. The {@link TSNode} objects are created lazily, when they are accessed using
+ * {@link #get(int)}. The start position of the nodes can be read without creating the
+ * {@link TSNode} objects.
+ *
+ * @author Akash Yadav
+ */
+public class TSNodeList extends AbstractList<TSNode> implements RandomAccess {
+
+  /**
+   * The number of <code>int</code> values in a single node record.
+   */
+  public static final int RECORD_SIZE = 6;
+
+  private static final int OFFSET_CONTEXT0 = 0;
+  private static final int OFFSET_CONTEXT1 = 1;
+  private static final int OFFSET_CONTEXT2 = 2;
+  private static final int OFFSET_CONTEXT3 = 3;
+  private static final int OFFSET_ID_LOW = 4;
+  private static final int OFFSET_ID_HIGH = 5;
+
+  private final int[] records;
+  private final long tree;
+
+  protected TSNodeList(int[] records, long tree) {
+    this.records = records == null ? new int[0] : records;
+    this.tree = tree;
+  }
+
+  /**
+   * Create a new {@link TSNodeList} from the given packed records.
+   *
+   * @param records The packed node records.
+   * @param tree    The pointer to the syntax tree that the nodes belong to.
+   * @return The node list.
+   */
+  public static TSNodeList create(int[] records, long tree) {
+    return new TSNodeList(records, tree);
+  }
+
+  @Override
+  public TSNode get(int index) {
+    final var offset = offsetOf(index);
+    return TSNode.create(records[offset + OFFSET_CONTEXT0], records[offset + OFFSET_CONTEXT1],
+      records[offset + OFFSET_CONTEXT2], records[offset + OFFSET_CONTEXT3], getNodeId(index),
+      tree);
+  }
+
+  @Override
+  public int size() {
+    return records.length / RECORD_SIZE;
+  }
+
+  /**
+   * Get the start byte of the node at the given index.
+   */
+  public int getStartByte(int index) {
+    return records[offsetOf(index) + OFFSET_CONTEXT0];
+  }
+
+  /**
+   * Get the row of the start position of the node at the given index.
+   */
+  public int getStartRow(int index) {
+    return records[offsetOf(index) + OFFSET_CONTEXT1];
+  }
+
+  /**
+   * Get the column of the start position of the node at the given index.
+   */
+  public int getStartColumn(int index) {
+    return records[offsetOf(index) + OFFSET_CONTEXT2];
+  }
+
+  /**
+   * Get the id of the node at the given index.
+   */
+  public long getNodeId(int index) {
+    final var offset = offsetOf(index);
+    return ((long) records[offset + OFFSET_ID_HIGH] << 32) |
+      (records[offset + OFFSET_ID_LOW] & 0xffffffffL);
+  }
+
+  /**
+   * Get the pointer to the syntax tree that the nodes in this list belong to.
+   */
+  public long getTree() {
+    return tree;
+  }
+
+  private int offsetOf(int index) {
+    if (index < 0 || index >= size()) {
+      throw new IndexOutOfBoundsException("size=" + size() + ", index=" + index);
+    }
+    return index * RECORD_SIZE;
+  }
+}
@@ -23,9 +23,13 @@ import com.itsaky.androidide.treesitter.string.UTF16StringFactory;
 import com.itsaky.androidide.treesitter.util.TSObjectFactoryProvider;
 import dalvik.annotation.optimization.CriticalNative;
 import dalvik.annotation.optimization.FastNative;
+import java.io.File;
+import java.io.IOException;
+import java.util.Objects;
 import java.util.concurrent.atomic.AtomicBoolean;
 import java.util.concurrent.locks.Condition;
 import java.util.concurrent.locks.ReentrantLock;
+import java.util.function.LongUnaryOperator;
 
 /**
  * Implementation of tree sitter's <code>TSParser</code> APIs. This implementation always converts
@@ -174,6 +178,141 @@ public class TSParser extends TSNativeObject {
    * @throws ParseInProgressException If the parser is currently parsing another syntax tree.
    */
   public TSTree parseString(TSTree oldTree, UTF16String source) {
+    try {
+      return doParse(oldTree, oldTreePointer -> Native.parse(getNativeObject(), oldTreePointer,
+        source.getNativeObject()));
+    } finally {
+      source.reachabilityFence();
+    }
+  }
+
+  /**
+   * Parses the source code provided by the given {@link TSInputReader}. See
+   * {@link #parseInput(TSTree, TSInputReader)} for more details.
+   *
+   * @param reader The reader which provides the source code.
+   * @return The parsed tree, or <code>null</code> if the parse failed or was cancelled.
+   */
+  public TSTree parseInput(TSInputReader reader) {
+    return parseInput(null, reader);
+  }
+
+  /**
+   * Parse the source code provided by the given {@link TSInputReader}, using the previously parsed
+   * syntax tree. The source code is read in chunks of {@link TSInputReader#DEFAULT_CHUNK_SIZE}
+   * characters, so the document never needs to be available as a single string. See
+   * {@link #parseString(TSTree, UTF16String)} for more details.
+   * <p>
+   * If the reader throws an exception, the parse is stopped and the exception is rethrown to the
+   * caller of this method.
+   *
+   * @param oldTree The previously parsed syntax tree.
+   * @param reader  The reader which provides the source code.
+   * @return The parsed tree, or <code>null</code> if the parse failed or was cancelled.
+   */
+  public TSTree parseInput(TSTree oldTree, TSInputReader reader) {
+    final var buffer = new char[TSInputReader.DEFAULT_CHUNK_SIZE];
+    return doParse(oldTree,
+      oldTreePointer -> Native.parseInput(getNativeObject(), oldTreePointer, reader, buffer));
+  }
+
+  /**
+   * Parse the source code which consists of the given chunks of {@link UTF16String}. The chunks are
+   * read in the given order, as if they were a single string, without concatenating them. See
+   * {@link #parseString(TSTree, UTF16String)} for more details.
+   *
+   * @param oldTree The previously parsed syntax tree.
+   * @param chunks  The chunks of the source code.
+   * @return The parsed tree, or <code>null</code> if the parse failed or was cancelled.
+   */
+  public TSTree parseChunks(TSTree oldTree, UTF16String... chunks) {
+    final var pointers = new long[chunks.length];
+    for (int i = 0; i < chunks.length; i++) {
+      pointers[i] = chunks[i].getNativeObject();
+    }
+    return doParse(oldTree,
+      oldTreePointer -> Native.parseChunks(getNativeObject(), oldTreePointer, pointers));
+  }
+
+  /**
+   * Apply the given edits to the old tree, reparse the edited source incrementally and compute the
+   * changed ranges between the edited old tree and the new tree, all in a single native call. This
+   * is equivalent to calling {@link TSTree#edit(TSInputEdit)} for each edit, followed by
+   * {@link #parseString(TSTree, UTF16String)} and {@link TSTree#getChangedRangeList(TSTree)}. See
+   * {@link #parseString(TSTree, UTF16String)} for more details.
+   * <p>
+   * The old tree is edited in place, as with {@link TSTree#edit(int[])}.
+   *
+   * @param oldTree The previously parsed syntax tree.
+   * @param edits   The edits, packed with {@link TSInputEdit#pack(java.util.List)}.
+   * @param source  The edited source code.
+   * @return The new tree and the changed ranges.
+   */
+  public TSReparseResult reparse(TSTree oldTree, int[] edits, UTF16String source) {
+    Objects.requireNonNull(oldTree, "oldTree cannot be null");
+    Objects.requireNonNull(edits, "edits cannot be null");
+    Objects.requireNonNull(source, "source cannot be null");
+    if (edits.length % TSInputEdit.RECORD_SIZE != 0) {
+      throw new IllegalArgumentException(
+        "The length of the packed edits must be a multiple of " + TSInputEdit.RECORD_SIZE);
+    }
+
+    oldTree.checkAccess();
+    final var changedRanges = new int[1][];
+    final TSTree tree;
+    try {
+      tree = doParse(oldTree, oldTreePointer -> {
+        final var newTree = new long[1];
+        changedRanges[0] = Native.reparse(getNativeObject(), oldTreePointer, edits,
+          source.getNativeObject(), newTree);
+        return newTree[0];
+      });
+    } finally {
+      source.reachabilityFence();
+    }
+
+    return new TSReparseResult(tree, TSRangeList.create(tree == null ? null : changedRanges[0]));
+  }
+
+  /**
+   * Parse the source code in the given file. See {@link #parseFile(TSTree, File, TSInputEncoding)}
+   * for more details.
+   *
+   * @param file     The file to parse.
+   * @param encoding The encoding of the file.
+   * @return The parsed tree, or <code>null</code> if the parse failed or was cancelled.
+   * @throws IOException If the file cannot be read.
+   */
+  public TSTree parseFile(File file, TSInputEncoding encoding) throws IOException {
+    return parseFile(null, file, encoding);
+  }
+
+  /**
+   * Parse the source code in the given file, using the previously parsed syntax tree. The file is
+   * memory-mapped and read directly by the parser, so its content is never copied to the Java
+   * heap or to a native string. The file is unmapped once the parse completes. See
+   * {@link #parseString(TSTree, UTF16String)} for more details.
+   * <p>
+   * The byte offsets in the resulting tree are offsets in the file, in the given encoding. The file
+   * must not be modified while it is being parsed.
+   *
+   * @param oldTree  The previously parsed syntax tree.
+   * @param file     The file to parse.
+   * @param encoding The encoding of the file.
+   * @return The parsed tree, or <code>null</code> if the parse failed or was cancelled.
+   * @throws IOException If the file cannot be read.
+   */
+  public TSTree parseFile(TSTree oldTree, File file, TSInputEncoding encoding)
+    throws IOException {
+    Objects.requireNonNull(file, "file cannot be null");
+    Objects.requireNonNull(encoding, "encoding cannot be null");
+    final var path = file.getPath();
+    return doParse(oldTree,
+      oldTreePointer -> Native.parseFile(getNativeObject(), oldTreePointer, path,
+        encoding.getFlag()));
+  }
+
+  private TSTree doParse(TSTree oldTree, LongUnaryOperator parseFunc) {
     checkAccess();
 
     // Check for reentrancy (same thread calling this method again, before the previous call returned)
@@ -191,11 +330,13 @@ public class TSParser extends TSNativeObject {
     setCancellationRequested(false);
     setParsingFlag();
     try {
-      final var strPointer = source.getNativeObject();
       final var oldTreePointer = oldTree != null ? oldTree.getNativeObject() : 0;
-      final var tree = Native.parse(this.getNativeObject(), oldTreePointer, strPointer);
+      final var tree = parseFunc.applyAsLong(oldTreePointer);
       return createTree(tree);
     } finally {
+      if (oldTree != null) {
+        oldTree.reachabilityFence();
+      }
       unsetParsingFlag();
       parseCondition.signalAll();
       parseLock.unlock();
@@ -232,6 +373,41 @@ public class TSParser extends TSNativeObject {
     return isParsing.get();
   }
 
+  /**
+   * Get the progress of the current parse, as the number of bytes of the source that the parser
+   * has read so far. If no parse is in progress, this returns the number of bytes read by the last
+   * parse. This can be called from any thread, for example to decide whether to wait for a parse
+   * to complete or to cancel it.
+   * <p>
+   * For incremental parses, the parser skips the regions of the source which have not changed, so
+   * the progress may advance in large steps.
+   *
+   * @return The number of bytes read by the current or the last parse.
+   */
+  public long getParseProgress() {
+    checkAccess();
+    return Native.getParseProgress(getNativeObject());
+  }
+
+  /**
+   * Get a snapshot of the stats of this parser. The stats are only recorded while they are enabled
+   * with {@link TSStats#setEnabled(boolean)}. This can be called from any thread.
+   *
+   * @return The stats of this parser.
+   */
+  public TSParserStats getStats() {
+    checkAccess();
+    return new TSParserStats(Native.getStats(getNativeObject()));
+  }
+
+  /**
+   * Reset the stats of this parser to zero.
+   */
+  public void resetStats() {
+    checkAccess();
+    Native.resetStats(getNativeObject());
+  }
+
   /**
    * Sets the 'parsing' flag to indicate that the parser is in the process of parsing a syntax
    * tree.
@@ -317,6 +493,30 @@ public class TSParser extends TSNativeObject {
     return Native.getIncludedRanges(getNativeObject());
   }
 
+  /**
+   * Same as {@link #setIncludedRanges(TSRange[])}, but the ranges are passed to the native side as
+   * a single flat array, without unmarshalling a {@link TSRange} object for each range.
+   *
+   * @param ranges The ranges to include.
+   * @return Whether the ranges were assigned.
+   */
+  public boolean setIncludedRanges(TSRangeList ranges) {
+    Objects.requireNonNull(ranges, "ranges cannot be null");
+    checkAccess();
+    return Native.setIncludedRangesPacked(getNativeObject(), ranges.getRecords());
+  }
+
+  /**
+   * Same as {@link #getIncludedRanges()}, but the ranges are returned as a {@link TSRangeList}
+   * backed by a single flat array.
+   *
+   * @return The included ranges.
+   */
+  public TSRangeList getIncludedRangeList() {
+    checkAccess();
+    return TSRangeList.create(Native.getIncludedRangesPacked(getNativeObject()));
+  }
+
   /**
    * Instruct the parser to start the next parse from the beginning.
    *
@@ -400,10 +600,41 @@ public class TSParser extends TSNativeObject {
     @FastNative
     static native TSRange[] getIncludedRanges(long parser);
 
+    @FastNative
+    static native boolean setIncludedRangesPacked(long parser, int[] ranges);
+
+    @FastNative
+    static native int[] getIncludedRangesPacked(long parser);
+
     @FastNative
     static native long parse(long parser, long treePointer, long strPointer);
 
     @FastNative
     static native boolean requestCancellation(long parser);
+
+    @FastNative
+    static native long getParseProgress(long parser);
+
+    @FastNative
+    static native long[] getStats(long parser);
+
+    @FastNative
+    static native void resetStats(long parser);
+
+    // returns the packed changed ranges and writes the new tree to newTree[0]
+    @FastNative
+    static native int[] reparse(long parser, long oldTree, int[] edits, long strPointer,
+                                long[] newTree);
+
+    // not a @FastNative method as it calls back into Java code
+    static native long parseInput(long parser, long treePointer, TSInputReader reader,
+                                  char[] buffer);
+
+    @FastNative
+    static native long parseChunks(long parser, long treePointer, long[] strPointers);
+
+    // not a @FastNative method as it reads the file
+    // throws IOException if the file cannot be mapped
+    static native long parseFile(long parser, long treePointer, String path, int encoding);
   }
 }
\ No newline at end of file
@@ -0,0 +1,336 @@
+/*
+ *  This file is part of android-tree-sitter.
+ *
+ *  android-tree-sitter library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  android-tree-sitter library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *  along with android-tree-sitter.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+package com.itsaky.androidide.treesitter;
+
+import com.itsaky.androidide.treesitter.annotations.GenerateNativeHeaders;
+import com.itsaky.androidide.treesitter.string.UTF16String;
+import dalvik.annotation.optimization.FastNative;
+import java.io.File;
+import java.io.IOException;
+import java.util.Objects;
+import java.util.concurrent.TimeUnit;
+
+/**
+ * A pool of {@link TSParser} instances for a single language. The native parsers are reused
+ * across parses, so that their parse stacks and lexer state are not reallocated for each parse.
+ * This allows parsing multiple documents in parallel on different threads, by acquiring a parser
+ * per thread.
+ * <p>
+ * New parsers are created on demand, until the maximum size of the pool is reached. After that,
+ * {@link #acquire()} waits until another thread returns a parser to the pool. Parsers are returned
+ * to the pool when they are closed :
+ * <pre>
+ *   try (final var parser = pool.acquire()) {
+ *     try (final var tree = parser.parseString(source)) {
+ *       // ...
+ *     }
+ *   }
+ * </pre>
+ * Parsers which are returned to the pool are reset to parse a new document with the language of
+ * the pool, without any included ranges and timeout.
+ * <p>
+ * Multiple documents can also be parsed in a single call with {@link #parseBatch(UTF16String...)}
+ * or {@link #parseFileBatch(File[], TSInputEncoding)}, which parse the documents in parallel on a
+ * native thread pool.
+ * <p>
+ * Closing the pool deletes the idle parsers. The acquired parsers are deleted when they are closed.
+ *
+ * @author Akash Yadav
+ */
+public class TSParserPool extends TSNativeObject {
+
+  protected final TSLanguage language;
+  protected final int maxSize;
+
+  protected TSParserPool(long pointer, TSLanguage language, int maxSize) {
+    super(pointer);
+    this.language = language;
+    this.maxSize = maxSize;
+  }
+
+  /**
+   * Create a new parser pool for the given language, with the maximum size set to the number of
+   * available processors.
+   *
+   * @param language The language of the parsers.
+   * @return The parser pool.
+   */
+  public static TSParserPool create(TSLanguage language) {
+    return create(language, Runtime.getRuntime().availableProcessors());
+  }
+
+  /**
+   * Create a new parser pool for the given language.
+   *
+   * @param language The language of the parsers.
+   * @param maxSize  The maximum number of parsers that the pool can create.
+   * @return The parser pool.
+   */
+  public static TSParserPool create(TSLanguage language, int maxSize) {
+    Objects.requireNonNull(language, "language cannot be null");
+    if (maxSize <= 0) {
+      throw new IllegalArgumentException("maxSize must be > 0");
+    }
+
+    language.checkAccess();
+    return new TSParserPool(Native.newPool(language.getNativeObject(), maxSize), language,
+      maxSize);
+  }
+
+  /**
+   * Acquire a parser from the pool, waiting until a parser is available if the pool has reached
+   * its maximum size.
+   *
+   * @return The parser. Must be closed to return it to the pool.
+   */
+  public TSParser acquire() {
+    return acquireParser(-1);
+  }
+
+  /**
+   * Acquire a parser from the pool, waiting up to the given time for a parser to become
+   * available.
+   *
+   * @param timeout The maximum time to wait.
+   * @param unit    The unit of the timeout.
+   * @return The parser, or <code>null</code> if no parser was available within the timeout. Must
+   * be closed to return it to the pool.
+   */
+  public TSParser acquire(long timeout, TimeUnit unit) {
+    return acquireParser(Math.max(0, unit.toMillis(timeout)));
+  }
+
+  /**
+   * Acquire a parser from the pool without waiting.
+   *
+   * @return The parser, or <code>null</code> if the pool has reached its maximum size and all the
+   * parsers are in use. Must be closed to return it to the pool.
+   */
+  public TSParser tryAcquire() {
+    return acquireParser(0);
+  }
+
+  private TSParser acquireParser(long timeoutMillis) {
+    checkAccess();
+    final var pool = getNativeObject();
+    final var parser = Native.acquire(pool, timeoutMillis);
+    if (parser == 0) {
+      return null;
+    }
+
+    return new PooledParser(parser, pool);
+  }
+
+  /**
+   * Parse the given sources in parallel, using the parsers of this pool.
+   *
+   * @param sources The sources to parse.
+   * @return The trees, in the same order as the sources.
+   * @see #parseBatch(UTF16String[], long)
+   */
+  public TSTree[] parseBatch(UTF16String... sources) {
+    return parseBatch(sources, 0);
+  }
+
+  /**
+   * Parse the given sources in parallel, using the parsers of this pool. The sources are parsed on
+   * a native thread pool, with up to {@link #getMaxSize()} parsers at a time, and the calling
+   * thread takes part in the parsing. This method blocks until all the sources have been parsed.
+   * <p>
+   * The sources are read directly from their native storage, so they must not be modified until
+   * this method returns. The calling thread must not hold a parser acquired from this pool if the
+   * pool has reached its maximum size, or this method may wait indefinitely.
+   *
+   * @param sources       The sources to parse.
+   * @param timeoutMicros The maximum duration in microseconds that the parse of each source is
+   *                      allowed to take. 0 for no timeout.
+   * @return The trees, in the same order as the sources. An element is <code>null</code> if the
+   * parse of the corresponding source timed out.
+   */
+  public TSTree[] parseBatch(UTF16String[] sources, long timeoutMicros) {
+    Objects.requireNonNull(sources, "sources cannot be null");
+    checkAccess();
+
+    final var pointers = new long[sources.length];
+    for (int i = 0; i < sources.length; i++) {
+      final var source = Objects.requireNonNull(sources[i], "sources cannot contain null");
+      pointers[i] = source.getNativeObject();
+    }
+
+    try {
+      return createTrees(Native.parseBatch(getNativeObject(), pointers, timeoutMicros));
+    } finally {
+      for (final var source : sources) {
+        source.reachabilityFence();
+      }
+    }
+  }
+
+  /**
+   * Parse the given files in parallel, using the parsers of this pool.
+   *
+   * @param files    The files to parse.
+   * @param encoding The encoding of the files.
+   * @return The trees and the errors of the files which could not be read.
+   * @see #parseFileBatch(File[], TSInputEncoding, long)
+   */
+  public TSFileBatchResult parseFileBatch(File[] files, TSInputEncoding encoding) {
+    return parseFileBatch(files, encoding, 0);
+  }
+
+  /**
+   * Parse the given files in parallel, using the parsers of this pool. Each file is memory-mapped
+   * only while it is parsed, see {@link TSParser#parseFile(TSTree, File, TSInputEncoding)}. This
+   * method has the same threading behavior as {@link #parseBatch(UTF16String[], long)}.
+   * <p>
+   * A file which cannot be read does not fail the batch : its tree is <code>null</code> and its
+   * error is reported in the result, while the other files are still parsed.
+   *
+   * @param files         The files to parse.
+   * @param encoding      The encoding of the files.
+   * @param timeoutMicros The maximum duration in microseconds that the parse of each file is
+   *                      allowed to take. 0 for no timeout.
+   * @return The trees and the errors of the files which could not be read.
+   */
+  public TSFileBatchResult parseFileBatch(File[] files, TSInputEncoding encoding,
+                                          long timeoutMicros) {
+    Objects.requireNonNull(files, "files cannot be null");
+    Objects.requireNonNull(encoding, "encoding cannot be null");
+    checkAccess();
+
+    final var paths = new String[files.length];
+    for (int i = 0; i < files.length; i++) {
+      paths[i] = Objects.requireNonNull(files[i], "files cannot contain null").getPath();
+    }
+
+    final var messages = new String[files.length];
+    final var trees = createTrees(
+      Native.parseFileBatch(getNativeObject(), paths, encoding.getFlag(), timeoutMicros, messages));
+
+    final var errors = new IOException[files.length];
+    for (int i = 0; i < messages.length; i++) {
+      if (messages[i] != null) {
+        errors[i] = new IOException(messages[i]);
+      }
+    }
+
+    return new TSFileBatchResult(trees, errors);
+  }
+
+  private static TSTree[] createTrees(long[] treePointers) {
+    final var trees = new TSTree[treePointers.length];
+    for (int i = 0; i < treePointers.length; i++) {
+      if (treePointers[i] != 0) {
+        trees[i] = TSTree.create(treePointers[i]);
+      }
+    }
+
+    return trees;
+  }
+
+  /**
+   * Get the language of the parsers in this pool.
+   */
+  public TSLanguage getLanguage() {
+    return language;
+  }
+
+  /**
+   * Get the maximum number of parsers that this pool can create.
+   */
+  public int getMaxSize() {
+    return maxSize;
+  }
+
+  /**
+   * Get the number of parsers created by this pool, including the ones which are currently
+   * acquired.
+   */
+  public int getSize() {
+    checkAccess();
+    return Native.size(getNativeObject());
+  }
+
+  /**
+   * Get the number of idle parsers in this pool.
+   */
+  public int getIdleCount() {
+    checkAccess();
+    return Native.idleCount(getNativeObject());
+  }
+
+  @Override
+  protected void closeNativeObj() {
+    Native.destroy(getNativeObject());
+  }
+
+  /**
+   * A parser acquired from a {@link TSParserPool}, which returns the native parser to the pool
+   * when closed.
+   */
+  private static final class PooledParser extends TSParser {
+
+    // the native pool stays alive until all of its parsers are released,
+    // even if the pool object has been closed
+    private final long pool;
+
+    private PooledParser(long pointer, long pool) {
+      super(pointer);
+      this.pool = pool;
+    }
+
+    @Override
+    protected void closeNativeObj() {
+      if (isParsing()) {
+        requestCancellationAndWait();
+      }
+
+      Native.release(pool, getNativeObject());
+    }
+  }
+
+  @GenerateNativeHeaders(fileName = "parser_pool")
+  private static class Native {
+
+    @FastNative
+    static native long newPool(long language, int maxSize);
+
+    @FastNative
+    static native void destroy(long pool);
+
+    // not a @FastNative method as it may block until a parser is released
+    static native long acquire(long pool, long timeoutMillis);
+
+    @FastNative
+    static native void release(long pool, long parser);
+
+    @FastNative
+    static native int size(long pool);
+
+    @FastNative
+    static native int idleCount(long pool);
+
+    // not a @FastNative method as it blocks until all the sources have been parsed
+    static native long[] parseBatch(long pool, long[] sources, long timeoutMicros);
+
+    // not a @FastNative method as it blocks until all the files have been parsed
+    // fills the errors with the message of each file which cannot be mapped
+    static native long[] parseFileBatch(long pool, String[] paths, int encoding,
+                                        long timeoutMicros, String[] errors);
+  }
+}
@@ -0,0 +1,111 @@
+/*
+ *  This file is part of android-tree-sitter.
+ *
+ *  android-tree-sitter library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  android-tree-sitter library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *  along with android-tree-sitter.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+package com.itsaky.androidide.treesitter;
+
+/**
+ * A snapshot of the stats of a {@link TSParser}, see {@link TSParser#getStats()}. Only the parses
+ * done while the stats are enabled (see {@link TSStats#setEnabled(boolean)}) are counted.
+ *
+ * @author Akash Yadav
+ */
+public class TSParserStats {
+
+  /**
+   * The number of buckets in the parse time histogram, see {@link #getParseTimeHistogram()}.
+   */
+  public static final int PARSE_TIME_BUCKETS = 24;
+
+  /**
+   * The number of values in a packed parser stats record.
+   */
+  public static final int RECORD_SIZE = 5 + PARSE_TIME_BUCKETS;
+
+  private static final int PARSE_COUNT = 0;
+  private static final int BYTES_PARSED = 1;
+  private static final int PARSE_TIME = 2;
+  private static final int CANCELLATIONS = 3;
+  private static final int TIMEOUTS = 4;
+  private static final int HISTOGRAM = 5;
+
+  private final long[] values;
+
+  protected TSParserStats(long[] values) {
+    this.values = values;
+  }
+
+  /**
+   * The number of parses, including the cancelled and timed out ones.
+   */
+  public long getParseCount() {
+    return values[PARSE_COUNT];
+  }
+
+  /**
+   * The total number of bytes of the sources read by the parser. For incremental parses, only the
+   * bytes that the parser actually read are counted.
+   */
+  public long getBytesParsed() {
+    return values[BYTES_PARSED];
+  }
+
+  /**
+   * The total time spent parsing, in nanoseconds.
+   */
+  public long getParseTimeNanos() {
+    return values[PARSE_TIME];
+  }
+
+  /**
+   * The number of parses which were cancelled.
+   */
+  public long getCancellationCount() {
+    return values[CANCELLATIONS];
+  }
+
+  /**
+   * The number of parses which timed out.
+   */
+  public long getTimeoutCount() {
+    return values[TIMEOUTS];
+  }
+
+  /**
+   * Get the parse time histogram. The bucket at index <code>i</code> counts the parses which took
+   * between <code>2^i</code> (inclusive) and <code>2^(i+1)</code> (exclusive) microseconds. The
+   * first bucket also counts the parses which took less than a microsecond, and the last bucket
+   * counts all the parses which took longer.
+   *
+   * @return A new array of {@link #PARSE_TIME_BUCKETS} values.
+   */
+  public long[] getParseTimeHistogram() {
+    final var histogram = new long[PARSE_TIME_BUCKETS];
+    System.arraycopy(values, HISTOGRAM, histogram, 0, PARSE_TIME_BUCKETS);
+    return histogram;
+  }
+
+  @Override
+  public String toString() {
+    return "TSParserStats{" +
+      "parseCount=" + getParseCount() +
+      ", bytesParsed=" + getBytesParsed() +
+      ", parseTimeNanos=" + getParseTimeNanos() +
+      ", cancellations=" + getCancellationCount() +
+      ", timeouts=" + getTimeoutCount() +
+      '}';
+  }
+}
@@ -19,8 +19,12 @@ package com.itsaky.androidide.treesitter;
 
 import android.text.TextUtils;
 import com.itsaky.androidide.treesitter.annotations.GenerateNativeHeaders;
+import com.itsaky.androidide.treesitter.predicate.TSPredicateHandler.PredicateStep;
 import com.itsaky.androidide.treesitter.util.TSObjectFactoryProvider;
 import dalvik.annotation.optimization.FastNative;
+import java.util.ArrayList;
+import java.util.Collections;
+import java.util.List;
 
 public class TSQuery extends TSNativeObject {
 
@@ -34,6 +38,12 @@ public class TSQuery extends TSNativeObject {
 
   protected String[] captureNames = null;
 
+  // predicates never change after the query is compiled
+  // these are computed once when the query is created
+  protected int patternCount = -1;
+  protected TSQueryPredicateStep[][] predicates = null;
+  protected List<List<PredicateStep>> predicateSteps = null;
+
   /**
    * For internal use only!
    * <p>
@@ -78,7 +88,10 @@ public class TSQuery extends TSNativeObject {
    */
   public int getPatternCount() {
     checkAccess();
-    return Native.patternCount(getNativeObject());
+    if (patternCount == -1) {
+      patternCount = Native.patternCount(getNativeObject());
+    }
+    return patternCount;
   }
 
   /**
@@ -110,9 +123,78 @@ public class TSQuery extends TSNativeObject {
   public TSQueryPredicateStep[] getPredicatesForPattern(int pattern) {
     checkAccess();
     validatePatternIndex(pattern);
+    if (predicates != null) {
+      return predicates[pattern].clone();
+    }
     return Native.predicatesForPattern(getNativeObject(), pattern);
   }
 
+  /**
+   * Get the decoded predicate steps for the given pattern. The values of the steps are resolved to
+   * the capture names and string values of the query. The steps of all the predicates of the
+   * pattern are returned in order, each predicate being terminated by a
+   * {@link TSQueryPredicateStep.Type#Done} step.
+   * <p>
+   * The steps are computed once when the query is created, so this does not make any JNI calls.
+   *
+   * @param pattern The pattern index.
+   * @return The (unmodifiable) list of predicate steps.
+   */
+  public List<PredicateStep> getPredicateStepsForPattern(int pattern) {
+    checkAccess();
+    validatePatternIndex(pattern);
+    if (predicateSteps == null) {
+      cachePredicates();
+    }
+    return predicateSteps.get(pattern);
+  }
+
+  /**
+   * Fetch and decode the predicates of all the patterns in this query.
+   */
+  protected void cachePredicates() {
+    final var count = getPatternCount();
+    final var predicates = new TSQueryPredicateStep[count][];
+    final var predicateSteps = new ArrayList<List<PredicateStep>>(count);
+    final var captureNames = getCaptureNames();
+    final var stringValues = new String[getStringCount()];
+
+    for (int i = 0; i < count; i++) {
+      final var patternPredicates = Native.predicatesForPattern(getNativeObject(), i);
+      predicates[i] = patternPredicates;
+
+      if (patternPredicates.length == 0) {
+        predicateSteps.add(Collections.emptyList());
+        continue;
+      }
+
+      final var steps = new ArrayList<PredicateStep>(patternPredicates.length);
+      for (final var predicate : patternPredicates) {
+        final var valueId = predicate.getValueId();
+        final String value;
+        switch (predicate.getType()) {
+          case Capture:
+            value = captureNames[valueId];
+            break;
+          case String:
+            if (stringValues[valueId] == null) {
+              stringValues[valueId] = getStringValueForId(valueId);
+            }
+            value = stringValues[valueId];
+            break;
+          default:
+            value = "";
+            break;
+        }
+        steps.add(new PredicateStep(predicate.getType(), value));
+      }
+      predicateSteps.add(Collections.unmodifiableList(steps));
+    }
+
+    this.predicates = predicates;
+    this.predicateSteps = predicateSteps;
+  }
+
   public boolean isPatternRooted(int pattern) {
     checkAccess();
     validatePatternIndex(pattern);
@@ -171,6 +253,10 @@ public class TSQuery extends TSNativeObject {
    * 1. The byte offset of the error is written to the {@link #errorOffset} parameter.
    * 2. The type of error is written to the {@link #errorType} parameter.
    *
+   * <p>Compiled queries are cached natively per language and query source, and are shared between
+   * all the {@link TSQuery} instances created with the same arguments. See
+   * {@link #setCacheLimit(int)} for the size of the cache.
+   *
    * @param language The {@link TSLanguage} for the query.
    * @param querySource    The query source.
    * @return The {@link TSQuery} object.
@@ -186,9 +272,89 @@ public class TSQuery extends TSNativeObject {
 
     final var query = TSObjectFactoryProvider.getFactory().createQuery(0);
     query.setNativeObject(Native.newQuery(query, language.getNativeObject(), querySource));
+    if (query.canAccess()) {
+      query.cachePredicates();
+    }
     return query;
   }
 
+  /**
+   * Compile the given query and keep it in the native query cache, without creating a
+   * {@link TSQuery}. Compiled queries are cached per language and query source, so a subsequent
+   * {@link #create(TSLanguage, String)} call with the same arguments does not compile the query
+   * again. This can be called from a background thread (e.g. at startup) to warm up the cache for
+   * large queries.
+   *
+   * @param language    The language of the query.
+   * @param querySource The query source.
+   * @return <code>true</code> if the query was compiled successfully, <code>false</code>
+   * otherwise.
+   */
+  public static boolean preload(TSLanguage language, String querySource) {
+    if (language == null) {
+      throw new IllegalArgumentException("Language cannot be null");
+    }
+
+    if (querySource == null || TextUtils.getTrimmedLength(querySource) == 0) {
+      throw new IllegalArgumentException("Query cannot be null or blank");
+    }
+
+    language.checkAccess();
+    return Native.preload(language.getNativeObject(), querySource);
+  }
+
+  /**
+   * Remove all the queries from the native query cache. Queries which are still in use are
+   * deleted when they are closed.
+   */
+  public static void clearCache() {
+    Native.clearCache();
+  }
+
+  /**
+   * Get the number of compiled queries in the native query cache.
+   *
+   * @return The number of cached queries.
+   */
+  public static int getCacheSize() {
+    return Native.cacheSize();
+  }
+
+  /**
+   * Get the maximum number of compiled queries in the native query cache.
+   *
+   * @return The maximum number of cached queries.
+   * @see #setCacheLimit(int)
+   */
+  public static int getCacheLimit() {
+    return Native.cacheLimit();
+  }
+
+  /**
+   * Set the maximum number of compiled queries in the native query cache, 64 by default. When the
+   * cache is full, the least recently used query is removed from it. Queries which are still in use
+   * are deleted when they are closed.
+   *
+   * @param limit The maximum number of cached queries, or <code>0</code> to disable the cache.
+   */
+  public static void setCacheLimit(int limit) {
+    if (limit < 0) {
+      throw new IllegalArgumentException("limit must not be negative: " + limit);
+    }
+
+    Native.setCacheLimit(limit);
+  }
+
+  /**
+   * Remove the cached queries for the given language. This is called before the language is
+   * unloaded.
+   */
+  static void evictCachedQueries(TSLanguage language) {
+    if (language.canAccess()) {
+      Native.evictCached(language.getNativeObject());
+    }
+  }
+
   /**
    * An empty query. Instances of this class are invalid queries and does not have any patterns,
    * capture names, etc. The <code>get*Count()</code> methods always return <code>0</code>, the
@@ -260,6 +426,24 @@ public class TSQuery extends TSNativeObject {
     @FastNative
     static native void delete(long query);
 
+    // not annotated with @FastNative as compiling large queries can take a while
+    static native boolean preload(long language, String source);
+
+    @FastNative
+    static native void evictCached(long language);
+
+    @FastNative
+    static native void clearCache();
+
+    @FastNative
+    static native int cacheSize();
+
+    @FastNative
+    static native int cacheLimit();
+
+    @FastNative
+    static native void setCacheLimit(int limit);
+
     @FastNative
     static native int captureCount(long query);
 
@@ -19,11 +19,10 @@ package com.itsaky.androidide.treesitter;
 
 import com.itsaky.androidide.treesitter.annotations.GenerateNativeHeaders;
 import com.itsaky.androidide.treesitter.predicate.TSPredicateHandler;
-import com.itsaky.androidide.treesitter.predicate.TSPredicateHandler.PredicateStep;
 import com.itsaky.androidide.treesitter.predicate.TSPredicateHandler.Result;
+import com.itsaky.androidide.treesitter.string.UTF16String;
 import com.itsaky.androidide.treesitter.util.TSObjectFactoryProvider;
 import dalvik.annotation.optimization.FastNative;
-import java.util.ArrayList;
 import java.util.HashSet;
 import java.util.Iterator;
 import java.util.NoSuchElementException;
@@ -35,10 +34,60 @@ import java.util.Set;
  */
 public class TSQueryCursor extends TSNativeObject implements Iterable<TSQueryMatch> {
 
+  /**
+   * The number of <code>int</code> values written for each capture by
+   * {@link #nextCaptures(int[])}.
+   */
+  public static final int CAPTURE_RECORD_SIZE = 6;
+
+  /**
+   * Offset of the capture ID (see {@link TSQuery#getCaptureNameForId(int)}) in a capture record.
+   */
+  public static final int CAPTURE_ID = 0;
+
+  /**
+   * Offset of the pattern index in a capture record.
+   */
+  public static final int CAPTURE_PATTERN_INDEX = 1;
+
+  /**
+   * Offset of the start byte of the captured node in a capture record.
+   */
+  public static final int CAPTURE_START_BYTE = 2;
+
+  /**
+   * Offset of the end byte of the captured node in a capture record.
+   */
+  public static final int CAPTURE_END_BYTE = 3;
+
+  /**
+   * Offset of the low 32 bits of the captured node's ID in a capture record.
+   */
+  public static final int CAPTURE_NODE_ID_LOW = 4;
+
+  /**
+   * Offset of the high 32 bits of the captured node's ID in a capture record.
+   */
+  public static final int CAPTURE_NODE_ID_HIGH = 5;
+
+  /**
+   * Flag for {@link #captureRanges(TSQuery, TSNode, UTF16String, int)} to drop the duplicate ranges
+   * of a capture, e.g. when the same node is captured by several patterns.
+   */
+  public static final int CAPTURE_RANGES_DEDUPLICATE = 1;
+
+  /**
+   * Flag for {@link #captureRanges(TSQuery, TSNode, UTF16String, int)} to drop the ranges of a
+   * capture which are nested in another range of the same capture, keeping only the outermost
+   * ranges. This implies {@link #CAPTURE_RANGES_DEDUPLICATE}.
+   */
+  public static final int CAPTURE_RANGES_MERGE_NESTED = 2;
+
   protected boolean isExecuted = false;
   private boolean allowChangedNodes = false;
   protected TSNode targetNode = null;
   protected TSQuery execQuery = null;
+  protected UTF16String execSource = null;
   protected final Set<TSPredicateHandler> predicateHandlers = new HashSet<>();
 
   protected TSQueryCursor() {
@@ -110,8 +159,121 @@ public class TSQueryCursor extends TSNativeObject implements Iterable<TSQueryMat
 
   /**
    * Start running the given query on the given node.
+   * <p>
+   * The standard text predicates (<code>#eq?</code>, <code>#match?</code>, <code>#any-of?</code>
+   * and their <code>#not-*</code> and <code>#any-*</code> variants) are NOT evaluated. Use
+   * {@link #exec(TSQuery, TSNode, UTF16String)} to evaluate them.
    */
   public void exec(TSQuery query, TSNode node) {
+    exec(query, node, null);
+  }
+
+  /**
+   * Start running the given query on the given node. The standard text predicates
+   * (<code>#eq?</code>, <code>#match?</code>, <code>#any-of?</code> and their <code>#not-*</code>
+   * and <code>#any-*</code> variants) are evaluated natively against the given source, and the
+   * matches which do not satisfy them are never returned. All the other predicates are passed to
+   * the predicate handlers.
+   * <p>
+   * The <code>#match?</code> patterns are ECMAScript regular expressions, optionally starting with
+   * the <code>(?i)</code> flag. Only the first 4096 characters of a node are searched, and a search
+   * which is too complex for the regex engine does not match. A pattern which the regex engine
+   * cannot compile rejects every match of its query pattern.
+   * <p>
+   * The source must be the text that the node's tree was parsed from, and must not be modified or
+   * closed while the matches are being iterated.
+   *
+   * @param query  The query to run.
+   * @param node   The node to run the query on.
+   * @param source The source text of the node's tree, or <code>null</code> to skip the evaluation
+   *               of the standard text predicates.
+   */
+  public void exec(TSQuery query, TSNode node, UTF16String source) {
+    checkExecutable(query, node, source);
+    try {
+      Native.exec(getNativeObject(), query.getNativeObject(), node);
+    } finally {
+      reachabilityFence();
+    }
+    onExecuted(query, node, source);
+  }
+
+  /**
+   * Run the given query on the given node to completion, and group the byte ranges of the captured
+   * nodes by capture. This is meant for the queries whose captures are only needed as ranges, like
+   * the folds or the outline of a document, and does not create any match or capture objects. The
+   * ranges of each capture are sorted by their start byte, and the outer ranges come first among
+   * the ranges which start at the same byte.
+   * <p>
+   * The query is run within the byte or point range set on this cursor, if any. The standard text
+   * predicates are evaluated as with {@link #exec(TSQuery, TSNode, UTF16String)}, but the predicate
+   * handlers are NOT applied. The cursor has no more matches after this call.
+   *
+   * @param query  The query to run.
+   * @param node   The node to run the query on.
+   * @param source The source text of the node's tree, or <code>null</code> to skip the evaluation
+   *               of the standard text predicates.
+   * @param flags  The <code>CAPTURE_RANGES_*</code> flags, or <code>0</code>.
+   * @return The ranges of each capture.
+   */
+  public TSCaptureRanges captureRanges(TSQuery query, TSNode node, UTF16String source, int flags) {
+    checkExecutable(query, node, source);
+    final int[] ranges;
+    try {
+      ranges = Native.captureRanges(getNativeObject(), query.getNativeObject(), node,
+        source == null ? 0 : source.getNativeObject(), flags);
+    } finally {
+      reachabilityFence();
+      if (source != null) {
+        source.reachabilityFence();
+      }
+    }
+    onExecuted(query, node, source);
+    return new TSCaptureRanges(query, ranges);
+  }
+
+  /**
+   * Run the given query on the given node to completion in parallel, and get all its captures in
+   * document order, as packed capture records in the same format as {@link #nextCaptures(int[])}.
+   * The node is split into byte-range shards aligned to the start of its children, and each shard
+   * is run with its own native query cursor on a native thread pool. The calling thread takes part
+   * in running the shards, and this method blocks until all of them are complete.
+   * <p>
+   * The captures are the same as the ones returned by {@link #nextCaptures(int[])} after executing
+   * the query on the whole node, including the captures of the matches spanning several shards.
+   * Nodes smaller than a few kilobytes are not split. The match limit of this cursor applies to each
+   * shard, while its byte and point ranges are not used. The standard text predicates are evaluated
+   * as with {@link #exec(TSQuery, TSNode, UTF16String)}, but the predicate handlers are NOT
+   * applied. This cursor is not executed by this method.
+   * <p>
+   * The tree and the source must not be modified until this method returns.
+   *
+   * @param query     The query to run.
+   * @param node      The node to run the query on, usually the root node.
+   * @param source    The source text of the node's tree, or <code>null</code> to skip the
+   *                  evaluation of the standard text predicates.
+   * @param maxShards The maximum number of shards, or <code>0</code> to use as many shards as
+   *                  there are threads to run them.
+   * @return The packed capture records, {@link #CAPTURE_RECORD_SIZE} values for each capture.
+   */
+  public int[] execParallel(TSQuery query, TSNode node, UTF16String source, int maxShards) {
+    if (maxShards < 0) {
+      throw new IllegalArgumentException("maxShards must not be negative: " + maxShards);
+    }
+
+    checkExecutable(query, node, source);
+    try {
+      return Native.execParallel(getNativeObject(), query.getNativeObject(), node,
+        source == null ? 0 : source.getNativeObject(), maxShards);
+    } finally {
+      reachabilityFence();
+      if (source != null) {
+        source.reachabilityFence();
+      }
+    }
+  }
+
+  private void checkExecutable(TSQuery query, TSNode node, UTF16String source) {
     Objects.requireNonNull(node, "TSNode cannot be null");
     checkAccess();
     if (query == null || !query.canAccess()) {
@@ -125,12 +287,16 @@ public class TSQueryCursor extends TSNativeObject implements Iterable<TSQueryMat
 
       throw new IllegalArgumentException(msg);
     }
+    if (source != null && !source.canAccess()) {
+      throw new IllegalArgumentException("Cannot execute query with an invalid source string");
+    }
+  }
 
-    Native.exec(getNativeObject(), query.getNativeObject(), node);
-
+  private void onExecuted(TSQuery query, TSNode node, UTF16String source) {
     isExecuted = true;
     targetNode = node;
     execQuery = query;
+    execSource = source;
   }
 
   /**
@@ -179,7 +345,11 @@ public class TSQueryCursor extends TSNativeObject implements Iterable<TSQueryMat
    */
   public boolean didExceedMatchLimit() {
     checkAccess();
-    return Native.exceededMatchLimit(getNativeObject());
+    try {
+      return Native.exceededMatchLimit(getNativeObject());
+    } finally {
+      reachabilityFence();
+    }
   }
 
   /**
@@ -190,7 +360,11 @@ public class TSQueryCursor extends TSNativeObject implements Iterable<TSQueryMat
    */
   public int getMatchLimit() {
     checkAccess();
-    return Native.getMatchLimit(getNativeObject());
+    try {
+      return Native.getMatchLimit(getNativeObject());
+    } finally {
+      reachabilityFence();
+    }
   }
 
   /**
@@ -201,54 +375,117 @@ public class TSQueryCursor extends TSNativeObject implements Iterable<TSQueryMat
    */
   public void setMatchLimit(int newLimit) {
     checkAccess();
-    Native.setMatchLimit(getNativeObject(), newLimit);
+    try {
+      Native.setMatchLimit(getNativeObject(), newLimit);
+    } finally {
+      reachabilityFence();
+    }
   }
 
   public void setByteRange(int start, int end) {
     checkAccess();
-    Native.setByteRange(getNativeObject(), start, end);
+    try {
+      Native.setByteRange(getNativeObject(), start, end);
+    } finally {
+      reachabilityFence();
+    }
   }
 
   public void setPointRange(TSPoint start, TSPoint end) {
     checkAccess();
-    Native.setPointRange(getNativeObject(), start, end);
+    try {
+      Native.setPointRange(getNativeObject(), start, end);
+    } finally {
+      reachabilityFence();
+    }
   }
 
   public TSQueryMatch nextMatch() {
     checkAccess();
     checkExecuted("nextMatch");
-    final var match = Native.nextMatch(getNativeObject());
+    final TSQueryMatch match;
+    try {
+      match = Native.nextMatch(getNativeObject(), execQuery.getNativeObject(), getSourcePointer());
+    } finally {
+      reachabilityFence();
+    }
     if (match != null) {
       applyPredicates(match);
     }
     return match;
   }
 
+  /**
+   * Advance to the next capture of the currently running query. Unlike {@link #nextMatch()}, the
+   * captures are returned in the order that they appear in the document, which is what syntax
+   * highlighting needs. Use {@link TSQueryMatch#getCaptureIndex()} to get the capture that the
+   * returned match was returned for.
+   *
+   * @return The match containing the next capture, or <code>null</code> if there are no more
+   * captures.
+   */
+  public TSQueryMatch nextCapture() {
+    checkAccess();
+    checkExecuted("nextCapture");
+    final TSQueryMatch match;
+    try {
+      match = Native.nextCapture(getNativeObject(), execQuery.getNativeObject(),
+        getSourcePointer());
+    } finally {
+      reachabilityFence();
+    }
+    if (match != null) {
+      applyPredicates(match);
+    }
+    return match;
+  }
+
+  /**
+   * Drain the next captures of the currently running query, in document order, into the given
+   * buffer. Each capture is written as a record of {@link #CAPTURE_RECORD_SIZE} values, the
+   * <code>CAPTURE_*</code> constants are the offsets of the values in a record. The buffer can be
+   * reused for subsequent calls.
+   * <p>
+   * No objects are allocated for the captures, and hence the predicate handlers are NOT applied to
+   * the captures returned by this method. The standard text predicates are still evaluated if a
+   * source was provided to {@link #exec(TSQuery, TSNode, UTF16String)}.
+   *
+   * @param buffer The buffer to write the capture records to.
+   * @return The number of captures written to the buffer. This is less than
+   * <code>buffer.length / CAPTURE_RECORD_SIZE</code> only if there are no more captures.
+   */
+  public int nextCaptures(int[] buffer) {
+    Objects.requireNonNull(buffer, "buffer cannot be null");
+    checkAccess();
+    checkExecuted("nextCaptures");
+    try {
+      return Native.nextCaptures(getNativeObject(), execQuery.getNativeObject(),
+        getSourcePointer(), buffer);
+    } finally {
+      reachabilityFence();
+    }
+  }
+
+  private long getSourcePointer() {
+    if (execSource == null) {
+      return 0;
+    }
+
+    if (!execSource.canAccess()) {
+      throw new IllegalStateException("The source string of the executed query has been closed");
+    }
+
+    return execSource.getNativeObject();
+  }
+
   private void applyPredicates(TSQueryMatch match) {
-    if (match == null || execQuery == null) {
+    if (match == null || execQuery == null || predicateHandlers.isEmpty()) {
       return;
     }
 
-    final var predicates = execQuery.getPredicatesForPattern(match.getPatternIndex());
-    final var steps = new ArrayList<PredicateStep>(predicates.length);
-
-    for (final var predicate : predicates) {
-      final PredicateStep step;
-      switch (predicate.getType()) {
-        case Capture:
-          step = new PredicateStep(predicate.getType(),
-            execQuery.getCaptureNameForId(predicate.getValueId()));
-          break;
-        case String:
-          step = new PredicateStep(predicate.getType(),
-            execQuery.getStringValueForId(predicate.getValueId()));
-          break;
-        default:
-          step = new PredicateStep(predicate.getType(), "");
-          break;
-      }
-
-      steps.add(step);
+    final var steps = execQuery.getPredicateStepsForPattern(match.getPatternIndex());
+    if (steps.isEmpty()) {
+      return;
     }
 
     for (final var handler : predicateHandlers) {
@@ -258,16 +495,48 @@ public class TSQueryCursor extends TSNativeObject implements Iterable<TSQueryMat
     }
   }
 
+  /**
+   * Get a snapshot of the stats of this cursor. The stats are only recorded while they are enabled
+   * with {@link TSStats#setEnabled(boolean)}.
+   *
+   * @return The stats of this cursor.
+   */
+  public TSQueryCursorStats getStats() {
+    checkAccess();
+    try {
+      return new TSQueryCursorStats(Native.getStats(getNativeObject()));
+    } finally {
+      reachabilityFence();
+    }
+  }
+
+  /**
+   * Reset the stats of this cursor to zero.
+   */
+  public void resetStats() {
+    checkAccess();
+    try {
+      Native.resetStats(getNativeObject());
+    } finally {
+      reachabilityFence();
+    }
+  }
+
   public void removeMatch(int id) {
     checkAccess();
     checkExecuted("removeMatch");
-    Native.removeMatch(getNativeObject(), id);
+    try {
+      Native.removeMatch(getNativeObject(), id);
+    } finally {
+      reachabilityFence();
+    }
   }
 
   @Override
   public void close() {
     isExecuted = false;
     targetNode = null;
+    execSource = null;
     super.close();
   }
 
@@ -276,6 +545,11 @@ public class TSQueryCursor extends TSNativeObject implements Iterable<TSQueryMat
     Native.delete(getNativeObject());
   }
 
+  @Override
+  protected NativeDeleter getNativeDeleter() {
+    return Native::delete;
+  }
+
   protected void checkExecuted(String name) {
     if (!isExecuted) {
       throw new IllegalStateException(
@@ -311,9 +585,28 @@ public class TSQueryCursor extends TSNativeObject implements Iterable<TSQueryMat
     static native void setPointRange(long cursor, TSPoint start, TSPoint end);
 
     @FastNative
-    static native TSQueryMatch nextMatch(long cursor);
+    static native TSQueryMatch nextMatch(long cursor, long query, long source);
+
+    @FastNative
+    static native TSQueryMatch nextCapture(long cursor, long query, long source);
+
+    @FastNative
+    static native int nextCaptures(long cursor, long query, long source, int[] buffer);
 
     @FastNative
     static native void removeMatch(long cursor, int id);
+
+    // not a @FastNative method as it runs the whole query
+    static native int[] captureRanges(long cursor, long query, TSNode node, long source, int flags);
+
+    // not a @FastNative method as it blocks until all the shards are complete
+    static native int[] execParallel(long cursor, long query, TSNode node, long source,
+      int maxShards);
+
+    @FastNative
+    static native long[] getStats(long cursor);
+
+    @FastNative
+    static native void resetStats(long cursor);
   }
 }
\ No newline at end of file
@@ -0,0 +1,104 @@
+/*
+ *  This file is part of android-tree-sitter.
+ *
+ *  android-tree-sitter library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  android-tree-sitter library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *  along with android-tree-sitter.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+package com.itsaky.androidide.treesitter;
+
+/**
+ * A snapshot of the stats of a {@link TSQueryCursor}, see {@link TSQueryCursor#getStats()}. Only
+ * the calls made while the stats are enabled (see {@link TSStats#setEnabled(boolean)}) are
+ * counted.
+ *
+ * @author Akash Yadav
+ */
+public class TSQueryCursorStats {
+
+  /**
+   * The number of values in a packed query cursor stats record.
+   */
+  public static final int RECORD_SIZE = 6;
+
+  private static final int EXECUTIONS = 0;
+  private static final int MATCHES = 1;
+  private static final int CAPTURES = 2;
+  private static final int TIME = 3;
+  private static final int MATCH_LIMIT_HITS = 4;
+  private static final int PREDICATE_REJECTIONS = 5;
+
+  private final long[] values;
+
+  protected TSQueryCursorStats(long[] values) {
+    this.values = values;
+  }
+
+  /**
+   * The number of queries executed with the cursor.
+   */
+  public long getExecutionCount() {
+    return values[EXECUTIONS];
+  }
+
+  /**
+   * The number of matches returned by {@link TSQueryCursor#nextMatch()}.
+   */
+  public long getMatchCount() {
+    return values[MATCHES];
+  }
+
+  /**
+   * The number of captures returned, either as part of the matches returned by
+   * {@link TSQueryCursor#nextMatch()}, or by {@link TSQueryCursor#nextCapture()} and
+   * {@link TSQueryCursor#nextCaptures(int[])}.
+   */
+  public long getCaptureCount() {
+    return values[CAPTURES];
+  }
+
+  /**
+   * The total time spent in the native calls advancing the cursor, in nanoseconds.
+   */
+  public long getTimeNanos() {
+    return values[TIME];
+  }
+
+  /**
+   * The number of executions which exceeded the match limit of the cursor, see
+   * {@link TSQueryCursor#didExceedMatchLimit()}.
+   */
+  public long getMatchLimitHitCount() {
+    return values[MATCH_LIMIT_HITS];
+  }
+
+  /**
+   * The number of matches which were discarded as they did not satisfy the standard text
+   * predicates of the query.
+   */
+  public long getPredicateRejectionCount() {
+    return values[PREDICATE_REJECTIONS];
+  }
+
+  @Override
+  public String toString() {
+    return "TSQueryCursorStats{" +
+      "executions=" + getExecutionCount() +
+      ", matches=" + getMatchCount() +
+      ", captures=" + getCaptureCount() +
+      ", timeNanos=" + getTimeNanos() +
+      ", matchLimitHits=" + getMatchLimitHitCount() +
+      ", predicateRejections=" + getPredicateRejectionCount() +
+      '}';
+  }
+}
@@ -29,6 +29,7 @@ public class TSQueryMatch {
   protected int id;
   protected int patternIndex;
   protected TSQueryCapture[] captures;
+  protected int captureIndex = -1;
 
   protected final Metadata metadata;
 
@@ -68,6 +69,17 @@ public class TSQueryMatch {
     return captures[index];
   }
 
+  /**
+   * Get the index (in {@link #getCaptures()}) of the capture that this match was returned for by
+   * {@link TSQueryCursor#nextCapture()}.
+   *
+   * @return The capture index, or <code>-1</code> if this match was not returned by
+   * {@link TSQueryCursor#nextCapture()}.
+   */
+  public int getCaptureIndex() {
+    return captureIndex;
+  }
+
   public Metadata getMetadata() {
     return metadata;
   }
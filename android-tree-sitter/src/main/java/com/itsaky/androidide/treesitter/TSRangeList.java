@@ -0,0 +1,130 @@
+/*
+ *  This file is part of android-tree-sitter.
+ *
+ *  android-tree-sitter library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  android-tree-sitter library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *  along with android-tree-sitter.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+package com.itsaky.androidide.treesitter;
+
+import java.util.AbstractList;
+import java.util.RandomAccess;
+
+/**
+ * A list of {@link TSRange} objects backed by a flat <code>int[]</code> filled by a single native
+ * call. Each range is stored as a record of {@link #RECORD_SIZE} values : the start byte, the end
+ * byte, the start row, the start column, the end row and the end column. The {@link TSRange}
+ * objects are created lazily, when they are accessed using {@link #get(int)}. The bounds of the
+ * ranges can be read without creating the {@link TSRange} objects.
+ *
+ * @author Akash Yadav
+ */
+public class TSRangeList extends AbstractList<TSRange> implements RandomAccess {
+
+  /**
+   * The number of <code>int</code> values in a single range record.
+   */
+  public static final int RECORD_SIZE = 6;
+
+  private static final int OFFSET_START_BYTE = 0;
+  private static final int OFFSET_END_BYTE = 1;
+  private static final int OFFSET_START_ROW = 2;
+  private static final int OFFSET_START_COLUMN = 3;
+  private static final int OFFSET_END_ROW = 4;
+  private static final int OFFSET_END_COLUMN = 5;
+
+  private final int[] records;
+
+  protected TSRangeList(int[] records) {
+    this.records = records == null ? new int[0] : records;
+  }
+
+  /**
+   * Create a new {@link TSRangeList} from the given packed records.
+   *
+   * @param records The packed range records.
+   * @return The range list.
+   */
+  public static TSRangeList create(int[] records) {
+    return new TSRangeList(records);
+  }
+
+  @Override
+  public TSRange get(int index) {
+    final var offset = offsetOf(index);
+    return TSRange.create(records[offset + OFFSET_START_BYTE], records[offset + OFFSET_END_BYTE],
+      TSPoint.create(records[offset + OFFSET_START_ROW], records[offset + OFFSET_START_COLUMN]),
+      TSPoint.create(records[offset + OFFSET_END_ROW], records[offset + OFFSET_END_COLUMN]));
+  }
+
+  @Override
+  public int size() {
+    return records.length / RECORD_SIZE;
+  }
+
+  /**
+   * Get the start byte of the range at the given index.
+   */
+  public int getStartByte(int index) {
+    return records[offsetOf(index) + OFFSET_START_BYTE];
+  }
+
+  /**
+   * Get the end byte of the range at the given index.
+   */
+  public int getEndByte(int index) {
+    return records[offsetOf(index) + OFFSET_END_BYTE];
+  }
+
+  /**
+   * Get the start row of the range at the given index.
+   */
+  public int getStartRow(int index) {
+    return records[offsetOf(index) + OFFSET_START_ROW];
+  }
+
+  /**
+   * Get the start column of the range at the given index.
+   */
+  public int getStartColumn(int index) {
+    return records[offsetOf(index) + OFFSET_START_COLUMN];
+  }
+
+  /**
+   * Get the end row of the range at the given index.
+   */
+  public int getEndRow(int index) {
+    return records[offsetOf(index) + OFFSET_END_ROW];
+  }
+
+  /**
+   * Get the end column of the range at the given index.
+   */
+  public int getEndColumn(int index) {
+    return records[offsetOf(index) + OFFSET_END_COLUMN];
+  }
+
+  /**
+   * Get the packed records backing this list. The returned array must not be modified.
+   */
+  public int[] getRecords() {
+    return records;
+  }
+
+  private int offsetOf(int index) {
+    if (index < 0 || index >= size()) {
+      throw new IndexOutOfBoundsException("size=" + size() + ", index=" + index);
+    }
+    return index * RECORD_SIZE;
+  }
+}
@@ -0,0 +1,52 @@
+/*
+ *  This file is part of android-tree-sitter.
+ *
+ *  android-tree-sitter library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  android-tree-sitter library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *  along with android-tree-sitter.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+package com.itsaky.androidide.treesitter;
+
+import com.itsaky.androidide.treesitter.string.UTF16String;
+
+/**
+ * The result of {@link TSParser#reparse(TSTree, int[], UTF16String)} : the new syntax tree and
+ * the ranges whose syntactic structure changed compared to the edited old tree.
+ *
+ * @author Akash Yadav
+ */
+public class TSReparseResult {
+
+  protected final TSTree tree;
+  protected final TSRangeList changedRanges;
+
+  protected TSReparseResult(TSTree tree, TSRangeList changedRanges) {
+    this.tree = tree;
+    this.changedRanges = changedRanges;
+  }
+
+  /**
+   * Get the new syntax tree, or <code>null</code> if the parse failed or was cancelled. The caller
+   * owns the tree and must close it.
+   */
+  public TSTree getTree() {
+    return tree;
+  }
+
+  /**
+   * Get the changed ranges. The list is empty if the parse failed or was cancelled.
+   */
+  public TSRangeList getChangedRanges() {
+    return changedRanges;
+  }
+}
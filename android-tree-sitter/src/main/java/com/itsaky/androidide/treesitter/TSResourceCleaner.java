@@ -0,0 +1,158 @@
+/*
+ *  This file is part of android-tree-sitter.
+ *
+ *  android-tree-sitter library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  android-tree-sitter library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *  along with android-tree-sitter.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+package com.itsaky.androidide.treesitter;
+
+import com.itsaky.androidide.treesitter.TSNativeObject.NativeDeleter;
+import java.lang.ref.PhantomReference;
+import java.lang.ref.ReferenceQueue;
+import java.util.Collections;
+import java.util.Set;
+import java.util.concurrent.ConcurrentHashMap;
+
+/**
+ * A safety net which releases the native objects whose Java objects became unreachable without
+ * being closed. This is disabled by default, and only applies to the objects created while it is
+ * enabled, of the classes which can be released without their Java object, see
+ * {@link TSNativeObject#getNativeDeleter()}. These are the trees, the strings, the tree cursors,
+ * the query cursors and the lookahead iterators. The views of a native object which is owned by
+ * another Java object, like {@link TSNode#getTree()} and
+ * {@link com.itsaky.androidide.treesitter.string.UTF16String#synchronizedString()}, are not
+ * released when they become unreachable.
+ * <p>
+ * The unreachable objects are released on a daemon thread, after the garbage collector discovers
+ * them, or on the calling thread with {@link #releaseUnreachable()}. Each such object is counted as
+ * leaked in {@link TSLiveObjects#getLeakedCount(Class)}. Closing the objects explicitly is still
+ * preferred, as the garbage collector does not account for the native memory.
+ * <p>
+ * The methods of these classes keep their object reachable until their native call returns, see
+ * {@link TSNativeObject#reachabilityFence()}. A pointer obtained with
+ * {@link TSNativeObject#getNativeObject()} is not covered by this : it may be released as soon as
+ * its object becomes unreachable, and must not be used without keeping the object reachable.
+ * Likewise, a {@link TSNode} does not keep its tree reachable : the tree must be kept reachable
+ * while its nodes are used.
+ * <p>
+ * This does not use <code>java.lang.ref.Cleaner</code> as it is not available before API 33.
+ *
+ * @author Akash Yadav
+ */
+public final class TSResourceCleaner {
+
+  private static final ReferenceQueue<TSNativeObject> queue = new ReferenceQueue<>();
+  private static final Set<Cleanable> cleanables = Collections.newSetFromMap(
+    new ConcurrentHashMap<>());
+  private static volatile boolean enabled = false;
+  private static Thread thread;
+
+  private TSResourceCleaner() {
+    throw new UnsupportedOperationException();
+  }
+
+  /**
+   * Enable or disable releasing the unreachable native objects. Disabling this does not affect the
+   * objects which were registered while it was enabled.
+   *
+   * @param enabled Whether to enable it.
+   */
+  public static synchronized void setEnabled(boolean enabled) {
+    if (enabled && thread == null) {
+      thread = new Thread(TSResourceCleaner::run, "TSResourceCleaner");
+      thread.setDaemon(true);
+      thread.start();
+    }
+    TSResourceCleaner.enabled = enabled;
+  }
+
+  /**
+   * Whether releasing the unreachable native objects is enabled.
+   */
+  public static boolean isEnabled() {
+    return enabled;
+  }
+
+  /**
+   * Get the number of registered objects which have neither been closed nor released yet.
+   */
+  public static int getRegisteredCount() {
+    return cleanables.size();
+  }
+
+  /**
+   * Release the native objects which have already been discovered as unreachable by the garbage
+   * collector, on the calling thread.
+   *
+   * @return The number of released objects.
+   */
+  public static int releaseUnreachable() {
+    var released = 0;
+    Cleanable cleanable;
+    while ((cleanable = (Cleanable) queue.poll()) != null) {
+      if (release(cleanable)) {
+        ++released;
+      }
+    }
+    return released;
+  }
+
+  static Cleanable register(TSNativeObject object, long pointer, NativeDeleter deleter) {
+    final var cleanable = new Cleanable(object, pointer, deleter);
+    cleanables.add(cleanable);
+    return cleanable;
+  }
+
+  static void unregister(Cleanable cleanable) {
+    cleanables.remove(cleanable);
+    cleanable.clear();
+  }
+
+  private static boolean release(Cleanable cleanable) {
+    // the object may be released by both the daemon thread and releaseUnreachable()
+    if (!cleanables.remove(cleanable)) {
+      return false;
+    }
+
+    cleanable.deleter.delete(cleanable.pointer);
+    TSLiveObjects.leaked(cleanable.type, cleanable.tracked);
+    return true;
+  }
+
+  private static void run() {
+    while (true) {
+      try {
+        release((Cleanable) queue.remove());
+      } catch (Throwable err) {
+        // keep releasing the other objects
+      }
+    }
+  }
+
+  static final class Cleanable extends PhantomReference<TSNativeObject> {
+
+    final Class<?> type;
+    final boolean tracked;
+    final long pointer;
+    final NativeDeleter deleter;
+
+    Cleanable(TSNativeObject object, long pointer, NativeDeleter deleter) {
+      super(object, queue);
+      this.type = object.getClass();
+      this.tracked = object.isTracked();
+      this.pointer = pointer;
+      this.deleter = deleter;
+    }
+  }
+}
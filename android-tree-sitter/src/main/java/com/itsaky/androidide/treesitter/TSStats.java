@@ -0,0 +1,118 @@
+/*
+ *  This file is part of android-tree-sitter.
+ *
+ *  android-tree-sitter library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  android-tree-sitter library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *  along with android-tree-sitter.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+package com.itsaky.androidide.treesitter;
+
+import com.itsaky.androidide.treesitter.annotations.GenerateNativeHeaders;
+import dalvik.annotation.optimization.FastNative;
+
+/**
+ * Controls the native instrumentation of the hot paths. When enabled, the native layer counts :
+ * <ul>
+ *   <li>For each {@link TSParser} : the parses, bytes parsed, parse time, cancellations and
+ *   timeouts, see {@link TSParser#getStats()}.</li>
+ *   <li>For each {@link TSQueryCursor} : the executions, matches, captures, match limit hits and
+ *   predicate rejections, see {@link TSQueryCursor#getStats()}.</li>
+ *   <li>Globally : the objects created through the native object factory, see
+ *   {@link #getMarshallingStats()}.</li>
+ * </ul>
+ * The stats are disabled by default. The counters are lock-free and can be read from any thread,
+ * and the only overhead of the instrumentation while disabled is a single check of the flag.
+ *
+ * @author Akash Yadav
+ */
+public final class TSStats {
+
+  private TSStats() {
+    throw new UnsupportedOperationException();
+  }
+
+  /**
+   * Enable or disable the collection of the stats. The counters keep their values when the stats
+   * are disabled.
+   *
+   * @param enabled Whether the stats should be collected.
+   */
+  public static void setEnabled(boolean enabled) {
+    Native.setEnabled(enabled);
+  }
+
+  /**
+   * Whether the stats are being collected.
+   */
+  public static boolean isEnabled() {
+    return Native.isEnabled();
+  }
+
+  /**
+   * Get a snapshot of the objects created through the native object factory. The counters are
+   * global to the process.
+   */
+  public static TSMarshallingStats getMarshallingStats() {
+    return new TSMarshallingStats(Native.getMarshallingStats());
+  }
+
+  /**
+   * Reset the marshalling stats to zero.
+   */
+  public static void resetMarshallingStats() {
+    Native.resetMarshallingStats();
+  }
+
+  /**
+   * Enable or disable the tracing of the long running native operations (parses, highlighter
+   * updates, layered document parses) as atrace sections, which show up in Perfetto and systrace
+   * captures. Tracing is independent of the stats, and is only available on Android API 23 or
+   * newer.
+   *
+   * @param enabled Whether the native operations should be traced.
+   * @return Whether the tracing is enabled. This is <code>false</code> if tracing is not
+   * available.
+   */
+  public static boolean setTracingEnabled(boolean enabled) {
+    return Native.setTracingEnabled(enabled);
+  }
+
+  /**
+   * Whether the native operations are being traced.
+   */
+  public static boolean isTracingEnabled() {
+    return Native.isTracingEnabled();
+  }
+
+  @GenerateNativeHeaders(fileName = "stats")
+  private static final class Native {
+
+    @FastNative
+    static native void setEnabled(boolean enabled);
+
+    @FastNative
+    static native boolean isEnabled();
+
+    @FastNative
+    static native long[] getMarshallingStats();
+
+    @FastNative
+    static native void resetMarshallingStats();
+
+    @FastNative
+    static native boolean setTracingEnabled(boolean enabled);
+
+    @FastNative
+    static native boolean isTracingEnabled();
+  }
+}
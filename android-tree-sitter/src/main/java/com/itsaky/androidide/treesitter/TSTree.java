@@ -37,6 +37,30 @@ public class TSTree extends TSNativeObject {
     Native.delete(getNativeObject());
   }
 
+  @Override
+  protected NativeDeleter getNativeDeleter() {
+    return Native::delete;
+  }
+
+  /**
+   * Get the approximate native memory footprint of this tree. The subtrees of a tree are shared
+   * with the trees created from it with {@link #copy()}, and with the trees parsed incrementally
+   * from it, for as long as those trees are alive. The footprint reports which part of the
+   * retained memory is shared with such trees, and would hence not be freed by closing this tree.
+   * <p>
+   * This walks the whole tree, its cost is linear in the number of nodes.
+   *
+   * @return The footprint of this tree.
+   */
+  public TSTreeFootprint getFootprint() {
+    checkAccess();
+    try {
+      return new TSTreeFootprint(Native.getFootprint(getNativeObject()));
+    } finally {
+      reachabilityFence();
+    }
+  }
+
   /**
    * Get the root node of this tree.
    *
@@ -44,7 +68,11 @@ public class TSTree extends TSNativeObject {
    */
   public TSNode getRootNode() {
     checkAccess();
-    return Native.rootNode(getNativeObject());
+    try {
+      return Native.rootNode(getNativeObject());
+    } finally {
+      reachabilityFence();
+    }
   }
 
   /**
@@ -53,7 +81,11 @@ public class TSTree extends TSNativeObject {
    */
   public TSNode getRootNodeWithOffset(int offsetBytes, TSPoint offsetExtent) {
     checkAccess();
-    return Native.rootNodeWithOffset(getNativeObject(), offsetBytes, offsetExtent);
+    try {
+      return Native.rootNodeWithOffset(getNativeObject(), offsetBytes, offsetExtent);
+    } finally {
+      reachabilityFence();
+    }
   }
 
   /**
@@ -69,20 +101,49 @@ public class TSTree extends TSNativeObject {
     checkAccess();
     oldTree.checkAccess();
 
-    TSRange[] ranges = Native.changedRanges(getNativeObject(), oldTree.getNativeObject());
+    final TSRange[] ranges;
+    try {
+      ranges = Native.changedRanges(getNativeObject(), oldTree.getNativeObject());
+    } finally {
+      reachabilityFence();
+      oldTree.reachabilityFence();
+    }
+
     if (ranges == null) {
       return new TSRange[0];
     }
     return ranges;
   }
 
+  /**
+   * Same as {@link #getChangedRanges(TSTree)}, but returns the ranges as a {@link TSRangeList} which
+   * is filled by a single native call, without creating a {@link TSRange} object per range.
+   */
+  public TSRangeList getChangedRangeList(TSTree oldTree) {
+    checkAccess();
+    oldTree.checkAccess();
+    try {
+      return TSRangeList.create(
+        Native.changedRangesPacked(getNativeObject(), oldTree.getNativeObject()));
+    } finally {
+      reachabilityFence();
+      oldTree.reachabilityFence();
+    }
+  }
+
   /**
    * Get the array of included ranges that was used to parse the syntax tree.
    */
   public TSRange[] getIncludedRanges() {
     checkAccess();
 
-    TSRange[] ranges = Native.includedRanges(getNativeObject());
+    final TSRange[] ranges;
+    try {
+      ranges = Native.includedRanges(getNativeObject());
+    } finally {
+      reachabilityFence();
+    }
+
     if (ranges == null) {
       return new TSRange[0];
     }
@@ -97,7 +158,11 @@ public class TSTree extends TSNativeObject {
    */
   public TSTree copy() {
     checkAccess();
-    return TSTree.create(Native.copy(getNativeObject()));
+    try {
+      return TSTree.create(Native.copy(getNativeObject()));
+    } finally {
+      reachabilityFence();
+    }
   }
 
   /**
@@ -108,7 +173,42 @@ public class TSTree extends TSNativeObject {
   public void edit(TSInputEdit edit) {
     Objects.requireNonNull(edit, "TSInputEdit cannot be null");
     checkAccess();
-    Native.edit(getNativeObject(), edit);
+    try {
+      Native.edit(getNativeObject(), edit);
+    } finally {
+      reachabilityFence();
+    }
+  }
+
+  /**
+   * Notify that this tree has been edited with all the given edits, in order, with a single native
+   * call.
+   *
+   * @param edits The edits, packed with {@link TSInputEdit#pack(java.util.List)}.
+   */
+  public void edit(int[] edits) {
+    Objects.requireNonNull(edits, "edits cannot be null");
+    if (edits.length % TSInputEdit.RECORD_SIZE != 0) {
+      throw new IllegalArgumentException(
+        "The length of the packed edits must be a multiple of " + TSInputEdit.RECORD_SIZE);
+    }
+
+    checkAccess();
+    try {
+      Native.editPacked(getNativeObject(), edits);
+    } finally {
+      reachabilityFence();
+    }
+  }
+
+  /**
+   * Create a flattened snapshot of all the nodes in this tree.
+   *
+   * @return The snapshot. The caller must close the snapshot when it is no longer needed.
+   * @see TSTreeSnapshot
+   */
+  public TSTreeSnapshot snapshot() {
+    return TSTreeSnapshot.create(this);
   }
 
   /**
@@ -118,7 +218,13 @@ public class TSTree extends TSNativeObject {
    */
   public TSLanguage getLanguage() {
     checkAccess();
-    final var langPtr = Native.getLanguage(getNativeObject());
+    final long langPtr;
+    try {
+      langPtr = Native.getLanguage(getNativeObject());
+    } finally {
+      reachabilityFence();
+    }
+
     if (langPtr == 0) {
       return null;
     }
@@ -129,6 +235,9 @@ public class TSTree extends TSNativeObject {
   @GenerateNativeHeaders(fileName = "tree")
   private static class Native {
 
+    // not a @FastNative method as it walks the whole tree
+    static native long[] getFootprint(long tree);
+
     @FastNative
     static native void edit(long tree, TSInputEdit inputEdit);
 
@@ -147,6 +256,12 @@ public class TSTree extends TSNativeObject {
     @FastNative
     static native TSRange[] changedRanges(long tree, long oldTree);
 
+    @FastNative
+    static native int[] changedRangesPacked(long tree, long oldTree);
+
+    @FastNative
+    static native void editPacked(long tree, int[] edits);
+
     @FastNative
     static native long getLanguage(long tree);
 
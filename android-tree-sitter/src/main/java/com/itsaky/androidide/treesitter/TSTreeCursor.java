@@ -24,6 +24,56 @@ import java.util.Objects;
 
 public class TSTreeCursor extends TSNativeObject {
 
+  /**
+   * The number of <code>int</code> values in a node info record, filled by
+   * {@link #getCurrentNodeInfo(int[])} and {@link #gotoNextPreOrder(int[])}.
+   */
+  public static final int INFO_SIZE = 8;
+
+  /**
+   * The index of the symbol of the node in a node info record. The name of the symbol can be looked
+   * up in {@link TSLanguage#getSymbolNames()}.
+   */
+  public static final int INFO_SYMBOL = 0;
+
+  /**
+   * The index of the field id of the node in a node info record, <code>0</code> if the node is not a
+   * field. The name of the field can be looked up in {@link TSLanguage#getFieldNames()}.
+   */
+  public static final int INFO_FIELD_ID = 1;
+
+  /**
+   * The index of the start byte of the node in a node info record.
+   */
+  public static final int INFO_START_BYTE = 2;
+
+  /**
+   * The index of the end byte of the node in a node info record.
+   */
+  public static final int INFO_END_BYTE = 3;
+
+  /**
+   * The index of the start row of the node in a node info record.
+   */
+  public static final int INFO_START_ROW = 4;
+
+  /**
+   * The index of the start column of the node in a node info record.
+   */
+  public static final int INFO_START_COLUMN = 5;
+
+  /**
+   * The index of the depth of the node, relative to the node this cursor was created with, in a
+   * node info record.
+   */
+  public static final int INFO_DEPTH = 6;
+
+  /**
+   * The index of the flags of the node in a node info record. These are the same flags as
+   * {@link TSTreeSnapshot#getFlags(int)}.
+   */
+  public static final int INFO_FLAGS = 7;
+
   protected int context0;
   protected int context1;
   protected long id;
@@ -46,11 +96,54 @@ public class TSTreeCursor extends TSNativeObject {
     return TSTreeCursor.create(Native.newCursor(node));
   }
 
+  /**
+   * Set the maximum number of closed native cursors which are kept for reuse. Creating or copying a
+   * cursor while there are pooled cursors re-initializes one of them instead of allocating a new
+   * one. Pooling is disabled by default, and is disabled again by setting the capacity to
+   * <code>0</code>. Reducing the capacity releases the excess pooled cursors.
+   *
+   * @param capacity The maximum number of pooled cursors.
+   */
+  public static void setPoolCapacity(int capacity) {
+    if (capacity < 0) {
+      throw new IllegalArgumentException("capacity must not be negative: " + capacity);
+    }
+    Native.setPoolCapacity(capacity);
+  }
+
+  /**
+   * Get the maximum number of closed native cursors which are kept for reuse.
+   *
+   * @see #setPoolCapacity(int)
+   */
+  public static int getPoolCapacity() {
+    return Native.getPoolCapacity();
+  }
+
+  /**
+   * Get the number of closed native cursors which are currently pooled.
+   */
+  public static long getPooledCount() {
+    return Native.getPoolStats()[0];
+  }
+
+  /**
+   * Get the number of cursors which have been created (or copied) by reusing a pooled cursor.
+   */
+  public static long getPoolHits() {
+    return Native.getPoolStats()[1];
+  }
+
   @Override
   protected void closeNativeObj() {
     Native.delete(getNativeObject());
   }
 
+  @Override
+  protected NativeDeleter getNativeDeleter() {
+    return Native::delete;
+  }
+
   /**
    * Get the current node of this tree cursor.
    *
@@ -58,7 +151,11 @@ public class TSTreeCursor extends TSNativeObject {
    */
   public TSNode getCurrentNode() {
     checkAccess();
-    return Native.currentNode(getNativeObject());
+    try {
+      return Native.currentNode(getNativeObject());
+    } finally {
+      reachabilityFence();
+    }
   }
 
   /**
@@ -68,7 +165,11 @@ public class TSTreeCursor extends TSNativeObject {
    */
   public String getCurrentFieldName() {
     checkAccess();
-    return Native.currentFieldName(getNativeObject());
+    try {
+      return Native.currentFieldName(getNativeObject());
+    } finally {
+      reachabilityFence();
+    }
   }
 
   /**
@@ -78,7 +179,11 @@ public class TSTreeCursor extends TSNativeObject {
    */
   public short getCurrentFieldId() {
     checkAccess();
-    return Native.currentFieldId(getNativeObject());
+    try {
+      return Native.currentFieldId(getNativeObject());
+    } finally {
+      reachabilityFence();
+    }
   }
 
   /**
@@ -88,7 +193,11 @@ public class TSTreeCursor extends TSNativeObject {
    */
   public TSTreeCursorNode getCurrentTreeCursorNode() {
     checkAccess();
-    return Native.currentTreeCursorNode(getNativeObject());
+    try {
+      return Native.currentTreeCursorNode(getNativeObject());
+    } finally {
+      reachabilityFence();
+    }
   }
 
   /**
@@ -98,7 +207,11 @@ public class TSTreeCursor extends TSNativeObject {
    */
   public boolean gotoFirstChild() {
     checkAccess();
-    return Native.gotoFirstChild(getNativeObject());
+    try {
+      return Native.gotoFirstChild(getNativeObject());
+    } finally {
+      reachabilityFence();
+    }
   }
 
   /**
@@ -110,7 +223,11 @@ public class TSTreeCursor extends TSNativeObject {
    */
   public long gotoFirstChildForByte(int byteIndex) {
     checkAccess();
-    return Native.gotoFirstChildForByte(getNativeObject(), byteIndex);
+    try {
+      return Native.gotoFirstChildForByte(getNativeObject(), byteIndex);
+    } finally {
+      reachabilityFence();
+    }
   }
 
   /**
@@ -121,7 +238,11 @@ public class TSTreeCursor extends TSNativeObject {
    */
   public boolean gotoFirstChildForPoint(TSPoint point) {
     checkAccess();
-    return Native.gotoFirstChildForPoint(getNativeObject(), point);
+    try {
+      return Native.gotoFirstChildForPoint(getNativeObject(), point);
+    } finally {
+      reachabilityFence();
+    }
   }
 
   /**
@@ -131,7 +252,11 @@ public class TSTreeCursor extends TSNativeObject {
    */
   public boolean gotoLastChild() {
     checkAccess();
-    return Native.gotoLastChild(getNativeObject());
+    try {
+      return Native.gotoLastChild(getNativeObject());
+    } finally {
+      reachabilityFence();
+    }
   }
 
   /**
@@ -141,7 +266,11 @@ public class TSTreeCursor extends TSNativeObject {
    */
   public boolean gotoNextSibling() {
     checkAccess();
-    return Native.gotoNextSibling(getNativeObject());
+    try {
+      return Native.gotoNextSibling(getNativeObject());
+    } finally {
+      reachabilityFence();
+    }
   }
 
   /**
@@ -151,7 +280,11 @@ public class TSTreeCursor extends TSNativeObject {
    */
   public boolean gotoPreviousSibling() {
     checkAccess();
-    return Native.gotoPreviousSibling(getNativeObject());
+    try {
+      return Native.gotoPreviousSibling(getNativeObject());
+    } finally {
+      reachabilityFence();
+    }
   }
 
   /**
@@ -161,7 +294,11 @@ public class TSTreeCursor extends TSNativeObject {
    */
   public boolean gotoParent() {
     checkAccess();
-    return Native.gotoParent(getNativeObject());
+    try {
+      return Native.gotoParent(getNativeObject());
+    } finally {
+      reachabilityFence();
+    }
   }
 
   /**
@@ -170,7 +307,11 @@ public class TSTreeCursor extends TSNativeObject {
    */
   public void gotoDescendant(int descendantIndex) {
     checkAccess();
-    Native.gotoDescendant(getNativeObject(), descendantIndex);
+    try {
+      Native.gotoDescendant(getNativeObject(), descendantIndex);
+    } finally {
+      reachabilityFence();
+    }
   }
 
   /**
@@ -179,7 +320,11 @@ public class TSTreeCursor extends TSNativeObject {
    */
   public int getCurrentDescendantIndex() {
     checkAccess();
-    return Native.currentDescendantIndex(getNativeObject());
+    try {
+      return Native.currentDescendantIndex(getNativeObject());
+    } finally {
+      reachabilityFence();
+    }
   }
 
   /**
@@ -188,7 +333,11 @@ public class TSTreeCursor extends TSNativeObject {
    */
   public int getDepth() {
     checkAccess();
-    return Native.depth(getNativeObject());
+    try {
+      return Native.depth(getNativeObject());
+    } finally {
+      reachabilityFence();
+    }
   }
 
   /**
@@ -197,7 +346,11 @@ public class TSTreeCursor extends TSNativeObject {
   public void reset(TSNode node) {
     Objects.requireNonNull(node, "TSNode cannot be null");
     checkAccess();
-    Native.reset(getNativeObject(), node);
+    try {
+      Native.reset(getNativeObject(), node);
+    } finally {
+      reachabilityFence();
+    }
   }
 
   /**
@@ -209,7 +362,86 @@ public class TSTreeCursor extends TSNativeObject {
   public void resetTo(TSTreeCursor another) {
     checkAccess();
     another.checkAccess();
-    Native.resetTo(getNativeObject(), another.getNativeObject());
+    try {
+      Native.resetTo(getNativeObject(), another.getNativeObject());
+    } finally {
+      reachabilityFence();
+      another.reachabilityFence();
+    }
+  }
+
+  /**
+   * Fill the given array with the info of the current node, as a record of {@link #INFO_SIZE}
+   * values. See the <code>INFO_*</code> constants for the layout of the record.
+   *
+   * @param info The array to fill, at least {@link #INFO_SIZE} long.
+   */
+  public void getCurrentNodeInfo(int[] info) {
+    checkInfoArray(info);
+    checkAccess();
+    try {
+      Native.currentNodeInfo(getNativeObject(), info);
+    } finally {
+      reachabilityFence();
+    }
+  }
+
+  /**
+   * Move the cursor to the next node in pre-order and fill the given array with the info of that
+   * node, in a single native call which does not allocate. The traversal covers the subtree of the
+   * node this cursor was created with, or last reset to. Walking the whole tree looks like this :
+   * <pre>
+   *   final var info = new int[TSTreeCursor.INFO_SIZE];
+   *   final var types = language.getSymbolNames();
+   *   cursor.getCurrentNodeInfo(info);
+   *   do {
+   *     final var type = types[info[TSTreeCursor.INFO_SYMBOL]];
+   *     // ...
+   *   } while (cursor.gotoNextPreOrder(info));
+   * </pre>
+   *
+   * @param info The array to fill, at least {@link #INFO_SIZE} long.
+   * @return <code>true</code> if the cursor moved to the next node, <code>false</code> if the
+   * traversal is complete. The cursor is back at the node it was created with in that case.
+   */
+  public boolean gotoNextPreOrder(int[] info) {
+    return gotoNextPreOrder(info, Integer.MAX_VALUE, 0, Integer.MAX_VALUE);
+  }
+
+  /**
+   * Same as {@link #gotoNextPreOrder(int[])}, but only visits the nodes which intersect the given
+   * byte range, up to the given depth. The subtrees which are entirely outside the byte range are
+   * skipped without being visited.
+   *
+   * @param info      The array to fill, at least {@link #INFO_SIZE} long.
+   * @param maxDepth  The maximum depth of the visited nodes, relative to the node this cursor was
+   *                  created with.
+   * @param startByte The start of the byte range.
+   * @param endByte   The end of the byte range, exclusive.
+   * @return <code>true</code> if the cursor moved to the next node, <code>false</code> if the
+   * traversal is complete.
+   */
+  public boolean gotoNextPreOrder(int[] info, int maxDepth, int startByte, int endByte) {
+    checkInfoArray(info);
+    if (maxDepth < 0 || startByte < 0 || startByte > endByte) {
+      throw new IllegalArgumentException(
+        "Invalid filter: maxDepth=" + maxDepth + ", startByte=" + startByte + ", endByte="
+          + endByte);
+    }
+
+    checkAccess();
+    try {
+      return Native.gotoNextPreOrder(getNativeObject(), maxDepth, startByte, endByte, info);
+    } finally {
+      reachabilityFence();
+    }
+  }
+
+  private static void checkInfoArray(int[] info) {
+    Objects.requireNonNull(info, "info cannot be null");
+    if (info.length < INFO_SIZE) {
+      throw new IllegalArgumentException("info must have at least " + INFO_SIZE + " elements");
+    }
   }
 
   /**
@@ -220,7 +452,13 @@ public class TSTreeCursor extends TSNativeObject {
    */
   public TSTreeCursor copy() {
     checkAccess();
-    final var pointer = Native.copy(this.getNativeObject());
+    final long pointer;
+    try {
+      pointer = Native.copy(this.getNativeObject());
+    } finally {
+      reachabilityFence();
+    }
+
     if (pointer == 0) {
       return null;
     }
@@ -231,6 +469,15 @@ public class TSTreeCursor extends TSNativeObject {
   @GenerateNativeHeaders(fileName = "tree_cursor")
   private static class Native {
 
+    @FastNative
+    static native void setPoolCapacity(int capacity);
+
+    @FastNative
+    static native int getPoolCapacity();
+
+    @FastNative
+    static native long[] getPoolStats();
+
     @FastNative
     static native long newCursor(TSNode node);
 
@@ -287,5 +534,12 @@ public class TSTreeCursor extends TSNativeObject {
 
     @FastNative
     static native long copy(long pointer);
+
+    @FastNative
+    static native void currentNodeInfo(long pointer, int[] info);
+
+    @FastNative
+    static native boolean gotoNextPreOrder(long pointer, int maxDepth, int startByte,
+                                           int endByte, int[] info);
   }
 }
\ No newline at end of file
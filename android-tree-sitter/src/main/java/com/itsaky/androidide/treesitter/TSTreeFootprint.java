@@ -0,0 +1,110 @@
+/*
+ *  This file is part of android-tree-sitter.
+ *
+ *  android-tree-sitter library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  android-tree-sitter library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *  along with android-tree-sitter.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+package com.itsaky.androidide.treesitter;
+
+/**
+ * The approximate native memory footprint of a {@link TSTree}, see {@link TSTree#getFootprint()}.
+ * The sizes do not account for the overhead of the allocator.
+ *
+ * @author Akash Yadav
+ */
+public class TSTreeFootprint {
+
+  /**
+   * The number of values in a packed tree footprint record.
+   */
+  public static final int RECORD_SIZE = 6;
+
+  private static final int RETAINED_BYTES = 0;
+  private static final int UNIQUE_BYTES = 1;
+  private static final int SHARED_BYTES = 2;
+  private static final int NODE_COUNT = 3;
+  private static final int SUBTREE_COUNT = 4;
+  private static final int SHARED_SUBTREE_COUNT = 5;
+
+  private final long[] values;
+
+  protected TSTreeFootprint(long[] values) {
+    this.values = values;
+  }
+
+  /**
+   * The number of bytes of native memory retained by the tree.
+   */
+  public long getRetainedBytes() {
+    return values[RETAINED_BYTES];
+  }
+
+  /**
+   * The number of bytes of native memory retained only by the tree, which would be freed by
+   * closing it.
+   */
+  public long getUniqueBytes() {
+    return values[UNIQUE_BYTES];
+  }
+
+  /**
+   * The number of bytes of native memory shared with other trees.
+   */
+  public long getSharedBytes() {
+    return values[SHARED_BYTES];
+  }
+
+  /**
+   * The number of nodes in the tree, including the hidden nodes.
+   */
+  public long getNodeCount() {
+    return values[NODE_COUNT];
+  }
+
+  /**
+   * The number of nodes which are allocated separately. The other nodes are stored inline in
+   * their parent.
+   */
+  public long getSubtreeCount() {
+    return values[SUBTREE_COUNT];
+  }
+
+  /**
+   * The number of separately allocated nodes which are shared with other trees.
+   */
+  public long getSharedSubtreeCount() {
+    return values[SHARED_SUBTREE_COUNT];
+  }
+
+  /**
+   * The ratio of the separately allocated nodes which are shared with other trees, between
+   * <code>0</code> and <code>1</code>.
+   */
+  public double getSharedRatio() {
+    final var subtrees = getSubtreeCount();
+    return subtrees == 0 ? 0 : (double) getSharedSubtreeCount() / subtrees;
+  }
+
+  @Override
+  public String toString() {
+    return "TSTreeFootprint{" +
+      "retainedBytes=" + getRetainedBytes() +
+      ", uniqueBytes=" + getUniqueBytes() +
+      ", sharedBytes=" + getSharedBytes() +
+      ", nodeCount=" + getNodeCount() +
+      ", subtreeCount=" + getSubtreeCount() +
+      ", sharedSubtreeCount=" + getSharedSubtreeCount() +
+      '}';
+  }
+}
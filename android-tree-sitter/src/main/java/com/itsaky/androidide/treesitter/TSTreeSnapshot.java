@@ -0,0 +1,230 @@
+/*
+ *  This file is part of android-tree-sitter.
+ *
+ *  android-tree-sitter library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  android-tree-sitter library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *  along with android-tree-sitter.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+package com.itsaky.androidide.treesitter;
+
+import com.itsaky.androidide.treesitter.annotations.GenerateNativeHeaders;
+import dalvik.annotation.optimization.FastNative;
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+import java.nio.IntBuffer;
+import java.nio.ShortBuffer;
+
+/**
+ * A flattened, read-only snapshot of all the nodes in a {@link TSTree}. The nodes are stored in
+ * pre-order (the root node is at index <code>0</code>) in a struct-of-arrays layout, in a single
+ * block of native memory. The columns are accessed through direct buffers, so traversing the
+ * snapshot does not require any JNI calls.
+ * <p>
+ * The snapshot does not reference the tree it was created from, the tree can be edited or closed
+ * once the snapshot has been created. The snapshot must be closed when it is no longer needed.
+ *
+ * @author Akash Yadav
+ */
+public class TSTreeSnapshot extends TSNativeObject {
+
+  public static final int FLAG_NAMED = 1;
+  public static final int FLAG_EXTRA = 1 << 1;
+  public static final int FLAG_MISSING = 1 << 2;
+  public static final int FLAG_ERROR = 1 << 3;
+  public static final int FLAG_HAS_ERROR = 1 << 4;
+
+  // the order of the columns must be kept in sync with ts_tree_snapshot.cc
+  private static final int COL_START_BYTE = 0;
+  private static final int COL_END_BYTE = 1;
+  private static final int COL_START_ROW = 2;
+  private static final int COL_START_COLUMN = 3;
+  private static final int COL_END_ROW = 4;
+  private static final int COL_END_COLUMN = 5;
+  private static final int COL_PARENT = 6;
+  private static final int INT_COLUMNS = 7;
+
+  private static final int COL_SYMBOL = 0;
+  private static final int COL_FIELD_ID = 1;
+  private static final int SHORT_COLUMNS = 2;
+
+  private final TSLanguage language;
+  private final int nodeCount;
+  private final IntBuffer ints;
+  private final ShortBuffer shorts;
+  private final ByteBuffer flags;
+
+  protected TSTreeSnapshot(long pointer, TSLanguage language) {
+    super(pointer);
+    this.language = language;
+    this.nodeCount = Native.getNodeCount(pointer);
+
+    final var buffer = Native.getBuffer(pointer).order(ByteOrder.nativeOrder());
+    this.ints = slice(buffer, 0).asIntBuffer();
+    this.shorts = slice(buffer, INT_COLUMNS * nodeCount * 4).asShortBuffer();
+    this.flags = slice(buffer, (INT_COLUMNS * 4 + SHORT_COLUMNS * 2) * nodeCount);
+  }
+
+  /**
+   * Create a snapshot of the given tree.
+   *
+   * @param tree The tree to create the snapshot of.
+   * @return The snapshot.
+   */
+  public static TSTreeSnapshot create(TSTree tree) {
+    tree.checkAccess();
+    final long pointer;
+    try {
+      pointer = Native.create(tree.getNativeObject());
+    } finally {
+      tree.reachabilityFence();
+    }
+    return new TSTreeSnapshot(pointer, tree.getLanguage());
+  }
+
+  private static ByteBuffer slice(ByteBuffer buffer, int offset) {
+    buffer.position(offset);
+    return buffer.slice().order(ByteOrder.nativeOrder());
+  }
+
+  /**
+   * Get the language of the tree that this snapshot was created from.
+   */
+  public TSLanguage getLanguage() {
+    return language;
+  }
+
+  /**
+   * Get the number of nodes in this snapshot.
+   */
+  public int getNodeCount() {
+    return nodeCount;
+  }
+
+  public int getStartByte(int index) {
+    return getInt(COL_START_BYTE, index);
+  }
+
+  public int getEndByte(int index) {
+    return getInt(COL_END_BYTE, index);
+  }
+
+  public int getStartRow(int index) {
+    return getInt(COL_START_ROW, index);
+  }
+
+  public int getStartColumn(int index) {
+    return getInt(COL_START_COLUMN, index);
+  }
+
+  public int getEndRow(int index) {
+    return getInt(COL_END_ROW, index);
+  }
+
+  public int getEndColumn(int index) {
+    return getInt(COL_END_COLUMN, index);
+  }
+
+  /**
+   * Get the index of the parent of the node at the given index, or <code>-1</code> for the root
+   * node.
+   */
+  public int getParent(int index) {
+    return getInt(COL_PARENT, index);
+  }
+
+  public short getSymbol(int index) {
+    return getShort(COL_SYMBOL, index);
+  }
+
+  /**
+   * Get the ID of the field of the node at the given index in its parent. Returns <code>0</code>
+   * if the node is not a field.
+   */
+  public short getFieldId(int index) {
+    return getShort(COL_FIELD_ID, index);
+  }
+
+  /**
+   * Get the flags of the node at the given index. This is a combination of the
+   * <code>FLAG_*</code> constants.
+   */
+  public int getFlags(int index) {
+    checkAccess();
+    return flags.get(checkIndex(index));
+  }
+
+  public boolean isNamed(int index) {
+    return (getFlags(index) & FLAG_NAMED) != 0;
+  }
+
+  public boolean isExtra(int index) {
+    return (getFlags(index) & FLAG_EXTRA) != 0;
+  }
+
+  public boolean isMissing(int index) {
+    return (getFlags(index) & FLAG_MISSING) != 0;
+  }
+
+  public boolean isError(int index) {
+    return (getFlags(index) & FLAG_ERROR) != 0;
+  }
+
+  public boolean hasError(int index) {
+    return (getFlags(index) & FLAG_HAS_ERROR) != 0;
+  }
+
+  /**
+   * Get the type of the node at the given index.
+   */
+  public String getType(int index) {
+    return language.getSymbolName(getSymbol(index));
+  }
+
+  private int getInt(int column, int index) {
+    checkAccess();
+    return ints.get(column * nodeCount + checkIndex(index));
+  }
+
+  private short getShort(int column, int index) {
+    checkAccess();
+    return shorts.get(column * nodeCount + checkIndex(index));
+  }
+
+  private int checkIndex(int index) {
+    if (index < 0 || index >= nodeCount) {
+      throw new IndexOutOfBoundsException("index=" + index + ", nodeCount=" + nodeCount);
+    }
+    return index;
+  }
+
+  @Override
+  protected void closeNativeObj() {
+    Native.delete(getNativeObject());
+  }
+
+  @GenerateNativeHeaders(fileName = "tree_snapshot")
+  private static class Native {
+
+    @FastNative
+    static native long create(long tree);
+
+    @FastNative
+    static native void delete(long pointer);
+
+    @FastNative
+    static native int getNodeCount(long pointer);
+
+    @FastNative
+    static native ByteBuffer getBuffer(long pointer);
+  }
+}
@@ -25,6 +25,20 @@ import dalvik.annotation.optimization.FastNative;
  */
 public class TreeSitter {
 
+  /**
+   * Tree-sitter allocates with the system allocator. This is the default.
+   */
+  public static final int ALLOCATOR_SYSTEM = 0;
+
+  /**
+   * Tree-sitter allocates its small objects (subtrees, parse stack nodes, most arrays) from a
+   * pool of size classes, with a per-thread cache of the freed blocks. This trades memory for
+   * throughput : the pooled memory is reused by the next trees instead of being returned to the
+   * system, which reduces the allocator time and the heap fragmentation when many short-lived
+   * trees are created (e.g. with {@link TSTree#copy()} or on every reparse).
+   */
+  public static final int ALLOCATOR_POOLED = 1;
+
   private static int sLangVer = -1, sMinCompatLangVer = -1;
 
   /**
@@ -61,6 +75,37 @@ public class TreeSitter {
     return sMinCompatLangVer;
   }
 
+  /**
+   * Set the allocator used by tree-sitter. The memory allocated by one allocator cannot be freed
+   * by another, so this must be called right after {@link #loadLibrary()}, before any parser,
+   * tree, query or cursor is created on any thread. Once {@link #ALLOCATOR_POOLED} is set, it
+   * cannot be changed.
+   *
+   * @param allocator The allocator, one of the <code>ALLOCATOR_*</code> constants.
+   * @throws IllegalArgumentException If the allocator is unknown.
+   * @throws IllegalStateException    If tree-sitter has already allocated memory with another
+   *                                  allocator.
+   */
+  public static void setAllocator(int allocator) {
+    Native.setAllocator(allocator);
+  }
+
+  /**
+   * Get the allocator used by tree-sitter, one of the <code>ALLOCATOR_*</code> constants.
+   */
+  public static int getAllocator() {
+    return Native.getAllocator();
+  }
+
+  /**
+   * Get a snapshot of the stats of the {@link #ALLOCATOR_POOLED pooled allocator}. Apart from the
+   * reserved bytes, the stats are only recorded while they are enabled with
+   * {@link TSStats#setEnabled(boolean)}.
+   */
+  public static TSAllocatorStats getAllocatorStats() {
+    return new TSAllocatorStats(Native.getAllocatorStats());
+  }
+
   @GenerateNativeHeaders(fileName = "meta")
   private static final class Native {
 
@@ -72,5 +117,14 @@ public class TreeSitter {
      */
     @FastNative
     static native int getMinimumCompatibleLanguageVersion();
+
+    @FastNative
+    static native void setAllocator(int allocator);
+
+    @FastNative
+    static native int getAllocator();
+
+    @FastNative
+    static native long[] getAllocatorStats();
   }
 }
\ No newline at end of file
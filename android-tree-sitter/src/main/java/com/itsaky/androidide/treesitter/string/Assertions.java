@@ -41,6 +41,13 @@ class Assertions {
     }
   }
 
+  public static void checkRange(int from, int to, int size) {
+    if (from < 0 || from > to || to > size) {
+      throw new IndexOutOfBoundsException(
+          "range [" + from + ", " + to + ") out of bounds, size = " + size);
+    }
+  }
+
   public static void checkStringRange(String str, int off, int len) {
     if (off < 0 || off + len > str.length()) {
       throw new StringIndexOutOfBoundsException(
@@ -18,10 +18,13 @@
 package com.itsaky.androidide.treesitter.string;
 
 import static com.itsaky.androidide.treesitter.string.Assertions.checkIndex;
+import static com.itsaky.androidide.treesitter.string.Assertions.checkRange;
 import static com.itsaky.androidide.treesitter.string.Assertions.checkStringRange;
 import static com.itsaky.androidide.treesitter.string.Assertions.checkUpperBound;
 
+import com.itsaky.androidide.treesitter.TSInputEdit;
 import com.itsaky.androidide.treesitter.TSNativeObject;
+import com.itsaky.androidide.treesitter.TSPoint;
 import com.itsaky.androidide.treesitter.annotations.DontSynchronize;
 import com.itsaky.androidide.treesitter.annotations.GenerateNativeHeaders;
 import com.itsaky.androidide.treesitter.annotations.Synchronized;
@@ -30,6 +33,14 @@ import dalvik.annotation.optimization.FastNative;
 import java.util.Objects;
 
 /**
+ * A UTF-16 string stored in native memory, which can be parsed by tree-sitter without copying it.
+ * <p>
+ * The string keeps an index of the start of its lines, so that char indices, byte indices and
+ * tree-sitter {@link TSPoint points} can be translated to each other without scanning the text.
+ * The index is built the first time it is used and is then updated incrementally by the edits, so
+ * {@link #editChars(int, int, String)} can describe an edit as a {@link TSInputEdit} in
+ * <code>O(log(lines))</code>.
+ *
  * @author Akash Yadav
  */
 @Synchronized(packagePrivateConstructor = false)
@@ -48,7 +59,11 @@ public class UTF16String extends TSNativeObject implements CharSequence {
   public byte byteAt(int index) {
     checkIndex(index, byteLength());
     checkAccess();
-    return Native.byteAt(getNativeObject(), index);
+    try {
+      return Native.byteAt(getNativeObject(), index);
+    } finally {
+      reachabilityFence();
+    }
   }
 
   /**
@@ -59,7 +74,11 @@ public class UTF16String extends TSNativeObject implements CharSequence {
   public void setByteAt(int index, byte b) {
     checkIndex(index, byteLength());
     checkAccess();
-    Native.setByteAt(getNativeObject(), index, b);
+    try {
+      Native.setByteAt(getNativeObject(), index, b);
+    } finally {
+      reachabilityFence();
+    }
   }
 
   /**
@@ -72,7 +91,11 @@ public class UTF16String extends TSNativeObject implements CharSequence {
   public char charAt(int index) {
     checkIndex(index, length());
     checkAccess();
-    return Native.chatAt(getNativeObject(), index);
+    try {
+      return Native.chatAt(getNativeObject(), index);
+    } finally {
+      reachabilityFence();
+    }
   }
 
   /**
@@ -83,7 +106,11 @@ public class UTF16String extends TSNativeObject implements CharSequence {
   public void setCharAt(int index, char c) {
     checkIndex(index, length());
     checkAccess();
-    Native.setCharAt(getNativeObject(), index, c);
+    try {
+      Native.setCharAt(getNativeObject(), index, c);
+    } finally {
+      reachabilityFence();
+    }
   }
 
   /**
@@ -97,7 +124,11 @@ public class UTF16String extends TSNativeObject implements CharSequence {
       return;
     }
     checkAccess();
-    Native.append(getNativeObject(), string);
+    try {
+      Native.append(getNativeObject(), string);
+    } finally {
+      reachabilityFence();
+    }
   }
 
   /**
@@ -111,7 +142,11 @@ public class UTF16String extends TSNativeObject implements CharSequence {
   public void append(String string, int fromIndex, int length) {
     checkStringRange(string, fromIndex, length);
     checkAccess();
-    Native.appendPart(getNativeObject(), string, fromIndex, length);
+    try {
+      Native.appendPart(getNativeObject(), string, fromIndex, length);
+    } finally {
+      reachabilityFence();
+    }
   }
 
   /**
@@ -134,7 +169,11 @@ public class UTF16String extends TSNativeObject implements CharSequence {
 
     checkIndex(index, length());
     checkAccess();
-    Native.insert(getNativeObject(), string, index);
+    try {
+      Native.insert(getNativeObject(), string, index);
+    } finally {
+      reachabilityFence();
+    }
   }
 
   /**
@@ -150,7 +189,11 @@ public class UTF16String extends TSNativeObject implements CharSequence {
     checkUpperBound(toIndex, size);
 
     checkAccess();
-    Native.deleteChars(getNativeObject(), fromIndex, toIndex);
+    try {
+      Native.deleteChars(getNativeObject(), fromIndex, toIndex);
+    } finally {
+      reachabilityFence();
+    }
   }
 
   /**
@@ -165,7 +208,11 @@ public class UTF16String extends TSNativeObject implements CharSequence {
     checkUpperBound(toIndex, size);
 
     checkAccess();
-    Native.deleteBytes(getNativeObject(), fromIndex, toIndex);
+    try {
+      Native.deleteBytes(getNativeObject(), fromIndex, toIndex);
+    } finally {
+      reachabilityFence();
+    }
   }
 
   /**
@@ -187,7 +234,11 @@ public class UTF16String extends TSNativeObject implements CharSequence {
     checkUpperBound(toIndex, size);
 
     checkAccess();
-    Native.replaceChars(getNativeObject(), fromIndex, toIndex, str);
+    try {
+      Native.replaceChars(getNativeObject(), fromIndex, toIndex, str);
+    } finally {
+      reachabilityFence();
+    }
   }
 
   /**
@@ -209,7 +260,11 @@ public class UTF16String extends TSNativeObject implements CharSequence {
     checkUpperBound(toIndex, size);
 
     checkAccess();
-    Native.replaceBytes(getNativeObject(), fromIndex, toIndex, str);
+    try {
+      Native.replaceBytes(getNativeObject(), fromIndex, toIndex, str);
+    } finally {
+      reachabilityFence();
+    }
   }
 
   /**
@@ -236,7 +291,11 @@ public class UTF16String extends TSNativeObject implements CharSequence {
     checkUpperBound(end, size);
 
     checkAccess();
-    return UTF16StringFactory.createString(Native.substring_chars(getNativeObject(), start, end));
+    try {
+      return UTF16StringFactory.createString(Native.substring_chars(getNativeObject(), start, end));
+    } finally {
+      reachabilityFence();
+    }
   }
 
   /**
@@ -264,7 +323,11 @@ public class UTF16String extends TSNativeObject implements CharSequence {
     checkUpperBound(end, size);
 
     checkAccess();
-    return UTF16StringFactory.createString(Native.substring_bytes(getNativeObject(), start, end));
+    try {
+      return UTF16StringFactory.createString(Native.substring_bytes(getNativeObject(), start, end));
+    } finally {
+      reachabilityFence();
+    }
   }
 
   /**
@@ -292,7 +355,11 @@ public class UTF16String extends TSNativeObject implements CharSequence {
     checkUpperBound(end, size);
 
     checkAccess();
-    return Native.subjstring_chars(getNativeObject(), start, end);
+    try {
+      return Native.subjstring_chars(getNativeObject(), start, end);
+    } finally {
+      reachabilityFence();
+    }
   }
 
   /**
@@ -320,7 +387,11 @@ public class UTF16String extends TSNativeObject implements CharSequence {
     checkUpperBound(end, size);
 
     checkAccess();
-    return Native.subjstring_bytes(getNativeObject(), start, end);
+    try {
+      return Native.subjstring_bytes(getNativeObject(), start, end);
+    } finally {
+      reachabilityFence();
+    }
   }
 
   /**
@@ -330,7 +401,11 @@ public class UTF16String extends TSNativeObject implements CharSequence {
    */
   public int length() {
     checkAccess();
-    return Native.length(getNativeObject());
+    try {
+      return Native.length(getNativeObject());
+    } finally {
+      reachabilityFence();
+    }
   }
 
   /**
@@ -340,7 +415,11 @@ public class UTF16String extends TSNativeObject implements CharSequence {
    */
   public int byteLength() {
     checkAccess();
-    return Native.byteLength(getNativeObject());
+    try {
+      return Native.byteLength(getNativeObject());
+    } finally {
+      reachabilityFence();
+    }
   }
 
   @Override
@@ -359,10 +438,20 @@ public class UTF16String extends TSNativeObject implements CharSequence {
     Native.erase(getNativeObject());
   }
 
+  @Override
+  @DontSynchronize
+  protected NativeDeleter getNativeDeleter() {
+    return Native::erase;
+  }
+
   @Override
   public String toString() {
     checkAccess();
-    return Native.toString(getNativeObject());
+    try {
+      return Native.toString(getNativeObject());
+    } finally {
+      reachabilityFence();
+    }
   }
 
   @Override
@@ -437,7 +526,8 @@ public class UTF16String extends TSNativeObject implements CharSequence {
   /**
    * Returns a new synchronized version of this string. Please note that the returned string will
    * still use the same native object as this string and hence, changes made to either of the
-   * strings will be reflected in both.
+   * strings will be reflected in both. The returned string keeps this string reachable, and
+   * closing it closes this string.
    *
    * @return A new synchronized version of this string, or <code>this</code> object if it is a
    * {@link SynchronizedUTF16String} instance.
@@ -446,7 +536,136 @@ public class UTF16String extends TSNativeObject implements CharSequence {
     if (this instanceof SynchronizedUTF16String) {
       return this;
     }
-    return UTF16StringFactory.createString(getNativeObject(), true);
+    final var string = UTF16StringFactory.createString(getNativeObject(), true);
+    string.markBorrowed(this);
+    return string;
+  }
+
+  /**
+   * Get the number of lines in this string. An empty string has one line.
+   */
+  public int getLineCount() {
+    checkAccess();
+    try {
+      return Native.lineCount(getNativeObject());
+    } finally {
+      reachabilityFence();
+    }
+  }
+
+  /**
+   * Get the char index of the start of the given line.
+   *
+   * @param line The line, 0-based.
+   * @return The char index of the start of the line.
+   */
+  public int getLineStart(int line) {
+    checkIndex(line, getLineCount());
+    try {
+      return Native.lineStart(getNativeObject(), line);
+    } finally {
+      reachabilityFence();
+    }
+  }
+
+  /**
+   * Get the line which contains the char at the given index.
+   *
+   * @param index The char index.
+   * @return The line, 0-based.
+   */
+  public int getLineForChar(int index) {
+    checkRange(index, index, length());
+    try {
+      return Native.lineOfChar(getNativeObject(), index);
+    } finally {
+      reachabilityFence();
+    }
+  }
+
+  /**
+   * Get the tree-sitter point of the char at the given index. The column of the point is
+   * byte-based, as expected by tree-sitter.
+   *
+   * @param index The char index.
+   * @return The point.
+   */
+  public TSPoint charToPoint(int index) {
+    checkRange(index, index, length());
+    checkAccess();
+    final long point;
+    try {
+      point = Native.pointOfChar(getNativeObject(), index);
+    } finally {
+      reachabilityFence();
+    }
+    return TSPoint.create((int) (point >>> 32), (int) point);
+  }
+
+  /**
+   * Get the tree-sitter point of the given byte index.
+   *
+   * @param byteIndex The byte index.
+   * @return The point.
+   * @see #charToPoint(int)
+   */
+  public TSPoint byteToPoint(int byteIndex) {
+    return charToPoint(byteIndex / 2);
+  }
+
+  /**
+   * Get the char index of the given tree-sitter point. Points beyond the end of their line are
+   * clamped to the end of the line, and points beyond the last line are clamped to the end of this
+   * string.
+   *
+   * @param point The point, with a byte-based column.
+   * @return The char index.
+   */
+  public int pointToChar(TSPoint point) {
+    Objects.requireNonNull(point, "point cannot be null");
+    checkAccess();
+    try {
+      return Native.charOfPoint(getNativeObject(), point.getRow(), point.getColumn());
+    } finally {
+      reachabilityFence();
+    }
+  }
+
+  /**
+   * Get the byte index of the given tree-sitter point.
+   *
+   * @param point The point, with a byte-based column.
+   * @return The byte index.
+   * @see #pointToChar(TSPoint)
+   */
+  public int pointToByte(TSPoint point) {
+    return pointToChar(point) * 2;
+  }
+
+  /**
+   * Replace the chars between the given indices with the given string and return the
+   * {@link TSInputEdit} which describes the edit, to be applied to the syntax tree of this string.
+   * The points of the edit are computed from the line index of this string.
+   * <p>
+   * Use an empty string to delete the chars, and equal indices to insert the string.
+   *
+   * @param fromIndex The index to replace from.
+   * @param toIndex   The index to replace to.
+   * @param str       The string to replace with.
+   * @return The edit.
+   */
+  public TSInputEdit editChars(int fromIndex, int toIndex, String str) {
+    Objects.requireNonNull(str, "str cannot be null");
+    checkRange(fromIndex, toIndex, length());
+    checkAccess();
+
+    final var record = new int[TSInputEdit.RECORD_SIZE];
+    try {
+      Native.editChars(getNativeObject(), fromIndex, toIndex, str, record);
+    } finally {
+      reachabilityFence();
+    }
+    return TSInputEdit.unpack(record, 0);
   }
 
   @GenerateNativeHeaders(fileName = "utf16string")
@@ -508,5 +727,23 @@ public class UTF16String extends TSNativeObject implements CharSequence {
 
     @FastNative
     static native void erase(long pointer);
+
+    @FastNative
+    static native int lineCount(long pointer);
+
+    @FastNative
+    static native int lineStart(long pointer, int line);
+
+    @FastNative
+    static native int lineOfChar(long pointer, int index);
+
+    @FastNative
+    static native long pointOfChar(long pointer, int index);
+
+    @FastNative
+    static native int charOfPoint(long pointer, int row, int column);
+
+    @FastNative
+    static native void editChars(long pointer, int start, int end, String str, int[] edit);
   }
 }
@@ -0,0 +1,132 @@
+/*
+ *  This file is part of android-tree-sitter.
+ *
+ *  android-tree-sitter library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  android-tree-sitter library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *  along with android-tree-sitter.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+package com.itsaky.androidide.treesitter;
+
+import static com.google.common.truth.Truth.assertThat;
+import static com.google.common.truth.Truth.assertWithMessage;
+import static org.junit.Assert.assertThrows;
+
+import com.itsaky.androidide.treesitter.java.TSLanguageJava;
+import com.itsaky.androidide.treesitter.string.UTF16StringFactory;
+import java.io.ByteArrayOutputStream;
+import java.io.IOException;
+import java.nio.charset.StandardCharsets;
+import java.nio.file.Paths;
+import java.util.concurrent.TimeUnit;
+import org.junit.Test;
+import org.junit.runner.RunWith;
+import org.robolectric.RobolectricTestRunner;
+
+/**
+ * @author Akash Yadav
+ */
+@RunWith(RobolectricTestRunner.class)
+public class AllocatorTest extends TreeSitterTest {
+
+  @Test
+  public void testAllocatorCannotBeChangedAfterAllocating() {
+    try (final var parser = TSParser.create()) {
+      parser.setLanguage(TSLanguageJava.getInstance());
+      parser.parseString("class Main {}").close();
+    }
+
+    assertThat(TreeSitter.getAllocator()).isEqualTo(TreeSitter.ALLOCATOR_SYSTEM);
+
+    // setting the current allocator is a no-op
+    TreeSitter.setAllocator(TreeSitter.ALLOCATOR_SYSTEM);
+
+    assertThrows(IllegalStateException.class,
+      () -> TreeSitter.setAllocator(TreeSitter.ALLOCATOR_POOLED));
+    assertThrows(IllegalArgumentException.class, () -> TreeSitter.setAllocator(42));
+    assertThat(TreeSitter.getAllocator()).isEqualTo(TreeSitter.ALLOCATOR_SYSTEM);
+  }
+
+  @Test
+  public void testAllocatorStats() {
+    final var stats = TreeSitter.getAllocatorStats();
+    assertThat(stats.getReservedBytes()).isAtLeast(0);
+    assertThat(stats.getAllocationCount()).isAtLeast(stats.getLargeAllocationCount());
+  }
+
+  @Test
+  public void testPooledAllocator() throws IOException, InterruptedException {
+    // the pool can only be installed before tree-sitter allocates anything, which has already
+    // happened in this process, so the pooled allocator is exercised in a new process
+    final var java = Paths.get(System.getProperty("java.home"), "bin", "java").toString();
+    final var process = new ProcessBuilder(java,
+      "-Djava.library.path=" + System.getProperty("java.library.path"),
+      "-cp", System.getProperty("java.class.path"),
+      PooledAllocatorProcess.class.getName())
+      .redirectErrorStream(true)
+      .start();
+
+    final var output = new ByteArrayOutputStream();
+    process.getInputStream().transferTo(output);
+    assertThat(process.waitFor(2, TimeUnit.MINUTES)).isTrue();
+    assertWithMessage(output.toString(StandardCharsets.UTF_8))
+      .that(process.exitValue())
+      .isEqualTo(0);
+  }
+
+  /**
+   * Installs the pooled allocator before any allocation, then parses, edits and reparses. Every
+   * API which frees memory allocated by tree-sitter is called, so that freeing it with the wrong
+   * allocator crashes the process.
+   */
+  public static final class PooledAllocatorProcess {
+
+    public static void main(String[] args) {
+      TreeSitter.loadLibrary();
+      TreeSitter.setAllocator(TreeSitter.ALLOCATOR_POOLED);
+      check(TreeSitter.getAllocator() == TreeSitter.ALLOCATOR_POOLED, "allocator not pooled");
+
+      final var language = TSLanguageJava.getInstance();
+      try (final var parser = TSParser.create();
+           final var query = TSQuery.create(language, "(identifier) @id");
+           final var highlighter = TSHighlighter.create(query)) {
+        parser.setLanguage(language);
+        for (int i = 0; i < 100; i++) {
+          try (final var oldSource = UTF16StringFactory.newString("class Main { void main() {} }");
+               final var newSource = UTF16StringFactory.newString("class Some { void main() {} }");
+               final var oldTree = parser.parseString(oldSource)) {
+            check(oldTree.getRootNode().getNodeString().startsWith("(program"), "bad tree");
+            oldTree.getIncludedRanges();
+            highlighter.update(oldTree, oldSource);
+
+            final var edit = TSInputEdit.create(12, 20, 20, TSPoint.create(0, 12),
+              TSPoint.create(0, 20), TSPoint.create(0, 20));
+            oldTree.edit(edit);
+            highlighter.edit(edit);
+            try (final var newTree = parser.parseString(oldTree, newSource)) {
+              check(newTree.getChangedRanges(oldTree).length > 0, "no changed ranges");
+              check(!newTree.getChangedRangeList(oldTree).isEmpty(), "no changed ranges");
+              newTree.getRootNode().getNodeString();
+              highlighter.update(newTree, newSource);
+            }
+          }
+        }
+      }
+    }
+
+    private static void check(boolean condition, String message) {
+      if (!condition) {
+        throw new AssertionError(message);
+      }
+    }
+  }
+}
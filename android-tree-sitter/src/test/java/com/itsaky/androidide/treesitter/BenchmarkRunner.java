@@ -0,0 +1,183 @@
+/*
+ *  This file is part of android-tree-sitter.
+ *
+ *  android-tree-sitter library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  android-tree-sitter library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *  along with android-tree-sitter.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+package com.itsaky.androidide.treesitter;
+
+import java.io.File;
+import java.io.IOException;
+import java.io.Writer;
+import java.nio.charset.StandardCharsets;
+import java.nio.file.Files;
+import java.util.ArrayList;
+import java.util.Arrays;
+import java.util.List;
+import java.util.Locale;
+
+/**
+ * A minimal benchmark runner for the JVM tests. Each benchmark is run for a number of warmup
+ * iterations, then timed for a number of measured iterations. The results of a suite are written as
+ * JSON to the directory set with the <code>ats.benchmark.output</code> system property, so that
+ * they can be compared across builds and devices.
+ * <p>
+ * Benchmarks are only run if the <code>ats.benchmark</code> system property is <code>true</code>
+ * (<code>./gradlew :android-tree-sitter:testDebugUnitTest -Pats.benchmark=true</code>). The number
+ * of iterations can be changed with the <code>ats.benchmark.warmup</code> and
+ * <code>ats.benchmark.iterations</code> system properties.
+ *
+ * @author Akash Yadav
+ */
+public class BenchmarkRunner {
+
+  public static final String PROP_ENABLED = "ats.benchmark";
+  public static final String PROP_OUTPUT = "ats.benchmark.output";
+  public static final String PROP_WARMUP = "ats.benchmark.warmup";
+  public static final String PROP_ITERATIONS = "ats.benchmark.iterations";
+
+  private final String suite;
+  private final int warmup;
+  private final int iterations;
+  private final List<Result> results = new ArrayList<>();
+
+  public BenchmarkRunner(String suite) {
+    this.suite = suite;
+    this.warmup = Integer.getInteger(PROP_WARMUP, 5);
+    this.iterations = Math.max(1, Integer.getInteger(PROP_ITERATIONS, 20));
+  }
+
+  /**
+   * Whether the benchmarks are enabled.
+   */
+  public static boolean isEnabled() {
+    return Boolean.getBoolean(PROP_ENABLED);
+  }
+
+  /**
+   * Run the given benchmark.
+   *
+   * @param name       The name of the benchmark.
+   * @param operations The number of operations performed by each iteration, used to report the
+   *                   time per operation.
+   * @param benchmark  The benchmark.
+   * @return The result.
+   */
+  public Result run(String name, int operations, Benchmark benchmark) throws Exception {
+    for (int i = 0; i < warmup; i++) {
+      benchmark.run(i);
+    }
+
+    final var times = new long[iterations];
+    for (int i = 0; i < iterations; i++) {
+      final var start = System.nanoTime();
+      benchmark.run(warmup + i);
+      times[i] = System.nanoTime() - start;
+    }
+
+    final var result = new Result(name, operations, times);
+    results.add(result);
+    System.out.println(result);
+    return result;
+  }
+
+  /**
+   * Write the results of this suite to <code>&lt;output&gt;/&lt;suite&gt;.json</code>, if an
+   * output directory was set.
+   */
+  public void writeResults() throws IOException {
+    final var output = System.getProperty(PROP_OUTPUT);
+    if (output == null || output.isEmpty()) {
+      return;
+    }
+
+    final var dir = new File(output);
+    if (!dir.isDirectory() && !dir.mkdirs()) {
+      throw new IOException("Unable to create directory: " + dir);
+    }
+
+    try (Writer writer = Files.newBufferedWriter(new File(dir, suite + ".json").toPath(),
+      StandardCharsets.UTF_8)) {
+      writer.write("{\n  \"suite\": \"" + suite + "\",\n");
+      writer.write("  \"warmup\": " + warmup + ",\n");
+      writer.write("  \"iterations\": " + iterations + ",\n");
+      writer.write("  \"benchmarks\": [");
+      for (int i = 0; i < results.size(); i++) {
+        writer.write(i == 0 ? "\n    " : ",\n    ");
+        writer.write(results.get(i).toJson());
+      }
+      writer.write("\n  ]\n}\n");
+    }
+  }
+
+  /**
+   * A benchmark.
+   */
+  public interface Benchmark {
+
+    /**
+     * Run a single iteration of the benchmark.
+     *
+     * @param iteration The index of the iteration, including the warmup iterations.
+     */
+    void run(int iteration) throws Exception;
+  }
+
+  /**
+   * The timings of a benchmark, in nanoseconds per iteration.
+   */
+  public static final class Result {
+
+    public final String name;
+    public final int operations;
+    public final long min;
+    public final long median;
+    public final long p90;
+    public final long max;
+    public final double mean;
+
+    Result(String name, int operations, long[] times) {
+      this.name = name;
+      this.operations = Math.max(1, operations);
+
+      final var sorted = times.clone();
+      Arrays.sort(sorted);
+      this.min = sorted[0];
+      this.median = sorted[sorted.length / 2];
+      this.p90 = sorted[Math.min(sorted.length - 1, (int) Math.ceil(sorted.length * 0.9) - 1)];
+      this.max = sorted[sorted.length - 1];
+      this.mean = Arrays.stream(sorted).average().orElse(0);
+    }
+
+    /**
+     * Get the median time per operation, in nanoseconds.
+     */
+    public double getMedianPerOperation() {
+      return (double) median / operations;
+    }
+
+    String toJson() {
+      return String.format(Locale.ROOT,
+        "{\"name\": \"%s\", \"operations\": %d, \"minNs\": %d, \"medianNs\": %d, \"p90Ns\": %d, "
+          + "\"maxNs\": %d, \"meanNs\": %.1f, \"medianNsPerOp\": %.1f}", name, operations, min,
+        median, p90, max, mean, getMedianPerOperation());
+    }
+
+    @Override
+    public String toString() {
+      return String.format(Locale.ROOT, "%-40s median %10.3f ms, %12.1f ns/op", name,
+        median / 1e6, getMedianPerOperation());
+    }
+  }
+}
@@ -45,4 +45,40 @@ public class ExternalLanguageTest extends TreeSitterTest {
       }
     }
   }
+
+  @Test
+  public void testLibraryReferencesAreCounted() throws InterruptedException {
+    String libraryPath = System.getProperty("user.dir") + "/src/test/resources/libtree-sitter-c";
+    final var lang = TSLanguage.loadLanguage(libraryPath, "c");
+    assertThat(lang).isNotNull();
+    assertThat(lang.getLibRefCount()).isEqualTo(1);
+
+    // the preload holds its own reference to the already open library
+    TSLanguage.preload(new String[]{libraryPath}, new String[]{"c"});
+    final var deadline = System.currentTimeMillis() + 5000;
+    while (lang.getLibRefCount() < 2 && System.currentTimeMillis() < deadline) {
+      Thread.sleep(10);
+    }
+    assertThat(lang.getLibRefCount()).isEqualTo(2);
+
+    TSLanguage.releasePreloaded();
+    assertThat(lang.getLibRefCount()).isEqualTo(1);
+
+    lang.close();
+    assertThat(lang.getLibRefCount()).isEqualTo(0);
+    assertThat(TSLanguageCache.get("c")).isNull();
+
+    // the library can be loaded again once it has been closed
+    try (final var reloaded = TSLanguage.loadLanguage(libraryPath, "c")) {
+      assertThat(reloaded).isNotNull();
+      assertThat(reloaded.getLibRefCount()).isEqualTo(1);
+    }
+  }
+
+  @Test
+  public void testMissingLanguage() {
+    String libraryPath = System.getProperty("user.dir") + "/src/test/resources/libtree-sitter-c";
+    assertThat(TSLanguage.loadLanguage(libraryPath, "missing")).isNull();
+    assertThat(TSLanguage.loadLanguage(libraryPath + "-missing", "c")).isNull();
+  }
 }
@@ -0,0 +1,217 @@
+/*
+ *  This file is part of android-tree-sitter.
+ *
+ *  android-tree-sitter library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  android-tree-sitter library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *  along with android-tree-sitter.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+package com.itsaky.androidide.treesitter;
+
+import static com.google.common.truth.Truth.assertThat;
+
+import com.itsaky.androidide.treesitter.java.TSLanguageJava;
+import com.itsaky.androidide.treesitter.string.UTF16String;
+import com.itsaky.androidide.treesitter.string.UTF16StringFactory;
+import java.util.ArrayList;
+import java.util.List;
+import java.util.TreeSet;
+import org.junit.Test;
+import org.junit.runner.RunWith;
+import org.robolectric.RobolectricTestRunner;
+
+/**
+ * @author Akash Yadav
+ */
+@RunWith(RobolectricTestRunner.class)
+public class HighlighterTest extends TreeSitterTest {
+
+  private static final String QUERY = "((identifier) @constant (#match? @constant \"^[A-Z_]+$\"))\n"
+    + "(identifier) @variable\n"
+    + "(string_literal) @string\n"
+    + "(integral_type) @type\n"
+    + "(block_comment) @comment";
+
+  @Test
+  public void testIncrementalUpdatesMatchFullHighlight() {
+    assertIncrementalUpdates("class Main {\n  int x = 1;\n  String s = \"a\";\n}", new String[][]{
+      // rename x to MAX, matching the #match? predicate
+      {"x", "MAX"},
+      // add a new field
+      {"String s", "long y = 2;\n  String s"},
+      // edit the string literal
+      {"\"a\"", "\"abc\""},
+      // delete the first field
+      {"int MAX = 1;\n  ", ""},
+    });
+  }
+
+  @Test
+  public void testIncrementalUpdatesWithLongSpans() {
+    final var comment = new StringBuilder("/*\n");
+    for (int i = 0; i < 20; i++) {
+      comment.append(" * line ").append(i).append(" of a comment longer than a short span\n");
+    }
+    comment.append(" */");
+
+    final var fields = new StringBuilder();
+    for (int i = 0; i < 40; i++) {
+      fields.append("  int f").append(i).append(" = ").append(i).append(";\n");
+    }
+
+    assertIncrementalUpdates("class Main {\n  " + comment + "\n" + fields + "  String s = \"a\";\n}",
+      new String[][]{
+        // shrink the comment to a short span, and grow it again
+        {comment.substring(2, comment.length() - 2), " short "},
+        {"/* short */", comment.toString()},
+        // edit inside the long comment, and the spans after it
+        {"line 3 ", "line three "},
+        {"int f0", "int FF"},
+        // edit far from the previous edit
+        {"\"a\"", "\"abc\""},
+        {"int f39", "long f39"},
+        // edits before and after a run of spans, in a single update
+        {"int f10", "int GG", "int f30", "int HH"},
+      });
+  }
+
+  private static void assertIncrementalUpdates(String text, String[][] edits) {
+    final var language = TSLanguageJava.getInstance();
+    try (final var parser = TSParser.create();
+         final var query = TSQuery.create(language, QUERY);
+         final var highlighter = TSHighlighter.create(query);
+         final var source = UTF16StringFactory.newString(text)) {
+      parser.setLanguage(language);
+
+      var tree = parser.parseString(source);
+      var diff = highlighter.update(tree, source);
+      assertThat(diff.getRemoved().size()).isEqualTo(0);
+      var spans = toList(diff.getAdded());
+      assertThat(spans).isEqualTo(toList(highlighter.getSpans()));
+      assertThat(spans).isEqualTo(fullHighlight(query, tree, source));
+
+      for (final var edit : edits) {
+        // each pair of strings is an edit, all of them are applied before the update
+        for (int i = 0; i < edit.length; i += 2) {
+          final var index = source.toString().indexOf(edit[i]);
+          assertThat(index).isAtLeast(0);
+          final var inputEdit = source.editChars(index, index + edit[i].length(), edit[i + 1]);
+          tree.edit(inputEdit);
+          highlighter.edit(inputEdit);
+          spans = shift(spans, inputEdit);
+        }
+
+        final var newTree = parser.parseString(tree, source);
+        tree.close();
+        tree = newTree;
+
+        diff = highlighter.update(tree, source);
+        assertThat(diff.isEmpty()).isFalse();
+
+        // applying the diff to the previous spans, in the coordinates of the
+        // new tree, must give the new spans
+        for (int i = 0; i < diff.getRemoved().size(); i++) {
+          assertThat(spans.remove(spanAt(diff.getRemoved(), i))).isTrue();
+        }
+        spans.addAll(toList(diff.getAdded()));
+        spans.sort(null);
+
+        assertThat(spans).isEqualTo(toList(highlighter.getSpans()));
+        assertThat(spans).isEqualTo(fullHighlight(query, tree, source));
+      }
+
+      tree.close();
+    }
+  }
+
+  @Test
+  public void testUpdateWithoutChanges() {
+    final var language = TSLanguageJava.getInstance();
+    try (final var parser = TSParser.create();
+         final var query = TSQuery.create(language, QUERY);
+         final var highlighter = TSHighlighter.create(query);
+         final var source = UTF16StringFactory.newString("class Main { int x = 1; }")) {
+      parser.setLanguage(language);
+      try (final var tree = parser.parseString(source);
+           final var newTree = parser.parseString(tree, source)) {
+        assertThat(highlighter.update(tree, source).getAdded().size()).isGreaterThan(0);
+        assertThat(highlighter.update(newTree, source).isEmpty()).isTrue();
+      }
+    }
+  }
+
+  /**
+   * Get the spans of the whole tree with a plain query cursor.
+   */
+  private static List<String> fullHighlight(TSQuery query, TSTree tree, UTF16String source) {
+    final var spans = new TreeSet<String>();
+    try (final var cursor = TSQueryCursor.create()) {
+      cursor.exec(query, tree.getRootNode(), source);
+      final var buffer = new int[64 * TSQueryCursor.CAPTURE_RECORD_SIZE];
+      int count;
+      do {
+        count = cursor.nextCaptures(buffer);
+        for (int i = 0; i < count; i++) {
+          final var offset = i * TSQueryCursor.CAPTURE_RECORD_SIZE;
+          spans.add(span(buffer[offset + TSQueryCursor.CAPTURE_START_BYTE],
+            buffer[offset + TSQueryCursor.CAPTURE_END_BYTE],
+            buffer[offset + TSQueryCursor.CAPTURE_ID],
+            buffer[offset + TSQueryCursor.CAPTURE_PATTERN_INDEX]));
+        }
+      } while (count == buffer.length / TSQueryCursor.CAPTURE_RECORD_SIZE);
+    }
+    return new ArrayList<>(spans);
+  }
+
+  /**
+   * Move the given spans the same way as the highlighter moves its spans for the given edit.
+   */
+  private static List<String> shift(List<String> spans, TSInputEdit edit) {
+    final var result = new ArrayList<String>();
+    for (final var span : spans) {
+      final var values = span.split("-");
+      result.add(span(shift(Integer.parseInt(values[0]), edit),
+        shift(Integer.parseInt(values[1]), edit), Integer.parseInt(values[2]),
+        Integer.parseInt(values[3])));
+    }
+    result.sort(null);
+    return result;
+  }
+
+  private static int shift(int offset, TSInputEdit edit) {
+    if (offset >= edit.getOldEndByte()) {
+      return offset - edit.getOldEndByte() + edit.getNewEndByte();
+    }
+    if (offset > edit.getStartByte()) {
+      return Math.min(offset, edit.getNewEndByte());
+    }
+    return offset;
+  }
+
+  private static List<String> toList(TSHighlightSpans spans) {
+    final var result = new ArrayList<String>();
+    for (int i = 0; i < spans.size(); i++) {
+      result.add(spanAt(spans, i));
+    }
+    return result;
+  }
+
+  private static String spanAt(TSHighlightSpans spans, int index) {
+    return span(spans.getStartByte(index), spans.getEndByte(index), spans.getCaptureId(index),
+      spans.getPatternIndex(index));
+  }
+
+  private static String span(int startByte, int endByte, int captureId, int patternIndex) {
+    // zero-padded so that the natural order of the strings is the order of the spans
+    return String.format("%08d-%08d-%04d-%04d", startByte, endByte, captureId, patternIndex);
+  }
+}
@@ -0,0 +1,360 @@
+/*
+ *  This file is part of android-tree-sitter.
+ *
+ *  android-tree-sitter library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  android-tree-sitter library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *  along with android-tree-sitter.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+package com.itsaky.androidide.treesitter;
+
+import static com.google.common.truth.Truth.assertThat;
+import static com.itsaky.androidide.treesitter.ResourceUtils.readResource;
+
+import com.itsaky.androidide.treesitter.java.TSLanguageJava;
+import com.itsaky.androidide.treesitter.json.TSLanguageJson;
+import com.itsaky.androidide.treesitter.kotlin.TSLanguageKotlin;
+import com.itsaky.androidide.treesitter.string.UTF16String;
+import com.itsaky.androidide.treesitter.string.UTF16StringFactory;
+import com.itsaky.androidide.treesitter.xml.TSLanguageXml;
+import java.util.List;
+import java.util.Random;
+import org.junit.AfterClass;
+import org.junit.Assume;
+import org.junit.Before;
+import org.junit.BeforeClass;
+import org.junit.Test;
+import org.junit.runner.RunWith;
+import org.robolectric.RobolectricTestRunner;
+
+/**
+ * Benchmarks of the JNI layer : full parses, incremental reparses, highlight queries, tree
+ * traversals and {@link UTF16String} edits, on the test corpora. The Kotlin and JSON corpora are
+ * generated. Skipped unless enabled, see {@link BenchmarkRunner}.
+ *
+ * @author Akash Yadav
+ */
+@RunWith(RobolectricTestRunner.class)
+public class JniBenchmarkTest extends TreeSitterTest {
+
+  private static final int EDITS_PER_ITERATION = 50;
+
+  private static BenchmarkRunner runner;
+  private static String viewJava;
+  private static String codeEditorJava;
+  private static String testXml;
+  private static String generatedKotlin;
+  private static String generatedJson;
+
+  @BeforeClass
+  public static void setupRunner() {
+    runner = new BenchmarkRunner(JniBenchmarkTest.class.getSimpleName());
+    viewJava = readResource("View.java.txt");
+    codeEditorJava = readResource("CodeEditor.java.txt");
+    testXml = readResource("test.xml");
+    generatedKotlin = generateKotlin(500);
+    generatedJson = generateJson(3000);
+  }
+
+  @AfterClass
+  public static void writeResults() throws Exception {
+    if (BenchmarkRunner.isEnabled()) {
+      runner.writeResults();
+    }
+  }
+
+  @Before
+  public void checkEnabled() {
+    Assume.assumeTrue("Benchmarks are disabled", BenchmarkRunner.isEnabled());
+  }
+
+  @Test
+  public void benchmarkFullParse() throws Exception {
+    try (final var parser = TSParser.create();
+         final var view = UTF16StringFactory.newString(viewJava);
+         final var editor = UTF16StringFactory.newString(codeEditorJava);
+         final var xml = UTF16StringFactory.newString(testXml);
+         final var kotlin = UTF16StringFactory.newString(generatedKotlin);
+         final var json = UTF16StringFactory.newString(generatedJson)) {
+      parser.setLanguage(TSLanguageJava.getInstance());
+      runner.run("parse/java/View.java", 1, i -> parser.parseString(view).close());
+      runner.run("parse/java/CodeEditor.java", 1, i -> parser.parseString(editor).close());
+
+      parser.setLanguage(TSLanguageXml.getInstance());
+      runner.run("parse/xml/test.xml", 1, i -> parser.parseString(xml).close());
+
+      parser.setLanguage(TSLanguageKotlin.getInstance());
+      runner.run("parse/kotlin/generated.kt", 1, i -> parser.parseString(kotlin).close());
+
+      parser.setLanguage(TSLanguageJson.getInstance());
+      runner.run("parse/json/generated.json", 1, i -> parser.parseString(json).close());
+    }
+  }
+
+  @Test
+  public void benchmarkIncrementalReparse() throws Exception {
+    try (final var parser = TSParser.create();
+         final var source = UTF16StringFactory.newString(viewJava)) {
+      parser.setLanguage(TSLanguageJava.getInstance());
+      final var tree = new TSTree[]{parser.parseString(source)};
+      final var random = new Random(42);
+
+      // insert and delete a line comment at random lines, reparsing after each edit
+      runner.run("reparse/java/View.java", EDITS_PER_ITERATION * 2, i -> {
+        for (int j = 0; j < EDITS_PER_ITERATION; j++) {
+          final var start = source.getLineStart(random.nextInt(source.getLineCount()));
+          tree[0] = reparse(parser, tree[0], source, source.editChars(start, start, "//\n"));
+          tree[0] = reparse(parser, tree[0], source, source.editChars(start, start + 3, ""));
+        }
+      });
+
+      runner.run("reparse/java/View.java/packed", EDITS_PER_ITERATION, i -> {
+        for (int j = 0; j < EDITS_PER_ITERATION; j++) {
+          final var start = source.getLineStart(random.nextInt(source.getLineCount()));
+          final var edit = source.editChars(start, start, " ");
+          final var result = parser.reparse(tree[0], TSInputEdit.pack(List.of(edit)), source);
+          tree[0].close();
+          tree[0] = result.getTree();
+        }
+      });
+
+      tree[0].close();
+    }
+
+    benchmarkLineReparse("reparse/kotlin/generated.kt", TSLanguageKotlin.getInstance(),
+      generatedKotlin, "//\n");
+    benchmarkLineReparse("reparse/json/generated.json", TSLanguageJson.getInstance(),
+      generatedJson, "\n");
+  }
+
+  /**
+   * Insert and delete the given text at the start of random lines, reparsing after each edit.
+   */
+  private static void benchmarkLineReparse(String name, TSLanguage language, String text,
+                                           String insertion) throws Exception {
+    try (final var parser = TSParser.create();
+         final var source = UTF16StringFactory.newString(text)) {
+      parser.setLanguage(language);
+      final var tree = new TSTree[]{parser.parseString(source)};
+      final var random = new Random(42);
+      final var length = insertion.length();
+
+      runner.run(name, EDITS_PER_ITERATION * 2, i -> {
+        for (int j = 0; j < EDITS_PER_ITERATION; j++) {
+          final var start = source.getLineStart(random.nextInt(source.getLineCount()));
+          tree[0] = reparse(parser, tree[0], source, source.editChars(start, start, insertion));
+          tree[0] = reparse(parser, tree[0], source, source.editChars(start, start + length, ""));
+        }
+      });
+
+      tree[0].close();
+    }
+  }
+
+  @Test
+  public void benchmarkHighlightQuery() throws Exception {
+    final var language = TSLanguageJava.getInstance();
+    try (final var parser = TSParser.create();
+         final var source = UTF16StringFactory.newString(viewJava);
+         final var query = TSQuery.create(language, readResource("highlights-java.scm"))) {
+      parser.setLanguage(language);
+      try (final var tree = parser.parseString(source)) {
+        final var buffer = new int[TSQueryCursor.CAPTURE_RECORD_SIZE * 256];
+        final var count = new int[1];
+        runner.run("query/highlights/View.java/nextCaptures", 1, i -> {
+          try (final var cursor = TSQueryCursor.create()) {
+            cursor.exec(query, tree.getRootNode(), source);
+            count[0] = 0;
+            for (int n = cursor.nextCaptures(buffer); n > 0; n = cursor.nextCaptures(buffer)) {
+              count[0] += n;
+            }
+          }
+        });
+        assertThat(count[0]).isGreaterThan(0);
+
+        runner.run("query/highlights/View.java/nextCapture", 1, i -> {
+          try (final var cursor = TSQueryCursor.create()) {
+            cursor.exec(query, tree.getRootNode(), source);
+            while (cursor.nextCapture() != null) {
+              // consume the captures
+            }
+          }
+        });
+
+        runner.run("query/highlights/View.java/highlighter", 1, i -> {
+          try (final var highlighter = TSHighlighter.create(query)) {
+            highlighter.update(tree, source);
+          }
+        });
+      }
+    }
+  }
+
+  @Test
+  public void benchmarkIncrementalHighlight() throws Exception {
+    final var language = TSLanguageJava.getInstance();
+    try (final var parser = TSParser.create();
+         final var source = UTF16StringFactory.newString(viewJava);
+         final var query = TSQuery.create(language, readResource("highlights-java.scm"));
+         final var highlighter = TSHighlighter.create(query)) {
+      parser.setLanguage(language);
+      final var tree = new TSTree[]{parser.parseString(source)};
+      highlighter.update(tree[0], source);
+
+      final var random = new Random(42);
+      runner.run("highlight/incremental/View.java", EDITS_PER_ITERATION, i -> {
+        for (int j = 0; j < EDITS_PER_ITERATION; j++) {
+          final var start = source.getLineStart(random.nextInt(source.getLineCount()));
+          final var edit = source.editChars(start, start, "x");
+          highlighter.edit(edit);
+          tree[0] = reparse(parser, tree[0], source, edit);
+          highlighter.update(tree[0], source);
+        }
+      });
+
+      tree[0].close();
+    }
+  }
+
+  @Test
+  public void benchmarkTraversal() throws Exception {
+    try (final var parser = TSParser.create()) {
+      parser.setLanguage(TSLanguageJava.getInstance());
+      try (final var tree = parser.parseString(viewJava)) {
+        final var nodeCount = tree.getRootNode().getDescendantCount();
+
+        runner.run("traversal/View.java/cursor", nodeCount, i -> {
+          try (final var cursor = tree.getRootNode().walk()) {
+            var visited = 0;
+            do {
+              cursor.getCurrentNode().getType();
+              ++visited;
+            } while (gotoNextPreOrder(cursor));
+            assertThat(visited).isEqualTo(nodeCount);
+          }
+        });
+
+        final var info = new int[TSTreeCursor.INFO_SIZE];
+        final var names = TSLanguageJava.getInstance().getSymbolNames();
+        runner.run("traversal/View.java/preOrderInfo", nodeCount, i -> {
+          try (final var cursor = tree.getRootNode().walk()) {
+            cursor.getCurrentNodeInfo(info);
+            var visited = 0;
+            do {
+              if (names[info[TSTreeCursor.INFO_SYMBOL]] != null) {
+                ++visited;
+              }
+            } while (cursor.gotoNextPreOrder(info));
+            assertThat(visited).isEqualTo(nodeCount);
+          }
+        });
+
+        runner.run("traversal/View.java/snapshot", nodeCount, i -> {
+          try (final var snapshot = TSTreeSnapshot.create(tree)) {
+            long sum = 0;
+            for (int node = 0; node < snapshot.getNodeCount(); node++) {
+              sum += snapshot.getSymbol(node);
+            }
+            assertThat(sum).isNotEqualTo(-1);
+          }
+        });
+      }
+    }
+  }
+
+  @Test
+  public void benchmarkStringEdits() throws Exception {
+    final var random = new Random(42);
+    try (final var source = UTF16StringFactory.newString(viewJava)) {
+      runner.run("string/View.java/insertDelete", EDITS_PER_ITERATION * 2, i -> {
+        for (int j = 0; j < EDITS_PER_ITERATION; j++) {
+          final var index = random.nextInt(source.length());
+          source.insert(index, "hello");
+          source.delete(index, index + 5);
+        }
+      });
+
+      runner.run("string/View.java/editChars", EDITS_PER_ITERATION, i -> {
+        for (int j = 0; j < EDITS_PER_ITERATION; j++) {
+          final var index = random.nextInt(source.length() - 5);
+          source.editChars(index, index + 5, source.substringChars(index, index + 5));
+        }
+      });
+
+      runner.run("string/View.java/toString", 1, i -> source.toString());
+      runner.run("string/View.java/create", 1,
+        i -> UTF16StringFactory.newString(viewJava).close());
+    }
+  }
+
+  private static String generateKotlin(int classes) {
+    final var builder = new StringBuilder("package com.example.benchmark\n\n");
+    for (int i = 0; i < classes; i++) {
+      builder.append("data class Item").append(i).append("(val id: Int, val name: String?)\n\n")
+        .append("class Repository").append(i).append(" {\n")
+        .append("  private val items = mutableListOf<Item").append(i).append(">()\n\n")
+        .append("  fun add(item: Item").append(i).append(") {\n")
+        .append("    items.add(item)\n")
+        .append("  }\n\n")
+        .append("  fun find(id: Int): Item").append(i).append("? {\n")
+        .append("    return items.firstOrNull { it.id == id }\n")
+        .append("  }\n\n")
+        .append("  fun describe(id: Int): String = when (id) {\n")
+        .append("    0 -> \"none\"\n")
+        .append("    else -> \"item ${find(id)?.name ?: id} of ${items.size}\"\n")
+        .append("  }\n")
+        .append("}\n\n");
+    }
+    return builder.toString();
+  }
+
+  private static String generateJson(int objects) {
+    final var random = new Random(42);
+    final var builder = new StringBuilder("[\n");
+    for (int i = 0; i < objects; i++) {
+      builder.append("  {\n")
+        .append("    \"id\": ").append(i).append(",\n")
+        .append("    \"name\": \"item ").append(i).append("\",\n")
+        .append("    \"enabled\": ").append(random.nextBoolean()).append(",\n")
+        .append("    \"score\": ").append(random.nextDouble()).append(",\n")
+        .append("    \"tags\": [\"tag").append(random.nextInt(10)).append("\", \"tag")
+        .append(random.nextInt(10)).append("\"],\n")
+        .append("    \"parent\": null,\n")
+        .append("    \"size\": {\n")
+        .append("      \"width\": ").append(random.nextInt(1000)).append(",\n")
+        .append("      \"height\": ").append(random.nextInt(1000)).append("\n")
+        .append("    }\n")
+        .append("  }").append(i == objects - 1 ? "\n" : ",\n");
+    }
+    return builder.append("]\n").toString();
+  }
+
+  private static TSTree reparse(TSParser parser, TSTree tree, UTF16String source,
+                                TSInputEdit edit) {
+    tree.edit(edit);
+    final var newTree = parser.parseString(tree, source);
+    tree.close();
+    return newTree;
+  }
+
+  private static boolean gotoNextPreOrder(TSTreeCursor cursor) {
+    if (cursor.gotoFirstChild() || cursor.gotoNextSibling()) {
+      return true;
+    }
+    while (cursor.gotoParent()) {
+      if (cursor.gotoNextSibling()) {
+        return true;
+      }
+    }
+    return false;
+  }
+}
@@ -0,0 +1,133 @@
+/*
+ *  This file is part of android-tree-sitter.
+ *
+ *  android-tree-sitter library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  android-tree-sitter library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *  along with android-tree-sitter.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+package com.itsaky.androidide.treesitter;
+
+import static com.google.common.truth.Truth.assertThat;
+
+import com.itsaky.androidide.treesitter.java.TSLanguageJava;
+import com.itsaky.androidide.treesitter.string.UTF16String;
+import com.itsaky.androidide.treesitter.string.UTF16StringFactory;
+import com.itsaky.androidide.treesitter.xml.TSLanguageXml;
+import org.junit.Test;
+import org.junit.runner.RunWith;
+import org.robolectric.RobolectricTestRunner;
+
+/**
+ * @author Akash Yadav
+ */
+@RunWith(RobolectricTestRunner.class)
+public class LayeredDocumentTest extends TreeSitterTest {
+
+  private static final String INJECTIONS =
+    "((string_literal) @injection.content (#set! injection.language \"xml\"))";
+
+  @Test
+  public void testLayersAreReparsedOnlyWhenTheirRangesChange() {
+    try (final var injections = TSQuery.create(TSLanguageJava.getInstance(), INJECTIONS);
+         final var document = TSLayeredDocument.create(TSLanguageJava.getInstance(), injections);
+         final var source = UTF16StringFactory.newString(
+           "class Main {\n  String s = \"<a></a>\";\n}")) {
+      document.addLanguage("xml", TSLanguageXml.getInstance());
+      assertThat(document.parse(source)).isTrue();
+
+      assertThat(document.getLayerCount()).isEqualTo(1);
+      assertThat(document.getLayerLanguageName(0)).isEqualTo("xml");
+      assertThat(document.getLayerLanguage(0)).isEqualTo(TSLanguageXml.getInstance());
+      assertThat(document.isLayerReparsed(0)).isTrue();
+      assertLiteralRanges(document, source, 1);
+
+      // rename the class, outside the injected range
+      edit(document, source, "Main", "Other");
+      assertThat(document.parse(source)).isTrue();
+      assertThat(document.getLayerCount()).isEqualTo(1);
+      assertThat(document.isLayerReparsed(0)).isFalse();
+      assertLiteralRanges(document, source, 1);
+
+      // edit the injected string
+      edit(document, source, "<a></a>", "<b></b>");
+      assertThat(document.parse(source)).isTrue();
+      assertThat(document.isLayerReparsed(0)).isTrue();
+      assertLiteralRanges(document, source, 1);
+
+      // add another injected string
+      edit(document, source, "\n}", "\n  String t = \"<c/>\";\n}");
+      assertThat(document.parse(source)).isTrue();
+      assertThat(document.isLayerReparsed(0)).isTrue();
+      assertLiteralRanges(document, source, 2);
+
+      // remove all the injected strings
+      edit(document, source, source.toString(), "class Main {}");
+      assertThat(document.parse(source)).isTrue();
+      assertThat(document.getLayerCount()).isEqualTo(0);
+    }
+  }
+
+  @Test
+  public void testUnregisteredLanguagesAreIgnored() {
+    try (final var injections = TSQuery.create(TSLanguageJava.getInstance(), INJECTIONS);
+         final var document = TSLayeredDocument.create(TSLanguageJava.getInstance(), injections);
+         final var source = UTF16StringFactory.newString("class Main { String s = \"<a/>\"; }")) {
+      assertThat(document.getTree()).isNull();
+      assertThat(document.parse(source)).isTrue();
+      assertThat(document.getLayerCount()).isEqualTo(0);
+      try (final var tree = document.getTree()) {
+        assertThat(tree.getRootNode().getType()).isEqualTo("program");
+      }
+    }
+  }
+
+  @Test
+  public void testPackedIncludedRanges() {
+    try (final var parser = TSParser.create()) {
+      parser.setLanguage(TSLanguageXml.getInstance());
+      final var ranges = TSRangeList.create(new int[]{2, 10, 0, 2, 0, 10, 20, 30, 0, 20, 0, 30});
+      assertThat(parser.setIncludedRanges(ranges)).isTrue();
+      assertThat(parser.getIncludedRangeList().getRecords()).isEqualTo(ranges.getRecords());
+
+      // overlapping ranges are rejected
+      assertThat(parser.setIncludedRanges(
+        TSRangeList.create(new int[]{0, 10, 0, 0, 0, 10, 5, 15, 0, 5, 0, 15}))).isFalse();
+    }
+  }
+
+  private static void edit(TSLayeredDocument document, UTF16String source, String from, String to) {
+    final var index = source.toString().indexOf(from);
+    document.edit(source.editChars(index, index + from.length(), to));
+  }
+
+  private static void assertLiteralRanges(TSLayeredDocument document, UTF16String source,
+                                          int count) {
+    final var ranges = document.getLayerRanges(0);
+    assertThat(ranges.size()).isEqualTo(count);
+
+    final var text = source.toString();
+    var from = 0;
+    for (int i = 0; i < count; i++) {
+      final var start = text.indexOf('"', from);
+      final var end = text.indexOf('"', start + 1) + 1;
+      assertThat(ranges.getStartByte(i)).isEqualTo(start * 2);
+      assertThat(ranges.getEndByte(i)).isEqualTo(end * 2);
+      from = end;
+    }
+
+    try (final var tree = document.getLayerTree(0)) {
+      assertThat(tree).isNotNull();
+      assertThat(tree.getRootNode().getStartByte()).isAtLeast(ranges.getStartByte(0));
+    }
+  }
+}
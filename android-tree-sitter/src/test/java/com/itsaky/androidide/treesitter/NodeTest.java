@@ -21,6 +21,7 @@ import static com.google.common.truth.Truth.assertThat;
 import static com.itsaky.androidide.treesitter.string.UTF16StringFactory.newString;
 
 import com.itsaky.androidide.treesitter.python.TSLanguagePython;
+import java.util.stream.Collectors;
 import org.junit.Test;
 import org.junit.runner.RunWith;
 import org.robolectric.RobolectricTestRunner;
@@ -130,4 +131,37 @@ public class NodeTest extends TreeSitterTest {
       }
     }
   }
+
+  @Test
+  public void testBatchedChildrenAndDescendants() {
+    try (TSParser parser = TSParser.create()) {
+      parser.setLanguage(TSLanguagePython.getInstance());
+      final var sourceToParse = newString("def foo(bar, baz):\n  print(bar)\n  print(baz)");
+      try (TSTree tree = parser.parseString(sourceToParse)) {
+        final var function = tree.getRootNode().getChild(0);
+
+        final var children = function.getChildren();
+        assertThat(children).hasSize(function.getChildCount());
+        for (int i = 0; i < children.size(); i++) {
+          assertThat(children.get(i).isEqualTo(function.getChild(i))).isTrue();
+          assertThat(children.getStartByte(i)).isEqualTo(function.getChild(i).getStartByte());
+        }
+
+        final var namedChildren = function.getNamedChildren();
+        assertThat(namedChildren).hasSize(function.getNamedChildCount());
+        assertThat(namedChildren.get(0).getType()).isEqualTo("identifier");
+
+        // the second 'print(baz)' call starts at char 34
+        final var descendants = tree.getRootNode().getNamedDescendantsInByteRange(34 * 2, 44 * 2);
+        final var types = descendants.stream().map(TSNode::getType).collect(Collectors.toList());
+        assertThat(types).containsAtLeast("function_definition", "block", "expression_statement",
+          "call", "argument_list").inOrder();
+        for (int i = 0; i < descendants.size(); i++) {
+          final var node = descendants.get(i);
+          assertThat(node.getEndByte()).isGreaterThan(34 * 2);
+          assertThat(node.getStartByte()).isLessThan(44 * 2);
+        }
+      }
+    }
+  }
 }
@@ -0,0 +1,224 @@
+/*
+ *  This file is part of android-tree-sitter.
+ *
+ *  android-tree-sitter library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  android-tree-sitter library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *  along with android-tree-sitter.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+package com.itsaky.androidide.treesitter;
+
+import static com.google.common.truth.Truth.assertThat;
+import static com.itsaky.androidide.treesitter.ResourceUtils.readResource;
+
+import com.itsaky.androidide.treesitter.java.TSLanguageJava;
+import com.itsaky.androidide.treesitter.string.UTF16String;
+import com.itsaky.androidide.treesitter.string.UTF16StringFactory;
+import java.io.File;
+import java.io.IOException;
+import java.nio.charset.StandardCharsets;
+import java.nio.file.Files;
+import java.util.ArrayList;
+import java.util.concurrent.Executors;
+import java.util.concurrent.Future;
+import java.util.concurrent.TimeUnit;
+import org.junit.Rule;
+import org.junit.Test;
+import org.junit.rules.TemporaryFolder;
+import org.junit.runner.RunWith;
+import org.robolectric.RobolectricTestRunner;
+
+/**
+ * @author Akash Yadav
+ */
+@RunWith(RobolectricTestRunner.class)
+public class ParserPoolTest extends TreeSitterTest {
+
+  @Rule
+  public final TemporaryFolder tempFolder = new TemporaryFolder();
+
+  @Test
+  public void testConcurrentParsing() throws Exception {
+    try (final var pool = TSParserPool.create(TSLanguageJava.getInstance(), 2)) {
+      final var executor = Executors.newFixedThreadPool(4);
+      try {
+        final var results = new ArrayList<Future<String>>();
+        for (int i = 0; i < 32; i++) {
+          final var source = "class Main" + i + " { void main() {} }";
+          results.add(executor.submit(() -> {
+            try (final var parser = pool.acquire()) {
+              assertThat(parser.getLanguage().getNativeObject()).isEqualTo(
+                TSLanguageJava.getInstance().getNativeObject());
+              try (final var tree = parser.parseString(source)) {
+                return tree.getRootNode().getChild(0).getChildByFieldName("name").getType();
+              }
+            }
+          }));
+        }
+
+        for (final var result : results) {
+          assertThat(result.get()).isEqualTo("identifier");
+        }
+      } finally {
+        executor.shutdown();
+      }
+
+      assertThat(pool.getSize()).isAtMost(2);
+      assertThat(pool.getIdleCount()).isEqualTo(pool.getSize());
+    }
+  }
+
+  @Test
+  public void testAcquireWhenExhausted() {
+    try (final var pool = TSParserPool.create(TSLanguageJava.getInstance(), 1)) {
+      final var parser = pool.tryAcquire();
+      assertThat(parser).isNotNull();
+      assertThat(pool.tryAcquire()).isNull();
+      assertThat(pool.acquire(10, TimeUnit.MILLISECONDS)).isNull();
+
+      // the parser is reset when it is returned to the pool
+      parser.setTimeout(1000);
+      parser.close();
+      assertThat(pool.getIdleCount()).isEqualTo(1);
+
+      try (final var reused = pool.tryAcquire()) {
+        assertThat(reused).isNotNull();
+        assertThat(reused.getTimeout()).isEqualTo(0);
+      }
+    }
+  }
+
+  @Test
+  public void testCloseParserAfterPool() {
+    final var pool = TSParserPool.create(TSLanguageJava.getInstance(), 2);
+    final var parser = pool.acquire();
+    pool.close();
+
+    // acquired parsers remain usable after the pool is closed
+    try (final var tree = parser.parseString("class Main {}")) {
+      assertThat(tree.getRootNode().getType()).isEqualTo("program");
+    }
+    parser.close();
+  }
+
+  @Test
+  public void testParseBatch() {
+    final var sources = new UTF16String[24];
+    for (int i = 0; i < sources.length; i++) {
+      sources[i] = UTF16StringFactory.newString(
+        "class Main" + i + " { void m" + i + "() { int x = " + i + "; } }");
+    }
+
+    try (final var pool = TSParserPool.create(TSLanguageJava.getInstance(), 4);
+         final var parser = TSParser.create()) {
+      parser.setLanguage(TSLanguageJava.getInstance());
+
+      final var trees = pool.parseBatch(sources);
+      assertThat(trees).hasLength(sources.length);
+
+      for (int i = 0; i < sources.length; i++) {
+        try (final var tree = trees[i]; final var expected = parser.parseString(sources[i])) {
+          assertThat(tree).isNotNull();
+          assertThat(tree.getRootNode().getNodeString()).isEqualTo(
+            expected.getRootNode().getNodeString());
+        }
+      }
+
+      assertThat(pool.getSize()).isAtMost(4);
+      assertThat(pool.getIdleCount()).isEqualTo(pool.getSize());
+      assertThat(pool.parseBatch()).isEmpty();
+    } finally {
+      for (final var source : sources) {
+        source.close();
+      }
+    }
+  }
+
+  @Test
+  public void testParseBatchAfterCancellation() throws Exception {
+    try (final var pool = TSParserPool.create(TSLanguageJava.getInstance(), 1);
+         final var source = UTF16StringFactory.newString(readResource("View.java.txt"))) {
+      final var parser = pool.acquire();
+      final var executor = Executors.newSingleThreadExecutor();
+      try {
+        // retry until the cancellation lands while the parse is in progress
+        var cancelled = false;
+        for (int i = 0; i < 10 && !cancelled; i++) {
+          final var parseFuture = executor.submit(() -> parser.parseString(source));
+          while (!parser.isParsing() && !parseFuture.isDone()) {
+            Thread.onSpinWait();
+          }
+
+          cancelled = parser.requestCancellationAsync();
+          final var tree = parseFuture.get();
+          if (tree != null) {
+            tree.close();
+          }
+        }
+        assertThat(cancelled).isTrue();
+      } finally {
+        executor.shutdownNow();
+        parser.close();
+      }
+
+      // the batch reuses the parser which was cancelled
+      final var trees = pool.parseBatch(source, source);
+      assertThat(pool.getSize()).isEqualTo(1);
+      assertThat(trees).hasLength(2);
+      for (int i = 0; i < trees.length; i++) {
+        try (final var tree = trees[i]) {
+          assertThat(tree).isNotNull();
+          assertThat(tree.getRootNode().getEndByte()).isEqualTo(source.byteLength());
+        }
+      }
+    }
+  }
+
+  @Test
+  public void testParseFileBatch() throws IOException {
+    final var files = new File[8];
+    for (int i = 0; i < files.length; i++) {
+      files[i] = tempFolder.newFile("Main" + i + ".java");
+      Files.write(files[i].toPath(),
+        ("class Main" + i + " { void main() {} }").getBytes(StandardCharsets.UTF_8));
+    }
+
+    try (final var pool = TSParserPool.create(TSLanguageJava.getInstance(), 3)) {
+      final var result = pool.parseFileBatch(files, TSInputEncoding.TSInputEncodingUTF8);
+      assertThat(result.getErrorCount()).isEqualTo(0);
+      final var trees = result.getTrees();
+      assertThat(trees).hasLength(files.length);
+      for (int i = 0; i < trees.length; i++) {
+        try (final var tree = trees[i]) {
+          final var name = tree.getRootNode().getChild(0).getChildByFieldName("name");
+          assertThat(name.getEndByte() - name.getStartByte()).isEqualTo(("Main" + i).length());
+        }
+      }
+
+      // a missing file does not fail the other files
+      final var withMissing = new File[]{files[0], new File(tempFolder.getRoot(), "Missing.java"),
+        files[1]};
+      final var partial = pool.parseFileBatch(withMissing, TSInputEncoding.TSInputEncodingUTF8);
+      assertThat(partial.getErrorCount()).isEqualTo(1);
+      assertThat(partial.getError(0)).isNull();
+      assertThat(partial.getError(1)).hasMessageThat().contains("Missing.java");
+      assertThat(partial.getError(2)).isNull();
+      assertThat(partial.getTrees()[1]).isNull();
+      try (final var first = partial.getTrees()[0]; final var last = partial.getTrees()[2]) {
+        assertThat(first.getRootNode().hasErrors()).isFalse();
+        assertThat(last.getRootNode().hasErrors()).isFalse();
+      }
+
+      assertThat(pool.getIdleCount()).isEqualTo(pool.getSize());
+    }
+  }
+}
@@ -28,7 +28,11 @@ import com.itsaky.androidide.treesitter.kotlin.TSLanguageKotlin;
 import com.itsaky.androidide.treesitter.log.TSLanguageLog;
 import com.itsaky.androidide.treesitter.python.TSLanguagePython;
 import com.itsaky.androidide.treesitter.string.UTF16StringFactory;
+import java.io.File;
+import java.io.IOException;
 import java.io.UnsupportedEncodingException;
+import java.nio.charset.StandardCharsets;
+import java.nio.file.Files;
 import java.util.ArrayList;
 import java.util.HashMap;
 import java.util.List;
@@ -39,7 +43,9 @@ import java.util.concurrent.TimeUnit;
 import java.util.stream.Collectors;
 import org.junit.After;
 import org.junit.Before;
+import org.junit.Rule;
 import org.junit.Test;
+import org.junit.rules.TemporaryFolder;
 import org.junit.runner.RunWith;
 import org.mockito.ArgumentMatchers;
 import org.mockito.MockedStatic;
@@ -49,6 +55,9 @@ import org.robolectric.RobolectricTestRunner;
 @RunWith(RobolectricTestRunner.class)
 public class ParserTest extends TreeSitterTest {
 
+  @Rule
+  public final TemporaryFolder tempFolder = new TemporaryFolder();
+
   private MockedStatic<TextUtils> mockedTextUtils;
 
   @Before
@@ -109,6 +118,37 @@ public class ParserTest extends TreeSitterTest {
     }
   }
 
+  @Test
+  public void testParseInputAndChunks() {
+    final var source = readResource("View.java.txt");
+    try (final var parser = TSParser.create()) {
+      parser.setLanguage(TSLanguageJava.getInstance());
+
+      final String expected;
+      try (final var tree = parser.parseString(source)) {
+        expected = tree.getRootNode().getNodeString();
+      }
+
+      try (final var tree = parser.parseInput((charOffset, buffer) -> {
+        final var count = Math.max(0, Math.min(buffer.length, source.length() - charOffset));
+        source.getChars(charOffset, charOffset + count, buffer, 0);
+        return count;
+      })) {
+        assertThat(tree).isNotNull();
+        assertThat(tree.getRootNode().getNodeString()).isEqualTo(expected);
+      }
+
+      final var mid = source.length() / 2;
+      try (final var first = UTF16StringFactory.newString(source.substring(0, mid));
+           final var empty = UTF16StringFactory.newString();
+           final var second = UTF16StringFactory.newString(source.substring(mid));
+           final var tree = parser.parseChunks(null, first, empty, second)) {
+        assertThat(tree).isNotNull();
+        assertThat(tree.getRootNode().getNodeString()).isEqualTo(expected);
+      }
+    }
+  }
+
   @Test
   public void testTimeout() throws UnsupportedEncodingException {
     final var timeout = 1000L; // 1 millisecond
@@ -341,6 +381,63 @@ public class ParserTest extends TreeSitterTest {
     }
   }
 
+  @Test
+  public void testParseProgress() throws Exception {
+    try (final var parser = TSParser.create();
+         final var source = UTF16StringFactory.newString(readResource("View.java.txt"))) {
+      parser.setLanguage(TSLanguageJava.getInstance());
+      assertThat(parser.getParseProgress()).isEqualTo(0);
+
+      try (final var tree = parser.parseString(source)) {
+        assertThat(tree).isNotNull();
+        assertThat(parser.getParseProgress()).isEqualTo(source.byteLength());
+      }
+
+      // a parse which stops early reports only the part of the source it has read
+      parser.setTimeout(1000);
+      try (final var tree = parser.parseString(source)) {
+        assertThat(tree).isNull();
+        assertThat(parser.getParseProgress()).isLessThan((long) source.byteLength());
+      }
+      parser.setTimeout(0);
+      parser.reset();
+
+      final var executor = Executors.newSingleThreadExecutor();
+      try {
+        // cancel and restart the parse repeatedly, as the editor does while typing
+        for (int i = 0; i < 10; i++) {
+          final var parseFuture = executor.submit(() -> parser.parseString(source));
+          while (parser.getParseProgress() == 0 || !parser.isParsing()) {
+            if (parseFuture.isDone()) {
+              break;
+            }
+            Thread.onSpinWait();
+          }
+
+          final var cancelled = parser.requestCancellationAsync();
+          try (final var tree = parseFuture.get()) {
+            // the parse may complete after the cancellation is requested, but
+            // it only returns no tree if it was cancelled
+            if (tree == null) {
+              assertThat(cancelled).isTrue();
+            } else {
+              assertThat(tree.getRootNode().getEndByte()).isEqualTo(source.byteLength());
+            }
+          }
+        }
+      } finally {
+        executor.shutdownNow();
+      }
+
+      // a cancellation does not affect the next parse
+      assertThat(parser.requestCancellationAsync()).isFalse();
+      try (final var tree = parser.parseString(source)) {
+        assertThat(tree).isNotNull();
+        assertThat(parser.getParseProgress()).isEqualTo(source.byteLength());
+      }
+    }
+  }
+
   @Test
   public void testParserParseCallShouldFailIfAnotherParseIsInProgress() {
     try (final var parser = TSParser.create(); final var mainParseContent = UTF16StringFactory.newString()) {
@@ -598,6 +695,51 @@ public class ParserTest extends TreeSitterTest {
     }
   }
 
+  @Test
+  public void testParseFile() throws IOException {
+    final var source = "class Main { void main() { var s = \"\u00e9t\u00e9\"; } }";
+    final var utf8 = tempFolder.newFile("Main.java");
+    final var utf16 = tempFolder.newFile("Main16.java");
+    Files.write(utf8.toPath(), source.getBytes(StandardCharsets.UTF_8));
+    Files.write(utf16.toPath(), source.getBytes(StandardCharsets.UTF_16LE));
+
+    try (final var parser = TSParser.create()) {
+      parser.setLanguage(TSLanguageJava.getInstance());
+      try (final var expected = parser.parseString(source);
+           final var fromUtf8 = parser.parseFile(utf8, TSInputEncoding.TSInputEncodingUTF8);
+           final var fromUtf16 = parser.parseFile(utf16, TSInputEncoding.TSInputEncodingUTF16)) {
+        final var expectedString = expected.getRootNode().getNodeString();
+        assertThat(fromUtf8.getRootNode().getNodeString()).isEqualTo(expectedString);
+        assertThat(fromUtf16.getRootNode().getNodeString()).isEqualTo(expectedString);
+
+        // byte offsets are offsets in the file
+        assertThat(fromUtf8.getRootNode().getEndByte()).isEqualTo(
+          source.getBytes(StandardCharsets.UTF_8).length);
+        assertThat(fromUtf16.getRootNode().getEndByte()).isEqualTo(
+          expected.getRootNode().getEndByte());
+      }
+
+      try (final var empty = parser.parseFile(tempFolder.newFile("Empty.java"),
+        TSInputEncoding.TSInputEncodingUTF8)) {
+        assertThat(empty.getRootNode().getType()).isEqualTo("program");
+        assertThat(empty.getRootNode().getEndByte()).isEqualTo(0);
+      }
+
+      final var missing = new File(tempFolder.getRoot(), "Missing.java");
+      try {
+        parser.parseFile(missing, TSInputEncoding.TSInputEncodingUTF8);
+        throw new AssertionError("Expected an IOException");
+      } catch (IOException err) {
+        assertThat(err.getMessage()).contains("Missing.java");
+      }
+
+      // the parser can still be used after a failure
+      try (final var tree = parser.parseFile(utf8, TSInputEncoding.TSInputEncodingUTF8)) {
+        assertThat(tree.getRootNode().hasErrors()).isFalse();
+      }
+    }
+  }
+
   private static Map<String, List<TSNode>> execQueryGroupByCaptures(String querySource,
                                                                     TSLanguage language, TSNode node
   ) {
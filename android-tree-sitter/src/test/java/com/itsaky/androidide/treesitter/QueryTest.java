@@ -22,10 +22,14 @@ import static com.itsaky.androidide.treesitter.TestUtils.readString;
 import static java.nio.file.Paths.get;
 
 import com.itsaky.androidide.treesitter.java.TSLanguageJava;
+import com.itsaky.androidide.treesitter.string.UTF16String;
 import com.itsaky.androidide.treesitter.string.UTF16StringFactory;
 import com.itsaky.androidide.treesitter.xml.TSLanguageXml;
 import java.nio.file.Paths;
+import java.util.ArrayList;
+import java.util.List;
 import java.util.NoSuchElementException;
+import java.util.stream.Collectors;
 import org.junit.Test;
 import org.junit.runner.RunWith;
 import org.robolectric.RobolectricTestRunner;
@@ -140,6 +144,215 @@ public class QueryTest extends TreeSitterTest {
     }
   }
 
+  @Test
+  public void testNextCaptures() {
+    try (final var parser = TSParser.create()) {
+      parser.setLanguage(TSLanguageJava.getInstance());
+      try (final var tree = parser.parseString(
+        readString(get("./src/test/resources/View.java.txt"))); final var query = TSQuery.create(
+        tree.getLanguage(), readString(get("./src/test/resources/highlights-java.scm")))) {
+
+        final var expected = new ArrayList<List<Integer>>();
+        try (final var cursor = TSQueryCursor.create()) {
+          cursor.exec(query, tree.getRootNode());
+          TSQueryMatch match;
+          while ((match = cursor.nextCapture()) != null) {
+            assertThat(match.getCaptureIndex()).isAtLeast(0);
+            final var capture = match.getCapture(match.getCaptureIndex());
+            expected.add(List.of(capture.getIndex(), match.getPatternIndex(),
+              capture.getNode().getStartByte(), capture.getNode().getEndByte()));
+          }
+        }
+
+        assertThat(expected).isNotEmpty();
+
+        final var actual = new ArrayList<List<Integer>>();
+        try (final var cursor = TSQueryCursor.create()) {
+          cursor.exec(query, tree.getRootNode());
+
+          // use a small buffer so that the captures are drained in multiple batches
+          final var buffer = new int[TSQueryCursor.CAPTURE_RECORD_SIZE * 7];
+          int count;
+          do {
+            count = cursor.nextCaptures(buffer);
+            for (int i = 0; i < count; i++) {
+              final var offset = i * TSQueryCursor.CAPTURE_RECORD_SIZE;
+              actual.add(List.of(buffer[offset + TSQueryCursor.CAPTURE_ID],
+                buffer[offset + TSQueryCursor.CAPTURE_PATTERN_INDEX],
+                buffer[offset + TSQueryCursor.CAPTURE_START_BYTE],
+                buffer[offset + TSQueryCursor.CAPTURE_END_BYTE]));
+            }
+          } while (count == buffer.length / TSQueryCursor.CAPTURE_RECORD_SIZE);
+        }
+
+        assertThat(actual).containsExactlyElementsIn(expected).inOrder();
+
+        // captures must be returned in document order
+        for (int i = 1; i < actual.size(); i++) {
+          assertThat(actual.get(i).get(2)).isAtLeast(actual.get(i - 1).get(2));
+        }
+      }
+    }
+  }
+
+  @Test
+  public void testNativeTextPredicates() {
+    final var lang = TSLanguageJava.getInstance();
+    try (final var parser = TSParser.create(); final var source = UTF16StringFactory.newString(
+      "class Main { int FOO = 1; int bar = 2; int baz = 3; }")) {
+      parser.setLanguage(lang);
+      try (final var tree = parser.parseString(source)) {
+        assertThat(matchedTexts(tree, source, true,
+          "((identifier) @id (#match? @id \"^[A-Z]+$\"))")).containsExactly("FOO");
+        assertThat(matchedTexts(tree, source, true,
+          "((identifier) @id (#not-match? @id \"^[A-Z]\"))")).containsExactly("bar", "baz");
+        assertThat(matchedTexts(tree, source, true,
+          "((identifier) @id (#eq? @id \"bar\"))")).containsExactly("bar");
+        assertThat(matchedTexts(tree, source, true,
+          "((identifier) @id (#not-eq? @id \"bar\"))")).containsExactly("Main", "FOO", "baz");
+        assertThat(matchedTexts(tree, source, true,
+          "((identifier) @id (#any-of? @id \"baz\" \"Main\"))")).containsExactly("Main", "baz");
+        assertThat(matchedTexts(tree, source, true,
+          "((identifier) @id (#not-any-of? @id \"baz\" \"Main\"))")).containsExactly("FOO",
+          "bar");
+
+        // predicates are not evaluated without the source
+        assertThat(matchedTexts(tree, source, false,
+          "((identifier) @id (#eq? @id \"bar\"))")).hasSize(4);
+      }
+    }
+  }
+
+  @Test
+  public void testUnsupportedRegexRejectsMatches() {
+    final var lang = TSLanguageJava.getInstance();
+    try (final var parser = TSParser.create(); final var source = UTF16StringFactory.newString(
+      "class Main { int FOO = 1; int bar = 2; }")) {
+      parser.setLanguage(lang);
+      try (final var tree = parser.parseString(source)) {
+        // inline flags are only supported at the start of the pattern
+        assertThat(matchedTexts(tree, source, true,
+          "((identifier) @id (#match? @id \"^b(?i)AR$\"))")).isEmpty();
+        assertThat(matchedTexts(tree, source, true,
+          "((identifier) @id (#not-match? @id \"^b(?i)AR$\"))")).isEmpty();
+
+        // other patterns of the query are not affected
+        assertThat(matchedTexts(tree, source, true,
+          "((identifier) @id (#match? @id \"^b(?i)AR$\")) "
+            + "((identifier) @id (#match? @id \"^(?i)foo$\"))")).containsExactly("FOO");
+      }
+    }
+  }
+
+  private static List<String> matchedTexts(TSTree tree, UTF16String source,
+                                           boolean evaluatePredicates, String querySource) {
+    try (final var query = TSQuery.create(tree.getLanguage(), querySource);
+         final var cursor = TSQueryCursor.create()) {
+      assertThat(query.getErrorType()).isEqualTo(TSQueryError.None);
+      final var predicateSource = evaluatePredicates ? source : null;
+      cursor.exec(query, tree.getRootNode(), predicateSource);
+
+      final var result = new ArrayList<String>();
+      for (final var match : cursor) {
+        final var node = match.getCapture(0).getNode();
+        result.add(source.substringBytes(node.getStartByte(), node.getEndByte()));
+      }
+
+      // the batched captures must agree with the matches
+      cursor.exec(query, tree.getRootNode(), predicateSource);
+      final var buffer = new int[TSQueryCursor.CAPTURE_RECORD_SIZE * 16];
+      assertThat(cursor.nextCaptures(buffer)).isEqualTo(result.size());
+      return result;
+    }
+  }
+
+  @Test
+  public void testPredicateStepsAreCached() {
+    try (final var query = TSQuery.create(TSLanguageJava.getInstance(),
+      "((identifier) @id (#eq? @id \"main\") (#set! \"key\" \"value\"))\n(identifier) @other")) {
+      assertThat(query.getErrorType()).isEqualTo(TSQueryError.None);
+      assertThat(query.getPatternCount()).isEqualTo(2);
+
+      final var steps = query.getPredicateStepsForPattern(0);
+      assertThat(steps).isSameInstanceAs(query.getPredicateStepsForPattern(0));
+      assertThat(steps.stream().map(step -> step.value).collect(Collectors.toList())).containsExactly(
+        "eq?", "id", "main", "", "set!", "key", "value", "").inOrder();
+
+      final var predicates = query.getPredicatesForPattern(0);
+      assertThat(predicates).hasLength(steps.size());
+      for (int i = 0; i < predicates.length; i++) {
+        assertThat(predicates[i].getType()).isEqualTo(steps.get(i).type);
+      }
+
+      assertThat(query.getPredicateStepsForPattern(1)).isEmpty();
+      assertThat(query.getPredicatesForPattern(1)).isEmpty();
+    }
+  }
+
+  @Test
+  public void testCompiledQueriesAreCached() {
+    final var lang = TSLanguageJava.getInstance();
+    final var querySource = "(method_declaration name: (identifier) @cached_method_name)";
+    TSQuery.clearCache();
+    assertThat(TSQuery.getCacheSize()).isEqualTo(0);
+
+    assertThat(TSQuery.preload(lang, querySource)).isTrue();
+    assertThat(TSQuery.getCacheSize()).isEqualTo(1);
+    assertThat(TSQuery.preload(lang, "(method_declaration")).isFalse();
+    assertThat(TSQuery.getCacheSize()).isEqualTo(1);
+
+    try (final var query = TSQuery.create(lang, querySource)) {
+      final var other = TSQuery.create(lang, querySource);
+      assertThat(other.getNativeObject()).isEqualTo(query.getNativeObject());
+      assertThat(TSQuery.getCacheSize()).isEqualTo(1);
+
+      // closing one of the queries must not affect the other
+      other.close();
+      assertThat(query.getCaptureNames()).asList().containsExactly("cached_method_name");
+
+      // queries in use stay valid after the cache is cleared
+      TSQuery.clearCache();
+      assertThat(TSQuery.getCacheSize()).isEqualTo(0);
+      assertThat(query.getPatternCount()).isEqualTo(1);
+    }
+  }
+
+  @Test
+  public void testQueryCacheIsBounded() {
+    final var lang = TSLanguageJava.getInstance();
+    final var limit = TSQuery.getCacheLimit();
+    TSQuery.clearCache();
+    try {
+      TSQuery.setCacheLimit(2);
+      assertThat(TSQuery.getCacheLimit()).isEqualTo(2);
+
+      final var first = "(identifier) @first";
+      final var second = "(identifier) @second";
+      final var third = "(identifier) @third";
+      assertThat(TSQuery.preload(lang, first)).isTrue();
+      assertThat(TSQuery.preload(lang, second)).isTrue();
+
+      try (final var query = TSQuery.create(lang, first)) {
+        // the least recently used query is evicted, queries in use stay valid
+        assertThat(TSQuery.preload(lang, third)).isTrue();
+        assertThat(TSQuery.getCacheSize()).isEqualTo(2);
+        try (final var other = TSQuery.create(lang, first)) {
+          assertThat(other.getNativeObject()).isEqualTo(query.getNativeObject());
+        }
+
+        TSQuery.setCacheLimit(0);
+        assertThat(TSQuery.getCacheSize()).isEqualTo(0);
+        assertThat(query.getCaptureNames()).asList().containsExactly("first");
+        try (final var other = TSQuery.create(lang, first)) {
+          assertThat(other.getNativeObject()).isNotEqualTo(query.getNativeObject());
+          assertThat(TSQuery.getCacheSize()).isEqualTo(0);
+        }
+      }
+    } finally {
+      TSQuery.setCacheLimit(limit);
+    }
+  }
+
   @Test
   public void testOffsetsInUtf16String() throws Exception {
     try (final var parser = TSParser.create()) {
@@ -560,4 +773,133 @@ public class QueryTest extends TreeSitterTest {
       }
     }
   }
-}
\ No newline at end of file
+
+  @Test
+  public void testCaptureRanges() {
+    try (final var parser = TSParser.create()) {
+      parser.setLanguage(TSLanguageJava.getInstance());
+      final var source = "class A { void a() {} class B { void b() {} } }";
+      try (final var tree = parser.parseString(source);
+           final var query = TSQuery.create(tree.getLanguage(),
+             "(class_declaration) @fold (method_declaration) @fold "
+               + "(class_declaration (class_body) @fold) "
+               + "(class_declaration name: (identifier) @name) "
+               + "(method_declaration name: (identifier) @name)");
+           final var cursor = TSQueryCursor.create()) {
+        final var root = tree.getRootNode();
+        final var outer = root.getChild(0);
+
+        var ranges = cursor.captureRanges(query, root, null, 0);
+        assertThat(ranges.getCaptureCount()).isEqualTo(2);
+        assertThat(ranges.getCaptureIndex("fold")).isEqualTo(0);
+        assertThat(ranges.getCaptureIndex("missing")).isEqualTo(-1);
+
+        // 2 classes, 2 class bodies and 2 methods, sorted by start
+        final var folds = ranges.getRanges("fold");
+        assertThat(folds).hasLength(6 * 2);
+        assertThat(folds[0]).isEqualTo(outer.getStartByte());
+        assertThat(folds[1]).isEqualTo(outer.getEndByte());
+        for (int i = 2; i < folds.length; i += 2) {
+          assertThat(folds[i]).isAtLeast(folds[i - 2]);
+        }
+
+        final var names = ranges.getRanges("name");
+        assertThat(names).hasLength(4 * 2);
+        final var identifiers = new ArrayList<String>();
+        for (int i = 0; i < names.length; i += 2) {
+          identifiers.add(source.substring(names[i] / 2, names[i + 1] / 2));
+        }
+        assertThat(identifiers).containsExactly("A", "a", "B", "b").inOrder();
+
+        // the class bodies and the nested declarations are all nested in the outer class
+        ranges = cursor.captureRanges(query, root, null,
+          TSQueryCursor.CAPTURE_RANGES_MERGE_NESTED);
+        assertThat(ranges.getRangeCount(0)).isEqualTo(1);
+        assertThat(ranges.getStartByte(0, 0)).isEqualTo(outer.getStartByte());
+        assertThat(ranges.getEndByte(0, 0)).isEqualTo(outer.getEndByte());
+        assertThat(ranges.getRangeCount(1)).isEqualTo(4);
+
+        // the cursor has no more matches after collecting the ranges
+        assertThat(cursor.nextMatch()).isNull();
+      }
+
+      try (final var tree = parser.parseString(source);
+           final var query = TSQuery.create(tree.getLanguage(),
+             "(class_declaration) @fold (class_declaration name: (identifier)) @fold");
+           final var cursor = TSQueryCursor.create()) {
+        assertThat(cursor.captureRanges(query, tree.getRootNode(), null, 0).getRangeCount(0))
+          .isEqualTo(4);
+        assertThat(cursor.captureRanges(query, tree.getRootNode(), null,
+          TSQueryCursor.CAPTURE_RANGES_DEDUPLICATE).getRangeCount(0)).isEqualTo(2);
+      }
+    }
+  }
+
+  @Test
+  public void testExecParallel() {
+    final var sb = new StringBuilder();
+    for (int i = 0; i < 1000; i++) {
+      sb.append("// class ").append(i).append('\n');
+      sb.append("class C").append(i).append(" {\n");
+      sb.append("  int field").append(i).append(" = ").append(i).append(";\n");
+      sb.append("  void method").append(i).append("() { call(\"s").append(i).append("\"); }\n");
+      sb.append("}\n");
+    }
+
+    assertParallelCapturesMatch(sb.toString(),
+      "(program) @program (class_declaration name: (identifier) @class) "
+        + "(method_declaration name: (identifier) @method) (string_literal) @string "
+        + "((identifier) @field (#match? @field \"^field\")) "
+        // a non-local pattern, which matches top-level siblings
+        + "((line_comment) @doc . (class_declaration) @documented)");
+  }
+
+  @Test
+  public void testExecParallelWithSiblingRuns() {
+    // most of the top-level children are in runs of comments, so that most of the shard
+    // boundaries are inside a run of siblings matched by the non-local patterns
+    final var sb = new StringBuilder();
+    for (int i = 0; i < 600; i++) {
+      for (int j = 0; j <= i % 10; j++) {
+        sb.append("// comment ").append(j).append(" of class ").append(i).append('\n');
+      }
+      sb.append("class C").append(i).append(" {}\n");
+    }
+
+    assertParallelCapturesMatch(sb.toString(),
+      "((line_comment)+ @doc . (class_declaration) @documented) "
+        + "((line_comment) . (line_comment) @second . (class_declaration) @pair)");
+  }
+
+  private static void assertParallelCapturesMatch(String text, String querySource) {
+    try (final var parser = TSParser.create()) {
+      parser.setLanguage(TSLanguageJava.getInstance());
+      try (final var source = UTF16StringFactory.newString(text);
+           final var tree = parser.parseString(source);
+           final var query = TSQuery.create(tree.getLanguage(), querySource);
+           final var cursor = TSQueryCursor.create()) {
+        assertThat(query.canAccess()).isTrue();
+        final var root = tree.getRootNode();
+
+        cursor.exec(query, root, source);
+        final var buffer = new int[64 * TSQueryCursor.CAPTURE_RECORD_SIZE];
+        final var expected = new ArrayList<Integer>();
+        int count;
+        while ((count = cursor.nextCaptures(buffer)) > 0) {
+          for (int i = 0; i < count * TSQueryCursor.CAPTURE_RECORD_SIZE; i++) {
+            expected.add(buffer[i]);
+          }
+        }
+
+        for (final var maxShards : new int[]{0, 1, 2, 3, 4, 8}) {
+          final var records = cursor.execParallel(query, root, source, maxShards);
+          final var actual = new ArrayList<Integer>(records.length);
+          for (final var value : records) {
+            actual.add(value);
+          }
+          assertThat(actual).containsExactlyElementsIn(expected).inOrder();
+        }
+      }
+    }
+  }
+}
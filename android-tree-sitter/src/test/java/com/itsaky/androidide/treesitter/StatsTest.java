@@ -0,0 +1,156 @@
+/*
+ *  This file is part of android-tree-sitter.
+ *
+ *  android-tree-sitter library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  android-tree-sitter library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *  along with android-tree-sitter.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+package com.itsaky.androidide.treesitter;
+
+import static com.google.common.truth.Truth.assertThat;
+import static com.itsaky.androidide.treesitter.ResourceUtils.readResource;
+
+import com.itsaky.androidide.treesitter.java.TSLanguageJava;
+import com.itsaky.androidide.treesitter.string.UTF16StringFactory;
+import org.junit.After;
+import org.junit.Test;
+import org.junit.runner.RunWith;
+import org.robolectric.RobolectricTestRunner;
+
+/**
+ * @author Akash Yadav
+ */
+@RunWith(RobolectricTestRunner.class)
+public class StatsTest extends TreeSitterTest {
+
+  private static final String SOURCE = "class Main {\n  int x = 1;\n  String s = \"a\";\n}";
+
+  @After
+  public void disableStats() {
+    TSStats.setEnabled(false);
+  }
+
+  @Test
+  public void testStatsAreNotRecordedWhenDisabled() {
+    TSStats.setEnabled(false);
+    assertThat(TSStats.isEnabled()).isFalse();
+    try (final var parser = TSParser.create()) {
+      parser.setLanguage(TSLanguageJava.getInstance());
+      parser.parseString(SOURCE).close();
+
+      final var stats = parser.getStats();
+      assertThat(stats.getParseCount()).isEqualTo(0);
+      assertThat(stats.getBytesParsed()).isEqualTo(0);
+    }
+  }
+
+  @Test
+  public void testParserStats() {
+    TSStats.setEnabled(true);
+    assertThat(TSStats.isEnabled()).isTrue();
+    try (final var parser = TSParser.create();
+         final var source = UTF16StringFactory.newString(SOURCE)) {
+      parser.setLanguage(TSLanguageJava.getInstance());
+      parser.parseString(source).close();
+      parser.parseString(source).close();
+
+      var stats = parser.getStats();
+      assertThat(stats.getParseCount()).isEqualTo(2);
+      assertThat(stats.getBytesParsed()).isEqualTo(2L * source.byteLength());
+      assertThat(stats.getParseTimeNanos()).isGreaterThan(0);
+      assertThat(stats.getCancellationCount()).isEqualTo(0);
+      assertThat(stats.getTimeoutCount()).isEqualTo(0);
+
+      long histogramCount = 0;
+      for (final var bucket : stats.getParseTimeHistogram()) {
+        histogramCount += bucket;
+      }
+      assertThat(histogramCount).isEqualTo(2);
+
+      parser.resetStats();
+      stats = parser.getStats();
+      assertThat(stats.getParseCount()).isEqualTo(0);
+      assertThat(stats.getParseTimeNanos()).isEqualTo(0);
+    }
+  }
+
+  @Test
+  public void testBytesParsedByIncompleteParse() {
+    TSStats.setEnabled(true);
+    try (final var parser = TSParser.create();
+         final var source = UTF16StringFactory.newString(readResource("View.java.txt"))) {
+      parser.setLanguage(TSLanguageJava.getInstance());
+      parser.setTimeout(1000);
+      try (final var tree = parser.parseString(source)) {
+        assertThat(tree).isNull();
+      }
+
+      final var stats = parser.getStats();
+      assertThat(stats.getParseCount()).isEqualTo(1);
+      assertThat(stats.getTimeoutCount()).isEqualTo(1);
+      assertThat(stats.getBytesParsed()).isLessThan((long) source.byteLength());
+    }
+  }
+
+  @Test
+  public void testQueryCursorStats() {
+    TSStats.setEnabled(true);
+    final var language = TSLanguageJava.getInstance();
+    try (final var parser = TSParser.create();
+         final var source = UTF16StringFactory.newString(SOURCE);
+         final var query = TSQuery.create(language,
+           "((identifier) @name (#eq? @name \"x\"))");
+         final var cursor = TSQueryCursor.create()) {
+      parser.setLanguage(language);
+      try (final var tree = parser.parseString(source)) {
+        cursor.exec(query, tree.getRootNode(), source);
+        var matches = 0;
+        while (cursor.nextMatch() != null) {
+          ++matches;
+        }
+
+        final var stats = cursor.getStats();
+        assertThat(matches).isEqualTo(1);
+        assertThat(stats.getExecutionCount()).isEqualTo(1);
+        assertThat(stats.getMatchCount()).isEqualTo(1);
+        assertThat(stats.getCaptureCount()).isEqualTo(1);
+
+        // Main and s do not satisfy the predicate
+        assertThat(stats.getPredicateRejectionCount()).isEqualTo(2);
+        assertThat(stats.getMatchLimitHitCount()).isEqualTo(0);
+
+        cursor.resetStats();
+        assertThat(cursor.getStats().getMatchCount()).isEqualTo(0);
+      }
+    }
+  }
+
+  @Test
+  public void testMarshallingStats() {
+    TSStats.setEnabled(true);
+    TSStats.resetMarshallingStats();
+    try (final var parser = TSParser.create()) {
+      parser.setLanguage(TSLanguageJava.getInstance());
+      try (final var tree = parser.parseString(SOURCE)) {
+        final var root = tree.getRootNode();
+        for (int i = 0; i < root.getChildCount(); i++) {
+          root.getChild(i);
+        }
+
+        final var stats = TSStats.getMarshallingStats();
+        assertThat(stats.getNodeCount()).isAtLeast(1 + root.getChildCount());
+        assertThat(stats.getMatchCount()).isEqualTo(0);
+      }
+    }
+  }
+}
@@ -17,8 +17,12 @@
 
 package com.itsaky.androidide.treesitter;
 
+import static com.google.common.truth.Truth.assertThat;
+
 import com.itsaky.androidide.treesitter.java.TSLanguageJava;
+import com.itsaky.androidide.treesitter.string.UTF16StringFactory;
 
+import java.util.ArrayList;
 import org.junit.Test;
 import org.junit.runner.RunWith;
 import org.junit.runners.JUnit4;
@@ -43,4 +47,73 @@ public class TSLanguageTest extends TreeSitterTest {
     lang.getSymbolForTypeString("identifier", true);
     lang.getSymbolForTypeString("block", false);
   }
-}
\ No newline at end of file
+
+  @Test
+  public void testNamesAreInterned() {
+    final var lang = TSLanguageJava.getInstance();
+    final var symbol = lang.getSymbolForTypeString("identifier", true);
+    final var field = lang.getFieldIdForName("name");
+    assertThat(lang.getSymbolName(symbol)).isEqualTo("identifier");
+    assertThat(lang.getSymbolName(symbol)).isSameInstanceAs(lang.getSymbolName(symbol));
+    assertThat(lang.getFieldNameForId(field)).isSameInstanceAs(lang.getFieldNameForId(field));
+    assertThat(lang.getFieldNameForId(0)).isNull();
+
+    try (final var parser = TSParser.create()) {
+      parser.setLanguage(lang);
+      try (final var source = UTF16StringFactory.newString("class Main { void main() {} }");
+           final var tree = parser.parseString(source);
+           final var cursor = tree.getRootNode().walk()) {
+        assertThat(cursor.gotoFirstChild()).isTrue();
+        assertThat(cursor.gotoFirstChild()).isTrue();
+        assertThat(cursor.gotoNextSibling()).isTrue();
+
+        final var node = cursor.getCurrentNode();
+        assertThat(node.getType()).isSameInstanceAs(lang.getSymbolName(symbol));
+        assertThat(node.getGrammarType()).isSameInstanceAs(node.getType());
+        assertThat(cursor.getCurrentFieldName()).isSameInstanceAs(lang.getFieldNameForId(field));
+        assertThat(cursor.getCurrentTreeCursorNode().getType()).isSameInstanceAs(node.getType());
+      }
+    }
+  }
+
+  @Test
+  public void testValidSymbolsAt() {
+    final var lang = TSLanguageJava.getInstance();
+    try (final var parser = TSParser.create()) {
+      parser.setLanguage(lang);
+      // the strings are parsed as UTF-16, hence 2 bytes per character
+      try (final var tree = parser.parseString("class Main { int x; }")) {
+        final var names = lang.getSymbolNames();
+        final var afterClass = TSLookaheadIterator.getValidSymbolsAt(tree, 6 * 2);
+        assertThat(afterClass).isNotEmpty();
+
+        final var afterClassNames = new ArrayList<String>();
+        for (final var symbol : afterClass) {
+          afterClassNames.add(names[symbol]);
+        }
+        assertThat(afterClassNames).contains("identifier");
+
+        // inside a token, the symbols which can replace that token
+        assertThat(TSLookaheadIterator.getValidSymbolsAt(tree, 8 * 2)).isEqualTo(afterClass);
+        assertThat(TSLookaheadIterator.getParseStateAt(tree, 8 * 2)).isEqualTo(
+          TSLookaheadIterator.getParseStateAt(tree, 6 * 2));
+
+        final var state = TSLookaheadIterator.getParseStateAt(tree, 6 * 2);
+        try (final var iterator = TSLookaheadIterator.create(lang, state)) {
+          assertThat(iterator).isNotNull();
+          final var iterated = new ArrayList<Short>();
+          while (iterator.next()) {
+            iterated.add(iterator.getCurrentSymbol());
+          }
+          assertThat(iterated).hasSize(afterClass.length);
+          for (int i = 0; i < afterClass.length; i++) {
+            assertThat(iterated.get(i)).isEqualTo(afterClass[i]);
+          }
+        }
+
+        // the start of the source is lexed in the initial state
+        assertThat(TSLookaheadIterator.getParseStateAt(tree, 0)).isEqualTo((short) 1);
+      }
+    }
+  }
+}
@@ -20,11 +20,14 @@ package com.itsaky.androidide.treesitter;
 import static com.google.common.truth.Truth.assertThat;
 
 import com.itsaky.androidide.treesitter.python.TSLanguagePython;
+import com.itsaky.androidide.treesitter.string.UTF16String;
 import com.itsaky.androidide.treesitter.string.UTF16StringFactory;
 
 import org.junit.Test;
 
 import java.io.UnsupportedEncodingException;
+import java.util.ArrayList;
+import java.util.List;
 import org.junit.runner.RunWith;
 import org.robolectric.RobolectricTestRunner;
 
@@ -64,4 +67,139 @@ public class TreeCursorTest extends TreeSitterTest {
       }
     }
   }
+
+  @Test
+  public void testGotoNextPreOrder() {
+    try (TSParser parser = TSParser.create();
+         UTF16String source =
+             UTF16StringFactory.newString("def foo(bar, baz):\n  print(bar)\n  print(baz)")) {
+      parser.setLanguage(TSLanguagePython.getInstance());
+      try (TSTree tree = parser.parseString(source)) {
+        final var root = tree.getRootNode();
+        final var expected = new ArrayList<String>();
+        collectPreOrder(root, 0, Integer.MAX_VALUE, 0, Integer.MAX_VALUE, expected);
+
+        final var names = TSLanguagePython.getInstance().getSymbolNames();
+        final var info = new int[TSTreeCursor.INFO_SIZE];
+        final var actual = new ArrayList<String>();
+        try (TSTreeCursor cursor = root.walk()) {
+          cursor.getCurrentNodeInfo(info);
+          assertThat(info[TSTreeCursor.INFO_DEPTH]).isEqualTo(0);
+          do {
+            actual.add(names[info[TSTreeCursor.INFO_SYMBOL]] + "@"
+                + info[TSTreeCursor.INFO_START_BYTE] + ":" + info[TSTreeCursor.INFO_DEPTH]);
+          } while (cursor.gotoNextPreOrder(info));
+
+          assertThat(actual).containsExactlyElementsIn(expected).inOrder();
+          assertThat(cursor.getCurrentNode().getType()).isEqualTo("module");
+        }
+
+        // the second call of print, at most two levels deep
+        final var second = root.getChild(0).getChildByFieldName("body").getChild(1);
+        expected.clear();
+        collectPreOrder(root, 0, 2, second.getStartByte(), second.getEndByte(), expected);
+        actual.clear();
+        try (TSTreeCursor cursor = root.walk()) {
+          cursor.getCurrentNodeInfo(info);
+          do {
+            actual.add(names[info[TSTreeCursor.INFO_SYMBOL]] + "@"
+                + info[TSTreeCursor.INFO_START_BYTE] + ":" + info[TSTreeCursor.INFO_DEPTH]);
+          } while (cursor.gotoNextPreOrder(info, 2, second.getStartByte(), second.getEndByte()));
+        }
+
+        assertThat(actual).containsExactlyElementsIn(expected).inOrder();
+
+        // the parameters of the function are at the same depth as its body,
+        // but do not intersect the range
+        final var parameters = root.getChild(0).getChildByFieldName("parameters");
+        assertThat(actual).contains("block@" + second.getParent().getStartByte() + ":2");
+        assertThat(actual).doesNotContain("parameters@" + parameters.getStartByte() + ":2");
+      }
+    }
+  }
+
+  private static void collectPreOrder(TSNode node, int depth, int maxDepth, int startByte,
+                                      int endByte, List<String> out) {
+    out.add(node.getType() + "@" + node.getStartByte() + ":" + depth);
+    if (depth == maxDepth) {
+      return;
+    }
+    for (int i = 0; i < node.getChildCount(); i++) {
+      final var child = node.getChild(i);
+      if (child.getEndByte() <= startByte || child.getStartByte() >= endByte) {
+        continue;
+      }
+      collectPreOrder(child, depth + 1, maxDepth, startByte, endByte, out);
+    }
+  }
+
+  @Test
+  public void testCursorPool() {
+    TSTreeCursor.setPoolCapacity(2);
+    try (TSParser parser = TSParser.create()) {
+      parser.setLanguage(TSLanguagePython.getInstance());
+      try (TSTree first = parser.parseString("def foo():\n  pass");
+           TSTree second = parser.parseString("x = 1")) {
+        final var hits = TSTreeCursor.getPoolHits();
+
+        var cursor = first.getRootNode().walk();
+        assertThat(cursor.gotoFirstChild()).isTrue();
+        assertThat(cursor.gotoFirstChild()).isTrue();
+        cursor.close();
+        assertThat(TSTreeCursor.getPooledCount()).isEqualTo(1);
+
+        // the reused cursor must not keep any state of the previous traversal
+        try (TSTreeCursor reused = second.getRootNode().walk()) {
+          assertThat(TSTreeCursor.getPoolHits()).isEqualTo(hits + 1);
+          assertThat(TSTreeCursor.getPooledCount()).isEqualTo(0);
+          assertThat(reused.getDepth()).isEqualTo(0);
+          assertThat(reused.getCurrentNode().getType()).isEqualTo("module");
+          assertThat(reused.gotoParent()).isFalse();
+          assertThat(reused.gotoFirstChild()).isTrue();
+          assertThat(reused.getCurrentNode().getType()).isEqualTo("expression_statement");
+        }
+
+        TSTreeCursor.setPoolCapacity(0);
+        assertThat(TSTreeCursor.getPooledCount()).isEqualTo(0);
+      }
+    } finally {
+      TSTreeCursor.setPoolCapacity(0);
+    }
+  }
+
+  @Test
+  public void testUnreachableCursorsAreReleased() throws InterruptedException {
+    TSResourceCleaner.setEnabled(true);
+    try (TSParser parser = TSParser.create()) {
+      parser.setLanguage(TSLanguagePython.getInstance());
+      try (TSTree tree = parser.parseString("x = 1")) {
+        final var live = TSLiveObjects.getLiveCount(TSTreeCursor.class);
+        final var leaked = TSLiveObjects.getLeakedCount(TSTreeCursor.class);
+
+        try (TSTreeCursor cursor = tree.getRootNode().walk()) {
+          assertThat(cursor.gotoFirstChild()).isTrue();
+        }
+        assertThat(TSLiveObjects.getLeakedCount(TSTreeCursor.class)).isEqualTo(leaked);
+
+        leakCursor(tree);
+        assertThat(TSLiveObjects.getLiveCount(TSTreeCursor.class)).isEqualTo(live + 1);
+
+        for (int i = 0; i < 50 && TSLiveObjects.getLeakedCount(TSTreeCursor.class) == leaked; i++) {
+          System.gc();
+          TSResourceCleaner.releaseUnreachable();
+          Thread.sleep(10);
+        }
+
+        assertThat(TSLiveObjects.getLeakedCount(TSTreeCursor.class)).isEqualTo(leaked + 1);
+        assertThat(TSLiveObjects.getLiveCount(TSTreeCursor.class)).isEqualTo(live);
+      }
+    } finally {
+      TSResourceCleaner.setEnabled(false);
+    }
+  }
+
+  private static void leakCursor(TSTree tree) {
+    final var cursor = tree.getRootNode().walk();
+    assertThat(cursor.gotoFirstChild()).isTrue();
+  }
 }
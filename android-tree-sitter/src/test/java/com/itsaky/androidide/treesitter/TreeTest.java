@@ -20,7 +20,10 @@ package com.itsaky.androidide.treesitter;
 import static com.google.common.truth.Truth.assertThat;
 
 import com.itsaky.androidide.treesitter.java.TSLanguageJava;
+import com.itsaky.androidide.treesitter.string.UTF16StringFactory;
 import java.io.UnsupportedEncodingException;
+import java.util.ArrayDeque;
+import java.util.List;
 import org.junit.Test;
 import org.junit.runner.RunWith;
 import org.robolectric.RobolectricTestRunner;
@@ -94,6 +97,51 @@ public class TreeTest extends TreeSitterTest {
     }
   }
 
+  @Test
+  public void testPackedEditsAndReparse() {
+    // replace 'Main' with 'Some' and 'main' with 'test', in UTF-16 byte offsets
+    final var edits = List.of(
+      TSInputEdit.create(12, 20, 20, TSPoint.create(0, 12), TSPoint.create(0, 20),
+        TSPoint.create(0, 20)),
+      TSInputEdit.create(36, 44, 44, TSPoint.create(0, 36), TSPoint.create(0, 44),
+        TSPoint.create(0, 44)));
+    final var packed = TSInputEdit.pack(edits);
+    assertThat(packed).hasLength(edits.size() * TSInputEdit.RECORD_SIZE);
+
+    try (final var parser = TSParser.create();
+         final var source = UTF16StringFactory.newString("class Some { void test() {} }")) {
+      parser.setLanguage(TSLanguageJava.getInstance());
+      try (final var oldTree = parser.parseString("class Main { void main() {} }");
+           final var expectedOldTree = oldTree.copy()) {
+
+        for (final var edit : edits) {
+          expectedOldTree.edit(edit);
+        }
+
+        final var result = parser.reparse(oldTree, packed, source);
+        try (final var tree = result.getTree();
+             final var expectedTree = parser.parseString(expectedOldTree, source)) {
+          assertThat(tree).isNotNull();
+          assertThat(tree.getRootNode().getNodeString()).isEqualTo(
+            expectedTree.getRootNode().getNodeString());
+
+          final var changedRanges = result.getChangedRanges();
+          assertThat(changedRanges).containsExactlyElementsIn(
+            expectedTree.getChangedRanges(expectedOldTree)).inOrder();
+          assertThat(tree.getChangedRangeList(oldTree)).containsExactlyElementsIn(changedRanges)
+            .inOrder();
+
+          for (int i = 0; i < changedRanges.size(); i++) {
+            final var range = changedRanges.get(i);
+            assertThat(changedRanges.getStartByte(i)).isEqualTo(range.getStartByte());
+            assertThat(changedRanges.getEndByte(i)).isEqualTo(range.getEndByte());
+            assertThat(changedRanges.getEndColumn(i)).isEqualTo(range.getEndPoint().getColumn());
+          }
+        }
+      }
+    }
+  }
+
   @Test
   public void testTreeGetIncludedRanges() {
     try (final var parser = TSParser.create()) {
@@ -118,4 +166,138 @@ public class TreeTest extends TreeSitterTest {
       }
     }
   }
+
+  @Test
+  public void testTreeSnapshot() {
+    try (final var parser = TSParser.create()) {
+      parser.setLanguage(TSLanguageJava.getInstance());
+      try (final var tree = parser.parseString(
+        "class Main { void main() { int x = 1 + ; } }"); final var snapshot = tree.snapshot();
+           final var cursor = TSTreeCursor.create(tree.getRootNode())) {
+        assertThat(snapshot.getNodeCount()).isEqualTo(tree.getRootNode().getDescendantCount());
+        assertThat(snapshot.getParent(0)).isEqualTo(-1);
+
+        final var parents = new ArrayDeque<Integer>();
+        var index = 0;
+        while (true) {
+          final var node = cursor.getCurrentNode();
+          assertThat(snapshot.getStartByte(index)).isEqualTo(node.getStartByte());
+          assertThat(snapshot.getEndByte(index)).isEqualTo(node.getEndByte());
+          assertThat(snapshot.getStartRow(index)).isEqualTo(node.getStartPoint().getRow());
+          assertThat(snapshot.getStartColumn(index)).isEqualTo(node.getStartPoint().getColumn());
+          assertThat(snapshot.getEndRow(index)).isEqualTo(node.getEndPoint().getRow());
+          assertThat(snapshot.getEndColumn(index)).isEqualTo(node.getEndPoint().getColumn());
+          assertThat(snapshot.getSymbol(index)).isEqualTo(node.getSymbol());
+          assertThat(snapshot.getType(index)).isEqualTo(node.getType());
+          assertThat(snapshot.getFieldId(index)).isEqualTo(cursor.getCurrentFieldId());
+          assertThat(snapshot.isNamed(index)).isEqualTo(node.isNamed());
+          assertThat(snapshot.isExtra(index)).isEqualTo(node.isExtra());
+          assertThat(snapshot.hasError(index)).isEqualTo(node.hasErrors());
+          assertThat(snapshot.getParent(index)).isEqualTo(parents.isEmpty() ? -1 : parents.peek());
+
+          if (cursor.gotoFirstChild()) {
+            parents.push(index++);
+            continue;
+          }
+
+          ++index;
+          var done = false;
+          while (!cursor.gotoNextSibling()) {
+            if (!cursor.gotoParent()) {
+              done = true;
+              break;
+            }
+            parents.pop();
+          }
+
+          if (done) {
+            break;
+          }
+        }
+
+        assertThat(index).isEqualTo(snapshot.getNodeCount());
+      }
+    }
+  }
+
+  @Test
+  public void testFootprint() {
+    try (final var parser = TSParser.create()) {
+      parser.setLanguage(TSLanguageJava.getInstance());
+      try (final var tree = parser.parseString("class Main { void main() { int x = 1; } }")) {
+        final var footprint = tree.getFootprint();
+        assertThat(footprint.getNodeCount()).isGreaterThan(0);
+        assertThat(footprint.getSubtreeCount()).isGreaterThan(0);
+        assertThat(footprint.getSharedBytes()).isEqualTo(0);
+        assertThat(footprint.getRetainedBytes()).isEqualTo(footprint.getUniqueBytes());
+
+        try (final var copy = tree.copy()) {
+          final var shared = tree.getFootprint();
+          assertThat(shared.getNodeCount()).isEqualTo(footprint.getNodeCount());
+          assertThat(shared.getRetainedBytes()).isEqualTo(footprint.getRetainedBytes());
+          assertThat(shared.getSharedSubtreeCount()).isEqualTo(shared.getSubtreeCount());
+          assertThat(shared.getSharedRatio()).isEqualTo(1.0);
+          assertThat(copy.getFootprint().getSharedBytes()).isEqualTo(shared.getSharedBytes());
+        }
+
+        assertThat(tree.getFootprint().getSharedBytes()).isEqualTo(0);
+      }
+    }
+  }
+
+  @Test
+  public void testLiveObjectCounts() {
+    final var trees = TSLiveObjects.getLiveCount(TSTree.class);
+    final var parsers = TSLiveObjects.getLiveCount(TSParser.class);
+    try (final var parser = TSParser.create()) {
+      parser.setLanguage(TSLanguageJava.getInstance());
+      assertThat(TSLiveObjects.getLiveCount(TSParser.class)).isEqualTo(parsers + 1);
+      try (final var tree = parser.parseString("class Main {}")) {
+        assertThat(TSLiveObjects.getLiveCount(TSTree.class)).isEqualTo(trees + 1);
+        assertThat(TSLiveObjects.getLiveCounts()).containsKey(TSTree.class);
+
+        tree.getRootNode();
+        assertThat(TSLiveObjects.getLiveCount(TSNode.class)).isEqualTo(0);
+      }
+      assertThat(TSLiveObjects.getLiveCount(TSTree.class)).isEqualTo(trees);
+    }
+    assertThat(TSLiveObjects.getLiveCount(TSParser.class)).isEqualTo(parsers);
+  }
+
+  @Test
+  public void testUnreachableTreesAreReleased() throws InterruptedException {
+    TSResourceCleaner.setEnabled(true);
+    try (final var parser = TSParser.create()) {
+      parser.setLanguage(TSLanguageJava.getInstance());
+      try (final var tree = parser.parseString("class Main {}")) {
+        final var live = TSLiveObjects.getLiveCount(TSTree.class);
+        final var leaked = TSLiveObjects.getLeakedCount(TSTree.class);
+
+        // a view of the tree is neither counted nor released
+        assertThat(tree.getRootNode().getTree().getNativeObject()).isEqualTo(
+          tree.getNativeObject());
+        assertThat(TSLiveObjects.getLiveCount(TSTree.class)).isEqualTo(live);
+
+        leakTree(parser);
+        assertThat(TSLiveObjects.getLiveCount(TSTree.class)).isEqualTo(live + 1);
+
+        for (int i = 0; i < 50 && TSLiveObjects.getLeakedCount(TSTree.class) == leaked; i++) {
+          System.gc();
+          TSResourceCleaner.releaseUnreachable();
+          Thread.sleep(10);
+        }
+
+        assertThat(TSLiveObjects.getLeakedCount(TSTree.class)).isEqualTo(leaked + 1);
+        assertThat(TSLiveObjects.getLiveCount(TSTree.class)).isEqualTo(live);
+        assertThat(tree.getRootNode().getType()).isEqualTo("program");
+      }
+    } finally {
+      TSResourceCleaner.setEnabled(false);
+    }
+  }
+
+  private static void leakTree(TSParser parser) {
+    final var tree = parser.parseString("class Leaked {}");
+    assertThat(tree.getRootNode().getChildCount()).isEqualTo(1);
+  }
 }
@@ -20,8 +20,11 @@ package com.itsaky.androidide.treesitter;
 import static com.google.common.truth.Truth.assertThat;
 import static com.itsaky.androidide.treesitter.ResourceUtils.readResource;
 
+import com.itsaky.androidide.treesitter.java.TSLanguageJava;
 import com.itsaky.androidide.treesitter.string.UTF16String;
 import com.itsaky.androidide.treesitter.string.UTF16StringFactory;
+import java.nio.charset.StandardCharsets;
+import java.util.Random;
 import org.junit.Test;
 import org.junit.runner.RunWith;
 import org.robolectric.RobolectricTestRunner;
@@ -201,4 +204,157 @@ public class UTF16StringTest extends TreeSitterTest {
       str.forEachByte(100, 1000, b -> {});
     }
   }
+
+  @Test
+  public void testEditsInTheMiddle() {
+    final var content = readResource("View.java.txt");
+    final var expected = new StringBuilder(content);
+    try (final var str = UTF16StringFactory.newString(content)) {
+      final var random = new Random(42);
+      for (int i = 0; i < 500; i++) {
+        final var start = random.nextInt(expected.length());
+        final var end = Math.min(expected.length(), start + random.nextInt(20));
+        switch (i % 3) {
+          case 0:
+            str.insert(start, "inserted");
+            expected.insert(start, "inserted");
+            break;
+          case 1:
+            str.delete(start, end);
+            expected.delete(start, end);
+            break;
+          default:
+            str.replaceChars(start, end, "\uD83D\uDE0D");
+            expected.replace(start, end, "\uD83D\uDE0D");
+            break;
+        }
+
+        final var at = random.nextInt(expected.length());
+        assertThat(str.charAt(at)).isEqualTo(expected.charAt(at));
+      }
+
+      assertThat(str.length()).isEqualTo(expected.length());
+      assertThat(str.toString()).isEqualTo(expected.toString());
+      assertThat(str.substringChars(100, 200)).isEqualTo(expected.substring(100, 200));
+    }
+  }
+
+  @Test
+  public void testNewStringFromBytesWithOffset() {
+    final var bytes = "__Hello World!__".getBytes(StandardCharsets.UTF_16LE);
+    try (final var str = UTF16StringFactory.newString(bytes, 4, bytes.length - 8)) {
+      assertThat(str.toString()).isEqualTo("Hello World!");
+      assertThat(str.byteLength()).isEqualTo(bytes.length - 8);
+    }
+  }
+
+  @Test
+  public void testLineIndex() {
+    try (final var str = UTF16StringFactory.newString("class Main {\n  void main() {}\n}")) {
+      assertThat(str.getLineCount()).isEqualTo(3);
+      assertThat(str.getLineStart(1)).isEqualTo(13);
+      assertThat(str.getLineForChar(15)).isEqualTo(1);
+      assertThat(str.charToPoint(15)).isEqualTo(TSPoint.create(1, 4));
+      assertThat(str.byteToPoint(30)).isEqualTo(TSPoint.create(1, 4));
+      assertThat(str.pointToChar(TSPoint.create(1, 4))).isEqualTo(15);
+      assertThat(str.pointToByte(TSPoint.create(2, 0))).isEqualTo(2 * 30);
+
+      // points past the end of a line are clamped to the line
+      assertThat(str.pointToChar(TSPoint.create(0, 100))).isEqualTo(12);
+      assertThat(str.pointToChar(TSPoint.create(10, 0))).isEqualTo(str.length());
+
+      // the index is updated by the edits
+      str.insert(0, "// comment\n");
+      assertThat(str.getLineCount()).isEqualTo(4);
+      assertThat(str.charToPoint(15 + 11)).isEqualTo(TSPoint.create(2, 4));
+      str.delete(0, 11);
+      assertThat(str.getLineCount()).isEqualTo(3);
+      assertThat(str.charToPoint(15)).isEqualTo(TSPoint.create(1, 4));
+    }
+  }
+
+  @Test
+  public void testLineIndexMatchesContentAfterRandomEdits() {
+    final var random = new Random(17);
+    final var expected = new StringBuilder("a\nbc\n\nd");
+    try (final var str = UTF16StringFactory.newString(expected.toString())) {
+      for (int i = 0; i < 500; i++) {
+        final var start = random.nextInt(expected.length() + 1);
+        final var end = start + random.nextInt(expected.length() - start + 1);
+        final var text = random.nextBoolean() ? "x\ny" : random.nextBoolean() ? "\n" : "";
+        str.replaceChars(start, end, text);
+        expected.replace(start, end, text);
+
+        final var index = random.nextInt(expected.length() + 1);
+        final var lineStart = expected.lastIndexOf("\n", index - 1) + 1;
+        final var row = (int) expected.substring(0, index).chars().filter(c -> c == '\n').count();
+        assertThat(str.charToPoint(index)).isEqualTo(TSPoint.create(row, (index - lineStart) * 2));
+      }
+    }
+  }
+
+  @Test
+  public void testEditCharsCreatesInputEdit() {
+    final var source = "class Main {\n  void main() {}\n}";
+    try (final var str = UTF16StringFactory.newString(source);
+         final var parser = TSParser.create()) {
+      parser.setLanguage(TSLanguageJava.getInstance());
+      try (final var tree = parser.parseString(str)) {
+        final var edit = str.editChars(15, 19, "int\nfoo");
+        assertThat(edit).isEqualTo(
+          TSInputEdit.create(30, 38, 44, TSPoint.create(1, 4), TSPoint.create(1, 12),
+            TSPoint.create(2, 6)));
+        assertThat(str.toString()).isEqualTo("class Main {\n  int\nfoo main() {}\n}");
+
+        tree.edit(edit);
+        try (final var newTree = parser.parseString(tree, str);
+             final var expected = parser.parseString(str.toString())) {
+          assertThat(newTree.getRootNode().getNodeString()).isEqualTo(
+            expected.getRootNode().getNodeString());
+        }
+      }
+    }
+  }
+
+  @Test
+  public void testUnreachableStringsAreReleased() throws InterruptedException {
+    TSResourceCleaner.setEnabled(true);
+    try {
+      final var live = TSLiveObjects.getLiveCount(UTF16String.class);
+      final var leaked = TSLiveObjects.getLeakedCount(UTF16String.class);
+
+      // the synchronized view keeps its string reachable, and is not counted
+      final var view = synchronizedView("view");
+      assertThat(TSLiveObjects.getLiveCount(UTF16String.class)).isEqualTo(live + 1);
+
+      leakString("leaked");
+      assertThat(TSLiveObjects.getLiveCount(UTF16String.class)).isEqualTo(live + 2);
+
+      for (int i = 0; i < 50 && TSLiveObjects.getLeakedCount(UTF16String.class) == leaked; i++) {
+        System.gc();
+        TSResourceCleaner.releaseUnreachable();
+        Thread.sleep(10);
+      }
+
+      assertThat(TSLiveObjects.getLeakedCount(UTF16String.class)).isEqualTo(leaked + 1);
+      assertThat(TSLiveObjects.getLiveCount(UTF16String.class)).isEqualTo(live + 1);
+      assertThat(view.toString()).isEqualTo("view");
+
+      // closing the view releases its string
+      view.close();
+      assertThat(view.canAccess()).isFalse();
+      assertThat(TSLiveObjects.getLiveCount(UTF16String.class)).isEqualTo(live);
+    } finally {
+      TSResourceCleaner.setEnabled(false);
+    }
+  }
+
+  private static UTF16String synchronizedView(String text) {
+    return UTF16StringFactory.newString(text).synchronizedString();
+  }
+
+  private static void leakString(String text) {
+    final var str = UTF16StringFactory.newString(text);
+    assertThat(str.length()).isEqualTo(text.length());
+  }
 }
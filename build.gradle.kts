@@ -86,6 +86,10 @@ subprojects {
     tasks.withType<Test> {
       systemProperty("java.library.path",
         rootProject.buildDir.resolve("host").absolutePath)
+
+      // benchmarks are skipped unless enabled with -Pats.benchmark=true
+      findProperty("ats.benchmark")?.let { systemProperty("ats.benchmark", it) }
+      systemProperty("ats.benchmark.output", buildDir.resolve("benchmarks").absolutePath)
     }
   }
 